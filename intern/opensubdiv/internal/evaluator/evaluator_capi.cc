@@ -132,6 +132,13 @@ void evaluateFaceVarying(OpenSubdiv_Evaluator *evaluator,
       face_varying_channel, ptex_face_index, face_u, face_v, face_varying);
 }
 
+OpenSubdiv_LimitStencils *createLimitStencils(OpenSubdiv_Evaluator *evaluator,
+                                              const OpenSubdiv_PatchCoord *patch_coords,
+                                              const int num_patch_coords)
+{
+  return openSubdiv_createLimitStencilsInternal(evaluator->impl, patch_coords, num_patch_coords);
+}
+
 void assignFunctionPointers(OpenSubdiv_Evaluator *evaluator)
 {
   evaluator->setCoarsePositions = setCoarsePositions;
@@ -149,6 +156,8 @@ void assignFunctionPointers(OpenSubdiv_Evaluator *evaluator)
   evaluator->evaluateFaceVarying = evaluateFaceVarying;
 
   evaluator->evaluatePatchesLimit = evaluatePatchesLimit;
+
+  evaluator->createLimitStencils = createLimitStencils;
 }
 
 }  // namespace
@@ -167,3 +176,13 @@ void openSubdiv_deleteEvaluator(OpenSubdiv_Evaluator *evaluator)
   openSubdiv_deleteEvaluatorInternal(evaluator->impl);
   OBJECT_GUARDED_DELETE(evaluator, OpenSubdiv_Evaluator);
 }
+
+void openSubdiv_deleteLimitStencils(OpenSubdiv_LimitStencils *stencils)
+{
+  MEM_freeN(stencils->offsets);
+  MEM_freeN(stencils->indices);
+  MEM_freeN(stencils->weights);
+  MEM_freeN(stencils->du_weights);
+  MEM_freeN(stencils->dv_weights);
+  MEM_freeN(stencils);
+}
@@ -18,8 +18,10 @@
 
 #include "internal/evaluator/evaluator_impl.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 
 #ifdef _MSC_VER
 #  include <iso646.h>
@@ -39,11 +41,13 @@
 
 #include "internal/base/type.h"
 #include "internal/topology/topology_refiner_impl.h"
+#include "opensubdiv_evaluator_capi.h"
 #include "opensubdiv_topology_refiner_capi.h"
 
 using OpenSubdiv::Far::PatchMap;
 using OpenSubdiv::Far::PatchTable;
 using OpenSubdiv::Far::PatchTableFactory;
+using OpenSubdiv::Far::Stencil;
 using OpenSubdiv::Far::StencilTable;
 using OpenSubdiv::Far::StencilTableFactory;
 using OpenSubdiv::Far::TopologyRefiner;
@@ -751,7 +755,7 @@ void CpuEvalOutputAPI::evaluatePatchesLimit(const OpenSubdiv_PatchCoord *patch_c
 }  // namespace blender
 
 OpenSubdiv_EvaluatorImpl::OpenSubdiv_EvaluatorImpl()
-    : eval_output(NULL), patch_map(NULL), patch_table(NULL)
+    : eval_output(NULL), patch_map(NULL), patch_table(NULL), vertex_stencils(NULL)
 {
 }
 
@@ -760,6 +764,7 @@ OpenSubdiv_EvaluatorImpl::~OpenSubdiv_EvaluatorImpl()
   delete eval_output;
   delete patch_map;
   delete patch_table;
+  delete vertex_stencils;
 }
 
 OpenSubdiv_EvaluatorImpl *openSubdiv_createEvaluatorInternal(
@@ -877,8 +882,15 @@ OpenSubdiv_EvaluatorImpl *openSubdiv_createEvaluatorInternal(
   evaluator_descr->eval_output = new blender::opensubdiv::CpuEvalOutputAPI(eval_output, patch_map);
   evaluator_descr->patch_map = patch_map;
   evaluator_descr->patch_table = patch_table;
+  // Vertex stencils are kept for the limit stencils creation, which needs all
+  // intermediate levels to be factorized down to the coarse vertices.
+  if (is_adaptive) {
+    evaluator_descr->vertex_stencils = vertex_stencils;
+  }
+  else {
+    delete vertex_stencils;
+  }
   // TOOD(sergey): Look into whether we've got duplicated stencils arrays.
-  delete vertex_stencils;
   delete varying_stencils;
   for (const StencilTable *table : all_face_varying_stencils) {
     delete table;
@@ -890,3 +902,124 @@ void openSubdiv_deleteEvaluatorInternal(OpenSubdiv_EvaluatorImpl *evaluator)
 {
   delete evaluator;
 }
+
+namespace {
+
+// Accumulates weights of a single limit stencil, merging weights of the same
+// coarse vertex.
+class LimitStencilBuilder {
+ public:
+  explicit LimitStencilBuilder(const int num_coarse_vertices)
+      : index_in_stencil_(num_coarse_vertices, -1)
+  {
+  }
+
+  void add(const int coarse_index,
+           const float weight,
+           const float du_weight,
+           const float dv_weight)
+  {
+    int &index_in_stencil = index_in_stencil_[coarse_index];
+    if (index_in_stencil == -1) {
+      index_in_stencil = int(indices.size()) - stencil_start_;
+      indices.push_back(coarse_index);
+      weights.push_back(weight);
+      du_weights.push_back(du_weight);
+      dv_weights.push_back(dv_weight);
+      return;
+    }
+    const int index = stencil_start_ + index_in_stencil;
+    weights[index] += weight;
+    du_weights[index] += du_weight;
+    dv_weights[index] += dv_weight;
+  }
+
+  void end_stencil()
+  {
+    for (int i = stencil_start_; i < int(indices.size()); ++i) {
+      index_in_stencil_[indices[i]] = -1;
+    }
+    stencil_start_ = int(indices.size());
+    offsets.push_back(stencil_start_);
+  }
+
+  blender::opensubdiv::vector<int> offsets{0};
+  blender::opensubdiv::vector<int> indices;
+  blender::opensubdiv::vector<float> weights;
+  blender::opensubdiv::vector<float> du_weights;
+  blender::opensubdiv::vector<float> dv_weights;
+
+ private:
+  // Position of the coarse vertex in the current stencil, -1 if not used yet.
+  blender::opensubdiv::vector<int> index_in_stencil_;
+  int stencil_start_ = 0;
+};
+
+template<typename T>
+T *copyToGuardedArray(const blender::opensubdiv::vector<T> &data, const char *name)
+{
+  T *result = static_cast<T *>(
+      MEM_malloc_arrayN(std::max(data.size(), size_t(1)), sizeof(T), name));
+  if (!data.empty()) {
+    memcpy(result, data.data(), sizeof(T) * data.size());
+  }
+  return result;
+}
+
+}  // namespace
+
+OpenSubdiv_LimitStencils *openSubdiv_createLimitStencilsInternal(
+    const OpenSubdiv_EvaluatorImpl *evaluator,
+    const OpenSubdiv_PatchCoord *patch_coords,
+    const int num_patch_coords)
+{
+  if (evaluator->vertex_stencils == NULL) {
+    return NULL;
+  }
+  const StencilTable *vertex_stencils = evaluator->vertex_stencils;
+  const PatchTable *patch_table = evaluator->patch_table;
+  const int num_coarse_vertices = vertex_stencils->GetNumControlVertices();
+  LimitStencilBuilder builder(num_coarse_vertices);
+  // Regular and Gregory basis patches have at most 20 control vertices.
+  float point_weights[20], du_weights[20], dv_weights[20];
+  for (int i = 0; i < num_patch_coords; ++i) {
+    const OpenSubdiv_PatchCoord &patch_coord = patch_coords[i];
+    if (patch_coord.ptex_face == -1) {
+      // Point which is not on the limit surface, keep its stencil empty.
+      builder.end_stencil();
+      continue;
+    }
+    const PatchTable::PatchHandle *handle = evaluator->patch_map->FindPatch(
+        patch_coord.ptex_face, patch_coord.u, patch_coord.v);
+    patch_table->EvaluateBasis(
+        *handle, patch_coord.u, patch_coord.v, point_weights, du_weights, dv_weights);
+    const OpenSubdiv::Far::ConstIndexArray control_vertices = patch_table->GetPatchVertices(
+        *handle);
+    for (int j = 0; j < control_vertices.size(); ++j) {
+      const int control_vertex = control_vertices[j];
+      if (control_vertex < num_coarse_vertices) {
+        builder.add(control_vertex, point_weights[j], du_weights[j], dv_weights[j]);
+        continue;
+      }
+      const Stencil stencil = vertex_stencils->GetStencil(control_vertex - num_coarse_vertices);
+      const int *stencil_indices = stencil.GetVertexIndices();
+      const float *stencil_weights = stencil.GetWeights();
+      for (int k = 0; k < stencil.GetSize(); ++k) {
+        builder.add(stencil_indices[k],
+                    point_weights[j] * stencil_weights[k],
+                    du_weights[j] * stencil_weights[k],
+                    dv_weights[j] * stencil_weights[k]);
+      }
+    }
+    builder.end_stencil();
+  }
+  OpenSubdiv_LimitStencils *stencils = static_cast<OpenSubdiv_LimitStencils *>(
+      MEM_mallocN(sizeof(OpenSubdiv_LimitStencils), "OpenSubdiv_LimitStencils"));
+  stencils->num_stencils = num_patch_coords;
+  stencils->offsets = copyToGuardedArray(builder.offsets, "limit stencils offsets");
+  stencils->indices = copyToGuardedArray(builder.indices, "limit stencils indices");
+  stencils->weights = copyToGuardedArray(builder.weights, "limit stencils weights");
+  stencils->du_weights = copyToGuardedArray(builder.du_weights, "limit stencils du weights");
+  stencils->dv_weights = copyToGuardedArray(builder.dv_weights, "limit stencils dv weights");
+  return stencils;
+}
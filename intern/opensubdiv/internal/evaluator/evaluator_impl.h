@@ -25,9 +25,11 @@
 
 #include <opensubdiv/far/patchMap.h>
 #include <opensubdiv/far/patchTable.h>
+#include <opensubdiv/far/stencilTable.h>
 
 #include "internal/base/memory.h"
 
+struct OpenSubdiv_LimitStencils;
 struct OpenSubdiv_PatchCoord;
 struct OpenSubdiv_TopologyRefiner;
 
@@ -146,6 +148,10 @@ struct OpenSubdiv_EvaluatorImpl {
   blender::opensubdiv::CpuEvalOutputAPI *eval_output;
   const OpenSubdiv::Far::PatchMap *patch_map;
   const OpenSubdiv::Far::PatchTable *patch_table;
+  // Stencils of all refined vertices and local points, factorized to the
+  // coarse vertices. Only kept for adaptive refinement, where they are used
+  // to create limit stencils.
+  const OpenSubdiv::Far::StencilTable *vertex_stencils;
 
   MEM_CXX_CLASS_ALLOC_FUNCS("OpenSubdiv_EvaluatorImpl");
 };
@@ -155,4 +161,9 @@ OpenSubdiv_EvaluatorImpl *openSubdiv_createEvaluatorInternal(
 
 void openSubdiv_deleteEvaluatorInternal(OpenSubdiv_EvaluatorImpl *evaluator);
 
+OpenSubdiv_LimitStencils *openSubdiv_createLimitStencilsInternal(
+    const OpenSubdiv_EvaluatorImpl *evaluator,
+    const OpenSubdiv_PatchCoord *patch_coords,
+    const int num_patch_coords);
+
 #endif  // OPENSUBDIV_EVALUATOR_IMPL_H_
@@ -27,6 +27,24 @@ struct OpenSubdiv_EvaluatorInternal;
 struct OpenSubdiv_PatchCoord;
 struct OpenSubdiv_TopologyRefiner;
 
+// Sparse weights of coarse vertices for a set of points on the limit surface.
+//
+// Limit position of point `i` is the sum of positions of coarse vertices
+// `indices[j]` multiplied by `weights[j]`, for `j` in range
+// `[offsets[i], offsets[i + 1])`. Derivatives are calculated the same way
+// from `du_weights` and `dv_weights`.
+//
+// NOTE: Coarse vertex indices are the ones passed to setCoarsePositions().
+typedef struct OpenSubdiv_LimitStencils {
+  int num_stencils;
+  // Array of num_stencils + 1 elements.
+  int *offsets;
+  int *indices;
+  float *weights;
+  float *du_weights;
+  float *dv_weights;
+} OpenSubdiv_LimitStencils;
+
 typedef struct OpenSubdiv_Evaluator {
   // Set coarse positions from a continuous array of coordinates.
   void (*setCoarsePositions)(struct OpenSubdiv_Evaluator *evaluator,
@@ -122,6 +140,19 @@ typedef struct OpenSubdiv_Evaluator {
                                float *dPdu,
                                float *dPdv);
 
+  // Create stencils which allow to evaluate limit surface at the given
+  // coordinates as a weighted sum of coarse vertex positions, without going
+  // through refinement.
+  //
+  // Returns NULL if the evaluator does not support stencils (which is the case
+  // for uniform refinement).
+  //
+  // NOTE: Result is to be freed with openSubdiv_deleteLimitStencils().
+  struct OpenSubdiv_LimitStencils *(*createLimitStencils)(
+      struct OpenSubdiv_Evaluator *evaluator,
+      const struct OpenSubdiv_PatchCoord *patch_coords,
+      const int num_patch_coords);
+
   // Implementation of the evaluator.
   struct OpenSubdiv_EvaluatorImpl *impl;
 } OpenSubdiv_Evaluator;
@@ -131,6 +162,8 @@ OpenSubdiv_Evaluator *openSubdiv_createEvaluatorFromTopologyRefiner(
 
 void openSubdiv_deleteEvaluator(OpenSubdiv_Evaluator *evaluator);
 
+void openSubdiv_deleteLimitStencils(OpenSubdiv_LimitStencils *stencils);
+
 #ifdef __cplusplus
 }
 #endif
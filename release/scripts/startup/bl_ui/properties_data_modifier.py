@@ -35,9 +35,12 @@ class DATA_PT_modifiers(ModifierButtonsPanel, Panel):
         ob = context.object
         return ob and ob.type != 'GPENCIL'
 
-    def draw(self, _context):
+    def draw(self, context):
         layout = self.layout
         layout.operator_menu_enum("object.modifier_add", "type")
+        ob = context.object
+        if ob.type == 'MESH':
+            layout.prop(ob, "use_modifier_cache_auto")
         layout.template_modifiers()
 
 
@@ -28,6 +28,7 @@ extern "C" {
 #endif
 
 struct AnimationEvalContext;
+struct ArmatureSkinningCache;
 struct bAction;
 struct BMEditMesh;
 struct Bone;
@@ -472,7 +473,8 @@ void BKE_armature_deform_coords_with_mesh(const struct Object *ob_arm,
                                           int deformflag,
                                           float (*vert_coords_prev)[3],
                                           const char *defgrp_name,
-                                          const struct Mesh *me_target);
+                                          const struct Mesh *me_target,
+                                          struct ArmatureSkinningCache *skinning_cache);
 
 void BKE_armature_deform_coords_with_editmesh(const struct Object *ob_arm,
                                               const struct Object *ob_target,
@@ -484,6 +486,23 @@ void BKE_armature_deform_coords_with_editmesh(const struct Object *ob_arm,
                                               const char *defgrp_name,
                                               struct BMEditMesh *em_target);
 
+struct ArmatureDeformRange *BKE_armature_deform_range_create_with_mesh(
+    const struct Object *ob_arm,
+    const struct Object *ob_target,
+    int deformflag,
+    const char *defgrp_name,
+    const struct Mesh *me_target,
+    int verts_num,
+    struct ArmatureSkinningCache *skinning_cache);
+void BKE_armature_deform_range_eval(const struct ArmatureDeformRange *range,
+                                    float (*vert_coords)[3],
+                                    int start,
+                                    int end);
+void BKE_armature_deform_range_destroy(struct ArmatureDeformRange *range);
+
+struct ArmatureSkinningCache *BKE_armature_skinning_cache_create(void);
+void BKE_armature_skinning_cache_free(struct ArmatureSkinningCache *cache);
+
 /** \} */
 
   /***************************************************************************/
@@ -132,6 +132,19 @@ void BKE_lattice_deform_coords_with_editmesh(const struct Object *ob_lattice,
                                              const char *defgrp_name,
                                              const float fac,
                                              struct BMEditMesh *em_target);
+
+struct LatticeDeformRange *BKE_lattice_deform_range_create_with_mesh(
+    const struct Object *ob_lattice,
+    const struct Object *ob_target,
+    const short flag,
+    const char *defgrp_name,
+    const float fac,
+    const struct Mesh *me_target) ATTR_WARN_UNUSED_RESULT;
+void BKE_lattice_deform_range_eval(const struct LatticeDeformRange *range,
+                                   float (*vert_coords)[3],
+                                   int start,
+                                   int end);
+void BKE_lattice_deform_range_destroy(struct LatticeDeformRange *range);
 /** \} */
 
 #ifdef __cplusplus
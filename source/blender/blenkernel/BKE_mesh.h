@@ -589,6 +589,12 @@ struct Mesh *BKE_mesh_merge_verts(struct Mesh *mesh,
                                   const int tot_vtargetmap,
                                   const int merge_mode);
 
+/* *** mesh_triangulate.cc *** */
+struct Mesh *BKE_mesh_triangulate(const struct Mesh *mesh,
+                                  const int quad_method,
+                                  const int ngon_method,
+                                  const int min_vertices);
+
 /* flush flags */
 void BKE_mesh_flush_hidden_from_verts_ex(const struct MVert *mvert,
                                          const struct MLoop *mloop,
@@ -61,6 +61,10 @@ struct Mesh *BKE_mesh_remesh_quadriflow_to_mesh_nomain(struct Mesh *mesh,
 void BKE_mesh_remesh_reproject_paint_mask(struct Mesh *target, struct Mesh *source);
 void BKE_remesh_reproject_vertex_paint(struct Mesh *target, struct Mesh *source);
 void BKE_remesh_reproject_sculpt_face_sets(struct Mesh *target, struct Mesh *source);
+void BKE_remesh_reproject_vertex_data(struct Mesh *target,
+                                      struct Mesh *source,
+                                      bool use_paint_mask,
+                                      bool use_vertex_paint);
 
 #ifdef __cplusplus
 }
@@ -26,6 +26,8 @@
 
 //#include "BKE_customdata.h"  /* for CustomDataMask */
 
+#include "BLI_sys_types.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -38,6 +40,8 @@ struct MLoop;
 struct MLoopTri;
 struct MVertTri;
 struct Mesh;
+struct MeshBatchCacheTopology;
+struct MeshDataKey;
 struct Object;
 struct Scene;
 
@@ -52,6 +56,50 @@ bool BKE_mesh_runtime_reset_edit_data(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_geometry(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_cache(struct Mesh *mesh);
 
+void *BKE_mesh_runtime_batch_cache_take(struct Mesh *mesh,
+                                        struct MeshBatchCacheTopology **r_topology);
+void BKE_mesh_runtime_batch_cache_restore(struct Mesh *mesh,
+                                          const struct Mesh *mesh_input,
+                                          void *batch_cache,
+                                          struct MeshBatchCacheTopology *topology);
+void BKE_mesh_runtime_batch_cache_discard(void *batch_cache,
+                                          struct MeshBatchCacheTopology *topology);
+
+struct Mesh *BKE_mesh_copy_for_eval_shared_topology(struct Mesh *source);
+void BKE_mesh_runtime_shared_topology_ensure_mutable(struct Mesh *mesh);
+void BKE_mesh_runtime_shared_topology_release(struct Mesh *mesh);
+
+struct MeshDataKey *BKE_mesh_runtime_data_key_new(const struct Mesh *mesh,
+                                                  const bool use_positions,
+                                                  const bool allow_owned_layers);
+bool BKE_mesh_runtime_data_key_matches(const struct MeshDataKey *key, const struct Mesh *mesh);
+void BKE_mesh_runtime_data_key_free(struct MeshDataKey *key);
+
+typedef void (*MeshDataFn)(void *user_data, const void *data, size_t size);
+void BKE_mesh_runtime_data_foreach(const struct Mesh *mesh,
+                                   const bool use_positions,
+                                   MeshDataFn fn,
+                                   void *user_data);
+
+/** Everything the shared result of a modifier stack depends on, besides its input mesh. */
+typedef struct MeshEvalSharedKey {
+  /** Serialized settings of the modifiers and of the object. */
+  const void *data;
+  size_t data_len;
+  /** Hash of #data, to quickly skip different keys. */
+  uint32_t hash;
+} MeshEvalSharedKey;
+
+struct Mesh *BKE_mesh_runtime_eval_shared_get(struct Mesh *mesh,
+                                              const MeshEvalSharedKey *key,
+                                              const int update);
+void BKE_mesh_runtime_eval_shared_store(struct Mesh *mesh,
+                                        struct Mesh *mesh_eval,
+                                        const MeshEvalSharedKey *key,
+                                        const int update);
+void BKE_mesh_runtime_eval_shared_clear(struct Mesh *mesh);
+bool BKE_mesh_runtime_eval_shared_release(struct Mesh *mesh_eval);
+
 void BKE_mesh_runtime_verttri_from_looptri(struct MVertTri *r_verttri,
                                            const struct MLoop *mloop,
                                            const struct MLoopTri *looptri,
@@ -91,6 +139,9 @@ struct Mesh *mesh_create_eval_no_deform_render(struct Depsgraph *depsgraph,
                                                struct Object *ob,
                                                const struct CustomData_MeshMasks *dataMask);
 
+const struct Mesh *mesh_modifier_stack_cache_result(const struct Object *ob);
+void mesh_modifier_stack_cache_free(struct Object *ob);
+
 void BKE_mesh_runtime_eval_to_meshkey(struct Mesh *me_deformed,
                                       struct Mesh *me,
                                       struct KeyBlock *kb);
@@ -29,4 +29,6 @@ typedef enum eMeshBatchDirtyMode {
   BKE_MESH_BATCH_DIRTY_SHADING,
   BKE_MESH_BATCH_DIRTY_UVEDIT_ALL,
   BKE_MESH_BATCH_DIRTY_UVEDIT_SELECT,
+  /** Only vertex positions changed, the topology and all other attributes are unchanged. */
+  BKE_MESH_BATCH_DIRTY_DEFORM,
 } eMeshBatchDirtyMode;
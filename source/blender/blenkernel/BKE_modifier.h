@@ -155,6 +155,15 @@ typedef struct ModifierEvalContext {
   ModifierApplyFlag flag;
 } ModifierEvalContext;
 
+/* Deformation of ranges of vertices, see #ModifierTypeInfo.deformVertsPointwise. */
+typedef struct ModifierPointwiseDeform {
+  /** Deform the vertices from \a start up to \a end, called from multiple threads at once. */
+  void (*deform_range)(void *userdata, float (*vertexCos)[3], int start, int end);
+  /** Free \a userdata once all vertices are deformed. */
+  void (*free_userdata)(void *userdata);
+  void *userdata;
+} ModifierPointwiseDeform;
+
 typedef struct ModifierTypeInfo {
   /* The user visible name for this modifier */
   char name[32];
@@ -228,6 +237,23 @@ typedef struct ModifierTypeInfo {
                            float (*defMats)[3][3],
                            int numVerts);
 
+  /**
+   * Optional, for deform types which move every vertex independently of the others. Prepare
+   * the deformation in \a r_deform, so that consecutive modifiers which support this can be
+   * evaluated in a single parallel loop over chunks of vertices, instead of each of them going
+   * over all vertices in turn. The vertex coordinates are not available here, since earlier
+   * modifiers of the same loop did not deform them yet.
+   *
+   * Returns false when the current settings need more than the vertex itself (like the normals
+   * of the deformed mesh), in which case #deformVerts is used. A null
+   * #ModifierPointwiseDeform.deform_range means the modifier has no effect.
+   */
+  bool (*deformVertsPointwise)(struct ModifierData *md,
+                               const struct ModifierEvalContext *ctx,
+                               struct Mesh *mesh,
+                               int numVerts,
+                               struct ModifierPointwiseDeform *r_deform);
+
   /********************* Non-deform modifier functions *********************/
 
   /**
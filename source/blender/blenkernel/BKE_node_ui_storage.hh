@@ -22,6 +22,7 @@
 #include "BLI_map.hh"
 #include "BLI_session_uuid.h"
 #include "BLI_set.hh"
+#include "BLI_timeit.hh"
 
 #include "DNA_ID.h"
 #include "DNA_modifier_types.h"
@@ -80,6 +81,16 @@ struct NodeWarning {
 struct NodeUIStorage {
   blender::Vector<NodeWarning> warnings;
   blender::Set<std::string> attribute_name_hints;
+  /**
+   * Accumulated time spent executing the node in the last evaluation. The statistics are only
+   * recorded with #G_DEBUG_NODES_TIME.
+   */
+  blender::timeit::Nanoseconds exec_time{0};
+  /**
+   * Change of the allocated memory caused by executing the node. This is only an approximation,
+   * since other threads may allocate or free memory at the same time.
+   */
+  int64_t exec_memory_delta = 0;
 };
 
 struct NodeTreeUIStorage {
@@ -104,3 +115,9 @@ void BKE_nodetree_attribute_hint_add(bNodeTree &ntree,
                                      const NodeTreeEvaluationContext &context,
                                      const bNode &node,
                                      const blender::StringRef attribute_name);
+
+void BKE_nodetree_exec_stats_add(bNodeTree &ntree,
+                                 const NodeTreeEvaluationContext &context,
+                                 const bNode &node,
+                                 const blender::timeit::Nanoseconds exec_time,
+                                 const int64_t exec_memory_delta);
@@ -602,6 +602,10 @@ typedef struct SculptSession {
   /* This flag prevents PBVH from being freed when creating the vp_handle for texture paint. */
   bool building_vp_handle;
 
+  /* The PBVH was kept over a mesh update, to be refit after evaluation when the topology did not
+   * change or rebuilt otherwise, see #BKE_sculpt_object_pbvh_ensure. */
+  bool pbvh_refit_pending;
+
   /**
    * ID data is older than sculpt-mode data.
    * Set #Main.is_memfile_undo_flush_needed when enabling.
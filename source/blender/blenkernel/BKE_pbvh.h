@@ -127,6 +127,12 @@ void BKE_pbvh_build_bmesh(PBVH *pbvh,
                           const int cd_face_node_offset);
 void BKE_pbvh_free(PBVH *pbvh);
 
+/* Refit: recompute the bounding boxes of an existing tree after its vertices moved,
+ * keeping the node layout and draw buffers. Much cheaper than a rebuild. */
+void BKE_pbvh_refit(PBVH *pbvh);
+bool BKE_pbvh_mesh_topology_matches(const PBVH *pbvh, const struct Mesh *mesh);
+void BKE_pbvh_refit_mesh(PBVH *pbvh, struct Mesh *mesh);
+
 /* Hierarchical Search in the BVH, two methods:
  * - for each hit calling a callback
  * - gather nodes in an array (easy to multithread) */
@@ -0,0 +1,90 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/** \file
+ * \ingroup bke
+ *
+ * A uniform grid over the points of a point cloud, used to answer nearest neighbor and radius
+ * queries for many query positions at once. The grid is built in parallel and cached on the point
+ * cloud, so that multiple nodes can use it without building their own acceleration structure.
+ */
+
+#include "BLI_array.hh"
+#include "BLI_float3.hh"
+#include "BLI_span.hh"
+
+struct PointCloud;
+
+namespace blender::bke {
+
+class PointCloudSpatialIndex {
+ private:
+  float3 min_;
+  float cell_size_;
+  int dims_[3];
+  /** Start of the points of every cell in #sorted_indices_, with one extra element at the end. */
+  Array<int> cell_offsets_;
+  /** Point indices, sorted by cell. Points in the same cell are sorted by index. */
+  Array<int> sorted_indices_;
+  /** Positions in the order of #sorted_indices_, to keep queries cache friendly. */
+  Array<float3> sorted_positions_;
+
+ public:
+  PointCloudSpatialIndex(Span<float3> positions);
+
+  int size() const
+  {
+    return sorted_indices_.size();
+  }
+
+  /**
+   * Find the \a k nearest points for every query position. The results for query \a i are stored
+   * at `i * k` in the output spans, sorted by distance. When there are fewer than \a k points,
+   * the remaining indices are set to -1 and the distances to #FLT_MAX.
+   */
+  void find_nearest_n(Span<float3> query_positions,
+                      int k,
+                      MutableSpan<int> r_indices,
+                      MutableSpan<float> r_distances_sq) const;
+
+  /**
+   * Find all points within \a radius of every query position. The result is stored compactly:
+   * the points of query \a i are `r_indices[r_offsets[i]]` to `r_indices[r_offsets[i + 1]]`.
+   * \a r_offsets must have space for one more element than there are query positions.
+   */
+  void find_in_radius(Span<float3> query_positions,
+                      float radius,
+                      MutableSpan<int> r_offsets,
+                      Array<int> &r_indices) const;
+
+ private:
+  int cell_coord(float value, int axis) const;
+  int cell_index(int x, int y, int z) const;
+  void find_nearest_n_single(const float3 &position,
+                             int k,
+                             MutableSpan<int> r_indices,
+                             MutableSpan<float> r_distances_sq) const;
+  template<typename Func>
+  void foreach_point_in_radius(const float3 &position, float radius, const Func &func) const;
+};
+
+}  // namespace blender::bke
+
+const blender::bke::PointCloudSpatialIndex &BKE_pointcloud_spatial_index_ensure(
+    const PointCloud &pointcloud);
+void BKE_pointcloud_spatial_index_free(PointCloud *pointcloud);
@@ -190,6 +190,13 @@ typedef struct Subdiv {
     /* Indexed by base face index, element indicates total number of ptex
      * faces created for preceding base faces. */
     int *face_ptex_offset;
+    /* Limit stencils of vertices of the mesh created by BKE_subdiv_to_mesh(). Built when the same
+     * coarse topology and resolution is evaluated again, and reused for as long as they stay the
+     * same. */
+    struct SubdivMeshLimitStencils *mesh_limit_stencils;
+    /* Mesh created by BKE_subdiv_to_mesh() and a key of the coarse data it was created from,
+     * used to only evaluate positions and normals when nothing else changed. */
+    struct SubdivMeshTopologyCache *mesh_topology;
   } cache_;
 } Subdiv;
 
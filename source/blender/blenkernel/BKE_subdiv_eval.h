@@ -30,6 +30,7 @@ extern "C" {
 #endif
 
 struct Mesh;
+struct OpenSubdiv_LimitStencils;
 struct Subdiv;
 
 /* Returns true if evaluator is ready for use. */
@@ -145,6 +146,45 @@ void BKE_subdiv_eval_limit_patch_resolution_point_and_short_normal(struct Subdiv
                                                                    const int normal_offset,
                                                                    const int normal_stride);
 
+/* Limit stencils.
+ *
+ * Weights of coarse vertices for a fixed set of points on the limit surface. Building them is
+ * expensive, but afterwards positions and derivatives of all the points are evaluated as a single
+ * sparse matrix-vector product, which is much faster than per-point patch evaluation. Useful for
+ * deforming meshes, where topology and the set of points stay the same between updates. */
+
+typedef struct SubdivLimitStencils {
+  int num_points;
+  /* Patch coordinates of the points. Points with ptex face index of -1 are not evaluated and
+   * have zero position and derivatives. */
+  int *ptex_face_indices;
+  float (*uvs)[2];
+
+  struct OpenSubdiv_LimitStencils *opensubdiv_stencils;
+} SubdivLimitStencils;
+
+/* Allocate stencils for the given number of points.
+ * Patch coordinates of the points are to be filled in by the caller. */
+SubdivLimitStencils *BKE_subdiv_eval_limit_stencils_new(const int num_points);
+void BKE_subdiv_eval_limit_stencils_free(SubdivLimitStencils *stencils);
+
+/* Calculate weights of the points. Requires the evaluator to be created.
+ * Returns false if stencils are not supported by the evaluator (uniform subdivision). */
+bool BKE_subdiv_eval_limit_stencils_build(struct Subdiv *subdiv, SubdivLimitStencils *stencils);
+
+/* Evaluate positions and derivatives of all points of the stencils, using coarse positions of the
+ * given mesh (or coarse_vertex_cos, when it is not NULL).
+ *
+ * NOTE: The evaluator is expected to be refined for the same positions, it is used for points
+ * with degenerate derivatives. */
+void BKE_subdiv_eval_limit_stencils(struct Subdiv *subdiv,
+                                    const SubdivLimitStencils *stencils,
+                                    const struct Mesh *mesh,
+                                    const float (*coarse_vertex_cos)[3],
+                                    float (*r_P)[3],
+                                    float (*r_dPdu)[3],
+                                    float (*r_dPdv)[3]);
+
 #ifdef __cplusplus
 }
 #endif
@@ -31,6 +31,8 @@ extern "C" {
 
 struct Mesh;
 struct Subdiv;
+struct SubdivMeshLimitStencils;
+struct SubdivMeshTopologyCache;
 
 typedef struct SubdivToMeshSettings {
   /* Resolution at which regular ptex (created for quad polygon) are being
@@ -49,6 +51,14 @@ struct Mesh *BKE_subdiv_to_mesh(struct Subdiv *subdiv,
                                 const SubdivToMeshSettings *settings,
                                 const struct Mesh *coarse_mesh);
 
+/* Free limit stencils cached by BKE_subdiv_to_mesh(). */
+void BKE_subdiv_mesh_limit_stencils_free(struct SubdivMeshLimitStencils *mesh_stencils);
+void BKE_subdiv_mesh_topology_cache_free(struct SubdivMeshTopologyCache *cache);
+/* Free the result kept by BKE_subdiv_to_mesh() for coarse meshes with unchanged data. Needed when
+ * data the coarse mesh references could have been freed, since the cache is matched by data
+ * pointers. */
+void BKE_subdiv_mesh_topology_cache_clear(struct Subdiv *subdiv);
+
 #ifdef __cplusplus
 }
 #endif
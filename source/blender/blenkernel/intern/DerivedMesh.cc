@@ -23,24 +23,29 @@
 
 #include <climits>
 #include <cstring>
+#include <string>
 
 #include "MEM_guardedalloc.h"
 
 #include "DNA_cloth_types.h"
 #include "DNA_customdata_types.h"
+#include "DNA_genfile.h"
 #include "DNA_key_types.h"
 #include "DNA_material_types.h"
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
+#include "DNA_sdna_types.h"
 
 #include "BLI_array.h"
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_float2.hh"
+#include "BLI_hash_mm2a.h"
 #include "BLI_linklist.h"
 #include "BLI_math.h"
+#include "BLI_session_uuid.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
 #include "BLI_vector.hh"
@@ -74,6 +79,8 @@
 #include "DEG_depsgraph.h"
 #include "DEG_depsgraph_query.h"
 
+#include "PIL_time.h"
+
 #include "CLG_log.h"
 
 #ifdef WITH_OPENSUBDIV
@@ -967,6 +974,643 @@ static Mesh *modifier_modify_mesh_and_geometry_set(ModifierData *md,
   return mesh_output;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Modifier Stack Result Cache
+ *
+ * The result of one constructive modifier can be kept on the evaluated object between updates,
+ * so that changing modifiers further down the stack restarts evaluation from that result
+ * instead of from the original mesh. The modifier is either chosen by the user with
+ * #eModifierFlag_CacheResult, or with #OB_MODIFIER_CACHE_AUTO it is the one that took longest
+ * to evaluate during the last full evaluation.
+ *
+ * The cached result is only reused when nothing that went into it has changed: the input mesh,
+ * the settings and order of all modifiers up to the cached one, the objects they reference and
+ * the data layers that the rest of the stack requests.
+ * \{ */
+
+/* Auto-caching is only worth the memory for modifiers which are noticeably slow. */
+#define MODIFIER_STACK_CACHE_AUTO_MIN_TIME 0.005
+
+/** State of an enabled modifier at or before the cached one. */
+struct ModifierStackCachePrefixItem {
+  SessionUUID session_uuid;
+  int type;
+  int mode;
+  /** Copy of the type specific settings which follow the #ModifierData header. */
+  blender::Vector<char> settings;
+};
+
+/** Everything the cached result depends on, besides the input mesh and the referenced IDs. */
+struct ModifierStackCacheKey {
+  blender::Vector<ModifierStackCachePrefixItem> prefix;
+  /** Data layers requested from the cached modifier, includes those of the rest of the stack. */
+  CustomData_MeshMasks mask;
+  int required_mode;
+  int totcol;
+  std::string vertex_group_names;
+  /** All IDs used by the modifiers are objects, other ID types are not tracked. */
+  bool ids_supported;
+  /** One of the used objects was updated in the current depsgraph evaluation. */
+  bool ids_changed;
+  /** One of the modifiers reported an error. */
+  bool has_error;
+};
+
+struct ModifierStackCache {
+  /** Modifier whose result is cached. */
+  SessionUUID session_uuid = {0};
+  /** Result of that modifier, which owns all its data layers. */
+  Mesh *mesh = nullptr;
+  /** Coordinates after the leading deform-only modifiers, null when there are none. */
+  float (*deformed_verts)[3] = nullptr;
+  ModifierStackCacheKey key;
+  /** Layers of the original input mesh, see #modifier_stack_cache_input_matches. */
+  MeshDataKey *input_key = nullptr;
+  /** Hash of the data of the input mesh and its shape keys. */
+  uint64_t input_hash = 0;
+
+  /** The constructive modifier that took longest in the last full evaluation. */
+  SessionUUID auto_session_uuid = {0};
+};
+
+static void modifier_stack_cache_clear(ModifierStackCache *cache)
+{
+  if (cache->mesh != nullptr) {
+    BKE_id_free(nullptr, cache->mesh);
+    cache->mesh = nullptr;
+  }
+  MEM_SAFE_FREE(cache->deformed_verts);
+  cache->key.prefix.clear();
+  if (cache->input_key != nullptr) {
+    BKE_mesh_runtime_data_key_free(cache->input_key);
+    cache->input_key = nullptr;
+  }
+}
+
+static ModifierStackCache *modifier_stack_cache_ensure(Object *ob)
+{
+  if (ob->runtime.modifier_stack_cache == nullptr) {
+    ob->runtime.modifier_stack_cache = OBJECT_GUARDED_NEW(ModifierStackCache);
+  }
+  return ob->runtime.modifier_stack_cache;
+}
+
+void mesh_modifier_stack_cache_free(Object *ob)
+{
+  ModifierStackCache *cache = ob->runtime.modifier_stack_cache;
+  if (cache != nullptr) {
+    modifier_stack_cache_clear(cache);
+    OBJECT_GUARDED_DELETE(cache, ModifierStackCache);
+    ob->runtime.modifier_stack_cache = nullptr;
+  }
+}
+
+/**
+ * The cached modifier result of an evaluated object, or null when there is none.
+ */
+const Mesh *mesh_modifier_stack_cache_result(const Object *ob)
+{
+  const ModifierStackCache *cache = ob->runtime.modifier_stack_cache;
+  return cache ? cache->mesh : nullptr;
+}
+
+static bool modifier_stack_cache_is_id_type(const SDNA *sdna, const short type)
+{
+  const int struct_nr = DNA_struct_find_nr(sdna, sdna->types[type]);
+  if (struct_nr == -1) {
+    return false;
+  }
+  const SDNA_Struct *struct_info = sdna->structs[struct_nr];
+  return struct_info->members_len > 0 && STREQ(sdna->types[struct_info->members[0].type], "ID");
+}
+
+/**
+ * Check whether the settings of the modifier point to data which isn't an ID, like a curve
+ * mapping or bind data. The settings bytes only contain the address of that data, and a changed
+ * copy can be allocated at the address of the previous one. Referenced IDs are tracked with
+ * their recalc flags instead.
+ */
+static bool modifier_stack_cache_has_data_pointers(const ModifierData *md,
+                                                   const ModifierTypeInfo *mti)
+{
+  const SDNA *sdna = DNA_sdna_current_get();
+  const int struct_nr = DNA_struct_find_nr(sdna, mti->structName);
+  if (struct_nr == -1) {
+    return true;
+  }
+  const SDNA_Struct *struct_info = sdna->structs[struct_nr];
+  int offset = 0;
+  for (int i = 0; i < struct_info->members_len; i++) {
+    const SDNA_StructMember *member = &struct_info->members[i];
+    const char *name = sdna->names[member->name];
+    const int size = DNA_elem_size_nr(sdna, member->type, member->name);
+    const bool is_pointer = (name[0] == '*' || name[1] == '*');
+    if (is_pointer && offset >= (int)sizeof(ModifierData) &&
+        !modifier_stack_cache_is_id_type(sdna, member->type)) {
+      const void *const *pointers = (const void *const *)((const char *)md + offset);
+      for (int j = 0; j < size / (int)sizeof(void *); j++) {
+        if (pointers[j] != nullptr) {
+          return true;
+        }
+      }
+    }
+    offset += size;
+  }
+  return false;
+}
+
+/**
+ * Modifiers which depend on time, write results for other parts of Blender or output geometry
+ * other than a mesh have to run on every evaluation, they can't be part of a cached result.
+ * Neither can modifiers whose settings can't be compared.
+ */
+static bool modifier_stack_cache_supports_modifier(ModifierData *md)
+{
+  const ModifierTypeInfo *mti = BKE_modifier_get_info((ModifierType)md->type);
+  if (mti->dependsOnTime && mti->dependsOnTime(md)) {
+    return false;
+  }
+  if (modifier_stack_cache_has_data_pointers(md, mti)) {
+    return false;
+  }
+  if (mti->flags & eModifierTypeFlag_UsesPointCache) {
+    return false;
+  }
+  if (mti->modifyGeometrySet != nullptr) {
+    return false;
+  }
+  return !ELEM(md->type,
+               eModifierType_ParticleSystem,
+               eModifierType_Surface,
+               eModifierType_Collision,
+               eModifierType_DynamicPaint,
+               eModifierType_Fluid);
+}
+
+/**
+ * Find the modifier whose result should be cached: the last enabled constructive modifier
+ * which is flagged, or which was chosen automatically, and which only follows supported
+ * modifiers.
+ */
+static ModifierData *modifier_stack_cache_modifier_find(const Scene *scene,
+                                                        const Object *ob,
+                                                        ModifierData *firstmd,
+                                                        const int required_mode)
+{
+  const ModifierStackCache *cache = ob->runtime.modifier_stack_cache;
+  const bool use_auto = (ob->modifier_cache_flag & OB_MODIFIER_CACHE_AUTO) && cache != nullptr &&
+                        BLI_session_uuid_is_generated(&cache->auto_session_uuid);
+  ModifierData *cache_md = nullptr;
+
+  for (ModifierData *md = firstmd; md; md = md->next) {
+    if (!BKE_modifier_is_enabled(scene, md, required_mode)) {
+      continue;
+    }
+    if (!modifier_stack_cache_supports_modifier(md)) {
+      break;
+    }
+    const ModifierTypeInfo *mti = BKE_modifier_get_info((ModifierType)md->type);
+    if (mti->type == eModifierTypeType_OnlyDeform) {
+      continue;
+    }
+    if ((md->flag & eModifierFlag_CacheResult) ||
+        (use_auto && BLI_session_uuid_is_equal(&md->session_uuid, &cache->auto_session_uuid))) {
+      cache_md = md;
+    }
+  }
+  return cache_md;
+}
+
+/** The input mesh of the cached modifier in the current evaluation. */
+struct ModifierStackCacheInput {
+  const Mesh *mesh;
+  /** The mesh or its shape keys were tagged for an update in this evaluation. */
+  bool is_tagged;
+  bool has_hash;
+  uint64_t hash;
+};
+
+static void modifier_stack_cache_input_init(const Mesh *mesh, ModifierStackCacheInput *r_input)
+{
+  r_input->mesh = mesh;
+  r_input->is_tagged = (mesh->id.recalc & ID_RECALC_ALL) ||
+                       (mesh->key != nullptr && (mesh->key->id.recalc & ID_RECALC_ALL));
+  r_input->has_hash = false;
+  r_input->hash = 0;
+}
+
+static void modifier_stack_cache_input_hash_fn(void *user_data, const void *data, size_t size)
+{
+  BLI_HashMurmur2A *mm2 = (BLI_HashMurmur2A *)user_data;
+  BLI_hash_mm2a_add(&mm2[0], (const unsigned char *)data, size);
+  BLI_hash_mm2a_add(&mm2[1], (const unsigned char *)data, size);
+}
+
+/**
+ * Hash of all data of the input mesh the cached result depends on. The data is read at most
+ * once per evaluation, and only when needed. Two 32 bit hashes with different seeds are
+ * combined, since the data itself isn't kept to compare it when the hashes match.
+ */
+static uint64_t modifier_stack_cache_input_hash_ensure(ModifierStackCacheInput *input)
+{
+  if (input->has_hash) {
+    return input->hash;
+  }
+  BLI_HashMurmur2A mm2[2];
+  BLI_hash_mm2a_init(&mm2[0], 0);
+  BLI_hash_mm2a_init(&mm2[1], 1);
+  const Mesh *mesh = input->mesh;
+  BKE_mesh_runtime_data_foreach(mesh, true, modifier_stack_cache_input_hash_fn, mm2);
+
+  /* Shape keys are applied by a virtual modifier, which has no settings of its own. */
+  const Key *key = mesh->key;
+  if (key != nullptr) {
+    auto add_data = [&](const void *data, const size_t size) {
+      modifier_stack_cache_input_hash_fn(mm2, data, size);
+    };
+    add_data(&key->type, sizeof(key->type));
+    add_data(&key->ctime, sizeof(key->ctime));
+    LISTBASE_FOREACH (const KeyBlock *, kb, &key->block) {
+      add_data(&kb->pos, sizeof(kb->pos));
+      add_data(&kb->curval, sizeof(kb->curval));
+      add_data(&kb->type, sizeof(kb->type));
+      add_data(&kb->relative, sizeof(kb->relative));
+      add_data(&kb->flag, sizeof(kb->flag));
+      add_data(kb->vgroup, strlen(kb->vgroup) + 1);
+      add_data(&kb->totelem, sizeof(kb->totelem));
+      add_data(kb->data, (size_t)key->elemsize * (size_t)kb->totelem);
+    }
+  }
+
+  input->hash = ((uint64_t)BLI_hash_mm2a_end(&mm2[0]) << 32) | BLI_hash_mm2a_end(&mm2[1]);
+  input->has_hash = true;
+  return input->hash;
+}
+
+/**
+ * Check whether the input mesh is the same as the input of the cached result.
+ *
+ * The layers of the original mesh are compared by pointer, unlike the ones of the evaluated
+ * copy they are not reallocated when the mesh is copied again for evaluation. Data that is
+ * changed in place is detected with the depsgraph tags of the mesh. Those can't tell changes
+ * apart from modifier edits, since tagging the object for a geometry update tags its data too,
+ * so the data is hashed when the mesh is tagged.
+ */
+static bool modifier_stack_cache_input_matches(const ModifierStackCache *cache,
+                                               ModifierStackCacheInput *input)
+{
+  const Mesh *mesh_orig = (const Mesh *)DEG_get_original_id((ID *)&input->mesh->id);
+  if (cache->input_key == nullptr ||
+      !BKE_mesh_runtime_data_key_matches(cache->input_key, mesh_orig)) {
+    return false;
+  }
+  return !input->is_tagged || modifier_stack_cache_input_hash_ensure(input) == cache->input_hash;
+}
+
+static void modifier_stack_cache_key_id_walk(void *user_data,
+                                             Object *UNUSED(ob),
+                                             ID **idpoin,
+                                             int UNUSED(cb_flag))
+{
+  ModifierStackCacheKey *key = (ModifierStackCacheKey *)user_data;
+  const ID *id = *idpoin;
+  if (id == nullptr) {
+    return;
+  }
+  if (GS(id->name) != ID_OB) {
+    key->ids_supported = false;
+  }
+  else if (id->recalc != 0) {
+    key->ids_changed = true;
+  }
+}
+
+static void modifier_stack_cache_key_build(const Scene *scene,
+                                           Object *ob,
+                                           ModifierData *firstmd,
+                                           const ModifierData *cache_md,
+                                           const CustomData_MeshMasks *mask,
+                                           const int required_mode,
+                                           ModifierStackCacheKey *r_key)
+{
+  r_key->prefix.clear();
+  r_key->mask = *mask;
+  r_key->required_mode = required_mode;
+  r_key->totcol = ob->totcol;
+  r_key->vertex_group_names.clear();
+  LISTBASE_FOREACH (const bDeformGroup *, dg, &ob->defbase) {
+    r_key->vertex_group_names.append(dg->name);
+    r_key->vertex_group_names.push_back('\0');
+  }
+  r_key->ids_supported = true;
+  r_key->ids_changed = false;
+  r_key->has_error = false;
+
+  for (ModifierData *md = firstmd; md; md = md->next) {
+    if (BKE_modifier_is_enabled(scene, md, required_mode)) {
+      const ModifierTypeInfo *mti = BKE_modifier_get_info((ModifierType)md->type);
+      ModifierStackCachePrefixItem item;
+      item.session_uuid = md->session_uuid;
+      item.type = md->type;
+      item.mode = md->mode;
+      const char *settings = (const char *)md + sizeof(ModifierData);
+      item.settings.extend(settings, mti->structSize - (int)sizeof(ModifierData));
+      r_key->prefix.append(std::move(item));
+
+      if (mti->foreachIDLink) {
+        mti->foreachIDLink(md, ob, modifier_stack_cache_key_id_walk, r_key);
+      }
+      r_key->has_error |= (md->error != nullptr);
+    }
+    if (md == cache_md) {
+      break;
+    }
+  }
+}
+
+static bool modifier_stack_cache_key_equals(const ModifierStackCacheKey *a,
+                                            const ModifierStackCacheKey *b)
+{
+  if (memcmp(&a->mask, &b->mask, sizeof(a->mask)) != 0 ||
+      a->required_mode != b->required_mode || a->totcol != b->totcol ||
+      a->vertex_group_names != b->vertex_group_names ||
+      a->prefix.size() != b->prefix.size()) {
+    return false;
+  }
+  for (const int i : a->prefix.index_range()) {
+    const ModifierStackCachePrefixItem &item_a = a->prefix[i];
+    const ModifierStackCachePrefixItem &item_b = b->prefix[i];
+    if (!BLI_session_uuid_is_equal(&item_a.session_uuid, &item_b.session_uuid) ||
+        item_a.type != item_b.type ||
+        item_a.mode != item_b.mode || item_a.settings.size() != item_b.settings.size() ||
+        memcmp(item_a.settings.data(), item_b.settings.data(), item_a.settings.size()) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Check whether the cached result can be used instead of evaluating the stack up to and
+ * including \a cache_md. Referenced objects are checked with the recalc flags of their
+ * evaluated copies, which tell what changed in the current depsgraph evaluation.
+ */
+static bool modifier_stack_cache_is_valid(const ModifierStackCache *cache,
+                                          const Scene *scene,
+                                          Object *ob,
+                                          ModifierStackCacheInput *input,
+                                          const ModifierStackCacheKey *key,
+                                          const ModifierData *cache_md)
+{
+  if (cache == nullptr || cache->mesh == nullptr ||
+      !BLI_session_uuid_is_equal(&cache->session_uuid, &cache_md->session_uuid)) {
+    return false;
+  }
+  /* The object transform is tagged when the object becomes visible again, in which case objects
+   * used by the modifiers could have changed without this object being evaluated. */
+  if ((ob->id.recalc & ID_RECALC_TRANSFORM) || (scene->id.recalc & ID_RECALC_COPY_ON_WRITE)) {
+    return false;
+  }
+  if (!key->ids_supported || key->ids_changed) {
+    return false;
+  }
+  if (!modifier_stack_cache_key_equals(&cache->key, key)) {
+    return false;
+  }
+  return modifier_stack_cache_input_matches(cache, input);
+}
+
+/** Keep the result of \a cache_md for the following evaluations, takes ownership of
+ * \a deformed_verts. */
+static void modifier_stack_cache_store(Object *ob,
+                                       const ModifierData *cache_md,
+                                       ModifierStackCacheInput *input,
+                                       Mesh *mesh,
+                                       float (*deformed_verts)[3],
+                                       ModifierStackCacheKey *key)
+{
+  ModifierStackCache *cache = modifier_stack_cache_ensure(ob);
+  Mesh *mesh_copy = BKE_mesh_copy_for_eval(mesh, false);
+  modifier_stack_cache_clear(cache);
+  cache->session_uuid = cache_md->session_uuid;
+  cache->mesh = mesh_copy;
+  cache->deformed_verts = deformed_verts;
+  cache->key = std::move(*key);
+  const Mesh *mesh_orig = (const Mesh *)DEG_get_original_id((ID *)&input->mesh->id);
+  cache->input_key = BKE_mesh_runtime_data_key_new(mesh_orig, true, true);
+  cache->input_hash = modifier_stack_cache_input_hash_ensure(input);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Shared Evaluated Meshes
+ *
+ * Objects using the same mesh with the same modifier settings share one evaluated mesh, see
+ * #BKE_mesh_runtime_eval_shared_get.
+ * \{ */
+
+static void mesh_eval_shared_id_walk(void *user_data,
+                                     Object *UNUSED(ob),
+                                     ID **idpoin,
+                                     int UNUSED(cb_flag))
+{
+  bool *r_has_ids = (bool *)user_data;
+  if (*idpoin != nullptr) {
+    *r_has_ids = true;
+  }
+}
+
+/**
+ * Serialize everything the result of the modifier stack of the object depends on, besides its
+ * mesh, into \a r_key_data.
+ * \return False when the result depends on more than that (other IDs, time, the object's
+ * transform, mode or physics), so it can't be shared with other objects.
+ */
+static bool mesh_eval_shared_key_build(struct Depsgraph *depsgraph,
+                                       const Scene *scene,
+                                       Object *ob,
+                                       const CustomData_MeshMasks *mask,
+                                       const bool need_mapping,
+                                       blender::Vector<char> &r_key_data)
+{
+  const Mesh *mesh = (const Mesh *)ob->data;
+  if (ob->mode != OB_MODE_OBJECT || ob->sculpt != nullptr || mesh->key != nullptr ||
+      ob->rigidbody_object != nullptr || !BLI_listbase_is_empty(&ob->particlesystem)) {
+    return false;
+  }
+  /* Modifiers like Displace in global space use the object matrix. */
+  if (DEG_get_eval_flags_for_id(depsgraph, &ob->id) &
+      (DAG_EVAL_NEED_SHRINKWRAP_BOUNDARY | DAG_EVAL_MODIFIERS_USE_TRANSFORM)) {
+    return false;
+  }
+
+  const bool use_render = (DEG_get_mode(depsgraph) == DAG_EVAL_RENDER);
+  const int required_mode = use_render ? eModifierMode_Render : eModifierMode_Realtime;
+
+  auto add_data = [&](const void *data, const size_t size) {
+    r_key_data.extend((const char *)data, (int64_t)size);
+  };
+  add_data(mask, sizeof(*mask));
+  add_data(&need_mapping, sizeof(need_mapping));
+  add_data(&required_mode, sizeof(required_mode));
+  add_data(&ob->totcol, sizeof(ob->totcol));
+  LISTBASE_FOREACH (const bDeformGroup *, dg, &ob->defbase) {
+    add_data(dg->name, strlen(dg->name) + 1);
+  }
+
+  bool has_modifiers = false;
+  bool has_ids = false;
+  VirtualModifierData virtual_modifier_data;
+  ModifierData *firstmd = BKE_modifiers_get_virtual_modifierlist(ob, &virtual_modifier_data);
+  for (ModifierData *md = firstmd; md; md = md->next) {
+    if (!BKE_modifier_is_enabled(scene, md, required_mode)) {
+      continue;
+    }
+    if (!modifier_stack_cache_supports_modifier(md) ||
+        ELEM(md->type, eModifierType_Multires, eModifierType_ShapeKey)) {
+      return false;
+    }
+    const ModifierTypeInfo *mti = BKE_modifier_get_info((ModifierType)md->type);
+    if (mti->foreachIDLink) {
+      mti->foreachIDLink(md, ob, mesh_eval_shared_id_walk, &has_ids);
+      if (has_ids) {
+        return false;
+      }
+    }
+    add_data(&md->type, sizeof(md->type));
+    add_data(&md->mode, sizeof(md->mode));
+    add_data((const char *)md + sizeof(ModifierData),
+             (size_t)mti->structSize - sizeof(ModifierData));
+    has_modifiers = true;
+  }
+  /* Without modifiers the input mesh is shared already. */
+  return has_modifiers;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Fused Deform Modifiers
+ *
+ * Consecutive deform-only modifiers which move every vertex independently of the others are
+ * evaluated in a single parallel loop over chunks of vertices. Each chunk goes through all the
+ * modifiers while its coordinates are in the CPU cache, instead of every modifier streaming the
+ * whole coordinate array through memory in turn.
+ * \{ */
+
+/* Small enough for the coordinates of a chunk to stay in the CPU cache between modifiers. */
+#define DEFORM_FUSED_CHUNK_SIZE 1024
+
+struct DeformFusedData {
+  blender::Span<ModifierPointwiseDeform> deforms;
+  float (*vertex_cos)[3];
+  int verts_num;
+};
+
+static void deform_fused_chunk_task(void *__restrict userdata,
+                                    const int chunk,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const DeformFusedData *data = (const DeformFusedData *)userdata;
+  const int start = chunk * DEFORM_FUSED_CHUNK_SIZE;
+  const int end = min_ii(start + DEFORM_FUSED_CHUNK_SIZE, data->verts_num);
+  for (const ModifierPointwiseDeform &deform : data->deforms) {
+    deform.deform_range(deform.userdata, data->vertex_cos, start, end);
+  }
+}
+
+static bool modifier_supports_fused_deform(Object *ob, ModifierData *md)
+{
+  const ModifierTypeInfo *mti = BKE_modifier_get_info((ModifierType)md->type);
+  if (mti->type != eModifierTypeType_OnlyDeform || mti->deformVertsPointwise == nullptr) {
+    return false;
+  }
+  if (mti->flags & eModifierTypeFlag_RequiresOriginalData) {
+    return false;
+  }
+  /* Original coordinates are added to the mesh before every modifier that needs them. */
+  if (mti->requiredDataMask) {
+    CustomData_MeshMasks mask = {0};
+    mti->requiredDataMask(ob, md, &mask);
+    if (mask.vmask & CD_MASK_ORCO) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Deform the coordinates with \a md, together with the directly following enabled modifiers
+ * when they all support #ModifierTypeInfo.deformVertsPointwise.
+ *
+ * \return The number of modifiers after \a md that were evaluated as well.
+ */
+static int modifier_deform_verts_fused(const Scene *scene,
+                                       Object *ob,
+                                       ModifierData *md,
+                                       const ModifierEvalContext *mectx,
+                                       Mesh *mesh,
+                                       float (*deformed_verts)[3],
+                                       const int num_deformed_verts,
+                                       const int required_mode,
+                                       const bool use_fusion)
+{
+  blender::Vector<ModifierPointwiseDeform, 8> deforms;
+  bool md_prepared = false;
+  int md_fused_num = 0;
+
+  if (use_fusion && modifier_supports_fused_deform(ob, md)) {
+    int md_index = 0;
+    for (ModifierData *md_iter = md; md_iter; md_iter = md_iter->next, md_index++) {
+      if (md_iter != md) {
+        if (!BKE_modifier_is_enabled(scene, md_iter, required_mode)) {
+          continue;
+        }
+        if (!modifier_supports_fused_deform(ob, md_iter)) {
+          break;
+        }
+      }
+      const ModifierTypeInfo *mti = BKE_modifier_get_info((ModifierType)md_iter->type);
+      ModifierPointwiseDeform deform = {nullptr};
+      if (!mti->deformVertsPointwise(md_iter, mectx, mesh, num_deformed_verts, &deform)) {
+        break;
+      }
+      if (deform.deform_range != nullptr) {
+        deforms.append(deform);
+      }
+      md_prepared = true;
+      md_fused_num = md_index;
+    }
+  }
+
+  if (!md_prepared) {
+    BKE_modifier_deform_verts(md, mectx, mesh, deformed_verts, num_deformed_verts);
+    return 0;
+  }
+
+  if (!deforms.is_empty()) {
+    DeformFusedData data;
+    data.deforms = deforms;
+    data.vertex_cos = deformed_verts;
+    data.verts_num = num_deformed_verts;
+
+    const int chunks_num = divide_ceil_u((uint)num_deformed_verts, DEFORM_FUSED_CHUNK_SIZE);
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    BLI_task_parallel_range(0, chunks_num, &data, deform_fused_chunk_task, &settings);
+  }
+
+  for (const ModifierPointwiseDeform &deform : deforms) {
+    if (deform.free_userdata) {
+      deform.free_userdata(deform.userdata);
+    }
+  }
+  return md_fused_num;
+}
+
+/** \} */
+
 static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
                                 Scene *scene,
                                 Object *ob,
@@ -1064,8 +1708,82 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
   /* Clear errors before evaluation. */
   BKE_modifiers_clear_errors(ob);
 
+  /* Find the modifier whose result is kept between evaluations, and restart from its cached
+   * result when nothing it depends on has changed. Only done for the regular evaluation of the
+   * object, and not when evaluating mapping or original coordinates, which are not cached. */
+  ModifierData *cache_md = nullptr;
+  CDMaskLink *cache_md_datamask = nullptr;
+  ModifierStackCacheKey cache_key;
+  ModifierStackCacheInput cache_input;
+  modifier_stack_cache_input_init(mesh_input, &cache_input);
+  const bool use_cache_auto = (ob->modifier_cache_flag & OB_MODIFIER_CACHE_AUTO) && use_cache &&
+                              !sculpt_mode;
+  if (use_cache_auto) {
+    modifier_stack_cache_ensure(ob);
+  }
+  if (use_cache && useDeform == 1 && index == -1 && !need_mapping && !sculpt_mode) {
+    cache_md = modifier_stack_cache_modifier_find(scene, ob, firstmd, required_mode);
+  }
+  if (cache_md) {
+    cache_md_datamask = datamasks;
+    for (ModifierData *md_iter = firstmd; md_iter != cache_md; md_iter = md_iter->next) {
+      cache_md_datamask = cache_md_datamask->next;
+    }
+    if ((cache_md_datamask->mask.vmask | final_datamask.vmask) &
+        (CD_MASK_ORCO | CD_MASK_CLOTH_ORCO)) {
+      cache_md = nullptr;
+    }
+  }
+  if (cache_md == nullptr) {
+    if (ob->runtime.modifier_stack_cache) {
+      if (use_cache_auto) {
+        modifier_stack_cache_clear(ob->runtime.modifier_stack_cache);
+      }
+      else if (use_cache) {
+        mesh_modifier_stack_cache_free(ob);
+      }
+    }
+  }
+  else {
+    modifier_stack_cache_key_build(scene,
+                                   ob,
+                                   firstmd,
+                                   cache_md,
+                                   &cache_md_datamask->mask,
+                                   required_mode,
+                                   &cache_key);
+  }
+  const bool use_cache_result = cache_md &&
+                                modifier_stack_cache_is_valid(ob->runtime.modifier_stack_cache,
+                                                              scene,
+                                                              ob,
+                                                              &cache_input,
+                                                              &cache_key,
+                                                              cache_md);
+  /* Consecutive point-wise deform modifiers are evaluated in one loop, except when stopping at
+   * a given modifier or when modifiers are skipped individually. */
+  const bool use_deform_fusion = useDeform > 0 && index == -1 && !need_mapping && !sculpt_mode;
+  /* Coordinates after the leading deform modifiers, stored with the cached result. */
+  float(*cache_deformed_verts)[3] = nullptr;
+  /* The constructive modifier that took longest, for #OB_MODIFIER_CACHE_AUTO. */
+  ModifierData *auto_md = nullptr;
+  double auto_time_max = MODIFIER_STACK_CACHE_AUTO_MIN_TIME;
+
+  if (use_cache_result) {
+    ModifierStackCache *cache = ob->runtime.modifier_stack_cache;
+    mesh_final = BKE_mesh_copy_for_eval(cache->mesh, true);
+    mesh_final->runtime.deformed_only = false;
+    if (r_deform) {
+      mesh_deform = BKE_mesh_copy_for_eval(mesh_input, true);
+      if (cache->deformed_verts) {
+        BKE_mesh_vert_coords_apply(mesh_deform, cache->deformed_verts);
+      }
+    }
+    md = cache_md->next;
+    md_datamask = cache_md_datamask->next;
+  }
   /* Apply all leading deform modifiers. */
-  if (useDeform) {
+  else if (useDeform) {
     for (; md; md = md->next, md_datamask = md_datamask->next) {
       const ModifierTypeInfo *mti = BKE_modifier_get_info((ModifierType)md->type);
 
@@ -1089,7 +1807,19 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
           BKE_mesh_vert_coords_apply(mesh_final, deformed_verts);
         }
 
-        BKE_modifier_deform_verts(md, &mectx, mesh_final, deformed_verts, num_deformed_verts);
+        const int md_fused_num = modifier_deform_verts_fused(scene,
+                                                             ob,
+                                                             md,
+                                                             &mectx,
+                                                             mesh_final,
+                                                             deformed_verts,
+                                                             num_deformed_verts,
+                                                             required_mode,
+                                                             use_deform_fusion);
+        for (int i = 0; i < md_fused_num; i++) {
+          md = md->next;
+          md_datamask = md_datamask->next;
+        }
 
         isPrevDeform = true;
       }
@@ -1114,10 +1844,14 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
         BKE_mesh_vert_coords_apply(mesh_deform, deformed_verts);
       }
     }
+
+    if (cache_md && deformed_verts) {
+      cache_deformed_verts = (float(*)[3])MEM_dupallocN(deformed_verts);
+    }
   }
 
   /* Apply all remaining constructive and deforming modifiers. */
-  bool have_non_onlydeform_modifiers_appled = false;
+  bool have_non_onlydeform_modifiers_appled = use_cache_result;
   for (; md; md = md->next, md_datamask = md_datamask->next) {
     const ModifierTypeInfo *mti = BKE_modifier_get_info((ModifierType)md->type);
 
@@ -1216,7 +1950,19 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
         }
         BKE_mesh_vert_coords_apply(mesh_final, deformed_verts);
       }
-      BKE_modifier_deform_verts(md, &mectx, mesh_final, deformed_verts, num_deformed_verts);
+      const int md_fused_num = modifier_deform_verts_fused(scene,
+                                                           ob,
+                                                           md,
+                                                           &mectx,
+                                                           mesh_final,
+                                                           deformed_verts,
+                                                           num_deformed_verts,
+                                                           required_mode,
+                                                           use_deform_fusion);
+      for (int i = 0; i < md_fused_num; i++) {
+        md = md->next;
+        md_datamask = md_datamask->next;
+      }
     }
     else {
       bool check_for_needs_mapping = false;
@@ -1301,10 +2047,20 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
         }
       }
 
+      const double time_start = use_cache_auto ? PIL_check_seconds_timer() : 0.0;
+
       Mesh *mesh_next = modifier_modify_mesh_and_geometry_set(
           md, mectx, mesh_final, geometry_set_final);
       ASSERT_IS_VALID_MESH(mesh_next);
 
+      if (use_cache_auto) {
+        const double time = PIL_check_seconds_timer() - time_start;
+        if (time > auto_time_max) {
+          auto_time_max = time;
+          auto_md = md;
+        }
+      }
+
       if (mesh_next) {
         /* if the modifier returned a new mesh, release the old one */
         if (mesh_final != mesh_next) {
@@ -1385,6 +2141,21 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
       }
 
       mesh_final->runtime.deformed_only = false;
+
+      if (md == cache_md) {
+        modifier_stack_cache_key_build(scene,
+                                       ob,
+                                       firstmd,
+                                       cache_md,
+                                       &md_datamask->mask,
+                                       required_mode,
+                                       &cache_key);
+        if (cache_key.ids_supported && !cache_key.has_error) {
+          modifier_stack_cache_store(
+              ob, cache_md, &cache_input, mesh_final, cache_deformed_verts, &cache_key);
+          cache_deformed_verts = nullptr;
+        }
+      }
     }
 
     isPrevDeform = (mti->type == eModifierTypeType_OnlyDeform);
@@ -1405,6 +2176,21 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
     BKE_modifier_free_temporary_data(md);
   }
 
+  MEM_SAFE_FREE(cache_deformed_verts);
+  if (use_cache_auto) {
+    /* Choose the modifier to cache from a full evaluation, and keep it while its result is
+     * cached so that timing noise does not move the cache around. */
+    ModifierStackCache *cache = ob->runtime.modifier_stack_cache;
+    if (cache->mesh == nullptr) {
+      if (auto_md) {
+        cache->auto_session_uuid = auto_md->session_uuid;
+      }
+      else {
+        cache->auto_session_uuid = {0};
+      }
+    }
+  }
+
   /* Yay, we are done. If we have a Mesh and deformed vertices,
    * we need to apply these back onto the Mesh. If we have no
    * Mesh then we need to build one. */
@@ -1891,11 +2677,16 @@ static void mesh_runtime_check_normals_valid(const Mesh *mesh)
   BLI_assert(!(mesh->runtime.cd_dirty_poly & CD_MASK_NORMAL));
 }
 
+/**
+ * \param allow_shared: Use the result of another object with the same mesh and modifiers. Shared
+ * results don't come with the deformed mesh (#Object_Runtime.mesh_deform_eval).
+ */
 static void mesh_build_data(struct Depsgraph *depsgraph,
                             Scene *scene,
                             Object *ob,
                             const CustomData_MeshMasks *dataMask,
-                            const bool need_mapping)
+                            const bool need_mapping,
+                            const bool allow_shared)
 {
   BLI_assert(ob->type == OB_MESH);
 
@@ -1903,6 +2694,18 @@ static void mesh_build_data(struct Depsgraph *depsgraph,
    * they aren't cleaned up properly on mode switch, causing crashes, e.g T58150. */
   BLI_assert(ob->id.tag & LIB_TAG_COPIED_ON_WRITE);
 
+  /* Keep the draw cache of the previous result, it stays mostly valid when the new result is only
+   * deformed from it (e.g. during armature playback). Shared results keep their cache for the
+   * other objects using them. */
+  void *batch_cache = nullptr;
+  MeshBatchCacheTopology *batch_cache_topology = nullptr;
+  if (ob->runtime.data_eval != nullptr && ob->runtime.is_data_eval_owned &&
+      GS(ob->runtime.data_eval->name) == ID_ME &&
+      ((Mesh *)ob->runtime.data_eval)->runtime.eval_shared_users == 0) {
+    batch_cache = BKE_mesh_runtime_batch_cache_take((Mesh *)ob->runtime.data_eval,
+                                                    &batch_cache_topology);
+  }
+
   BKE_object_free_derived_caches(ob);
   if (DEG_is_active(depsgraph)) {
     BKE_sculpt_update_object_before_eval(ob);
@@ -1917,30 +2720,65 @@ static void mesh_build_data(struct Depsgraph *depsgraph,
   }
 #endif
 
+  Mesh *mesh = (Mesh *)ob->data;
   Mesh *mesh_eval = nullptr, *mesh_deform_eval = nullptr;
   GeometrySet *geometry_set_eval = nullptr;
-  mesh_calc_modifiers(depsgraph,
-                      scene,
-                      ob,
-                      1,
-                      need_mapping,
-                      dataMask,
-                      -1,
-                      true,
-                      true,
-                      &mesh_deform_eval,
-                      &mesh_eval,
-                      &geometry_set_eval);
+
+  /* Use the result of another object with the same mesh and modifiers from this update. */
+  blender::Vector<char> shared_key_data;
+  MeshEvalSharedKey shared_key = {nullptr};
+  const int update_count = DEG_get_update_count(depsgraph);
+  const bool use_shared = allow_shared &&
+                          mesh_eval_shared_key_build(
+                              depsgraph, scene, ob, dataMask, need_mapping, shared_key_data);
+  if (use_shared) {
+    shared_key.data = shared_key_data.data();
+    shared_key.data_len = (size_t)shared_key_data.size();
+    shared_key.hash = BLI_hash_mm2(
+        (const unsigned char *)shared_key_data.data(), shared_key.data_len, 0);
+    mesh_eval = BKE_mesh_runtime_eval_shared_get(mesh, &shared_key, update_count);
+  }
+  const bool is_shared_hit = (mesh_eval != nullptr);
+
+  if (is_shared_hit) {
+    geometry_set_eval = new GeometrySet();
+    geometry_set_eval->get_component_for_write<MeshComponent>()
+        .copy_vertex_group_names_from_object(*ob);
+  }
+  else {
+    mesh_calc_modifiers(depsgraph,
+                        scene,
+                        ob,
+                        1,
+                        need_mapping,
+                        dataMask,
+                        -1,
+                        true,
+                        true,
+                        &mesh_deform_eval,
+                        &mesh_eval,
+                        &geometry_set_eval);
+  }
 
   /* The modifier stack evaluation is storing result in mesh->runtime.mesh_eval, but this result
    * is not guaranteed to be owned by object.
    *
    * Check ownership now, since later on we can not go to a mesh owned by someone else via
    * object's runtime: this could cause access freed data on depsgraph destruction (mesh who owns
-   * the final result might be freed prior to object). */
-  Mesh *mesh = (Mesh *)ob->data;
+   * the final result might be freed prior to object). Shared results are reference counted, so
+   * every object using them owns them. */
   const bool is_mesh_eval_owned = (mesh_eval != mesh->runtime.mesh_eval);
   BKE_object_eval_assign_data(ob, &mesh_eval->id, is_mesh_eval_owned);
+  if (is_shared_hit) {
+    /* The shared result has the draw cache of the object which evaluated it. */
+    BKE_mesh_runtime_batch_cache_discard(batch_cache, batch_cache_topology);
+  }
+  else {
+    BKE_mesh_runtime_batch_cache_restore(mesh_eval, mesh, batch_cache, batch_cache_topology);
+    if (use_shared && is_mesh_eval_owned) {
+      BKE_mesh_runtime_eval_shared_store(mesh, mesh_eval, &shared_key, update_count);
+    }
+  }
 
   /* Add the final mesh as read-only non-owning component to the geometry set. */
   MeshComponent &mesh_component = geometry_set_eval->get_component_for_write<MeshComponent>();
@@ -1954,6 +2792,12 @@ static void mesh_build_data(struct Depsgraph *depsgraph,
 
   BKE_object_boundbox_calc_from_mesh(ob, mesh_eval);
 
+  if (is_shared_hit) {
+    /* The rest only applies to objects that can't share their result. */
+    mesh_runtime_check_normals_valid(mesh_eval);
+    return;
+  }
+
   /* Make sure that drivers can target shapekey properties.
    * Note that this causes a potential inconsistency, as the shapekey may have a
    * different topology than the evaluated mesh. */
@@ -2067,7 +2911,7 @@ void makeDerivedMesh(struct Depsgraph *depsgraph,
     editbmesh_build_data(depsgraph, scene, ob, em, &cddata_masks);
   }
   else {
-    mesh_build_data(depsgraph, scene, ob, &cddata_masks, need_mapping);
+    mesh_build_data(depsgraph, scene, ob, &cddata_masks, need_mapping, true);
   }
 }
 
@@ -2097,8 +2941,12 @@ Mesh *mesh_get_eval_final(struct Depsgraph *depsgraph,
       !CustomData_MeshMasks_are_matching(&(ob->runtime.last_data_mask), &cddata_masks) ||
       (need_mapping && !ob->runtime.last_need_mapping)) {
     CustomData_MeshMasks_update(&cddata_masks, &ob->runtime.last_data_mask);
-    mesh_build_data(
-        depsgraph, scene, ob, &cddata_masks, need_mapping || ob->runtime.last_need_mapping);
+    mesh_build_data(depsgraph,
+                    scene,
+                    ob,
+                    &cddata_masks,
+                    need_mapping || ob->runtime.last_need_mapping,
+                    true);
     mesh_eval = BKE_object_get_evaluated_mesh(ob);
   }
 
@@ -2132,8 +2980,13 @@ Mesh *mesh_get_eval_deform(struct Depsgraph *depsgraph,
       !CustomData_MeshMasks_are_matching(&(ob->runtime.last_data_mask), &cddata_masks) ||
       (need_mapping && !ob->runtime.last_need_mapping)) {
     CustomData_MeshMasks_update(&cddata_masks, &ob->runtime.last_data_mask);
-    mesh_build_data(
-        depsgraph, scene, ob, &cddata_masks, need_mapping || ob->runtime.last_need_mapping);
+    /* Objects using a shared result evaluate their own, to get the deformed mesh. */
+    mesh_build_data(depsgraph,
+                    scene,
+                    ob,
+                    &cddata_masks,
+                    need_mapping || ob->runtime.last_need_mapping,
+                    false);
   }
 
   return ob->runtime.mesh_deform_eval;
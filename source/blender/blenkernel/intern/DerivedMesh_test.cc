@@ -0,0 +1,577 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_action.h"
+#include "BKE_appdir.h"
+#include "BKE_armature.h"
+#include "BKE_customdata.h"
+#include "BKE_deform.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
+#include "BKE_modifier.h"
+#include "BKE_object.h"
+#include "BKE_scene.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math_vector.h"
+#include "BLI_string.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_query.h"
+
+#include "DNA_action_types.h"
+#include "DNA_armature_types.h"
+#include "DNA_genfile.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "IMB_imbuf.h"
+
+#include "tests/blenkernel_testing.hh"
+
+namespace blender::bke::tests {
+
+class ModifierStackTest : public MeshTest {
+ public:
+  Main *bmain;
+  Scene *scene;
+  ViewLayer *view_layer;
+  Depsgraph *depsgraph;
+
+  static void SetUpTestSuite()
+  {
+    MeshTest::SetUpTestSuite();
+    DNA_sdna_current_init();
+    BKE_appdir_init();
+    IMB_init();
+    BKE_modifier_init();
+    DEG_register_node_types();
+  }
+
+  static void TearDownTestSuite()
+  {
+    DEG_free_node_types();
+    IMB_exit();
+    BKE_appdir_exit();
+    DNA_sdna_current_free();
+    MeshTest::TearDownTestSuite();
+  }
+
+  void SetUp() override
+  {
+    bmain = BKE_main_new();
+    scene = BKE_scene_add(bmain, "Scene");
+    view_layer = (ViewLayer *)scene->view_layers.first;
+    depsgraph = nullptr;
+  }
+
+  void TearDown() override
+  {
+    if (depsgraph) {
+      DEG_graph_free(depsgraph);
+    }
+    BKE_main_free(bmain);
+  }
+
+  /* Add a mesh object with a quad and no modifiers. */
+  Object *add_quad_object(const char *name)
+  {
+    Object *ob = BKE_object_add(bmain, view_layer, OB_MESH, name);
+
+    /* Keep the quad away from the mirror plane. */
+    Mesh *quad = create_grid_mesh(1);
+    for (int i = 0; i < quad->totvert; i++) {
+      quad->mvert[i].co[0] += 1.0f;
+    }
+    BKE_mesh_nomain_to_mesh(quad, (Mesh *)ob->data, ob, &CD_MASK_MESH, true);
+    return ob;
+  }
+
+  ModifierData *add_modifier(Object *ob, const ModifierType type)
+  {
+    ModifierData *md = BKE_modifier_new(type);
+    BLI_addtail(&ob->modifiers, md);
+    BKE_modifier_session_uuid_generate(md);
+    return md;
+  }
+
+  /* Add a mesh object with a quad, followed by a mirror and an array modifier. */
+  Object *add_object(const char *name, const bool use_cache_result)
+  {
+    Object *ob = add_quad_object(name);
+    ModifierData *mirror = add_modifier(ob, eModifierType_Mirror);
+    if (use_cache_result) {
+      mirror->flag |= eModifierFlag_CacheResult;
+    }
+    add_modifier(ob, eModifierType_Array);
+    return ob;
+  }
+
+  /* Add an object using the mesh of another one, with a mirror and an array modifier. */
+  Object *add_linked_object(const char *name, Object *ob_src)
+  {
+    Object *ob = BKE_object_add(bmain, view_layer, OB_MESH, name);
+    id_us_min((ID *)ob->data);
+    ob->data = ob_src->data;
+    id_us_plus((ID *)ob->data);
+    add_modifier(ob, eModifierType_Mirror);
+    add_modifier(ob, eModifierType_Array);
+    return ob;
+  }
+
+  void evaluate()
+  {
+    if (depsgraph == nullptr) {
+      depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
+      DEG_graph_build_from_view_layer(depsgraph);
+      /* Like the viewport, so that recalc flags of original data-blocks are cleared. */
+      DEG_make_active(depsgraph);
+    }
+    BKE_scene_graph_update_tagged(depsgraph, bmain);
+  }
+
+  void tag_update(Object *ob)
+  {
+    DEG_id_tag_update_ex(bmain, &ob->id, ID_RECALC_GEOMETRY);
+  }
+
+  Object *evaluated_object(Object *ob)
+  {
+    return DEG_get_evaluated_object(depsgraph, ob);
+  }
+
+  const Mesh *evaluated_mesh(Object *ob)
+  {
+    return (const Mesh *)evaluated_object(ob)->runtime.data_eval;
+  }
+
+  void expect_meshes_equal(const Mesh *a, const Mesh *b)
+  {
+    ASSERT_EQ(a->totvert, b->totvert);
+    ASSERT_EQ(a->totpoly, b->totpoly);
+    for (int i = 0; i < a->totvert; i++) {
+      EXPECT_V3_NEAR(a->mvert[i].co, b->mvert[i].co, 0.0f);
+    }
+  }
+};
+
+TEST_F(ModifierStackTest, downstream_and_upstream_changes)
+{
+  Object *ob_cached = add_object("Cached", true);
+  Object *ob_reference = add_object("Reference", false);
+  evaluate();
+
+  const Mesh *cache_result = mesh_modifier_stack_cache_result(evaluated_object(ob_cached));
+  ASSERT_NE(cache_result, nullptr);
+  EXPECT_EQ(cache_result->totpoly, 2);
+  EXPECT_EQ(evaluated_object(ob_reference)->runtime.modifier_stack_cache, nullptr);
+  expect_meshes_equal(evaluated_mesh(ob_cached), evaluated_mesh(ob_reference));
+  EXPECT_EQ(evaluated_mesh(ob_cached)->totpoly, 2 * 2);
+
+  /* Change the modifier after the cached one, the cached result is used. */
+  for (Object *ob : {ob_cached, ob_reference}) {
+    ((ArrayModifierData *)ob->modifiers.last)->count = 3;
+    tag_update(ob);
+  }
+  evaluate();
+  EXPECT_EQ(mesh_modifier_stack_cache_result(evaluated_object(ob_cached)), cache_result);
+  expect_meshes_equal(evaluated_mesh(ob_cached), evaluated_mesh(ob_reference));
+  EXPECT_EQ(evaluated_mesh(ob_cached)->totpoly, 2 * 3);
+
+  /* Change the cached modifier itself, it has to be evaluated again. */
+  for (Object *ob : {ob_cached, ob_reference}) {
+    ((MirrorModifierData *)ob->modifiers.first)->flag |= MOD_MIR_AXIS_Y;
+    tag_update(ob);
+  }
+  evaluate();
+  EXPECT_NE(mesh_modifier_stack_cache_result(evaluated_object(ob_cached)), cache_result);
+  cache_result = mesh_modifier_stack_cache_result(evaluated_object(ob_cached));
+  expect_meshes_equal(evaluated_mesh(ob_cached), evaluated_mesh(ob_reference));
+  EXPECT_EQ(evaluated_mesh(ob_cached)->totpoly, 4 * 3);
+
+  /* Change the input mesh. */
+  for (Object *ob : {ob_cached, ob_reference}) {
+    Mesh *mesh = (Mesh *)ob->data;
+    mesh->mvert[0].co[2] = 1.0f;
+    DEG_id_tag_update_ex(bmain, &mesh->id, ID_RECALC_GEOMETRY);
+  }
+  evaluate();
+  EXPECT_NE(mesh_modifier_stack_cache_result(evaluated_object(ob_cached)), cache_result);
+  expect_meshes_equal(evaluated_mesh(ob_cached), evaluated_mesh(ob_reference));
+
+  /* Disabling the cache frees the cached result. */
+  ((ModifierData *)ob_cached->modifiers.first)->flag &= ~eModifierFlag_CacheResult;
+  tag_update(ob_cached);
+  evaluate();
+  EXPECT_EQ(evaluated_object(ob_cached)->runtime.modifier_stack_cache, nullptr);
+  expect_meshes_equal(evaluated_mesh(ob_cached), evaluated_mesh(ob_reference));
+}
+
+TEST_F(ModifierStackTest, multires_displacement_input)
+{
+  /* Every copy of the mesh for evaluation reallocates the displacement arrays. */
+  Object *ob = add_object("Multires", true);
+  Mesh *mesh = (Mesh *)ob->data;
+  MDisps *mdisps = (MDisps *)CustomData_add_layer(
+      &mesh->ldata, CD_MDISPS, CD_CALLOC, nullptr, mesh->totloop);
+  for (int i = 0; i < mesh->totloop; i++) {
+    mdisps[i].level = 1;
+    mdisps[i].totdisp = 4;
+    mdisps[i].disps = (float(*)[3])MEM_calloc_arrayN(4, sizeof(float[3]), __func__);
+  }
+  evaluate();
+  const Mesh *cache_result = mesh_modifier_stack_cache_result(evaluated_object(ob));
+  ASSERT_NE(cache_result, nullptr);
+
+  /* The mesh is copied again, but its data didn't change. */
+  ((ArrayModifierData *)ob->modifiers.last)->count = 3;
+  tag_update(ob);
+  evaluate();
+  EXPECT_EQ(mesh_modifier_stack_cache_result(evaluated_object(ob)), cache_result);
+  EXPECT_EQ(evaluated_mesh(ob)->totpoly, 2 * 3);
+
+  /* Displacements changed in place are detected. */
+  mdisps[0].disps[1][2] = 1.0f;
+  DEG_id_tag_update_ex(bmain, &mesh->id, ID_RECALC_GEOMETRY);
+  evaluate();
+  EXPECT_NE(mesh_modifier_stack_cache_result(evaluated_object(ob)), cache_result);
+}
+
+TEST_F(ModifierStackTest, settings_with_data_pointers)
+{
+  /* The bevel profile is not an ID, changes to it can't be detected. */
+  Object *ob_bevel = add_quad_object("Bevel");
+  ModifierData *bevel = add_modifier(ob_bevel, eModifierType_Bevel);
+  ASSERT_NE(((BevelModifierData *)bevel)->custom_profile, nullptr);
+  bevel->flag |= eModifierFlag_CacheResult;
+  /* Without such data, the settings can be compared. */
+  Object *ob_mirror = add_object("Mirror", true);
+  evaluate();
+
+  EXPECT_EQ(mesh_modifier_stack_cache_result(evaluated_object(ob_bevel)), nullptr);
+  EXPECT_NE(mesh_modifier_stack_cache_result(evaluated_object(ob_mirror)), nullptr);
+}
+
+TEST_F(ModifierStackTest, auto_cache)
+{
+  Object *ob = add_object("Auto", false);
+  ob->modifier_cache_flag |= OB_MODIFIER_CACHE_AUTO;
+  evaluate();
+
+  /* Neither modifier is slow enough on such a small mesh. */
+  EXPECT_NE(evaluated_object(ob)->runtime.modifier_stack_cache, nullptr);
+  EXPECT_EQ(mesh_modifier_stack_cache_result(evaluated_object(ob)), nullptr);
+
+  ob->modifier_cache_flag &= ~OB_MODIFIER_CACHE_AUTO;
+  tag_update(ob);
+  evaluate();
+  EXPECT_EQ(evaluated_object(ob)->runtime.modifier_stack_cache, nullptr);
+}
+
+TEST_F(ModifierStackTest, fused_deform)
+{
+  Object *ob = add_quad_object("Deform");
+  CastModifierData *cast = (CastModifierData *)add_modifier(ob, eModifierType_Cast);
+  cast->fac = 1.0f;
+  cast->flag &= ~MOD_CAST_SIZE_FROM_RADIUS;
+  cast->size = 2.0f;
+  /* Disabled modifiers in between don't interrupt the fused evaluation. */
+  WaveModifierData *wave = (WaveModifierData *)add_modifier(ob, eModifierType_Wave);
+  wave->modifier.mode &= ~(eModifierMode_Realtime | eModifierMode_Render);
+  DisplaceModifierData *displace = (DisplaceModifierData *)add_modifier(
+      ob, eModifierType_Displace);
+  displace->direction = MOD_DISP_DIR_Z;
+  displace->strength = 0.5f;
+  displace->midlevel = 0.5f;
+  evaluate();
+
+  /* Every vertex is moved onto the sphere, then up by the displacement. */
+  const Mesh *mesh_orig = (const Mesh *)ob->data;
+  const Mesh *mesh_eval = evaluated_mesh(ob);
+  ASSERT_EQ(mesh_eval->totvert, mesh_orig->totvert);
+  for (int i = 0; i < mesh_eval->totvert; i++) {
+    float expected[3];
+    normalize_v3_v3_length(expected, mesh_orig->mvert[i].co, 2.0f);
+    expected[2] += 0.25f;
+    EXPECT_V3_NEAR(mesh_eval->mvert[i].co, expected, 1e-5f);
+  }
+
+  /* An automatic cast size depends on all vertices, the cast is evaluated on its own. */
+  cast->size = 0.0f;
+  tag_update(ob);
+  evaluate();
+  mesh_eval = evaluated_mesh(ob);
+  float radius = 0.0f;
+  for (int i = 0; i < mesh_orig->totvert; i++) {
+    radius += len_v3(mesh_orig->mvert[i].co) / mesh_orig->totvert;
+  }
+  for (int i = 0; i < mesh_eval->totvert; i++) {
+    float expected[3];
+    normalize_v3_v3_length(expected, mesh_orig->mvert[i].co, radius);
+    expected[2] += 0.25f;
+    EXPECT_V3_NEAR(mesh_eval->mvert[i].co, expected, 1e-5f);
+  }
+}
+
+TEST_F(ModifierStackTest, armature_first)
+{
+  /* An armature at the start of the stack deforms without a mesh. */
+  Object *ob = add_quad_object("Skinned");
+  Object *ob_arm = BKE_object_add(bmain, view_layer, OB_ARMATURE, "Armature");
+  bArmature *arm = (bArmature *)ob_arm->data;
+  Bone *bone = (Bone *)MEM_callocN(sizeof(Bone), __func__);
+  STRNCPY(bone->name, "Bone");
+  copy_v3_fl3(bone->tail, 0.0f, 1.0f, 0.0f);
+  bone->length = 1.0f;
+  BLI_addtail(&arm->bonebase, bone);
+  BKE_armature_where_is(arm);
+  BKE_pose_rebuild(bmain, ob_arm, arm, false);
+
+  Mesh *mesh = (Mesh *)ob->data;
+  bDeformGroup *defgroup = (bDeformGroup *)MEM_callocN(sizeof(bDeformGroup), __func__);
+  STRNCPY(defgroup->name, "Bone");
+  BLI_addtail(&ob->defbase, defgroup);
+  mesh->dvert = (MDeformVert *)CustomData_add_layer(
+      &mesh->vdata, CD_MDEFORMVERT, CD_CALLOC, nullptr, mesh->totvert);
+  for (int i = 0; i < mesh->totvert; i++) {
+    BKE_defvert_add_index_notest(&mesh->dvert[i], 0, 1.0f);
+  }
+  ArmatureModifierData *amd = (ArmatureModifierData *)add_modifier(ob, eModifierType_Armature);
+  amd->object = ob_arm;
+  add_modifier(ob, eModifierType_Mirror);
+
+  auto expect_offset = [&](const float offset, const float weight_first) {
+    const Mesh *mesh_eval = evaluated_mesh(ob);
+    ASSERT_EQ(mesh_eval->totvert, mesh->totvert * 2);
+    for (int i = 0; i < mesh->totvert; i++) {
+      float expected[3];
+      copy_v3_v3(expected, mesh->mvert[i].co);
+      expected[1] += offset * ((i == 0) ? weight_first : 1.0f);
+      EXPECT_V3_NEAR(mesh_eval->mvert[i].co, expected, 1e-6f);
+    }
+  };
+  evaluate();
+  expect_offset(0.0f, 1.0f);
+
+  /* Moving the bone reuses the weights, which didn't change. */
+  bPoseChannel *pchan = BKE_pose_channel_find_name(ob_arm->pose, "Bone");
+  for (const float offset : {1.0f, 2.0f}) {
+    pchan->loc[1] = offset;
+    DEG_id_tag_update_ex(bmain, &ob_arm->id, ID_RECALC_GEOMETRY);
+    evaluate();
+    expect_offset(offset, 1.0f);
+  }
+
+  /* Weights changed in place are taken into account. */
+  mesh->dvert[0].dw[0].weight = 0.0f;
+  DEG_id_tag_update_ex(bmain, &mesh->id, ID_RECALC_GEOMETRY);
+  evaluate();
+  expect_offset(2.0f, 0.0f);
+}
+
+static eMeshBatchDirtyMode batch_cache_dirty_mode;
+
+static void batch_cache_dirty_tag_record(Mesh *UNUSED(mesh), eMeshBatchDirtyMode mode)
+{
+  batch_cache_dirty_mode = mode;
+}
+
+static void batch_cache_free_none(Mesh *mesh)
+{
+  mesh->runtime.batch_cache = nullptr;
+}
+
+TEST_F(ModifierStackTest, batch_cache_deform)
+{
+  void (*dirty_tag_cb_prev)(Mesh *, eMeshBatchDirtyMode) = BKE_mesh_batch_cache_dirty_tag_cb;
+  void (*free_cb_prev)(Mesh *) = BKE_mesh_batch_cache_free_cb;
+  BKE_mesh_batch_cache_dirty_tag_cb = batch_cache_dirty_tag_record;
+  BKE_mesh_batch_cache_free_cb = batch_cache_free_none;
+
+  /* Moving the objects the modifiers use changes the result without copying the object, like
+   * moving an armature does. The array copies are merged when the offset brings them together,
+   * the cast only deforms. */
+  Object *ob = add_quad_object("Deform");
+  Object *ob_offset = BKE_object_add(bmain, view_layer, OB_EMPTY, "Offset");
+  Object *ob_center = BKE_object_add(bmain, view_layer, OB_EMPTY, "Center");
+  ob_offset->loc[0] = 5.0f;
+  ArrayModifierData *array = (ArrayModifierData *)add_modifier(ob, eModifierType_Array);
+  array->offset_type = MOD_ARR_OFF_OBJ;
+  array->offset_ob = ob_offset;
+  array->flags |= MOD_ARR_MERGE;
+  CastModifierData *cast = (CastModifierData *)add_modifier(ob, eModifierType_Cast);
+  cast->fac = 1.0f;
+  cast->object = ob_center;
+  evaluate();
+  /* Without a draw cache, nothing is kept to compare with. */
+  EXPECT_EQ(evaluated_mesh(ob)->runtime.batch_cache_topology, nullptr);
+
+  /* Stand-in for the draw cache. */
+  int batch_cache;
+  ((Mesh *)evaluated_mesh(ob))->runtime.batch_cache = &batch_cache;
+
+  /* The first result the cache moves to can't be compared with anything. */
+  batch_cache_dirty_mode = BKE_MESH_BATCH_DIRTY_DEFORM;
+  ob_center->loc[2] = 0.5f;
+  DEG_id_tag_update_ex(bmain, &ob_center->id, ID_RECALC_TRANSFORM);
+  evaluate();
+  EXPECT_EQ(evaluated_mesh(ob)->runtime.batch_cache, &batch_cache);
+  EXPECT_EQ(batch_cache_dirty_mode, BKE_MESH_BATCH_DIRTY_ALL);
+  EXPECT_NE(evaluated_mesh(ob)->runtime.batch_cache_topology, nullptr);
+
+  /* Only the positions change, the cache moves to the new result and is tagged partially. */
+  const float co_prev[3] = {UNPACK3(evaluated_mesh(ob)->mvert[0].co)};
+  ob_center->loc[2] = 1.0f;
+  DEG_id_tag_update_ex(bmain, &ob_center->id, ID_RECALC_TRANSFORM);
+  evaluate();
+  EXPECT_FALSE(equals_v3v3(evaluated_mesh(ob)->mvert[0].co, co_prev));
+  EXPECT_EQ(evaluated_mesh(ob)->runtime.batch_cache, &batch_cache);
+  EXPECT_EQ(batch_cache_dirty_mode, BKE_MESH_BATCH_DIRTY_DEFORM);
+
+  /* Changes to the topology tag everything. */
+  EXPECT_EQ(evaluated_mesh(ob)->totvert, 8);
+  ob_offset->loc[0] = 1.0f;
+  DEG_id_tag_update_ex(bmain, &ob_offset->id, ID_RECALC_TRANSFORM);
+  evaluate();
+  EXPECT_EQ(evaluated_mesh(ob)->totvert, 6);
+  EXPECT_EQ(evaluated_mesh(ob)->runtime.batch_cache, &batch_cache);
+  EXPECT_EQ(batch_cache_dirty_mode, BKE_MESH_BATCH_DIRTY_ALL);
+
+  ((Mesh *)evaluated_mesh(ob))->runtime.batch_cache = nullptr;
+  BKE_mesh_batch_cache_dirty_tag_cb = dirty_tag_cb_prev;
+  BKE_mesh_batch_cache_free_cb = free_cb_prev;
+}
+
+TEST_F(ModifierStackTest, batch_cache_deform_only)
+{
+  void (*dirty_tag_cb_prev)(Mesh *, eMeshBatchDirtyMode) = BKE_mesh_batch_cache_dirty_tag_cb;
+  void (*free_cb_prev)(Mesh *) = BKE_mesh_batch_cache_free_cb;
+  BKE_mesh_batch_cache_dirty_tag_cb = batch_cache_dirty_tag_record;
+  BKE_mesh_batch_cache_free_cb = batch_cache_free_none;
+
+  /* The result only deforms its input, so it references the layers of the input mesh. */
+  Object *ob = add_quad_object("Deform");
+  Object *ob_center = BKE_object_add(bmain, view_layer, OB_EMPTY, "Center");
+  Mesh *mesh = (Mesh *)ob->data;
+  CastModifierData *cast = (CastModifierData *)add_modifier(ob, eModifierType_Cast);
+  cast->fac = 1.0f;
+  cast->object = ob_center;
+  evaluate();
+
+  int batch_cache;
+  ((Mesh *)evaluated_mesh(ob))->runtime.batch_cache = &batch_cache;
+  ob_center->loc[2] = 0.5f;
+  DEG_id_tag_update_ex(bmain, &ob_center->id, ID_RECALC_TRANSFORM);
+  evaluate();
+  EXPECT_EQ(batch_cache_dirty_mode, BKE_MESH_BATCH_DIRTY_ALL);
+
+  /* Only the positions change, the other layers are still the ones of the input mesh. */
+  ob_center->loc[2] = 1.0f;
+  DEG_id_tag_update_ex(bmain, &ob_center->id, ID_RECALC_TRANSFORM);
+  evaluate();
+  EXPECT_EQ(evaluated_mesh(ob)->runtime.batch_cache, &batch_cache);
+  EXPECT_EQ(batch_cache_dirty_mode, BKE_MESH_BATCH_DIRTY_DEFORM);
+
+  /* Other data in the input mesh is never only a deformation. */
+  mesh->mpoly[0].flag |= ME_SMOOTH;
+  DEG_id_tag_update_ex(bmain, &mesh->id, ID_RECALC_GEOMETRY);
+  evaluate();
+  EXPECT_TRUE(evaluated_mesh(ob)->mpoly[0].flag & ME_SMOOTH);
+  EXPECT_TRUE(evaluated_mesh(ob)->runtime.batch_cache == nullptr ||
+              batch_cache_dirty_mode == BKE_MESH_BATCH_DIRTY_ALL);
+
+  ((Mesh *)evaluated_mesh(ob))->runtime.batch_cache = nullptr;
+  BKE_mesh_batch_cache_dirty_tag_cb = dirty_tag_cb_prev;
+  BKE_mesh_batch_cache_free_cb = free_cb_prev;
+}
+
+TEST_F(ModifierStackTest, shared_evaluated_mesh)
+{
+  Object *ob_a = add_object("A", false);
+  Object *ob_b = add_linked_object("B", ob_a);
+  Object *ob_c = add_linked_object("C", ob_a);
+  ((ArrayModifierData *)ob_c->modifiers.last)->count = 3;
+  evaluate();
+
+  /* Objects with the same modifiers share the result. */
+  const Mesh *mesh_shared = evaluated_mesh(ob_a);
+  EXPECT_EQ(evaluated_mesh(ob_b), mesh_shared);
+  EXPECT_EQ(mesh_shared->totpoly, 2 * 2);
+  EXPECT_NE(evaluated_mesh(ob_c), mesh_shared);
+  EXPECT_EQ(evaluated_mesh(ob_c)->totpoly, 2 * 3);
+
+  /* Objects using the shared result evaluate their own when the deformed mesh is needed. */
+  Object *ob_b_eval = evaluated_object(ob_b);
+  EXPECT_EQ(ob_b_eval->runtime.mesh_deform_eval, nullptr);
+  const Mesh *mesh_deform = mesh_get_eval_deform(depsgraph, scene, ob_b_eval, &CD_MASK_BAREMESH);
+  ASSERT_NE(mesh_deform, nullptr);
+  EXPECT_EQ(mesh_deform->totpoly, 1);
+  EXPECT_EQ(mesh_get_eval_deform(depsgraph, scene, ob_b_eval, &CD_MASK_BAREMESH), mesh_deform);
+  EXPECT_NE(evaluated_mesh(ob_b), mesh_shared);
+  EXPECT_EQ(evaluated_mesh(ob_b)->totpoly, 2 * 2);
+  /* The mesh stores the result of C, A is the only user left. */
+  EXPECT_EQ(mesh_shared->runtime.eval_shared_users, 1);
+
+  /* Editing the modifier updates the mesh too, so all objects are evaluated again. The users are
+   * the objects and the mesh. */
+  ((ArrayModifierData *)ob_c->modifiers.last)->count = 2;
+  tag_update(ob_c);
+  evaluate();
+  mesh_shared = evaluated_mesh(ob_a);
+  EXPECT_EQ(evaluated_mesh(ob_b), mesh_shared);
+  EXPECT_EQ(evaluated_mesh(ob_c), mesh_shared);
+  EXPECT_EQ(mesh_shared->runtime.eval_shared_users, 4);
+
+  /* Objects referencing other IDs don't share their result. */
+  Object *ob_empty = BKE_object_add(bmain, view_layer, OB_EMPTY, "Empty");
+  for (Object *ob : {ob_a, ob_b}) {
+    ArrayModifierData *array = (ArrayModifierData *)ob->modifiers.last;
+    array->offset_type |= MOD_ARR_OFF_OBJ;
+    array->offset_ob = ob_empty;
+  }
+  DEG_relations_tag_update(bmain);
+  for (Object *ob : {ob_a, ob_b, ob_c}) {
+    tag_update(ob);
+  }
+  evaluate();
+  EXPECT_NE(evaluated_mesh(ob_a), evaluated_mesh(ob_b));
+  EXPECT_EQ(evaluated_mesh(ob_a)->runtime.eval_shared_users, 0);
+  EXPECT_EQ(evaluated_mesh(ob_c)->runtime.eval_shared_users, 2);
+}
+
+TEST_F(ModifierStackTest, shared_evaluated_mesh_transform)
+{
+  /* Displacing along the global X axis depends on the rotation of the object. */
+  Object *ob_a = add_quad_object("A");
+  Object *ob_b = BKE_object_add(bmain, view_layer, OB_MESH, "B");
+  id_us_min((ID *)ob_b->data);
+  ob_b->data = ob_a->data;
+  id_us_plus((ID *)ob_b->data);
+  ob_b->rot[2] = (float)M_PI_2;
+  for (Object *ob : {ob_a, ob_b}) {
+    DisplaceModifierData *displace = (DisplaceModifierData *)add_modifier(
+        ob, eModifierType_Displace);
+    displace->direction = MOD_DISP_DIR_X;
+    displace->space = MOD_DISP_SPACE_GLOBAL;
+  }
+  evaluate();
+
+  EXPECT_NE(evaluated_mesh(ob_a), evaluated_mesh(ob_b));
+  EXPECT_EQ(evaluated_mesh(ob_a)->runtime.eval_shared_users, 0);
+  EXPECT_EQ(evaluated_mesh(ob_b)->runtime.eval_shared_users, 0);
+  const float *co_a = evaluated_mesh(ob_a)->mvert[0].co;
+  const float *co_b = evaluated_mesh(ob_b)->mvert[0].co;
+  EXPECT_NEAR(co_a[0], co_b[0] + 0.5f, 1e-5f);
+  EXPECT_NEAR(co_a[1], co_b[1] + 0.5f, 1e-5f);
+}
+
+}  // namespace blender::bke::tests
@@ -34,6 +34,7 @@
 
 #include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_simd.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
 
@@ -231,6 +232,178 @@ static void pchan_bone_deform(bPoseChannel *pchan,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Skinning Table
+ *
+ * A copy of the vertex group weights of a mesh in flat arrays, kept between evaluations, so
+ * that deforming reads the weights sequentially instead of following every #MDeformVert.
+ * \{ */
+
+typedef struct ArmatureSkinningCache {
+  /** Weights the table was built from, or was last found to match. */
+  const MDeformVert *dverts;
+  int verts_len;
+  /** Vertex group #armature_weights are read from, -1 when there is none. */
+  int armature_def_nr;
+  /** Influences of vertex `i` range from `influence_offsets[i]` to `influence_offsets[i + 1]`. */
+  int *influence_offsets;
+  int *influence_def_nrs;
+  float *influence_weights;
+  /** Weight of every vertex in the armature modifier's own vertex group. */
+  float *armature_weights;
+} ArmatureSkinningCache;
+
+ArmatureSkinningCache *BKE_armature_skinning_cache_create(void)
+{
+  ArmatureSkinningCache *cache = MEM_callocN(sizeof(*cache), __func__);
+  cache->armature_def_nr = -1;
+  return cache;
+}
+
+static void skinning_cache_clear(ArmatureSkinningCache *cache)
+{
+  MEM_SAFE_FREE(cache->influence_offsets);
+  MEM_SAFE_FREE(cache->influence_def_nrs);
+  MEM_SAFE_FREE(cache->influence_weights);
+  MEM_SAFE_FREE(cache->armature_weights);
+  cache->dverts = NULL;
+  cache->verts_len = 0;
+  cache->armature_def_nr = -1;
+}
+
+void BKE_armature_skinning_cache_free(ArmatureSkinningCache *cache)
+{
+  skinning_cache_clear(cache);
+  MEM_freeN(cache);
+}
+
+typedef struct SkinningCacheTaskData {
+  ArmatureSkinningCache *cache;
+  const MDeformVert *dverts;
+} SkinningCacheTaskData;
+
+static void skinning_cache_fill_task(void *__restrict userdata,
+                                     const int i,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SkinningCacheTaskData *data = userdata;
+  ArmatureSkinningCache *cache = data->cache;
+  const MDeformVert *dvert = &data->dverts[i];
+  const int start = cache->influence_offsets[i];
+
+  for (int j = 0; j < dvert->totweight; j++) {
+    cache->influence_def_nrs[start + j] = dvert->dw[j].def_nr;
+    cache->influence_weights[start + j] = dvert->dw[j].weight;
+  }
+  if (cache->armature_weights) {
+    cache->armature_weights[i] = BKE_defvert_find_weight(dvert, cache->armature_def_nr);
+  }
+}
+
+static void skinning_cache_compare_task(void *__restrict userdata,
+                                        const int i,
+                                        const TaskParallelTLS *__restrict tls)
+{
+  const SkinningCacheTaskData *data = userdata;
+  const ArmatureSkinningCache *cache = data->cache;
+  const MDeformVert *dvert = &data->dverts[i];
+  bool *is_equal = tls->userdata_chunk;
+  if (!*is_equal) {
+    return;
+  }
+
+  const int start = cache->influence_offsets[i];
+  if (cache->influence_offsets[i + 1] - start != dvert->totweight) {
+    *is_equal = false;
+    return;
+  }
+  for (int j = 0; j < dvert->totweight; j++) {
+    if (cache->influence_def_nrs[start + j] != dvert->dw[j].def_nr ||
+        cache->influence_weights[start + j] != dvert->dw[j].weight) {
+      *is_equal = false;
+      return;
+    }
+  }
+  if (cache->armature_weights &&
+      cache->armature_weights[i] != BKE_defvert_find_weight(dvert, cache->armature_def_nr)) {
+    *is_equal = false;
+  }
+}
+
+static void skinning_cache_compare_reduce(const void *__restrict UNUSED(userdata),
+                                          void *__restrict chunk_join,
+                                          void *__restrict chunk)
+{
+  bool *is_equal_join = chunk_join;
+  const bool *is_equal = chunk;
+  *is_equal_join = *is_equal_join && *is_equal;
+}
+
+/**
+ * Make \a cache match the weights in \a dverts, it's only rebuilt when they changed.
+ *
+ * \param dverts_unchanged: True when the weights at the address of \a dverts can't have changed
+ * since the last evaluation, in which case the table is kept without comparing them.
+ */
+static void skinning_cache_ensure(ArmatureSkinningCache *cache,
+                                  const MDeformVert *dverts,
+                                  const int verts_len,
+                                  const int armature_def_nr,
+                                  const bool dverts_unchanged)
+{
+  SkinningCacheTaskData data = {
+      .cache = cache,
+      .dverts = dverts,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+
+  if (cache->influence_offsets != NULL && cache->verts_len == verts_len &&
+      cache->armature_def_nr == armature_def_nr) {
+    if (dverts_unchanged && cache->dverts == dverts) {
+      return;
+    }
+    bool is_equal = true;
+    settings.userdata_chunk = &is_equal;
+    settings.userdata_chunk_size = sizeof(is_equal);
+    settings.func_reduce = skinning_cache_compare_reduce;
+    BLI_task_parallel_range(0, verts_len, &data, skinning_cache_compare_task, &settings);
+    if (is_equal) {
+      cache->dverts = dverts;
+      return;
+    }
+    settings.userdata_chunk = NULL;
+    settings.userdata_chunk_size = 0;
+    settings.func_reduce = NULL;
+  }
+
+  skinning_cache_clear(cache);
+  cache->dverts = dverts;
+  cache->verts_len = verts_len;
+  cache->armature_def_nr = armature_def_nr;
+  cache->influence_offsets = MEM_malloc_arrayN(
+      (size_t)verts_len + 1, sizeof(*cache->influence_offsets), __func__);
+  int influences_len = 0;
+  for (int i = 0; i < verts_len; i++) {
+    cache->influence_offsets[i] = influences_len;
+    influences_len += dverts[i].totweight;
+  }
+  cache->influence_offsets[verts_len] = influences_len;
+  cache->influence_def_nrs = MEM_malloc_arrayN(
+      (size_t)influences_len, sizeof(*cache->influence_def_nrs), __func__);
+  cache->influence_weights = MEM_malloc_arrayN(
+      (size_t)influences_len, sizeof(*cache->influence_weights), __func__);
+  if (armature_def_nr != -1) {
+    cache->armature_weights = MEM_malloc_arrayN(
+        (size_t)verts_len, sizeof(*cache->armature_weights), __func__);
+  }
+
+  BLI_task_parallel_range(0, verts_len, &data, skinning_cache_fill_task, &settings);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Armature Deform #BKE_armature_deform_coords API
  *
@@ -265,6 +438,13 @@ typedef struct ArmatureUserdata {
   struct {
     int cd_dvert_offset;
   } bmesh;
+
+  /** Weights of #me_target or #ob_target, only used when #vert_coords_prev is null. */
+  const ArmatureSkinningCache *skinning;
+  /** For every vertex group, true when its bone deforms with a single matrix. */
+  bool *defbase_use_mat;
+  /** For every vertex group with #defbase_use_mat, the bone's matrix in target object space. */
+  float (*defbase_mats)[4][4];
 } ArmatureUserdata;
 
 static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
@@ -414,34 +594,208 @@ static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
   }
 }
 
-static void armature_vert_task(void *__restrict userdata,
-                               const int i,
-                               const TaskParallelTLS *__restrict UNUSED(tls))
+/**
+ * Check the bones influencing a vertex in the skinning table. Returns false when the vertex
+ * needs #armature_vert_task_with_dvert, for B-Bones, envelopes or when no bone deforms it.
+ */
+static bool armature_vert_skinning_check(const ArmatureUserdata *data,
+                                         const int start,
+                                         const int end)
+{
+  const ArmatureSkinningCache *skinning = data->skinning;
+  bool deformed = false;
+  for (int j = start; j < end; j++) {
+    const uint def_nr = (uint)skinning->influence_def_nrs[j];
+    if (def_nr < data->defbase_len && data->pchan_from_defbase[def_nr]) {
+      if (!data->defbase_use_mat[def_nr]) {
+        return false;
+      }
+      deformed = true;
+    }
+  }
+  return deformed;
+}
+
+/**
+ * Linear blend skinning: the bone matrices already include #ArmatureUserdata.premat and
+ * #ArmatureUserdata.postmat, so the weighted sum of the matrices is applied once.
+ */
+static void armature_vert_skin_linear(const ArmatureUserdata *data,
+                                      const int i,
+                                      const int start,
+                                      const int end,
+                                      const float armature_weight)
+{
+  const ArmatureSkinningCache *skinning = data->skinning;
+  float *co = data->vert_coords[i];
+  float summat[4][4];
+  float contrib = 0.0f;
+
+#ifdef BLI_HAVE_SSE2
+  __m128 sum[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+  for (int j = start; j < end; j++) {
+    const uint def_nr = (uint)skinning->influence_def_nrs[j];
+    const float weight = skinning->influence_weights[j];
+    if (def_nr >= data->defbase_len || !data->pchan_from_defbase[def_nr] || weight == 0.0f) {
+      continue;
+    }
+    const float(*mat)[4] = data->defbase_mats[def_nr];
+    const __m128 weight_v = _mm_set1_ps(weight);
+    for (int k = 0; k < 4; k++) {
+      sum[k] = _mm_add_ps(sum[k], _mm_mul_ps(_mm_loadu_ps(mat[k]), weight_v));
+    }
+    contrib += weight;
+  }
+  for (int k = 0; k < 4; k++) {
+    _mm_storeu_ps(summat[k], sum[k]);
+  }
+#else
+  zero_m4(summat);
+  for (int j = start; j < end; j++) {
+    const uint def_nr = (uint)skinning->influence_def_nrs[j];
+    const float weight = skinning->influence_weights[j];
+    if (def_nr >= data->defbase_len || !data->pchan_from_defbase[def_nr] || weight == 0.0f) {
+      continue;
+    }
+    madd_m4_m4m4fl(summat, summat, data->defbase_mats[def_nr], weight);
+    contrib += weight;
+  }
+#endif
+
+  /* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
+  if (contrib <= 0.0001f) {
+    return;
+  }
+
+  /* The sum of `weight * (mat * co - co)` over all bones. */
+  const float fac = armature_weight / contrib;
+  float dco[3];
+  mul_v3_m4v3(dco, summat, co);
+  madd_v3_v3fl(dco, co, -contrib);
+  madd_v3_v3fl(co, dco, fac);
+
+  if (data->vert_deform_mats) {
+    float smat[3][3], tmpmat[3][3];
+    copy_m3_m4(smat, summat);
+    mul_m3_fl(smat, fac);
+    copy_m3_m3(tmpmat, data->vert_deform_mats[i]);
+    mul_m3_m3m3(data->vert_deform_mats[i], smat, tmpmat);
+  }
+}
+
+static void armature_vert_skin_quaternion(const ArmatureUserdata *data,
+                                          const int i,
+                                          const int start,
+                                          const int end,
+                                          const float armature_weight)
+{
+  const ArmatureSkinningCache *skinning = data->skinning;
+  float(*vert_deform_mats)[3][3] = data->vert_deform_mats;
+  float *co = data->vert_coords[i];
+  DualQuat sumdq;
+  float contrib = 0.0f;
+
+  memset(&sumdq, 0, sizeof(sumdq));
+  for (int j = start; j < end; j++) {
+    const uint def_nr = (uint)skinning->influence_def_nrs[j];
+    const float weight = skinning->influence_weights[j];
+    if (def_nr >= data->defbase_len || !data->pchan_from_defbase[def_nr] || weight == 0.0f) {
+      continue;
+    }
+    add_weighted_dq_dq(
+        &sumdq, &data->pchan_from_defbase[def_nr]->runtime.deform_dual_quat, weight);
+    contrib += weight;
+  }
+
+  mul_m4_v3(data->premat, co);
+
+  if (contrib > 0.0001f) {
+    float summat[3][3];
+    normalize_dq(&sumdq, contrib);
+
+    if (armature_weight != 1.0f) {
+      float dco[3];
+      copy_v3_v3(dco, co);
+      mul_v3m3_dq(dco, (vert_deform_mats) ? summat : NULL, &sumdq);
+      sub_v3_v3(dco, co);
+      mul_v3_fl(dco, armature_weight);
+      add_v3_v3(co, dco);
+    }
+    else {
+      mul_v3m3_dq(co, (vert_deform_mats) ? summat : NULL, &sumdq);
+    }
+
+    if (vert_deform_mats) {
+      float pre[3][3], post[3][3], tmpmat[3][3];
+
+      copy_m3_m4(pre, data->premat);
+      copy_m3_m4(post, data->postmat);
+      copy_m3_m3(tmpmat, vert_deform_mats[i]);
+
+      mul_m3_series(vert_deform_mats[i], post, summat, pre, tmpmat);
+    }
+  }
+
+  mul_m4_v3(data->postmat, co);
+}
+
+/* Same as #armature_vert_task_with_dvert, using #ArmatureUserdata.skinning when possible. */
+static void armature_vert_task_with_skinning(const ArmatureUserdata *data, const int i)
+{
+  const ArmatureSkinningCache *skinning = data->skinning;
+  const int start = skinning->influence_offsets[i];
+  const int end = skinning->influence_offsets[i + 1];
+
+  if (!armature_vert_skinning_check(data, start, end)) {
+    armature_vert_task_with_dvert(data, i, &skinning->dverts[i]);
+    return;
+  }
+
+  float armature_weight = 1.0f;
+  if (skinning->armature_weights) {
+    armature_weight = skinning->armature_weights[i];
+    if (data->invert_vgroup) {
+      armature_weight = 1.0f - armature_weight;
+    }
+    if (armature_weight == 0.0f) {
+      return;
+    }
+  }
+
+  if (data->use_quaternion) {
+    armature_vert_skin_quaternion(data, i, start, end, armature_weight);
+  }
+  else {
+    armature_vert_skin_linear(data, i, start, end, armature_weight);
+  }
+}
+
+static const MDeformVert *armature_vert_dvert_get(const ArmatureUserdata *data, const int i)
 {
-  const ArmatureUserdata *data = userdata;
-  const MDeformVert *dvert;
   if (data->use_dverts || data->armature_def_nr != -1) {
     if (data->me_target) {
       BLI_assert(i < data->me_target->totvert);
       if (data->me_target->dvert != NULL) {
-        dvert = data->me_target->dvert + i;
-      }
-      else {
-        dvert = NULL;
+        return data->me_target->dvert + i;
       }
     }
     else if (data->dverts && i < data->dverts_len) {
-      dvert = data->dverts + i;
+      return data->dverts + i;
     }
-    else {
-      dvert = NULL;
-    }
-  }
-  else {
-    dvert = NULL;
   }
+  return NULL;
+}
 
-  armature_vert_task_with_dvert(data, i, dvert);
+static void armature_vert_task(void *__restrict userdata,
+                               const int i,
+                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ArmatureUserdata *data = userdata;
+  if (data->skinning) {
+    armature_vert_task_with_skinning(data, i);
+    return;
+  }
+  armature_vert_task_with_dvert(data, i, armature_vert_dvert_get(data, i));
 }
 
 static void armature_vert_task_editmesh(void *__restrict userdata, MempoolIterData *iter)
@@ -459,17 +813,21 @@ static void armature_vert_task_editmesh_no_dvert(void *__restrict userdata, Memp
   armature_vert_task_with_dvert(data, BM_elem_index_get(v), NULL);
 }
 
-static void armature_deform_coords_impl(const Object *ob_arm,
-                                        const Object *ob_target,
-                                        float (*vert_coords)[3],
-                                        float (*vert_deform_mats)[3][3],
-                                        const int vert_coords_len,
-                                        const int deformflag,
-                                        float (*vert_coords_prev)[3],
-                                        const char *defgrp_name,
-                                        const Mesh *me_target,
-                                        BMEditMesh *em_target,
-                                        bGPDstroke *gps_target)
+/**
+ * Fill in \a data for deforming with \a ob_arm, returns false when the armature can't be used.
+ * On success #ArmatureUserdata.pchan_from_defbase has to be freed by the caller.
+ */
+static bool armature_deform_userdata_init(ArmatureUserdata *data,
+                                          const Object *ob_arm,
+                                          const Object *ob_target,
+                                          float (*vert_coords)[3],
+                                          float (*vert_deform_mats)[3][3],
+                                          const int deformflag,
+                                          float (*vert_coords_prev)[3],
+                                          const char *defgrp_name,
+                                          const Mesh *me_target,
+                                          BMEditMesh *em_target,
+                                          bGPDstroke *gps_target)
 {
   bArmature *arm = ob_arm->data;
   bPoseChannel **pchan_from_defbase = NULL;
@@ -486,7 +844,7 @@ static void armature_deform_coords_impl(const Object *ob_arm,
 
   /* in editmode, or not an armature */
   if (arm->edbo || (ob_arm->pose == NULL)) {
-    return;
+    return false;
   }
 
   if ((ob_arm->pose->flag & POSE_RECALC) != 0) {
@@ -560,7 +918,7 @@ static void armature_deform_coords_impl(const Object *ob_arm,
     }
   }
 
-  ArmatureUserdata data = {
+  *data = (ArmatureUserdata){
       .ob_arm = ob_arm,
       .ob_target = ob_target,
       .me_target = me_target,
@@ -585,15 +943,111 @@ static void armature_deform_coords_impl(const Object *ob_arm,
   float obinv[4][4];
   invert_m4_m4(obinv, ob_target->obmat);
 
-  mul_m4_m4m4(data.postmat, obinv, ob_arm->obmat);
-  invert_m4_m4(data.premat, data.postmat);
+  mul_m4_m4m4(data->postmat, obinv, ob_arm->obmat);
+  invert_m4_m4(data->premat, data->postmat);
+  return true;
+}
+
+/**
+ * Use the weights from \a skinning_cache for deforming the \a verts_len vertices of
+ * #ArmatureUserdata.me_target, when possible. Without a mesh, as for the leading deform
+ * modifiers of a stack, the weights of the target object's mesh are used. The bone matrices are
+ * combined with #ArmatureUserdata.premat and postmat here.
+ */
+static void armature_deform_userdata_skinning_init(ArmatureUserdata *data,
+                                                   ArmatureSkinningCache *skinning_cache,
+                                                   const int verts_len)
+{
+  if (skinning_cache == NULL || data->ob_target->type != OB_MESH || !data->use_dverts ||
+      data->vert_coords_prev != NULL || data->defbase_len == 0) {
+    return;
+  }
+  const Mesh *me_data = data->ob_target->data;
+  const MDeformVert *dverts = data->dverts;
+  int dverts_len = data->dverts_len;
+  if (data->me_target != NULL) {
+    dverts = data->me_target->dvert;
+    dverts_len = data->me_target->totvert;
+  }
+  if (dverts == NULL || dverts_len != verts_len) {
+    return;
+  }
+
+  /* The weights of the evaluated mesh of the object are only written to when it is copied
+   * again, which tags it for an update. Other meshes are temporary, another one can reuse the
+   * address of their weights. */
+  const bool dverts_unchanged = dverts == me_data->dvert &&
+                                (me_data->id.recalc & ID_RECALC_ALL) == 0;
+  skinning_cache_ensure(
+      skinning_cache, dverts, verts_len, data->armature_def_nr, dverts_unchanged);
+  data->skinning = skinning_cache;
+
+  data->defbase_use_mat = MEM_malloc_arrayN(
+      (size_t)data->defbase_len, sizeof(*data->defbase_use_mat), __func__);
+  if (!data->use_quaternion) {
+    data->defbase_mats = MEM_malloc_arrayN(
+        (size_t)data->defbase_len, sizeof(*data->defbase_mats), __func__);
+  }
+  for (int i = 0; i < data->defbase_len; i++) {
+    const bPoseChannel *pchan = data->pchan_from_defbase[i];
+    data->defbase_use_mat[i] = false;
+    if (pchan == NULL) {
+      continue;
+    }
+    const Bone *bone = pchan->bone;
+    if ((bone->segments > 1 && pchan->runtime.bbone_segments == bone->segments) ||
+        (bone->flag & BONE_MULT_VG_ENV)) {
+      continue;
+    }
+    data->defbase_use_mat[i] = true;
+    if (data->defbase_mats) {
+      mul_m4_series(data->defbase_mats[i], data->postmat, pchan->chan_mat, data->premat);
+    }
+  }
+}
+
+static void armature_deform_userdata_free(ArmatureUserdata *data)
+{
+  MEM_SAFE_FREE(data->pchan_from_defbase);
+  MEM_SAFE_FREE(data->defbase_use_mat);
+  MEM_SAFE_FREE(data->defbase_mats);
+}
+
+static void armature_deform_coords_impl(const Object *ob_arm,
+                                        const Object *ob_target,
+                                        float (*vert_coords)[3],
+                                        float (*vert_deform_mats)[3][3],
+                                        const int vert_coords_len,
+                                        const int deformflag,
+                                        float (*vert_coords_prev)[3],
+                                        const char *defgrp_name,
+                                        const Mesh *me_target,
+                                        ArmatureSkinningCache *skinning_cache,
+                                        BMEditMesh *em_target,
+                                        bGPDstroke *gps_target)
+{
+  ArmatureUserdata data;
+  if (!armature_deform_userdata_init(&data,
+                                     ob_arm,
+                                     ob_target,
+                                     vert_coords,
+                                     vert_deform_mats,
+                                     deformflag,
+                                     vert_coords_prev,
+                                     defgrp_name,
+                                     me_target,
+                                     em_target,
+                                     gps_target)) {
+    return;
+  }
+  armature_deform_userdata_skinning_init(&data, skinning_cache, vert_coords_len);
 
   if (em_target != NULL) {
     /* While this could cause an extra loop over mesh data, in most cases this will
      * have already been properly set. */
     BM_mesh_elem_index_ensure(em_target->bm, BM_VERT);
 
-    if (use_dverts) {
+    if (data.use_dverts) {
       BLI_task_parallel_mempool(em_target->bm->vpool, &data, armature_vert_task_editmesh, true);
     }
     else {
@@ -608,9 +1062,7 @@ static void armature_deform_coords_impl(const Object *ob_arm,
     BLI_task_parallel_range(0, vert_coords_len, &data, armature_vert_task, &settings);
   }
 
-  if (pchan_from_defbase) {
-    MEM_freeN(pchan_from_defbase);
-  }
+  armature_deform_userdata_free(&data);
 }
 
 void BKE_armature_deform_coords_with_gpencil_stroke(const Object *ob_arm,
@@ -633,6 +1085,7 @@ void BKE_armature_deform_coords_with_gpencil_stroke(const Object *ob_arm,
                               defgrp_name,
                               NULL,
                               NULL,
+                              NULL,
                               gps_target);
 }
 
@@ -644,7 +1097,8 @@ void BKE_armature_deform_coords_with_mesh(const Object *ob_arm,
                                           int deformflag,
                                           float (*vert_coords_prev)[3],
                                           const char *defgrp_name,
-                                          const Mesh *me_target)
+                                          const Mesh *me_target,
+                                          ArmatureSkinningCache *skinning_cache)
 {
   armature_deform_coords_impl(ob_arm,
                               ob_target,
@@ -655,10 +1109,77 @@ void BKE_armature_deform_coords_with_mesh(const Object *ob_arm,
                               vert_coords_prev,
                               defgrp_name,
                               me_target,
+                              skinning_cache,
                               NULL,
                               NULL);
 }
 
+/** Armature deformation prepared for evaluating ranges of vertices one after another. */
+typedef struct ArmatureDeformRange {
+  ArmatureUserdata data;
+} ArmatureDeformRange;
+
+/**
+ * Prepare deforming the \a verts_num vertices of \a me_target in ranges, with
+ * #BKE_armature_deform_range_eval. Returns null when the armature has no effect.
+ *
+ * Unlike #BKE_armature_deform_coords_with_mesh, this doesn't support blending with previous
+ * coordinates or deform matrices.
+ */
+ArmatureDeformRange *BKE_armature_deform_range_create_with_mesh(
+    const Object *ob_arm,
+    const Object *ob_target,
+    int deformflag,
+    const char *defgrp_name,
+    const Mesh *me_target,
+    int verts_num,
+    ArmatureSkinningCache *skinning_cache)
+{
+  ArmatureDeformRange *range = MEM_mallocN(sizeof(*range), __func__);
+  if (!armature_deform_userdata_init(&range->data,
+                                     ob_arm,
+                                     ob_target,
+                                     NULL,
+                                     NULL,
+                                     deformflag,
+                                     NULL,
+                                     defgrp_name,
+                                     me_target,
+                                     NULL,
+                                     NULL)) {
+    MEM_freeN(range);
+    return NULL;
+  }
+  armature_deform_userdata_skinning_init(&range->data, skinning_cache, verts_num);
+  return range;
+}
+
+/**
+ * Deform the vertices from \a start up to \a end, can be called from multiple threads at once.
+ */
+void BKE_armature_deform_range_eval(const ArmatureDeformRange *range,
+                                    float (*vert_coords)[3],
+                                    const int start,
+                                    const int end)
+{
+  ArmatureUserdata data = range->data;
+  data.vert_coords = vert_coords;
+  for (int i = start; i < end; i++) {
+    if (data.skinning) {
+      armature_vert_task_with_skinning(&data, i);
+    }
+    else {
+      armature_vert_task_with_dvert(&data, i, armature_vert_dvert_get(&data, i));
+    }
+  }
+}
+
+void BKE_armature_deform_range_destroy(ArmatureDeformRange *range)
+{
+  armature_deform_userdata_free(&range->data);
+  MEM_freeN(range);
+}
+
 void BKE_armature_deform_coords_with_editmesh(const Object *ob_arm,
                                               const Object *ob_target,
                                               float (*vert_coords)[3],
@@ -678,6 +1199,7 @@ void BKE_armature_deform_coords_with_editmesh(const Object *ob_arm,
                               vert_coords_prev,
                               defgrp_name,
                               NULL,
+                              NULL,
                               em_target,
                               NULL);
 }
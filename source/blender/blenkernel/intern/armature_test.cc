@@ -19,7 +19,26 @@
 
 #include "BKE_armature.h"
 
+#include "MEM_guardedalloc.h"
+
+#include "BKE_action.h"
+#include "BKE_customdata.h"
+#include "BKE_deform.h"
+#include "BKE_lib_id.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_object.h"
+
+#include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_string.h"
+
+#include "DNA_armature_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+
+#include "tests/blenkernel_testing.hh"
 
 #include "testing/testing.h"
 
@@ -157,4 +176,149 @@ TEST(vec_roll_to_mat3_normalized, Rotationmatrix)
   }
 }
 
+class ArmatureDeformTest : public MeshTest {
+ public:
+  Main *bmain;
+  Object *ob_arm;
+  Object *ob_target;
+  Mesh *mesh;
+
+  void SetUp() override
+  {
+    bmain = BKE_main_new();
+
+    /* A translated bone and a rotated bone. */
+    bArmature *arm = BKE_armature_add(bmain, "Armature");
+    ob_arm = BKE_object_add_only_object(bmain, OB_ARMATURE, "Armature");
+    ob_arm->data = arm;
+    unit_m4(ob_arm->obmat);
+    add_bone(arm, "Translated", 0.0f);
+    add_bone(arm, "Rotated", 1.0f);
+    BKE_armature_where_is(arm);
+    BKE_pose_rebuild(bmain, ob_arm, arm, false);
+    ob_arm->pose->flag &= ~POSE_RECALC;
+
+    LISTBASE_FOREACH (bPoseChannel *, pchan, &ob_arm->pose->chanbase) {
+      float pose_mat[4][4];
+      copy_m4_m4(pose_mat, pchan->bone->arm_mat);
+      if (STREQ(pchan->name, "Translated")) {
+        pose_mat[3][2] += 1.0f;
+      }
+      else {
+        float rot[4][4];
+        axis_angle_to_mat4_single(rot, 'Z', (float)M_PI_2);
+        mul_m4_m4_pre(pose_mat, rot);
+      }
+      float imat[4][4];
+      invert_m4_m4(imat, pchan->bone->arm_mat);
+      mul_m4_m4m4(pchan->chan_mat, pose_mat, imat);
+      mat4_to_dquat(&pchan->runtime.deform_dual_quat, pchan->bone->arm_mat, pchan->chan_mat);
+    }
+
+    /* The "Other" group has no bone. */
+    ob_target = BKE_object_add_only_object(bmain, OB_MESH, "Target");
+    ob_target->data = BKE_mesh_add(bmain, "Target");
+    unit_m4(ob_target->obmat);
+    for (const char *name : {"Translated", "Rotated", "Other"}) {
+      bDeformGroup *defgroup = (bDeformGroup *)MEM_callocN(sizeof(bDeformGroup), __func__);
+      STRNCPY(defgroup->name, name);
+      BLI_addtail(&ob_target->defbase, defgroup);
+    }
+
+    const int verts_num = 50;
+    mesh = BKE_mesh_new_nomain(verts_num, 0, 0, 0, 0);
+    mesh->dvert = (MDeformVert *)CustomData_add_layer(
+        &mesh->vdata, CD_MDEFORMVERT, CD_CALLOC, nullptr, verts_num);
+    for (int i = 0; i < verts_num; i++) {
+      mesh->mvert[i].co[0] = (float)(i % 5);
+      mesh->mvert[i].co[1] = (float)(i / 5) * 0.25f;
+      mesh->mvert[i].co[2] = (float)(i % 3);
+      /* Some vertices without weights, or only in the group without bone. */
+      if (i % 7 != 0) {
+        BKE_defvert_add_index_notest(&mesh->dvert[i], i % 2, (float)(i % 4) * 0.25f);
+      }
+      if (i % 3 != 0) {
+        BKE_defvert_add_index_notest(&mesh->dvert[i], 1 - i % 2, 0.5f);
+      }
+      if (i % 4 == 0) {
+        BKE_defvert_add_index_notest(&mesh->dvert[i], 2, (float)(i % 5) * 0.2f);
+      }
+    }
+  }
+
+  void TearDown() override
+  {
+    BKE_id_free(nullptr, mesh);
+    BKE_main_free(bmain);
+  }
+
+  static void add_bone(bArmature *arm, const char *name, const float x)
+  {
+    Bone *bone = (Bone *)MEM_callocN(sizeof(Bone), __func__);
+    STRNCPY(bone->name, name);
+    copy_v3_fl3(bone->head, x, 0.0f, 0.0f);
+    copy_v3_fl3(bone->tail, x, 1.0f, 0.0f);
+    bone->length = 1.0f;
+    BLI_addtail(&arm->bonebase, bone);
+  }
+
+  /* Compare deforming with and without the skinning table. */
+  void expect_skinning_cache_matches(ArmatureSkinningCache *cache,
+                                     const int deformflag,
+                                     const char *defgrp_name)
+  {
+    const int verts_num = mesh->totvert;
+    float(*coords)[3] = BKE_mesh_vert_coords_alloc(mesh, nullptr);
+    float(*coords_cached)[3] = BKE_mesh_vert_coords_alloc(mesh, nullptr);
+    float(*mats)[3][3] = (float(*)[3][3])MEM_malloc_arrayN(verts_num, sizeof(*mats), __func__);
+    float(*mats_cached)[3][3] = (float(*)[3][3])MEM_malloc_arrayN(
+        verts_num, sizeof(*mats), __func__);
+    for (int i = 0; i < verts_num; i++) {
+      unit_m3(mats[i]);
+      unit_m3(mats_cached[i]);
+    }
+
+    BKE_armature_deform_coords_with_mesh(
+        ob_arm, ob_target, coords, mats, verts_num, deformflag, nullptr, defgrp_name, mesh, nullptr);
+    BKE_armature_deform_coords_with_mesh(ob_arm,
+                                         ob_target,
+                                         coords_cached,
+                                         mats_cached,
+                                         verts_num,
+                                         deformflag,
+                                         nullptr,
+                                         defgrp_name,
+                                         mesh,
+                                         cache);
+    for (int i = 0; i < verts_num; i++) {
+      EXPECT_V3_NEAR(coords_cached[i], coords[i], 1e-5f);
+      EXPECT_M3_NEAR(mats_cached[i], mats[i], 1e-5f);
+    }
+
+    MEM_freeN(coords);
+    MEM_freeN(coords_cached);
+    MEM_freeN(mats);
+    MEM_freeN(mats_cached);
+  }
+};
+
+TEST_F(ArmatureDeformTest, skinning_cache)
+{
+  ArmatureSkinningCache *cache = BKE_armature_skinning_cache_create();
+  for (const int deformflag : {int(ARM_DEF_VGROUP), ARM_DEF_VGROUP | ARM_DEF_QUATERNION}) {
+    for (const char *defgrp_name : {"", "Other"}) {
+      expect_skinning_cache_matches(cache, deformflag, defgrp_name);
+      expect_skinning_cache_matches(cache, deformflag | ARM_DEF_INVERT_VGROUP, defgrp_name);
+    }
+  }
+
+  /* Changed weights are taken into account. */
+  mesh->dvert[1].dw[0].weight = 1.0f;
+  BKE_defvert_add_index_notest(&mesh->dvert[2], 2, 0.5f);
+  expect_skinning_cache_matches(cache, ARM_DEF_VGROUP, "Other");
+  expect_skinning_cache_matches(cache, ARM_DEF_VGROUP, "");
+
+  BKE_armature_skinning_cache_free(cache);
+}
+
 }  // namespace blender::bke::tests
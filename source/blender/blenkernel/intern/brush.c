@@ -2461,6 +2461,92 @@ float BKE_brush_curve_strength(const Brush *br, float p, const float len)
   return strength;
 }
 
+/**
+ * Same as #BKE_brush_curve_strength for an array of distances, which are replaced by their
+ * strength. The preset is only looked up once, so every loop is simple enough for the compiler
+ * to vectorize.
+ */
+void BKE_brush_curve_strength_array(const Brush *br,
+                                    float *r_values,
+                                    const int values_len,
+                                    const float len)
+{
+  if (br->curve_preset == BRUSH_CURVE_CUSTOM) {
+    for (int i = 0; i < values_len; i++) {
+      r_values[i] = BKE_brush_curve_strength(br, r_values[i], len);
+    }
+    return;
+  }
+  if (!ELEM(br->curve_preset,
+            BRUSH_CURVE_SHARP,
+            BRUSH_CURVE_SMOOTH,
+            BRUSH_CURVE_SMOOTHER,
+            BRUSH_CURVE_ROOT,
+            BRUSH_CURVE_LIN,
+            BRUSH_CURVE_SPHERE,
+            BRUSH_CURVE_POW4,
+            BRUSH_CURVE_INVSQUARE)) {
+    /* Constant strength inside of the brush. */
+    for (int i = 0; i < values_len; i++) {
+      r_values[i] = (r_values[i] < len) ? 1.0f : 0.0f;
+    }
+    return;
+  }
+
+  /* The remaining presets are all zero at the edge of the brush, so distances outside of it only
+   * have to be clamped there. */
+  for (int i = 0; i < values_len; i++) {
+    const float p = 1.0f - r_values[i] / len;
+    r_values[i] = (r_values[i] < len) ? p : 0.0f;
+  }
+
+  switch (br->curve_preset) {
+    case BRUSH_CURVE_SHARP:
+      for (int i = 0; i < values_len; i++) {
+        const float p = r_values[i];
+        r_values[i] = p * p;
+      }
+      break;
+    case BRUSH_CURVE_SMOOTH:
+      for (int i = 0; i < values_len; i++) {
+        const float p = r_values[i];
+        r_values[i] = 3.0f * p * p - 2.0f * p * p * p;
+      }
+      break;
+    case BRUSH_CURVE_SMOOTHER:
+      for (int i = 0; i < values_len; i++) {
+        const float p = r_values[i];
+        r_values[i] = pow3f(p) * (p * (p * 6.0f - 15.0f) + 10.0f);
+      }
+      break;
+    case BRUSH_CURVE_ROOT:
+      for (int i = 0; i < values_len; i++) {
+        r_values[i] = sqrtf(r_values[i]);
+      }
+      break;
+    case BRUSH_CURVE_LIN:
+      break;
+    case BRUSH_CURVE_SPHERE:
+      for (int i = 0; i < values_len; i++) {
+        const float p = r_values[i];
+        r_values[i] = sqrtf(2 * p - p * p);
+      }
+      break;
+    case BRUSH_CURVE_POW4:
+      for (int i = 0; i < values_len; i++) {
+        const float p = r_values[i];
+        r_values[i] = p * p * p * p;
+      }
+      break;
+    case BRUSH_CURVE_INVSQUARE:
+      for (int i = 0; i < values_len; i++) {
+        const float p = r_values[i];
+        r_values[i] = p * (2.0f - p);
+      }
+      break;
+  }
+}
+
 /* Uses the brush curve control to find a strength value between 0 and 1 */
 float BKE_brush_curve_strength_clamped(Brush *br, float p, const float len)
 {
@@ -0,0 +1,50 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "DNA_brush_types.h"
+#include "DNA_color_types.h"
+
+#include "BKE_brush.h"
+#include "BKE_colortools.h"
+
+#include "BLI_vector.hh"
+
+namespace blender::bke::tests {
+
+TEST(brush, curve_strength_array)
+{
+  const float radius = 0.37f;
+  Vector<float> distances;
+  for (int i = 0; i <= 100; i++) {
+    distances.append(radius * 1.2f * i / 100.0f);
+  }
+  distances.append(radius);
+
+  Brush brush = {};
+  brush.curve = BKE_curvemapping_add(1, 0.0f, 0.0f, 1.0f, 1.0f);
+  BKE_curvemapping_init(brush.curve);
+
+  for (const int preset : {BRUSH_CURVE_CUSTOM,
+                           BRUSH_CURVE_SMOOTH,
+                           BRUSH_CURVE_SPHERE,
+                           BRUSH_CURVE_ROOT,
+                           BRUSH_CURVE_SHARP,
+                           BRUSH_CURVE_LIN,
+                           BRUSH_CURVE_POW4,
+                           BRUSH_CURVE_INVSQUARE,
+                           BRUSH_CURVE_CONSTANT,
+                           BRUSH_CURVE_SMOOTHER}) {
+    brush.curve_preset = preset;
+    Vector<float> strengths = distances;
+    BKE_brush_curve_strength_array(&brush, strengths.data(), strengths.size(), radius);
+    for (const int i : distances.index_range()) {
+      EXPECT_EQ(strengths[i], BKE_brush_curve_strength(&brush, distances[i], radius))
+          << "preset " << preset << ", distance " << distances[i];
+    }
+  }
+
+  BKE_curvemapping_free(brush.curve);
+}
+
+}  // namespace blender::bke::tests
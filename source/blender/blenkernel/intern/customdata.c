@@ -3641,7 +3641,11 @@ void CustomData_bmesh_free_block_data(CustomData *data, void *block)
   }
 }
 
-static void CustomData_bmesh_alloc_block(CustomData *data, void **block)
+/**
+ * Allocate a block from the pool of \a data, without initializing it. Allocating is not thread
+ * safe, so this can be used to allocate all blocks before filling them in parallel.
+ */
+void CustomData_bmesh_alloc_block(CustomData *data, void **block)
 {
   if (*block) {
     CustomData_bmesh_free_block(data, block);
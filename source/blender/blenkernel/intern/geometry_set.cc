@@ -21,9 +21,11 @@
 #include "BKE_geometry_set.hh"
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 #include "BKE_mesh_wrapper.h"
 #include "BKE_modifier.h"
 #include "BKE_pointcloud.h"
+#include "BKE_pointcloud_spatial_index.hh"
 #include "BKE_volume.h"
 
 #include "DNA_collection_types.h"
@@ -327,7 +329,15 @@ GeometryComponent *MeshComponent::copy() const
 {
   MeshComponent *new_component = new MeshComponent();
   if (mesh_ != nullptr) {
-    new_component->mesh_ = BKE_mesh_copy_for_eval(mesh_, false);
+    if (ownership_ == GeometryOwnershipType::Owned) {
+      /* Most data is rarely changed after a copy, so share it instead of duplicating it. This
+       * moves the layers of the source into the shared storage, which is only allowed when the
+       * component owns the mesh. */
+      new_component->mesh_ = BKE_mesh_copy_for_eval_shared_topology(mesh_);
+    }
+    else {
+      new_component->mesh_ = BKE_mesh_copy_for_eval(mesh_, false);
+    }
     new_component->ownership_ = GeometryOwnershipType::Owned;
     new_component->vertex_group_names_ = blender::Map(vertex_group_names_);
   }
@@ -511,6 +521,10 @@ PointCloud *PointCloudComponent::get_for_write()
     pointcloud_ = BKE_pointcloud_copy_for_eval(pointcloud_, false);
     ownership_ = GeometryOwnershipType::Owned;
   }
+  else if (pointcloud_ != nullptr) {
+    /* The caller may change the positions. */
+    BKE_pointcloud_spatial_index_free(pointcloud_);
+  }
   return pointcloud_;
 }
 
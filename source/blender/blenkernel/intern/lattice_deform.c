@@ -337,15 +337,19 @@ static void lattice_vert_task_editmesh_no_dvert(void *__restrict userdata, Mempo
   lattice_deform_vert_with_dvert(data, BM_elem_index_get(v), NULL);
 }
 
-static void lattice_deform_coords_impl(const Object *ob_lattice,
-                                       const Object *ob_target,
-                                       float (*vert_coords)[3],
-                                       const int vert_coords_len,
-                                       const short flag,
-                                       const char *defgrp_name,
-                                       const float fac,
-                                       const Mesh *me_target,
-                                       BMEditMesh *em_target)
+/**
+ * Fill in \a data for deforming with \a ob_lattice, returns false when it is not a lattice.
+ * On success #LatticeDeformUserdata.lattice_deform_data has to be freed by the caller.
+ */
+static bool lattice_deform_userdata_init(LatticeDeformUserdata *data,
+                                         const Object *ob_lattice,
+                                         const Object *ob_target,
+                                         float (*vert_coords)[3],
+                                         const short flag,
+                                         const char *defgrp_name,
+                                         const float fac,
+                                         const Mesh *me_target,
+                                         BMEditMesh *em_target)
 {
   LatticeDeformData *lattice_deform_data;
   const MDeformVert *dvert = NULL;
@@ -353,7 +357,7 @@ static void lattice_deform_coords_impl(const Object *ob_lattice,
   int cd_dvert_offset = -1;
 
   if (ob_lattice->type != OB_LATTICE) {
-    return;
+    return false;
   }
 
   lattice_deform_data = BKE_lattice_deform_data_create(ob_lattice, ob_target);
@@ -381,7 +385,7 @@ static void lattice_deform_coords_impl(const Object *ob_lattice,
     }
   }
 
-  LatticeDeformUserdata data = {
+  *data = (LatticeDeformUserdata){
       .lattice_deform_data = lattice_deform_data,
       .vert_coords = vert_coords,
       .dvert = dvert,
@@ -393,13 +397,38 @@ static void lattice_deform_coords_impl(const Object *ob_lattice,
               .cd_dvert_offset = cd_dvert_offset,
           },
   };
+  return true;
+}
+
+static void lattice_deform_coords_impl(const Object *ob_lattice,
+                                       const Object *ob_target,
+                                       float (*vert_coords)[3],
+                                       const int vert_coords_len,
+                                       const short flag,
+                                       const char *defgrp_name,
+                                       const float fac,
+                                       const Mesh *me_target,
+                                       BMEditMesh *em_target)
+{
+  LatticeDeformUserdata data;
+  if (!lattice_deform_userdata_init(&data,
+                                    ob_lattice,
+                                    ob_target,
+                                    vert_coords,
+                                    flag,
+                                    defgrp_name,
+                                    fac,
+                                    me_target,
+                                    em_target)) {
+    return;
+  }
 
   if (em_target != NULL) {
     /* While this could cause an extra loop over mesh data, in most cases this will
      * have already been properly set. */
     BM_mesh_elem_index_ensure(em_target->bm, BM_VERT);
 
-    if (cd_dvert_offset != -1) {
+    if (data.bmesh.cd_dvert_offset != -1) {
       BLI_task_parallel_mempool(em_target->bm->vpool, &data, lattice_vert_task_editmesh, true);
     }
     else {
@@ -414,7 +443,7 @@ static void lattice_deform_coords_impl(const Object *ob_lattice,
     BLI_task_parallel_range(0, vert_coords_len, &data, lattice_deform_vert_task, &settings);
   }
 
-  BKE_lattice_deform_data_destroy(lattice_deform_data);
+  BKE_lattice_deform_data_destroy(data.lattice_deform_data);
 }
 
 void BKE_lattice_deform_coords(const Object *ob_lattice,
@@ -449,6 +478,52 @@ void BKE_lattice_deform_coords_with_mesh(const Object *ob_lattice,
                              NULL);
 }
 
+/** Lattice deformation prepared for evaluating ranges of vertices one after another. */
+typedef struct LatticeDeformRange {
+  LatticeDeformUserdata data;
+} LatticeDeformRange;
+
+/**
+ * Prepare deforming the vertices of \a me_target in ranges, with
+ * #BKE_lattice_deform_range_eval. Returns null when \a ob_lattice is not a lattice.
+ */
+LatticeDeformRange *BKE_lattice_deform_range_create_with_mesh(const Object *ob_lattice,
+                                                              const Object *ob_target,
+                                                              const short flag,
+                                                              const char *defgrp_name,
+                                                              const float fac,
+                                                              const Mesh *me_target)
+{
+  LatticeDeformRange *range = MEM_mallocN(sizeof(*range), __func__);
+  if (!lattice_deform_userdata_init(
+          &range->data, ob_lattice, ob_target, NULL, flag, defgrp_name, fac, me_target, NULL)) {
+    MEM_freeN(range);
+    return NULL;
+  }
+  return range;
+}
+
+/**
+ * Deform the vertices from \a start up to \a end, can be called from multiple threads at once.
+ */
+void BKE_lattice_deform_range_eval(const LatticeDeformRange *range,
+                                   float (*vert_coords)[3],
+                                   const int start,
+                                   const int end)
+{
+  LatticeDeformUserdata data = range->data;
+  data.vert_coords = vert_coords;
+  for (int index = start; index < end; index++) {
+    lattice_deform_vert_with_dvert(&data, index, data.dvert ? &data.dvert[index] : NULL);
+  }
+}
+
+void BKE_lattice_deform_range_destroy(LatticeDeformRange *range)
+{
+  BKE_lattice_deform_data_destroy(range->data.lattice_deform_data);
+  MEM_freeN(range);
+}
+
 void BKE_lattice_deform_coords_with_editmesh(const struct Object *ob_lattice,
                                              const struct Object *ob_target,
                                              float (*vert_coords)[3],
@@ -805,6 +805,7 @@ static void mesh_clear_geometry(Mesh *mesh)
   CustomData_free(&mesh->fdata, mesh->totface);
   CustomData_free(&mesh->ldata, mesh->totloop);
   CustomData_free(&mesh->pdata, mesh->totpoly);
+  BKE_mesh_runtime_shared_topology_release(mesh);
 
   MEM_SAFE_FREE(mesh->mselect);
   MEM_SAFE_FREE(mesh->edit_mesh);
@@ -985,6 +986,10 @@ Mesh *BKE_mesh_new_nomain_from_template(const Mesh *me_src,
 
 void BKE_mesh_eval_delete(struct Mesh *mesh_eval)
 {
+  /* Evaluated meshes shared by multiple objects are freed by their last user. */
+  if (!BKE_mesh_runtime_eval_shared_release(mesh_eval)) {
+    return;
+  }
   /* Evaluated mesh may point to edit mesh, but never owns it. */
   mesh_eval->edit_mesh = NULL;
   BKE_mesh_free(mesh_eval);
@@ -2147,6 +2152,7 @@ void BKE_mesh_eval_geometry(Depsgraph *depsgraph, Mesh *mesh)
     BKE_id_free(NULL, mesh->runtime.mesh_eval);
     mesh->runtime.mesh_eval = NULL;
   }
+  BKE_mesh_runtime_eval_shared_clear(mesh);
   if (DEG_is_active(depsgraph)) {
     Mesh *mesh_orig = (Mesh *)DEG_get_original_id(&mesh->id);
     if (mesh->texflag & ME_AUTOSPACE_EVALUATED) {
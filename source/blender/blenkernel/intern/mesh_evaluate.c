@@ -41,6 +41,7 @@
 #include "BLI_math.h"
 #include "BLI_memarena.h"
 #include "BLI_polyfill_2d.h"
+#include "BLI_simd.h"
 #include "BLI_stack.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
@@ -49,6 +50,7 @@
 #include "BKE_editmesh_cache.h"
 #include "BKE_global.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 #include "BKE_multires.h"
 #include "BKE_report.h"
 
@@ -206,6 +208,143 @@ void BKE_mesh_calc_normals_mapping_ex(MVert *mverts,
   fnors = pnors = NULL;
 }
 
+/* Triangles and quads are processed four at a time, one polygon per SIMD lane, when a block of
+ * consecutive polygons all have the same number of corners (the common case for meshes which
+ * only have triangles or quads). The math is the same as the scalar code, operation for
+ * operation, so results are identical. */
+
+/** Number of consecutive polygons handled together by the block callbacks. */
+#define MESH_POLY_BLOCK_SIZE 4
+
+#ifdef BLI_HAVE_SSE2
+
+/**
+ * \return The number of corners shared by all polygons of the block,
+ * or zero when they differ or the block is not complete.
+ */
+static int mesh_poly_block_totloop(const MPoly *mpolys, const int numPolys, const int block)
+{
+  const int pidx_start = block * MESH_POLY_BLOCK_SIZE;
+  if (pidx_start + MESH_POLY_BLOCK_SIZE > numPolys) {
+    return 0;
+  }
+  const MPoly *mp = &mpolys[pidx_start];
+  const int totloop = mp[0].totloop;
+  for (int i = 1; i < MESH_POLY_BLOCK_SIZE; i++) {
+    if (mp[i].totloop != totloop) {
+      return 0;
+    }
+  }
+  return totloop;
+}
+
+/** Four 3D vectors, as a structure of arrays. */
+typedef struct MeshPolySIMDFloat3 {
+  __m128 x, y, z;
+} MeshPolySIMDFloat3;
+
+/** Gather the coordinates of the \a corner of each polygon of the block. */
+BLI_INLINE void mesh_poly_simd_gather_co(MeshPolySIMDFloat3 *r_co,
+                                         const MVert *mverts,
+                                         const MLoop *mloop,
+                                         const MPoly *mp,
+                                         const int corner)
+{
+  const float *co_a = mverts[mloop[mp[0].loopstart + corner].v].co;
+  const float *co_b = mverts[mloop[mp[1].loopstart + corner].v].co;
+  const float *co_c = mverts[mloop[mp[2].loopstart + corner].v].co;
+  const float *co_d = mverts[mloop[mp[3].loopstart + corner].v].co;
+  r_co->x = _mm_set_ps(co_d[0], co_c[0], co_b[0], co_a[0]);
+  r_co->y = _mm_set_ps(co_d[1], co_c[1], co_b[1], co_a[1]);
+  r_co->z = _mm_set_ps(co_d[2], co_c[2], co_b[2], co_a[2]);
+}
+
+/** Write the vector of each lane to \a r_vecs, starting at the polygon of the first lane. */
+BLI_INLINE void mesh_poly_simd_scatter(float (*r_vecs)[3], const MeshPolySIMDFloat3 *v)
+{
+  float x[4], y[4], z[4];
+  _mm_storeu_ps(x, v->x);
+  _mm_storeu_ps(y, v->y);
+  _mm_storeu_ps(z, v->z);
+  for (int i = 0; i < MESH_POLY_BLOCK_SIZE; i++) {
+    r_vecs[i][0] = x[i];
+    r_vecs[i][1] = y[i];
+    r_vecs[i][2] = z[i];
+  }
+}
+
+BLI_INLINE void mesh_poly_simd_sub(MeshPolySIMDFloat3 *r,
+                                   const MeshPolySIMDFloat3 *a,
+                                   const MeshPolySIMDFloat3 *b)
+{
+  r->x = _mm_sub_ps(a->x, b->x);
+  r->y = _mm_sub_ps(a->y, b->y);
+  r->z = _mm_sub_ps(a->z, b->z);
+}
+
+BLI_INLINE void mesh_poly_simd_cross(MeshPolySIMDFloat3 *r,
+                                     const MeshPolySIMDFloat3 *a,
+                                     const MeshPolySIMDFloat3 *b)
+{
+  r->x = _mm_sub_ps(_mm_mul_ps(a->y, b->z), _mm_mul_ps(a->z, b->y));
+  r->y = _mm_sub_ps(_mm_mul_ps(a->z, b->x), _mm_mul_ps(a->x, b->z));
+  r->z = _mm_sub_ps(_mm_mul_ps(a->x, b->y), _mm_mul_ps(a->y, b->x));
+}
+
+BLI_INLINE __m128 mesh_poly_simd_dot(const MeshPolySIMDFloat3 *a, const MeshPolySIMDFloat3 *b)
+{
+  return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a->x, b->x), _mm_mul_ps(a->y, b->y)),
+                    _mm_mul_ps(a->z, b->z));
+}
+
+/** Same as #add_newell_cross_v3_v3v3. */
+BLI_INLINE void mesh_poly_simd_add_newell_cross(MeshPolySIMDFloat3 *n,
+                                                const MeshPolySIMDFloat3 *v_prev,
+                                                const MeshPolySIMDFloat3 *v_curr)
+{
+  const MeshPolySIMDFloat3 *a = v_prev, *b = v_curr;
+  n->x = _mm_add_ps(n->x, _mm_mul_ps(_mm_sub_ps(a->y, b->y), _mm_add_ps(a->z, b->z)));
+  n->y = _mm_add_ps(n->y, _mm_mul_ps(_mm_sub_ps(a->z, b->z), _mm_add_ps(a->x, b->x)));
+  n->z = _mm_add_ps(n->z, _mm_mul_ps(_mm_sub_ps(a->x, b->x), _mm_add_ps(a->y, b->y)));
+}
+
+/** Same as #normalize_v3, \return The mask of lanes which could not be normalized. */
+BLI_INLINE __m128 mesh_poly_simd_normalize(MeshPolySIMDFloat3 *n)
+{
+  const __m128 len_squared = mesh_poly_simd_dot(n, n);
+  const __m128 is_valid = _mm_cmpgt_ps(len_squared, _mm_set1_ps(1.0e-35f));
+  const __m128 fac = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(len_squared));
+  n->x = _mm_and_ps(_mm_mul_ps(n->x, fac), is_valid);
+  n->y = _mm_and_ps(_mm_mul_ps(n->y, fac), is_valid);
+  n->z = _mm_and_ps(_mm_mul_ps(n->z, fac), is_valid);
+  return _mm_cmple_ps(len_squared, _mm_set1_ps(1.0e-35f));
+}
+
+/** Same as #normal_tri_v3 and #normal_quad_v3 (as used by #BKE_mesh_calc_poly_normal). */
+static void mesh_poly_simd_calc_normal(MeshPolySIMDFloat3 *r_no,
+                                       const MVert *mverts,
+                                       const MLoop *mloop,
+                                       const MPoly *mp,
+                                       const int totloop)
+{
+  MeshPolySIMDFloat3 co[4], n1, n2;
+  for (int i = 0; i < totloop; i++) {
+    mesh_poly_simd_gather_co(&co[i], mverts, mloop, mp, i);
+  }
+  if (totloop == 3) {
+    mesh_poly_simd_sub(&n1, &co[0], &co[1]);
+    mesh_poly_simd_sub(&n2, &co[1], &co[2]);
+  }
+  else {
+    mesh_poly_simd_sub(&n1, &co[0], &co[2]);
+    mesh_poly_simd_sub(&n2, &co[1], &co[3]);
+  }
+  mesh_poly_simd_cross(r_no, &n1, &n2);
+  mesh_poly_simd_normalize(r_no);
+}
+
+#endif /* BLI_HAVE_SSE2 */
+
 typedef struct MeshCalcNormalsData {
   const MPoly *mpolys;
   const MLoop *mloop;
@@ -213,23 +352,36 @@ typedef struct MeshCalcNormalsData {
   float (*pnors)[3];
   float (*lnors_weighted)[3];
   float (*vnors)[3];
+  int numPolys;
 } MeshCalcNormalsData;
 
 static void mesh_calc_normals_poly_cb(void *__restrict userdata,
-                                      const int pidx,
+                                      const int block,
                                       const TaskParallelTLS *__restrict UNUSED(tls))
 {
   MeshCalcNormalsData *data = userdata;
-  const MPoly *mp = &data->mpolys[pidx];
+  const int pidx_start = block * MESH_POLY_BLOCK_SIZE;
+
+#ifdef BLI_HAVE_SSE2
+  const int totloop = mesh_poly_block_totloop(data->mpolys, data->numPolys, block);
+  if (ELEM(totloop, 3, 4)) {
+    MeshPolySIMDFloat3 no;
+    mesh_poly_simd_calc_normal(
+        &no, data->mverts, data->mloop, &data->mpolys[pidx_start], totloop);
+    mesh_poly_simd_scatter(&data->pnors[pidx_start], &no);
+    return;
+  }
+#endif
 
-  BKE_mesh_calc_poly_normal(mp, data->mloop + mp->loopstart, data->mverts, data->pnors[pidx]);
+  const int pidx_end = min_ii(pidx_start + MESH_POLY_BLOCK_SIZE, data->numPolys);
+  for (int pidx = pidx_start; pidx < pidx_end; pidx++) {
+    const MPoly *mp = &data->mpolys[pidx];
+    BKE_mesh_calc_poly_normal(mp, data->mloop + mp->loopstart, data->mverts, data->pnors[pidx]);
+  }
 }
 
-static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
-                                              const int pidx,
-                                              const TaskParallelTLS *__restrict UNUSED(tls))
+static void mesh_calc_normals_poly_prepare_single(MeshCalcNormalsData *data, const int pidx)
 {
-  MeshCalcNormalsData *data = userdata;
   const MPoly *mp = &data->mpolys[pidx];
   const MLoop *ml = &data->mloop[mp->loopstart];
   const MVert *mverts = data->mverts;
@@ -288,6 +440,70 @@ static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
   }
 }
 
+#ifdef BLI_HAVE_SSE2
+/** Same as #mesh_calc_normals_poly_prepare_single, for a block of triangles or quads. */
+static void mesh_calc_normals_poly_prepare_simd(MeshCalcNormalsData *data,
+                                                const int pidx_start,
+                                                const int nverts)
+{
+  const MPoly *mp = &data->mpolys[pidx_start];
+
+  MeshPolySIMDFloat3 co[4], edgevec[4], pnor;
+  for (int i = 0; i < nverts; i++) {
+    mesh_poly_simd_gather_co(&co[i], data->mverts, data->mloop, mp, i);
+  }
+
+  pnor.x = pnor.y = pnor.z = _mm_setzero_ps();
+  int i_prev = nverts - 1;
+  for (int i = 0; i < nverts; i++) {
+    mesh_poly_simd_add_newell_cross(&pnor, &co[i_prev], &co[i]);
+    mesh_poly_simd_sub(&edgevec[i_prev], &co[i_prev], &co[i]);
+    mesh_poly_simd_normalize(&edgevec[i_prev]);
+    i_prev = i;
+  }
+  const __m128 is_degenerate = mesh_poly_simd_normalize(&pnor);
+  pnor.z = _mm_or_ps(_mm_andnot_ps(is_degenerate, pnor.z),
+                     _mm_and_ps(is_degenerate, _mm_set1_ps(1.0f)));
+
+  float pnors_temp[MESH_POLY_BLOCK_SIZE][3];
+  float(*pnors)[3] = data->pnors ? &data->pnors[pidx_start] : pnors_temp;
+  mesh_poly_simd_scatter(pnors, &pnor);
+
+  float(*lnors_weighted)[3] = data->lnors_weighted;
+  const MeshPolySIMDFloat3 *prev_edge = &edgevec[nverts - 1];
+  for (int i = 0; i < nverts; i++) {
+    float dots[4];
+    _mm_storeu_ps(dots, mesh_poly_simd_dot(&edgevec[i], prev_edge));
+    for (int j = 0; j < MESH_POLY_BLOCK_SIZE; j++) {
+      const float fac = saacos(-dots[j]);
+      mul_v3_v3fl(lnors_weighted[mp[j].loopstart + i], pnors[j], fac);
+    }
+    prev_edge = &edgevec[i];
+  }
+}
+#endif
+
+static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
+                                              const int block,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshCalcNormalsData *data = userdata;
+  const int pidx_start = block * MESH_POLY_BLOCK_SIZE;
+
+#ifdef BLI_HAVE_SSE2
+  const int totloop = mesh_poly_block_totloop(data->mpolys, data->numPolys, block);
+  if (ELEM(totloop, 3, 4)) {
+    mesh_calc_normals_poly_prepare_simd(data, pidx_start, totloop);
+    return;
+  }
+#endif
+
+  const int pidx_end = min_ii(pidx_start + MESH_POLY_BLOCK_SIZE, data->numPolys);
+  for (int pidx = pidx_start; pidx < pidx_end; pidx++) {
+    mesh_calc_normals_poly_prepare_single(data, pidx);
+  }
+}
+
 static void mesh_calc_normals_poly_finalize_cb(void *__restrict userdata,
                                                const int vidx,
                                                const TaskParallelTLS *__restrict UNUSED(tls))
@@ -321,6 +537,11 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
   BLI_parallel_range_settings_defaults(&settings);
   settings.min_iter_per_thread = 1024;
 
+  /* Polygons are processed in blocks, see #MESH_POLY_BLOCK_SIZE. */
+  const int numBlocks = (numPolys + MESH_POLY_BLOCK_SIZE - 1) / MESH_POLY_BLOCK_SIZE;
+  TaskParallelSettings settings_blocks = settings;
+  settings_blocks.min_iter_per_thread = 1024 / MESH_POLY_BLOCK_SIZE;
+
   if (only_face_normals) {
     BLI_assert((pnors != NULL) || (numPolys == 0));
     BLI_assert(r_vertnors == NULL);
@@ -330,9 +551,10 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
         .mloop = mloop,
         .mverts = mverts,
         .pnors = pnors,
+        .numPolys = numPolys,
     };
 
-    BLI_task_parallel_range(0, numPolys, &data, mesh_calc_normals_poly_cb, &settings);
+    BLI_task_parallel_range(0, numBlocks, &data, mesh_calc_normals_poly_cb, &settings_blocks);
     return;
   }
 
@@ -357,10 +579,12 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
       .pnors = pnors,
       .lnors_weighted = lnors_weighted,
       .vnors = vnors,
+      .numPolys = numPolys,
   };
 
   /* Compute poly normals, and prepare weighted loop normals. */
-  BLI_task_parallel_range(0, numPolys, &data, mesh_calc_normals_poly_prepare_cb, &settings);
+  BLI_task_parallel_range(
+      0, numBlocks, &data, mesh_calc_normals_poly_prepare_cb, &settings_blocks);
 
   /* Actually accumulate weighted loop normals into vertex ones. */
   /* Unfortunately, not possible to thread that
@@ -820,111 +1044,193 @@ typedef struct LoopSplitTaskDataCommon {
 /* See comment about edge_to_loops below. */
 #define IS_EDGE_SHARP(_e2l) (ELEM((_e2l)[1], INDEX_UNSET, INDEX_INVALID))
 
-static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
-                                 const bool check_angle,
-                                 const float split_angle,
-                                 const bool do_sharp_edges_tag)
-{
-  const MVert *mverts = data->mverts;
-  const MEdge *medges = data->medges;
-  const MLoop *mloops = data->mloops;
+typedef struct MeshEdgesSharpTagData {
+  LoopSplitTaskDataCommon *common_data;
 
-  const MPoly *mpolys = data->mpolys;
+  /** Loops using each edge, grouped per edge (`edge_loops[edge_loop_offsets[e]..]`). */
+  int *edge_loop_offsets;
+  int *edge_loops;
 
-  const int numEdges = data->numEdges;
-  const int numPolys = data->numPolys;
+  bool check_angle;
+  float split_angle_cos;
+  bool do_sharp_edges_tag;
+} MeshEdgesSharpTagData;
 
-  float(*loopnors)[3] = data->loopnors; /* Note: loopnors may be NULL here. */
-  const float(*polynors)[3] = data->polynors;
+static void mesh_edges_sharp_tag_poly_cb(void *__restrict userdata,
+                                         const int mp_index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshEdgesSharpTagData *data = userdata;
+  LoopSplitTaskDataCommon *common_data = data->common_data;
+  const MVert *mverts = common_data->mverts;
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mp = &common_data->mpolys[mp_index];
+  float(*loopnors)[3] = common_data->loopnors; /* Note: loopnors may be NULL here. */
+  int *loop_to_poly = common_data->loop_to_poly;
 
-  int(*edge_to_loops)[2] = data->edge_to_loops;
-  int *loop_to_poly = data->loop_to_poly;
+  const int ml_end_index = mp->loopstart + mp->totloop;
+  for (int ml_index = mp->loopstart; ml_index < ml_end_index; ml_index++) {
+    loop_to_poly[ml_index] = mp_index;
 
-  BLI_bitmap *sharp_edges = do_sharp_edges_tag ? BLI_BITMAP_NEW(numEdges, __func__) : NULL;
+    /* Pre-populate all loop normals as if their verts were all-smooth,
+     * this way we don't have to compute those later!
+     */
+    if (loopnors) {
+      normal_short_to_float_v3(loopnors[ml_index], mverts[mloops[ml_index].v].no);
+    }
 
-  const MPoly *mp;
-  int mp_index;
+    atomic_add_and_fetch_int32(&data->edge_loop_offsets[mloops[ml_index].e], 1);
+  }
+}
 
-  const float split_angle_cos = check_angle ? cosf(split_angle) : -1.0f;
+static void mesh_edges_sharp_tag_fill_cb(void *__restrict userdata,
+                                         const int mp_index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshEdgesSharpTagData *data = userdata;
+  const MLoop *mloops = data->common_data->mloops;
+  const MPoly *mp = &data->common_data->mpolys[mp_index];
 
-  for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-    const MLoop *ml_curr;
-    int *e2l;
-    int ml_curr_index = mp->loopstart;
-    const int ml_last_index = (ml_curr_index + mp->totloop) - 1;
+  const int ml_end_index = mp->loopstart + mp->totloop;
+  for (int ml_index = mp->loopstart; ml_index < ml_end_index; ml_index++) {
+    /* Offsets hold the end of each edge's group here, they are back to its start once filled. */
+    const int index = atomic_sub_and_fetch_int32(&data->edge_loop_offsets[mloops[ml_index].e], 1);
+    data->edge_loops[index] = ml_index;
+  }
+}
 
-    ml_curr = &mloops[ml_curr_index];
+/**
+ * Whether loop \a a comes before loop \a b when iterating over polygons, then over their loops.
+ */
+BLI_INLINE bool mesh_edges_sharp_tag_loop_is_before(const int *loop_to_poly,
+                                                    const int a,
+                                                    const int b)
+{
+  return (loop_to_poly[a] < loop_to_poly[b]) || (loop_to_poly[a] == loop_to_poly[b] && a < b);
+}
 
-    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
-      e2l = edge_to_loops[ml_curr->e];
+static void mesh_edges_sharp_tag_edge_cb(void *__restrict userdata,
+                                         const int me_index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshEdgesSharpTagData *data = userdata;
+  LoopSplitTaskDataCommon *common_data = data->common_data;
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mpolys = common_data->mpolys;
+  const float(*polynors)[3] = common_data->polynors;
+  const int *loop_to_poly = common_data->loop_to_poly;
+  MEdge *me = (MEdge *)&common_data->medges[me_index];
+  int *e2l = common_data->edge_to_loops[me_index];
 
-      loop_to_poly[ml_curr_index] = mp_index;
+  const int *edge_loops = &data->edge_loops[data->edge_loop_offsets[me_index]];
+  const int edge_loops_num = data->edge_loop_offsets[me_index + 1] -
+                             data->edge_loop_offsets[me_index];
 
-      /* Pre-populate all loop normals as if their verts were all-smooth,
-       * this way we don't have to compute those later!
-       */
-      if (loopnors) {
-        normal_short_to_float_v3(loopnors[ml_curr_index], mverts[ml_curr->v].no);
-      }
+  if (edge_loops_num == 0) {
+    /* Loose edge, both values stay set to 0. */
+    return;
+  }
 
-      /* Check whether current edge might be smooth or sharp */
-      if ((e2l[0] | e2l[1]) == 0) {
-        /* 'Empty' edge until now, set e2l[0] (and e2l[1] to INDEX_UNSET to tag it as unset). */
-        e2l[0] = ml_curr_index;
-        /* We have to check this here too, else we might miss some flat faces!!! */
-        e2l[1] = (mp->flag & ME_SMOOTH) ? INDEX_UNSET : INDEX_INVALID;
-      }
-      else if (e2l[1] == INDEX_UNSET) {
-        const bool is_angle_sharp = (check_angle &&
-                                     dot_v3v3(polynors[loop_to_poly[e2l[0]]], polynors[mp_index]) <
-                                         split_angle_cos);
-
-        /* Second loop using this edge, time to test its sharpness.
-         * An edge is sharp if it is tagged as such, or its face is not smooth,
-         * or both poly have opposed (flipped) normals, i.e. both loops on the same edge share the
-         * same vertex, or angle between both its polys' normals is above split_angle value.
-         */
-        if (!(mp->flag & ME_SMOOTH) || (medges[ml_curr->e].flag & ME_SHARP) ||
-            ml_curr->v == mloops[e2l[0]].v || is_angle_sharp) {
-          /* Note: we are sure that loop != 0 here ;) */
-          e2l[1] = INDEX_INVALID;
-
-          /* We want to avoid tagging edges as sharp when it is already defined as such by
-           * other causes than angle threshold... */
-          if (do_sharp_edges_tag && is_angle_sharp) {
-            BLI_BITMAP_SET(sharp_edges, ml_curr->e, true);
-          }
-        }
-        else {
-          e2l[1] = ml_curr_index;
-        }
-      }
-      else if (!IS_EDGE_SHARP(e2l)) {
-        /* More than two loops using this edge, tag as sharp if not yet done. */
-        e2l[1] = INDEX_INVALID;
-
-        /* We want to avoid tagging edges as sharp when it is already defined as such by
-         * other causes than angle threshold... */
-        if (do_sharp_edges_tag) {
-          BLI_BITMAP_SET(sharp_edges, ml_curr->e, false);
-        }
-      }
-      /* Else, edge is already 'disqualified' (i.e. sharp)! */
+  /* The result only depends on the first two loops using this edge, in the order in which the
+   * polygons define them. Loops were grouped in a non-deterministic order, find these two. */
+  int ml_first = edge_loops[0];
+  int ml_second = -1;
+  for (int i = 1; i < edge_loops_num; i++) {
+    const int ml_index = edge_loops[i];
+    if (mesh_edges_sharp_tag_loop_is_before(loop_to_poly, ml_index, ml_first)) {
+      ml_second = ml_first;
+      ml_first = ml_index;
+    }
+    else if (ml_second == -1 ||
+             mesh_edges_sharp_tag_loop_is_before(loop_to_poly, ml_index, ml_second)) {
+      ml_second = ml_index;
     }
   }
 
-  /* If requested, do actual tagging of edges as sharp in another loop. */
-  if (do_sharp_edges_tag) {
-    MEdge *me;
-    int me_index;
-    for (me = (MEdge *)medges, me_index = 0; me_index < numEdges; me++, me_index++) {
-      if (BLI_BITMAP_TEST(sharp_edges, me_index)) {
-        me->flag |= ME_SHARP;
-      }
+  e2l[0] = ml_first;
+  /* We have to check this here too, else we might miss some flat faces!!! */
+  e2l[1] = (mpolys[loop_to_poly[ml_first]].flag & ME_SMOOTH) ? INDEX_UNSET : INDEX_INVALID;
+
+  if (edge_loops_num == 1 || e2l[1] == INDEX_INVALID) {
+    return;
+  }
+
+  const MPoly *mp = &mpolys[loop_to_poly[ml_second]];
+  const bool is_angle_sharp = (data->check_angle &&
+                               dot_v3v3(polynors[loop_to_poly[ml_first]],
+                                        polynors[loop_to_poly[ml_second]]) <
+                                   data->split_angle_cos);
+
+  /* Second loop using this edge, time to test its sharpness.
+   * An edge is sharp if it is tagged as such, or its face is not smooth,
+   * or both poly have opposed (flipped) normals, i.e. both loops on the same edge share the
+   * same vertex, or angle between both its polys' normals is above split_angle value.
+   */
+  if (!(mp->flag & ME_SMOOTH) || (me->flag & ME_SHARP) ||
+      mloops[ml_second].v == mloops[ml_first].v || is_angle_sharp) {
+    e2l[1] = INDEX_INVALID;
+
+    /* We want to avoid tagging edges as sharp when it is already defined as such by
+     * other causes than angle threshold... */
+    if (data->do_sharp_edges_tag && is_angle_sharp) {
+      me->flag |= ME_SHARP;
     }
+  }
+  else if (edge_loops_num > 2) {
+    /* More than two loops using this edge, tag as sharp (but not in the edge flags). */
+    e2l[1] = INDEX_INVALID;
+  }
+  else {
+    e2l[1] = ml_second;
+  }
+}
+
+/**
+ * Fill the edge -> loops and loop -> poly mappings, and find out which edges are smooth.
+ *
+ * Loops are first grouped per edge, so that each edge can then be classified independently
+ * from the others, in parallel. This gives the same result as walking over all polygons and
+ * their loops in order.
+ */
+static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *common_data,
+                                 const bool check_angle,
+                                 const float split_angle,
+                                 const bool do_sharp_edges_tag)
+{
+  const int numEdges = common_data->numEdges;
+  const int numLoops = common_data->numLoops;
+  const int numPolys = common_data->numPolys;
 
-    MEM_freeN(sharp_edges);
+  MeshEdgesSharpTagData data = {
+      .common_data = common_data,
+      .edge_loop_offsets = MEM_calloc_arrayN(
+          (size_t)numEdges + 1, sizeof(*data.edge_loop_offsets), __func__),
+      .edge_loops = MEM_malloc_arrayN((size_t)numLoops, sizeof(*data.edge_loops), __func__),
+      .check_angle = check_angle,
+      .split_angle_cos = check_angle ? cosf(split_angle) : -1.0f,
+      .do_sharp_edges_tag = do_sharp_edges_tag,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+
+  /* Count loops per edge. */
+  BLI_task_parallel_range(0, numPolys, &data, mesh_edges_sharp_tag_poly_cb, &settings);
+
+  /* Turn counts into the end offset of each edge's group. */
+  int offset = 0;
+  for (int me_index = 0; me_index < numEdges; me_index++) {
+    offset += data.edge_loop_offsets[me_index];
+    data.edge_loop_offsets[me_index] = offset;
   }
+  data.edge_loop_offsets[numEdges] = offset;
+
+  BLI_task_parallel_range(0, numPolys, &data, mesh_edges_sharp_tag_fill_cb, &settings);
+  BLI_task_parallel_range(0, numEdges, &data, mesh_edges_sharp_tag_edge_cb, &settings);
+
+  MEM_freeN(data.edge_loop_offsets);
+  MEM_freeN(data.edge_loops);
 }
 
 /**
@@ -964,6 +1270,7 @@ void BKE_edges_sharp_from_angle_set(const struct MVert *mverts,
       .loop_to_poly = loop_to_poly,
       .polynors = polynors,
       .numEdges = numEdges,
+      .numLoops = numLoops,
       .numPolys = numPolys,
   };
 
@@ -1596,13 +1903,251 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
 #endif
 }
 
+/* Values of #LoopSplitParallelData.loop_fan_state. */
+#define LOOP_FAN_UNVISITED 0
+#define LOOP_FAN_VISITED 1
+#define LOOP_FAN_ENTRY 2
+
+typedef struct LoopSplitParallelData {
+  LoopSplitTaskDataCommon *common_data;
+
+  /** Loops with two smooth edges, grouped per vertex (`vert_loops[vert_loop_offsets[v]..]`). */
+  int *vert_loop_offsets;
+  int *vert_loops;
+  /** For loops with two smooth edges, whether their cyclic smooth fan is processed from them. */
+  char *loop_fan_state;
+} LoopSplitParallelData;
+
+/** Whether both edges of the loop are smooth, so it is part of a smooth fan with other loops. */
+BLI_INLINE bool loop_split_loop_is_smooth(const LoopSplitTaskDataCommon *common_data,
+                                          const MLoop *ml_curr,
+                                          const MLoop *ml_prev)
+{
+  return !IS_EDGE_SHARP(common_data->edge_to_loops[ml_curr->e]) &&
+         !IS_EDGE_SHARP(common_data->edge_to_loops[ml_prev->e]);
+}
+
+static void loop_split_vert_loops_count_cb(void *__restrict userdata,
+                                           const int mp_index,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  LoopSplitParallelData *data = userdata;
+  const LoopSplitTaskDataCommon *common_data = data->common_data;
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mp = &common_data->mpolys[mp_index];
+
+  const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+  int ml_prev_index = ml_last_index;
+  for (int ml_curr_index = mp->loopstart; ml_curr_index <= ml_last_index; ml_curr_index++) {
+    const MLoop *ml_curr = &mloops[ml_curr_index];
+    if (loop_split_loop_is_smooth(common_data, ml_curr, &mloops[ml_prev_index])) {
+      atomic_add_and_fetch_int32(&data->vert_loop_offsets[ml_curr->v], 1);
+    }
+    ml_prev_index = ml_curr_index;
+  }
+}
+
+static void loop_split_vert_loops_fill_cb(void *__restrict userdata,
+                                          const int mp_index,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  LoopSplitParallelData *data = userdata;
+  const LoopSplitTaskDataCommon *common_data = data->common_data;
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mp = &common_data->mpolys[mp_index];
+
+  const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+  int ml_prev_index = ml_last_index;
+  for (int ml_curr_index = mp->loopstart; ml_curr_index <= ml_last_index; ml_curr_index++) {
+    const MLoop *ml_curr = &mloops[ml_curr_index];
+    if (loop_split_loop_is_smooth(common_data, ml_curr, &mloops[ml_prev_index])) {
+      /* Offsets hold the end of each vertex's group here, and its start once filled. */
+      const int index = atomic_sub_and_fetch_int32(&data->vert_loop_offsets[ml_curr->v], 1);
+      data->vert_loops[index] = ml_curr_index;
+    }
+    ml_prev_index = ml_curr_index;
+  }
+}
+
+/**
+ * Walk the smooth fans around a vertex, each one only once, and find the loop each cyclic fan
+ * is processed from: its first loop, in the order in which polygons define them. This is the
+ * same loop #loop_split_generator processes the fan from. All loops of a fan use the same
+ * vertex, so vertices can be handled in parallel.
+ */
+static void loop_split_vert_fans_cb(void *__restrict userdata,
+                                    const int mv_index,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  LoopSplitParallelData *data = userdata;
+  const LoopSplitTaskDataCommon *common_data = data->common_data;
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mpolys = common_data->mpolys;
+  const int(*edge_to_loops)[2] = common_data->edge_to_loops;
+  const int *loop_to_poly = common_data->loop_to_poly;
+  char *loop_fan_state = data->loop_fan_state;
+
+  for (int i = data->vert_loop_offsets[mv_index]; i < data->vert_loop_offsets[mv_index + 1];
+       i++) {
+    const int ml_curr_index = data->vert_loops[i];
+    if (loop_fan_state[ml_curr_index] != LOOP_FAN_UNVISITED) {
+      continue;
+    }
+    loop_fan_state[ml_curr_index] = LOOP_FAN_VISITED;
+
+    const int mp_curr_index = loop_to_poly[ml_curr_index];
+    const MPoly *mp = &mpolys[mp_curr_index];
+    const int ml_prev_index = (ml_curr_index == mp->loopstart) ?
+                                  mp->loopstart + mp->totloop - 1 :
+                                  ml_curr_index - 1;
+
+    const MLoop *mlfan_curr = &mloops[ml_prev_index];
+    const int *e2lfan_curr = edge_to_loops[mlfan_curr->e];
+    /* mlfan_vert_index: the loop of our current edge might not be the loop of our current
+     * vertex! */
+    int mlfan_curr_index = ml_prev_index;
+    int mlfan_vert_index = ml_curr_index;
+    int mpfan_curr_index = mp_curr_index;
+    int ml_first_index = ml_curr_index;
+
+    while (true) {
+      /* Find next loop of the smooth fan. */
+      BKE_mesh_loop_manifold_fan_around_vert_next(mloops,
+                                                  mpolys,
+                                                  loop_to_poly,
+                                                  e2lfan_curr,
+                                                  (uint)mv_index,
+                                                  &mlfan_curr,
+                                                  &mlfan_curr_index,
+                                                  &mlfan_vert_index,
+                                                  &mpfan_curr_index);
+
+      e2lfan_curr = edge_to_loops[mlfan_curr->e];
+
+      if (IS_EDGE_SHARP(e2lfan_curr)) {
+        /* Sharp loop/edge, so not a cyclic smooth fan, it is processed from the sharp loop. */
+        break;
+      }
+      if (mlfan_vert_index == ml_curr_index) {
+        /* We walked around a whole cyclic smooth fan. */
+        loop_fan_state[ml_first_index] = LOOP_FAN_ENTRY;
+        break;
+      }
+      if (loop_fan_state[mlfan_vert_index] != LOOP_FAN_UNVISITED) {
+        /* Reached the part of a non-cyclic fan walked from another of its loops already. */
+        break;
+      }
+      loop_fan_state[mlfan_vert_index] = LOOP_FAN_VISITED;
+      if (mesh_edges_sharp_tag_loop_is_before(loop_to_poly, mlfan_vert_index, ml_first_index)) {
+        ml_first_index = mlfan_vert_index;
+      }
+    }
+  }
+}
+
+static void loop_split_poly_cb(void *__restrict userdata,
+                               const int mp_index,
+                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  LoopSplitParallelData *parallel_data = userdata;
+  LoopSplitTaskDataCommon *common_data = parallel_data->common_data;
+  const MLoop *mloops = common_data->mloops;
+  const MPoly *mp = &common_data->mpolys[mp_index];
+  const int(*edge_to_loops)[2] = common_data->edge_to_loops;
+
+  BLI_assert(common_data->lnors_spacearr == NULL);
+
+  const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+  int ml_prev_index = ml_last_index;
+
+  for (int ml_curr_index = mp->loopstart; ml_curr_index <= ml_last_index; ml_curr_index++) {
+    const MLoop *ml_curr = &mloops[ml_curr_index];
+    const MLoop *ml_prev = &mloops[ml_prev_index];
+    const int *e2l_curr = edge_to_loops[ml_curr->e];
+    const int *e2l_prev = edge_to_loops[ml_prev->e];
+
+    /* Same checks as done in #loop_split_generator: a loop with a sharp edge after it starts its
+     * fan, one with only a sharp edge before it is part of the fan started from another loop. */
+    bool is_fan_entry;
+    if (IS_EDGE_SHARP(e2l_curr)) {
+      is_fan_entry = true;
+    }
+    else if (IS_EDGE_SHARP(e2l_prev)) {
+      is_fan_entry = false;
+    }
+    else {
+      is_fan_entry = parallel_data->loop_fan_state[ml_curr_index] == LOOP_FAN_ENTRY;
+    }
+    if (is_fan_entry) {
+      LoopSplitTaskData data = {
+          .ml_curr = ml_curr,
+          .ml_prev = ml_prev,
+          .ml_curr_index = ml_curr_index,
+          .mp_index = mp_index,
+      };
+
+      if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
+        data.lnor = &common_data->loopnors[ml_curr_index];
+      }
+      else {
+        data.ml_prev_index = ml_prev_index;
+        data.e2l_prev = e2l_prev; /* Also tag as 'fan' task. */
+      }
+
+      loop_split_worker_do(common_data, &data, NULL);
+    }
+
+    ml_prev_index = ml_curr_index;
+  }
+}
+
+/**
+ * Compute loop normals in parallel over polygons, for when no lnor spaces are needed (no custom
+ * normals). Each fan gets processed from the same loop as in #loop_split_generator.
+ */
+static void loop_split_parallel(LoopSplitTaskDataCommon *common_data, const int numVerts)
+{
+  const int numLoops = common_data->numLoops;
+  const int numPolys = common_data->numPolys;
+
+  LoopSplitParallelData data = {
+      .common_data = common_data,
+      .vert_loop_offsets = MEM_calloc_arrayN(
+          (size_t)numVerts + 1, sizeof(*data.vert_loop_offsets), __func__),
+      .vert_loops = MEM_malloc_arrayN((size_t)numLoops, sizeof(*data.vert_loops), __func__),
+      .loop_fan_state = MEM_calloc_arrayN(
+          (size_t)numLoops, sizeof(*data.loop_fan_state), __func__),
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+
+  /* Group loops inside of smooth fans per vertex. */
+  BLI_task_parallel_range(0, numPolys, &data, loop_split_vert_loops_count_cb, &settings);
+  int offset = 0;
+  for (int mv_index = 0; mv_index < numVerts; mv_index++) {
+    offset += data.vert_loop_offsets[mv_index];
+    data.vert_loop_offsets[mv_index] = offset;
+  }
+  data.vert_loop_offsets[numVerts] = offset;
+  BLI_task_parallel_range(0, numPolys, &data, loop_split_vert_loops_fill_cb, &settings);
+
+  BLI_task_parallel_range(0, numVerts, &data, loop_split_vert_fans_cb, &settings);
+  BLI_task_parallel_range(0, numPolys, &data, loop_split_poly_cb, &settings);
+
+  MEM_freeN(data.vert_loop_offsets);
+  MEM_freeN(data.vert_loops);
+  MEM_freeN(data.loop_fan_state);
+}
+
 /**
  * Compute split normals, i.e. vertex normals associated with each poly (hence 'loop normals').
  * Useful to materialize sharp edges (or non-smooth faces) without actually modifying the geometry
  * (splitting edges).
  */
 void BKE_mesh_normals_loop_split(const MVert *mverts,
-                                 const int UNUSED(numVerts),
+                                 const int numVerts,
                                  MEdge *medges,
                                  const int numEdges,
                                  MLoop *mloops,
@@ -1710,7 +2255,12 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
   /* This first loop check which edges are actually smooth, and compute edge vectors. */
   mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
 
-  if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
+  if (r_lnors_spacearr == NULL) {
+    /* Without lnor spaces to fill (no custom normals), the loops smooth fans are processed from
+     * can be found for all vertices in parallel, no need for the generator and its task data. */
+    loop_split_parallel(&common_data, numVerts);
+  }
+  else if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
     /* Not enough loops to be worth the whole threading overhead... */
     loop_split_generator(NULL, &common_data);
   }
@@ -2072,6 +2622,8 @@ static void mesh_set_custom_normals(Mesh *mesh, float (*r_custom_nors)[3], const
     free_polynors = true;
   }
 
+  /* Sharp edge flags are set in place. */
+  BKE_mesh_runtime_shared_topology_ensure_mutable(mesh);
   mesh_normals_loop_custom_set(mesh->mvert,
                                mesh->totvert,
                                mesh->medge,
@@ -3278,146 +3830,220 @@ int BKE_mesh_tessface_calc_ex(CustomData *fdata,
 #undef ML_TO_MF_QUAD
 }
 
-/**
- * Calculate tessellation into #MLoopTri which exist only for this purpose.
- */
-void BKE_mesh_recalc_looptri(const MLoop *mloop,
-                             const MPoly *mpoly,
-                             const MVert *mvert,
-                             int totloop,
-                             int totpoly,
-                             MLoopTri *mlooptri)
+typedef struct MeshRecalcLoopTriData {
+  const MLoop *mloop;
+  const MPoly *mpoly;
+  const MVert *mvert;
+  MLoopTri *mlooptri;
+  int totpoly;
+} MeshRecalcLoopTriData;
+
+typedef struct MeshRecalcLoopTriTLS {
+  /* Only allocated when the thread has to fill n-gons. */
+  MemArena *pf_arena;
+} MeshRecalcLoopTriTLS;
+
+static void mesh_recalc_looptri_poly(const MeshRecalcLoopTriData *data,
+                                     MeshRecalcLoopTriTLS *tls_data,
+                                     const int poly_index)
 {
-  /* use this to avoid locking pthread for _every_ polygon
-   * and calling the fill function */
+  const MLoop *mloop = data->mloop;
+  const MVert *mvert = data->mvert;
+  const MPoly *mp = &data->mpoly[poly_index];
+  const unsigned int mp_loopstart = (unsigned int)mp->loopstart;
+  const unsigned int mp_totloop = (unsigned int)mp->totloop;
+  /* Triangles of a polygon are stored after the ones of all previous polygons. */
+  MLoopTri *mlt = &data->mlooptri[poly_to_tri_count(poly_index, mp->loopstart)];
+  unsigned int l1, l2, l3;
+
+#define ML_TO_MLT(i1, i2, i3) \
+  { \
+    l1 = mp_loopstart + i1; \
+    l2 = mp_loopstart + i2; \
+    l3 = mp_loopstart + i3; \
+    ARRAY_SET_ITEMS(mlt->tri, l1, l2, l3); \
+    mlt->poly = (unsigned int)poly_index; \
+  } \
+  ((void)0)
+
+  if (mp_totloop < 3) {
+    /* do nothing */
+  }
+  else if (mp_totloop == 3) {
+    ML_TO_MLT(0, 1, 2);
+  }
+  else if (mp_totloop == 4) {
+    MLoopTri *mlt_a = mlt;
+    ML_TO_MLT(0, 1, 2);
+    mlt++;
+    MLoopTri *mlt_b = mlt;
+    ML_TO_MLT(0, 2, 3);
+
+    if (UNLIKELY(is_quad_flip_v3_first_third_fast(mvert[mloop[mlt_a->tri[0]].v].co,
+                                                  mvert[mloop[mlt_a->tri[1]].v].co,
+                                                  mvert[mloop[mlt_a->tri[2]].v].co,
+                                                  mvert[mloop[mlt_b->tri[2]].v].co))) {
+      /* flip out of degenerate 0-2 state. */
+      mlt_a->tri[2] = mlt_b->tri[2];
+      mlt_b->tri[0] = mlt_a->tri[1];
+    }
+  }
+  else {
+    const MLoop *ml;
+    const float *co_curr, *co_prev;
 
-#define USE_TESSFACE_SPEEDUP
+    float normal[3];
 
-  const MPoly *mp;
-  const MLoop *ml;
-  MLoopTri *mlt;
-  MemArena *arena = NULL;
-  int poly_index, mlooptri_index;
-  unsigned int j;
+    float axis_mat[3][3];
+    float(*projverts)[2];
+    unsigned int(*tris)[3];
 
-  mlooptri_index = 0;
-  mp = mpoly;
-  for (poly_index = 0; poly_index < totpoly; poly_index++, mp++) {
-    const unsigned int mp_loopstart = (unsigned int)mp->loopstart;
-    const unsigned int mp_totloop = (unsigned int)mp->totloop;
-    unsigned int l1, l2, l3;
-    if (mp_totloop < 3) {
-      /* do nothing */
+    const unsigned int totfilltri = mp_totloop - 2;
+
+    if (UNLIKELY(tls_data->pf_arena == NULL)) {
+      tls_data->pf_arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
     }
+    MemArena *arena = tls_data->pf_arena;
 
-#ifdef USE_TESSFACE_SPEEDUP
+    tris = BLI_memarena_alloc(arena, sizeof(*tris) * (size_t)totfilltri);
+    projverts = BLI_memarena_alloc(arena, sizeof(*projverts) * (size_t)mp_totloop);
 
-#  define ML_TO_MLT(i1, i2, i3) \
-    { \
-      mlt = &mlooptri[mlooptri_index]; \
-      l1 = mp_loopstart + i1; \
-      l2 = mp_loopstart + i2; \
-      l3 = mp_loopstart + i3; \
-      ARRAY_SET_ITEMS(mlt->tri, l1, l2, l3); \
-      mlt->poly = (unsigned int)poly_index; \
-    } \
-    ((void)0)
+    zero_v3(normal);
 
-    else if (mp_totloop == 3) {
-      ML_TO_MLT(0, 1, 2);
-      mlooptri_index++;
+    /* calc normal, flipped: to get a positive 2d cross product */
+    ml = mloop + mp_loopstart;
+    co_prev = mvert[ml[mp_totloop - 1].v].co;
+    for (unsigned int j = 0; j < mp_totloop; j++, ml++) {
+      co_curr = mvert[ml->v].co;
+      add_newell_cross_v3_v3v3(normal, co_prev, co_curr);
+      co_prev = co_curr;
     }
-    else if (mp_totloop == 4) {
-      ML_TO_MLT(0, 1, 2);
-      MLoopTri *mlt_a = mlt;
-      mlooptri_index++;
-      ML_TO_MLT(0, 2, 3);
-      MLoopTri *mlt_b = mlt;
-      mlooptri_index++;
-
-      if (UNLIKELY(is_quad_flip_v3_first_third_fast(mvert[mloop[mlt_a->tri[0]].v].co,
-                                                    mvert[mloop[mlt_a->tri[1]].v].co,
-                                                    mvert[mloop[mlt_a->tri[2]].v].co,
-                                                    mvert[mloop[mlt_b->tri[2]].v].co))) {
-        /* flip out of degenerate 0-2 state. */
-        mlt_a->tri[2] = mlt_b->tri[2];
-        mlt_b->tri[0] = mlt_a->tri[1];
-      }
+    if (UNLIKELY(normalize_v3(normal) == 0.0f)) {
+      normal[2] = 1.0f;
     }
-#endif /* USE_TESSFACE_SPEEDUP */
-    else {
-      const float *co_curr, *co_prev;
 
-      float normal[3];
-
-      float axis_mat[3][3];
-      float(*projverts)[2];
-      unsigned int(*tris)[3];
-
-      const unsigned int totfilltri = mp_totloop - 2;
-
-      if (UNLIKELY(arena == NULL)) {
-        arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
-      }
+    /* project verts to 2d */
+    axis_dominant_v3_to_m3_negate(axis_mat, normal);
 
-      tris = BLI_memarena_alloc(arena, sizeof(*tris) * (size_t)totfilltri);
-      projverts = BLI_memarena_alloc(arena, sizeof(*projverts) * (size_t)mp_totloop);
+    ml = mloop + mp_loopstart;
+    for (unsigned int j = 0; j < mp_totloop; j++, ml++) {
+      mul_v2_m3v3(projverts[j], axis_mat, mvert[ml->v].co);
+    }
 
-      zero_v3(normal);
+    BLI_polyfill_calc_arena(projverts, mp_totloop, 1, tris, arena);
 
-      /* calc normal, flipped: to get a positive 2d cross product */
-      ml = mloop + mp_loopstart;
-      co_prev = mvert[ml[mp_totloop - 1].v].co;
-      for (j = 0; j < mp_totloop; j++, ml++) {
-        co_curr = mvert[ml->v].co;
-        add_newell_cross_v3_v3v3(normal, co_prev, co_curr);
-        co_prev = co_curr;
-      }
-      if (UNLIKELY(normalize_v3(normal) == 0.0f)) {
-        normal[2] = 1.0f;
-      }
+    /* apply fill */
+    for (unsigned int j = 0; j < totfilltri; j++, mlt++) {
+      ML_TO_MLT(tris[j][0], tris[j][1], tris[j][2]);
+    }
 
-      /* project verts to 2d */
-      axis_dominant_v3_to_m3_negate(axis_mat, normal);
+    BLI_memarena_clear(arena);
+  }
 
-      ml = mloop + mp_loopstart;
-      for (j = 0; j < mp_totloop; j++, ml++) {
-        mul_v2_m3v3(projverts[j], axis_mat, mvert[ml->v].co);
-      }
+#undef ML_TO_MLT
+}
 
-      BLI_polyfill_calc_arena(projverts, mp_totloop, 1, tris, arena);
+#ifdef BLI_HAVE_SSE2
+/**
+ * Same as #mesh_recalc_looptri_poly for a block of quads,
+ * doing #is_quad_flip_v3_first_third_fast for all of them at once.
+ */
+static void mesh_recalc_looptri_quads_simd(const MeshRecalcLoopTriData *data, const int block)
+{
+  const int poly_start = block * MESH_POLY_BLOCK_SIZE;
+  const MPoly *mp = &data->mpoly[poly_start];
+
+  MeshPolySIMDFloat3 co[4], d_12, d_13, d_14, cross_a, cross_b;
+  for (int i = 0; i < 4; i++) {
+    mesh_poly_simd_gather_co(&co[i], data->mvert, data->mloop, mp, i);
+  }
+  mesh_poly_simd_sub(&d_12, &co[1], &co[0]);
+  mesh_poly_simd_sub(&d_13, &co[2], &co[0]);
+  mesh_poly_simd_sub(&d_14, &co[3], &co[0]);
+  mesh_poly_simd_cross(&cross_a, &d_12, &d_13);
+  mesh_poly_simd_cross(&cross_b, &d_14, &d_13);
+  const int flip_mask = _mm_movemask_ps(
+      _mm_cmpgt_ps(mesh_poly_simd_dot(&cross_a, &cross_b), _mm_setzero_ps()));
+
+  MLoopTri *mlt = &data->mlooptri[poly_to_tri_count(poly_start, mp->loopstart)];
+  for (int i = 0; i < MESH_POLY_BLOCK_SIZE; i++, mlt += 2) {
+    const unsigned int l = (unsigned int)mp[i].loopstart;
+    if (UNLIKELY(flip_mask & (1 << i))) {
+      /* flip out of degenerate 0-2 state. */
+      ARRAY_SET_ITEMS(mlt[0].tri, l, l + 1, l + 3);
+      ARRAY_SET_ITEMS(mlt[1].tri, l + 1, l + 2, l + 3);
+    }
+    else {
+      ARRAY_SET_ITEMS(mlt[0].tri, l, l + 1, l + 2);
+      ARRAY_SET_ITEMS(mlt[1].tri, l, l + 2, l + 3);
+    }
+    mlt[0].poly = mlt[1].poly = (unsigned int)(poly_start + i);
+  }
+}
+#endif
 
-      /* apply fill */
-      for (j = 0; j < totfilltri; j++) {
-        unsigned int *tri = tris[j];
+static void mesh_recalc_looptri_cb(void *__restrict userdata,
+                                   const int block,
+                                   const TaskParallelTLS *__restrict tls)
+{
+  const MeshRecalcLoopTriData *data = userdata;
+  const int poly_start = block * MESH_POLY_BLOCK_SIZE;
 
-        mlt = &mlooptri[mlooptri_index];
+#ifdef BLI_HAVE_SSE2
+  if (mesh_poly_block_totloop(data->mpoly, data->totpoly, block) == 4) {
+    mesh_recalc_looptri_quads_simd(data, block);
+    return;
+  }
+#endif
 
-        /* set loop indices, transformed to vert indices later */
-        l1 = mp_loopstart + tri[0];
-        l2 = mp_loopstart + tri[1];
-        l3 = mp_loopstart + tri[2];
+  const int poly_end = min_ii(poly_start + MESH_POLY_BLOCK_SIZE, data->totpoly);
+  for (int poly_index = poly_start; poly_index < poly_end; poly_index++) {
+    mesh_recalc_looptri_poly(data, tls->userdata_chunk, poly_index);
+  }
+}
 
-        ARRAY_SET_ITEMS(mlt->tri, l1, l2, l3);
-        mlt->poly = (unsigned int)poly_index;
+static void mesh_recalc_looptri_free(const void *__restrict UNUSED(userdata),
+                                     void *__restrict tls_v)
+{
+  MeshRecalcLoopTriTLS *tls_data = tls_v;
+  if (tls_data->pf_arena) {
+    BLI_memarena_free(tls_data->pf_arena);
+  }
+}
 
-        mlooptri_index++;
-      }
+/**
+ * Calculate tessellation into #MLoopTri which exist only for this purpose.
+ *
+ * \note Polygons are expected to be stored in the same order as their loops,
+ * so that the triangles of each polygon can be filled in parallel.
+ */
+void BKE_mesh_recalc_looptri(const MLoop *mloop,
+                             const MPoly *mpoly,
+                             const MVert *mvert,
+                             int totloop,
+                             int totpoly,
+                             MLoopTri *mlooptri)
+{
+  MeshRecalcLoopTriData data = {
+      .mloop = mloop,
+      .mpoly = mpoly,
+      .mvert = mvert,
+      .mlooptri = mlooptri,
+      .totpoly = totpoly,
+  };
+  MeshRecalcLoopTriTLS tls_data = {NULL};
 
-      BLI_memarena_clear(arena);
-    }
-  }
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024 / MESH_POLY_BLOCK_SIZE;
+  settings.userdata_chunk = &tls_data;
+  settings.userdata_chunk_size = sizeof(tls_data);
+  settings.func_free = mesh_recalc_looptri_free;
 
-  if (arena) {
-    BLI_memarena_free(arena);
-    arena = NULL;
-  }
+  const int numBlocks = (totpoly + MESH_POLY_BLOCK_SIZE - 1) / MESH_POLY_BLOCK_SIZE;
+  BLI_task_parallel_range(0, numBlocks, &data, mesh_recalc_looptri_cb, &settings);
 
-  BLI_assert(mlooptri_index == poly_to_tri_count(totpoly, totloop));
   UNUSED_VARS_NDEBUG(totloop);
-
-#undef USE_TESSFACE_SPEEDUP
-#undef ML_TO_MLT
 }
 
 static void bm_corners_to_loops_ex(ID *id,
@@ -0,0 +1,401 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "testing/testing.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "BLI_math_base.h"
+#include "BLI_math_geom.h"
+#include "BLI_math_rotation.h"
+#include "BLI_math_vector.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "tests/blenkernel_testing.hh"
+
+namespace blender::bke::tests {
+
+using MeshEvaluateTest = MeshTest;
+
+/* Create a bumpy grid with some flat faces and sharp edges, large enough to be processed on
+ * multiple threads. */
+static Mesh *create_bumpy_grid_mesh(const int resolution)
+{
+  Mesh *mesh = create_grid_mesh(resolution, [](int x, int y) {
+    return sinf((float)x * 0.7f) * cosf((float)y * 0.3f) + (float)((x * y) % 5) * 0.2f;
+  });
+  for (int i = 0; i < mesh->totpoly; i++) {
+    mesh->mpoly[i].flag = (i % 7 == 0) ? 0 : ME_SMOOTH;
+  }
+  for (int i = 0; i < mesh->totedge; i++) {
+    if (i % 11 == 0) {
+      mesh->medge[i].flag |= ME_SHARP;
+    }
+  }
+  return mesh;
+}
+
+static float (*mesh_poly_normals(const Mesh *mesh))[3]
+{
+  float(*poly_normals)[3] = (float(*)[3])MEM_malloc_arrayN(
+      mesh->totpoly, sizeof(*poly_normals), __func__);
+  BKE_mesh_calc_normals_poly(mesh->mvert,
+                             nullptr,
+                             mesh->totvert,
+                             mesh->mloop,
+                             mesh->mpoly,
+                             mesh->totloop,
+                             mesh->totpoly,
+                             poly_normals,
+                             true);
+  return poly_normals;
+}
+
+static void mesh_loop_normals(Mesh *mesh,
+                              const float (*poly_normals)[3],
+                              const float split_angle,
+                              MLoopNorSpaceArray *r_lnors_spacearr,
+                              float (*r_loop_normals)[3])
+{
+  BKE_mesh_normals_loop_split(mesh->mvert,
+                              mesh->totvert,
+                              mesh->medge,
+                              mesh->totedge,
+                              mesh->mloop,
+                              r_loop_normals,
+                              mesh->totloop,
+                              mesh->mpoly,
+                              poly_normals,
+                              mesh->totpoly,
+                              true,
+                              split_angle,
+                              r_lnors_spacearr,
+                              nullptr,
+                              nullptr);
+}
+
+TEST_F(MeshEvaluateTest, loop_split_normals_match_lnor_spaces)
+{
+  Mesh *mesh = create_bumpy_grid_mesh(100);
+  float(*poly_normals)[3] = mesh_poly_normals(mesh);
+  const float split_angle = DEG2RADF(30.0f);
+
+  /* Without lnor spaces, fans are processed in parallel from the polygons. */
+  float(*loop_normals)[3] = (float(*)[3])MEM_malloc_arrayN(
+      mesh->totloop, sizeof(*loop_normals), __func__);
+  mesh_loop_normals(mesh, poly_normals, split_angle, nullptr, loop_normals);
+
+  /* Building lnor spaces goes through the fan generator instead. */
+  float(*loop_normals_spaces)[3] = (float(*)[3])MEM_malloc_arrayN(
+      mesh->totloop, sizeof(*loop_normals_spaces), __func__);
+  MLoopNorSpaceArray lnors_spacearr = {nullptr};
+  mesh_loop_normals(mesh, poly_normals, split_angle, &lnors_spacearr, loop_normals_spaces);
+
+  bool has_split_normals = false;
+  for (int i = 0; i < mesh->totloop; i++) {
+    EXPECT_V3_NEAR(loop_normals[i], loop_normals_spaces[i], 1e-6f);
+    float vert_normal[3];
+    normal_short_to_float_v3(vert_normal, mesh->mvert[mesh->mloop[i].v].no);
+    has_split_normals |= !equals_v3v3(loop_normals[i], vert_normal);
+  }
+  EXPECT_TRUE(has_split_normals);
+
+  BKE_lnor_spacearr_free(&lnors_spacearr);
+  MEM_freeN(loop_normals_spaces);
+  MEM_freeN(loop_normals);
+  MEM_freeN(poly_normals);
+  BKE_id_free(nullptr, mesh);
+}
+
+/* A cone of triangles around a single apex vertex with a high valence. */
+static Mesh *create_cone_mesh(const int sides)
+{
+  Mesh *mesh = BKE_mesh_new_nomain(sides + 1, 0, 0, sides * 3, sides);
+  zero_v3(mesh->mvert[0].co);
+  mesh->mvert[0].co[2] = 1.0f;
+  for (int i = 0; i < sides; i++) {
+    const float angle = (float)i / (float)sides * (float)(M_PI * 2.0);
+    mesh->mvert[i + 1].co[0] = cosf(angle);
+    mesh->mvert[i + 1].co[1] = sinf(angle);
+    mesh->mvert[i + 1].co[2] = 0.0f;
+
+    MPoly &poly = mesh->mpoly[i];
+    poly.loopstart = i * 3;
+    poly.totloop = 3;
+    poly.flag = ME_SMOOTH;
+    mesh->mloop[i * 3].v = 0;
+    mesh->mloop[i * 3 + 1].v = i + 1;
+    mesh->mloop[i * 3 + 2].v = (i + 1) % sides + 1;
+  }
+  BKE_mesh_calc_edges(mesh, false, false);
+  BKE_mesh_calc_normals(mesh);
+  return mesh;
+}
+
+static void expect_loop_normals_match_lnor_spaces(Mesh *mesh)
+{
+  float(*poly_normals)[3] = mesh_poly_normals(mesh);
+  float(*loop_normals)[3] = (float(*)[3])MEM_malloc_arrayN(
+      mesh->totloop, sizeof(*loop_normals), __func__);
+  mesh_loop_normals(mesh, poly_normals, (float)M_PI, nullptr, loop_normals);
+  float(*loop_normals_spaces)[3] = (float(*)[3])MEM_malloc_arrayN(
+      mesh->totloop, sizeof(*loop_normals_spaces), __func__);
+  MLoopNorSpaceArray lnors_spacearr = {nullptr};
+  mesh_loop_normals(mesh, poly_normals, (float)M_PI, &lnors_spacearr, loop_normals_spaces);
+  for (int i = 0; i < mesh->totloop; i++) {
+    EXPECT_V3_NEAR(loop_normals[i], loop_normals_spaces[i], 1e-6f);
+  }
+  BKE_lnor_spacearr_free(&lnors_spacearr);
+  MEM_freeN(loop_normals_spaces);
+  MEM_freeN(loop_normals);
+  MEM_freeN(poly_normals);
+}
+
+TEST_F(MeshEvaluateTest, loop_split_normals_cone)
+{
+  Mesh *mesh = create_cone_mesh(2000);
+
+  /* The smooth fan around the apex is cyclic. */
+  expect_loop_normals_match_lnor_spaces(mesh);
+
+  /* A sharp edge at the apex makes it start at that edge. */
+  for (int i = 0; i < mesh->totedge; i++) {
+    const MEdge &edge = mesh->medge[i];
+    if (edge.v1 == 0 && edge.v2 == 100) {
+      mesh->medge[i].flag |= ME_SHARP;
+    }
+  }
+  expect_loop_normals_match_lnor_spaces(mesh);
+
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshEvaluateTest, loop_split_normals_flat_angle)
+{
+  Mesh *mesh = create_bumpy_grid_mesh(20);
+  float(*poly_normals)[3] = mesh_poly_normals(mesh);
+
+  /* A zero split angle makes every edge between non-coplanar faces sharp. */
+  float(*loop_normals)[3] = (float(*)[3])MEM_malloc_arrayN(
+      mesh->totloop, sizeof(*loop_normals), __func__);
+  mesh_loop_normals(mesh, poly_normals, 0.0f, nullptr, loop_normals);
+
+  for (int i = 0; i < mesh->totpoly; i++) {
+    const MPoly &poly = mesh->mpoly[i];
+    for (int j = 0; j < poly.totloop; j++) {
+      EXPECT_V3_NEAR(loop_normals[poly.loopstart + j], poly_normals[i], 1e-6f);
+    }
+  }
+
+  MEM_freeN(loop_normals);
+  MEM_freeN(poly_normals);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshEvaluateTest, edges_sharp_from_angle)
+{
+  Mesh *mesh = create_bumpy_grid_mesh(20);
+  float(*poly_normals)[3] = mesh_poly_normals(mesh);
+  const float split_angle = DEG2RADF(30.0f);
+  const float split_angle_cos = cosf(split_angle);
+
+  BKE_edges_sharp_from_angle_set(mesh->mvert,
+                                 mesh->totvert,
+                                 mesh->medge,
+                                 mesh->totedge,
+                                 mesh->mloop,
+                                 mesh->totloop,
+                                 mesh->mpoly,
+                                 poly_normals,
+                                 mesh->totpoly,
+                                 split_angle);
+
+  /* Find the two polygons of each edge. */
+  int(*edge_polys)[2] = (int(*)[2])MEM_malloc_arrayN(
+      mesh->totedge, sizeof(*edge_polys), __func__);
+  for (int i = 0; i < mesh->totedge; i++) {
+    edge_polys[i][0] = edge_polys[i][1] = -1;
+  }
+  for (int i = 0; i < mesh->totpoly; i++) {
+    const MPoly &poly = mesh->mpoly[i];
+    for (int j = 0; j < poly.totloop; j++) {
+      int *polys = edge_polys[mesh->mloop[poly.loopstart + j].e];
+      polys[polys[0] == -1 ? 0 : 1] = i;
+    }
+  }
+
+  for (int i = 0; i < mesh->totedge; i++) {
+    const int *polys = edge_polys[i];
+    if (polys[1] == -1 || i % 11 == 0 || !(mesh->mpoly[polys[0]].flag & ME_SMOOTH) ||
+        !(mesh->mpoly[polys[1]].flag & ME_SMOOTH)) {
+      continue;
+    }
+    const bool is_angle_sharp = dot_v3v3(poly_normals[polys[0]], poly_normals[polys[1]]) <
+                                split_angle_cos;
+    EXPECT_EQ((mesh->medge[i].flag & ME_SHARP) != 0, is_angle_sharp);
+  }
+
+  MEM_freeN(edge_polys);
+  MEM_freeN(poly_normals);
+  BKE_id_free(nullptr, mesh);
+}
+
+/* Replace some quads of the grid by two triangles, so that polygon blocks are mixed. */
+static Mesh *create_mixed_grid_mesh(const int resolution)
+{
+  Mesh *grid = create_bumpy_grid_mesh(resolution);
+  int split_num = 0;
+  for (int i = 0; i < grid->totpoly; i++) {
+    split_num += (i % 13 < 6) ? 1 : 0;
+  }
+  Mesh *mesh = BKE_mesh_new_nomain(
+      grid->totvert, 0, 0, grid->totloop + split_num * 2, grid->totpoly + split_num);
+  memcpy(mesh->mvert, grid->mvert, sizeof(MVert) * grid->totvert);
+
+  int poly_index = 0, loop_index = 0;
+  for (int i = 0; i < grid->totpoly; i++) {
+    const MLoop *loops = &grid->mloop[grid->mpoly[i].loopstart];
+    const int tris[2][3] = {{0, 1, 2}, {0, 2, 3}};
+    if (i % 13 < 6) {
+      for (int j = 0; j < 2; j++, poly_index++) {
+        mesh->mpoly[poly_index].loopstart = loop_index;
+        mesh->mpoly[poly_index].totloop = 3;
+        for (int k = 0; k < 3; k++, loop_index++) {
+          mesh->mloop[loop_index].v = loops[tris[j][k]].v;
+        }
+      }
+    }
+    else {
+      mesh->mpoly[poly_index].loopstart = loop_index;
+      mesh->mpoly[poly_index].totloop = 4;
+      poly_index++;
+      for (int k = 0; k < 4; k++, loop_index++) {
+        mesh->mloop[loop_index].v = loops[k].v;
+      }
+    }
+  }
+  /* Make a few quads concave, to test the triangulation flipping. */
+  for (int i = 0; i < mesh->totvert; i += 17) {
+    mesh->mvert[i].co[0] += 0.9f;
+    mesh->mvert[i].co[1] += 0.9f;
+  }
+
+  BKE_mesh_calc_edges(mesh, false, false);
+  BKE_mesh_calc_normals(mesh);
+  BKE_id_free(nullptr, grid);
+  return mesh;
+}
+
+TEST_F(MeshEvaluateTest, poly_normals_tris_and_quads)
+{
+  Mesh *mesh = create_mixed_grid_mesh(30);
+  float(*poly_normals)[3] = mesh_poly_normals(mesh);
+
+  for (int i = 0; i < mesh->totpoly; i++) {
+    const MPoly &poly = mesh->mpoly[i];
+    float normal[3];
+    BKE_mesh_calc_poly_normal(&poly, &mesh->mloop[poly.loopstart], mesh->mvert, normal);
+    /* Blocks of triangles or quads give the same result as the scalar code. */
+    EXPECT_V3_NEAR(poly_normals[i], normal, 0.0f);
+  }
+
+  /* Normals computed along with vertex normals use Newell's method. */
+  float(*vert_normals)[3] = (float(*)[3])MEM_malloc_arrayN(
+      mesh->totvert, sizeof(*vert_normals), __func__);
+  BKE_mesh_calc_normals_poly(mesh->mvert,
+                             vert_normals,
+                             mesh->totvert,
+                             mesh->mloop,
+                             mesh->mpoly,
+                             mesh->totloop,
+                             mesh->totpoly,
+                             poly_normals,
+                             false);
+  for (int i = 0; i < mesh->totpoly; i++) {
+    const MPoly &poly = mesh->mpoly[i];
+    float normal[3] = {0.0f, 0.0f, 0.0f};
+    const float *co_prev = mesh->mvert[mesh->mloop[poly.loopstart + poly.totloop - 1].v].co;
+    for (int j = 0; j < poly.totloop; j++) {
+      const float *co_curr = mesh->mvert[mesh->mloop[poly.loopstart + j].v].co;
+      add_newell_cross_v3_v3v3(normal, co_prev, co_curr);
+      co_prev = co_curr;
+    }
+    normalize_v3(normal);
+    EXPECT_V3_NEAR(poly_normals[i], normal, 0.0f);
+  }
+  for (int i = 0; i < mesh->totvert; i++) {
+    EXPECT_NEAR(len_v3(vert_normals[i]), 1.0f, 1e-5f);
+  }
+
+  MEM_freeN(vert_normals);
+  MEM_freeN(poly_normals);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshEvaluateTest, looptri_tris_and_quads)
+{
+  Mesh *mesh = create_mixed_grid_mesh(30);
+  const int looptris_num = poly_to_tri_count(mesh->totpoly, mesh->totloop);
+  MLoopTri *looptris = (MLoopTri *)MEM_malloc_arrayN(
+      looptris_num, sizeof(*looptris), __func__);
+  BKE_mesh_recalc_looptri(
+      mesh->mloop, mesh->mpoly, mesh->mvert, mesh->totloop, mesh->totpoly, looptris);
+
+  int looptri_index = 0;
+  int flip_num = 0;
+  for (int i = 0; i < mesh->totpoly; i++) {
+    const MPoly &poly = mesh->mpoly[i];
+    const uint l = (uint)poly.loopstart;
+    const MLoopTri &looptri = looptris[looptri_index];
+    EXPECT_EQ(looptri.poly, i);
+    if (poly.totloop == 3) {
+      EXPECT_EQ(looptri.tri[0], l);
+      EXPECT_EQ(looptri.tri[1], l + 1);
+      EXPECT_EQ(looptri.tri[2], l + 2);
+      looptri_index++;
+      continue;
+    }
+    /* Quads are split along the diagonal which keeps both triangles facing the same way. */
+    const bool flip = is_quad_flip_v3_first_third_fast(mesh->mvert[mesh->mloop[l].v].co,
+                                                       mesh->mvert[mesh->mloop[l + 1].v].co,
+                                                       mesh->mvert[mesh->mloop[l + 2].v].co,
+                                                       mesh->mvert[mesh->mloop[l + 3].v].co);
+    const MLoopTri &looptri_b = looptris[looptri_index + 1];
+    EXPECT_EQ(looptri_b.poly, i);
+    const uint expected[2][3] = {{l, l + 1, flip ? l + 3 : l + 2},
+                                 {flip ? l + 1 : l, l + 2, l + 3}};
+    for (int k = 0; k < 3; k++) {
+      EXPECT_EQ(looptri.tri[k], expected[0][k]);
+      EXPECT_EQ(looptri_b.tri[k], expected[1][k]);
+    }
+    flip_num += flip ? 1 : 0;
+    looptri_index += 2;
+  }
+  EXPECT_GT(flip_num, 0);
+  EXPECT_EQ(looptri_index, looptris_num);
+
+  MEM_freeN(looptris);
+  BKE_id_free(nullptr, mesh);
+}
+
+}  // namespace blender::bke::tests
@@ -32,6 +32,7 @@
 
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_mesh_types.h"
@@ -314,14 +315,62 @@ Mesh *BKE_mesh_remesh_voxel_to_mesh_nomain(Mesh *mesh,
   return new_mesh;
 }
 
-void BKE_mesh_remesh_reproject_paint_mask(Mesh *target, Mesh *source)
+/* -------------------------------------------------------------------- */
+/** \name Data Reprojection
+ *
+ * Every vertex or face of the remeshed mesh takes its data from the nearest element of the
+ * original mesh. The BVH trees of the original mesh are kept in its runtime cache, so they are
+ * shared between the different kinds of data as long as the geometry isn't cleared.
+ * \{ */
+
+typedef struct ReprojectNearestData {
+  BVHTreeFromMesh *bvhtree;
+  const MVert *target_verts;
+  int *r_nearest_index;
+} ReprojectNearestData;
+
+static void reproject_nearest_vert_task(void *__restrict userdata,
+                                        const int i,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ReprojectNearestData *data = userdata;
+  BVHTreeFromMesh *bvhtree = data->bvhtree;
+  BVHTreeNearest nearest;
+  nearest.index = -1;
+  nearest.dist_sq = FLT_MAX;
+  BLI_bvhtree_find_nearest(
+      bvhtree->tree, data->target_verts[i].co, &nearest, bvhtree->nearest_callback, bvhtree);
+  data->r_nearest_index[i] = nearest.index;
+}
+
+/**
+ * The index of the nearest source vertex for every target vertex, -1 when none was found.
+ */
+static int *reproject_nearest_source_verts(Mesh *target, Mesh *source)
 {
   BVHTreeFromMesh bvhtree = {
       .nearest_callback = NULL,
   };
   BKE_bvhtree_from_mesh_get(&bvhtree, source, BVHTREE_FROM_VERTS, 2);
-  MVert *target_verts = CustomData_get_layer(&target->vdata, CD_MVERT);
 
+  int *nearest_index = MEM_malloc_arrayN(
+      (size_t)target->totvert, sizeof(*nearest_index), __func__);
+  ReprojectNearestData data = {
+      .bvhtree = &bvhtree,
+      .target_verts = CustomData_get_layer(&target->vdata, CD_MVERT),
+      .r_nearest_index = nearest_index,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, target->totvert, &data, reproject_nearest_vert_task, &settings);
+
+  free_bvhtree_from_mesh(&bvhtree);
+  return nearest_index;
+}
+
+static void reproject_paint_mask(Mesh *target, Mesh *source, const int *nearest_index)
+{
   float *target_mask;
   if (CustomData_has_layer(&target->vdata, CD_PAINT_MASK)) {
     target_mask = CustomData_get_layer(&target->vdata, CD_PAINT_MASK);
@@ -341,17 +390,68 @@ void BKE_mesh_remesh_reproject_paint_mask(Mesh *target, Mesh *source)
   }
 
   for (int i = 0; i < target->totvert; i++) {
-    float from_co[3];
-    BVHTreeNearest nearest;
-    nearest.index = -1;
-    nearest.dist_sq = FLT_MAX;
-    copy_v3_v3(from_co, target_verts[i].co);
-    BLI_bvhtree_find_nearest(bvhtree.tree, from_co, &nearest, bvhtree.nearest_callback, &bvhtree);
-    if (nearest.index != -1) {
-      target_mask[i] = source_mask[nearest.index];
+    if (nearest_index[i] != -1) {
+      target_mask[i] = source_mask[nearest_index[i]];
+    }
+  }
+}
+
+static void reproject_vertex_paint(Mesh *target, Mesh *source, const int *nearest_index)
+{
+  int tot_color_layer = CustomData_number_of_layers(&source->vdata, CD_PROP_COLOR);
+
+  for (int layer_n = 0; layer_n < tot_color_layer; layer_n++) {
+    const char *layer_name = CustomData_get_layer_name(&source->vdata, CD_PROP_COLOR, layer_n);
+    CustomData_add_layer_named(
+        &target->vdata, CD_PROP_COLOR, CD_CALLOC, NULL, target->totvert, layer_name);
+
+    MPropCol *target_color = CustomData_get_layer_n(&target->vdata, CD_PROP_COLOR, layer_n);
+    MPropCol *source_color = CustomData_get_layer_n(&source->vdata, CD_PROP_COLOR, layer_n);
+    for (int i = 0; i < target->totvert; i++) {
+      if (nearest_index[i] != -1) {
+        copy_v4_v4(target_color[i].color, source_color[nearest_index[i]].color);
+      }
     }
   }
-  free_bvhtree_from_mesh(&bvhtree);
+}
+
+void BKE_mesh_remesh_reproject_paint_mask(Mesh *target, Mesh *source)
+{
+  int *nearest_index = reproject_nearest_source_verts(target, source);
+  reproject_paint_mask(target, source, nearest_index);
+  MEM_freeN(nearest_index);
+}
+
+typedef struct ReprojectFaceSetsData {
+  BVHTreeFromMesh *bvhtree;
+  const MPoly *target_polys;
+  const MLoop *target_loops;
+  const MVert *target_verts;
+  int *target_face_sets;
+  const int *source_face_sets;
+  const MLoopTri *source_looptri;
+} ReprojectFaceSetsData;
+
+static void reproject_face_sets_task(void *__restrict userdata,
+                                     const int i,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ReprojectFaceSetsData *data = userdata;
+  BVHTreeFromMesh *bvhtree = data->bvhtree;
+  float from_co[3];
+  BVHTreeNearest nearest;
+  nearest.index = -1;
+  nearest.dist_sq = FLT_MAX;
+  const MPoly *mpoly = &data->target_polys[i];
+  BKE_mesh_calc_poly_center(
+      mpoly, &data->target_loops[mpoly->loopstart], data->target_verts, from_co);
+  BLI_bvhtree_find_nearest(bvhtree->tree, from_co, &nearest, bvhtree->nearest_callback, bvhtree);
+  if (nearest.index != -1) {
+    data->target_face_sets[i] = data->source_face_sets[data->source_looptri[nearest.index].poly];
+  }
+  else {
+    data->target_face_sets[i] = 1;
+  }
 }
 
 void BKE_remesh_reproject_sculpt_face_sets(Mesh *target, Mesh *source)
@@ -360,10 +460,6 @@ void BKE_remesh_reproject_sculpt_face_sets(Mesh *target, Mesh *source)
       .nearest_callback = NULL,
   };
 
-  const MPoly *target_polys = CustomData_get_layer(&target->pdata, CD_MPOLY);
-  const MVert *target_verts = CustomData_get_layer(&target->vdata, CD_MVERT);
-  const MLoop *target_loops = CustomData_get_layer(&target->ldata, CD_MLOOP);
-
   int *target_face_sets;
   if (CustomData_has_layer(&target->pdata, CD_SCULPT_FACE_SETS)) {
     target_face_sets = CustomData_get_layer(&target->pdata, CD_SCULPT_FACE_SETS);
@@ -385,55 +481,58 @@ void BKE_remesh_reproject_sculpt_face_sets(Mesh *target, Mesh *source)
   const MLoopTri *looptri = BKE_mesh_runtime_looptri_ensure(source);
   BKE_bvhtree_from_mesh_get(&bvhtree, source, BVHTREE_FROM_LOOPTRI, 2);
 
-  for (int i = 0; i < target->totpoly; i++) {
-    float from_co[3];
-    BVHTreeNearest nearest;
-    nearest.index = -1;
-    nearest.dist_sq = FLT_MAX;
-    const MPoly *mpoly = &target_polys[i];
-    BKE_mesh_calc_poly_center(mpoly, &target_loops[mpoly->loopstart], target_verts, from_co);
-    BLI_bvhtree_find_nearest(bvhtree.tree, from_co, &nearest, bvhtree.nearest_callback, &bvhtree);
-    if (nearest.index != -1) {
-      target_face_sets[i] = source_face_sets[looptri[nearest.index].poly];
-    }
-    else {
-      target_face_sets[i] = 1;
-    }
-  }
+  ReprojectFaceSetsData data = {
+      .bvhtree = &bvhtree,
+      .target_polys = CustomData_get_layer(&target->pdata, CD_MPOLY),
+      .target_loops = CustomData_get_layer(&target->ldata, CD_MLOOP),
+      .target_verts = CustomData_get_layer(&target->vdata, CD_MVERT),
+      .target_face_sets = target_face_sets,
+      .source_face_sets = source_face_sets,
+      .source_looptri = looptri,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, target->totpoly, &data, reproject_face_sets_task, &settings);
+
   free_bvhtree_from_mesh(&bvhtree);
 }
 
 void BKE_remesh_reproject_vertex_paint(Mesh *target, Mesh *source)
 {
-  BVHTreeFromMesh bvhtree = {
-      .nearest_callback = NULL,
-  };
-  BKE_bvhtree_from_mesh_get(&bvhtree, source, BVHTREE_FROM_VERTS, 2);
-
-  int tot_color_layer = CustomData_number_of_layers(&source->vdata, CD_PROP_COLOR);
-
-  for (int layer_n = 0; layer_n < tot_color_layer; layer_n++) {
-    const char *layer_name = CustomData_get_layer_name(&source->vdata, CD_PROP_COLOR, layer_n);
-    CustomData_add_layer_named(
-        &target->vdata, CD_PROP_COLOR, CD_CALLOC, NULL, target->totvert, layer_name);
+  if (CustomData_number_of_layers(&source->vdata, CD_PROP_COLOR) == 0) {
+    return;
+  }
+  int *nearest_index = reproject_nearest_source_verts(target, source);
+  reproject_vertex_paint(target, source, nearest_index);
+  MEM_freeN(nearest_index);
+}
 
-    MPropCol *target_color = CustomData_get_layer_n(&target->vdata, CD_PROP_COLOR, layer_n);
-    MVert *target_verts = CustomData_get_layer(&target->vdata, CD_MVERT);
-    MPropCol *source_color = CustomData_get_layer_n(&source->vdata, CD_PROP_COLOR, layer_n);
-    for (int i = 0; i < target->totvert; i++) {
-      BVHTreeNearest nearest;
-      nearest.index = -1;
-      nearest.dist_sq = FLT_MAX;
-      BLI_bvhtree_find_nearest(
-          bvhtree.tree, target_verts[i].co, &nearest, bvhtree.nearest_callback, &bvhtree);
-      if (nearest.index != -1) {
-        copy_v4_v4(target_color[i].color, source_color[nearest.index].color);
-      }
-    }
+/**
+ * Reproject the paint mask and the vertex colors together, looking up the nearest source
+ * vertex only once for both.
+ */
+void BKE_remesh_reproject_vertex_data(Mesh *target,
+                                      Mesh *source,
+                                      const bool use_paint_mask,
+                                      const bool use_vertex_paint)
+{
+  if (!use_paint_mask &&
+      !(use_vertex_paint && CustomData_number_of_layers(&source->vdata, CD_PROP_COLOR) > 0)) {
+    return;
   }
-  free_bvhtree_from_mesh(&bvhtree);
+  int *nearest_index = reproject_nearest_source_verts(target, source);
+  if (use_paint_mask) {
+    reproject_paint_mask(target, source, nearest_index);
+  }
+  if (use_vertex_paint) {
+    reproject_vertex_paint(target, source, nearest_index);
+  }
+  MEM_freeN(nearest_index);
 }
 
+/** \} */
+
 struct Mesh *BKE_mesh_remesh_voxel_fix_poles(struct Mesh *mesh)
 {
   const BMAllocTemplate allocsize = BMALLOC_TEMPLATE_FROM_ME(mesh);
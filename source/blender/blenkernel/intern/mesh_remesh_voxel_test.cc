@@ -0,0 +1,93 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "testing/testing.h"
+
+#include "BKE_customdata.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_remesh_voxel.h"
+
+#include "BLI_math_vector.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "tests/blenkernel_testing.hh"
+
+namespace blender::bke::tests {
+
+using MeshRemeshReprojectTest = MeshTest;
+
+/* Create a grid of quads, moved up by `offset`. */
+static Mesh *create_offset_grid_mesh(const int resolution, const float offset)
+{
+  return create_grid_mesh(resolution, [&](int /*x*/, int /*y*/) { return offset; });
+}
+
+TEST_F(MeshRemeshReprojectTest, vertex_data_and_face_sets)
+{
+  Mesh *source = create_offset_grid_mesh(20, 0.0f);
+  Mesh *target = create_offset_grid_mesh(20, 0.1f);
+
+  float *mask = (float *)CustomData_add_layer(
+      &source->vdata, CD_PAINT_MASK, CD_CALLOC, nullptr, source->totvert);
+  MPropCol *colors = (MPropCol *)CustomData_add_layer_named(
+      &source->vdata, CD_PROP_COLOR, CD_CALLOC, nullptr, source->totvert, "Color");
+  for (int i = 0; i < source->totvert; i++) {
+    mask[i] = (float)(i % 10) * 0.1f;
+    copy_v4_fl4(colors[i].color, (float)i, 0.0f, 1.0f, 1.0f);
+  }
+  int *face_sets = (int *)CustomData_add_layer(
+      &source->pdata, CD_SCULPT_FACE_SETS, CD_CALLOC, nullptr, source->totpoly);
+  for (int i = 0; i < source->totpoly; i++) {
+    face_sets[i] = i % 7 + 1;
+  }
+
+  BKE_remesh_reproject_vertex_data(target, source, true, true);
+  BKE_remesh_reproject_sculpt_face_sets(target, source);
+
+  /* Every element of the target is right above the same element of the source. */
+  const float *target_mask = (const float *)CustomData_get_layer(&target->vdata, CD_PAINT_MASK);
+  const MPropCol *target_colors = (const MPropCol *)CustomData_get_layer_named(
+      &target->vdata, CD_PROP_COLOR, "Color");
+  ASSERT_NE(target_mask, nullptr);
+  ASSERT_NE(target_colors, nullptr);
+  for (int i = 0; i < target->totvert; i++) {
+    EXPECT_EQ(target_mask[i], mask[i]);
+    EXPECT_V4_NEAR(target_colors[i].color, colors[i].color, 0.0f);
+  }
+  const int *target_face_sets = (const int *)CustomData_get_layer(&target->pdata,
+                                                                  CD_SCULPT_FACE_SETS);
+  ASSERT_NE(target_face_sets, nullptr);
+  for (int i = 0; i < target->totpoly; i++) {
+    EXPECT_EQ(target_face_sets[i], face_sets[i]);
+  }
+
+  /* The separate functions give the same result. */
+  Mesh *target_mask_only = create_offset_grid_mesh(20, 0.1f);
+  BKE_mesh_remesh_reproject_paint_mask(target_mask_only, source);
+  const float *mask_only = (const float *)CustomData_get_layer(&target_mask_only->vdata,
+                                                               CD_PAINT_MASK);
+  for (int i = 0; i < target->totvert; i++) {
+    EXPECT_EQ(mask_only[i], target_mask[i]);
+  }
+
+  BKE_id_free(nullptr, target_mask_only);
+  BKE_id_free(nullptr, target);
+  BKE_id_free(nullptr, source);
+}
+
+}  // namespace blender::bke::tests
@@ -21,6 +21,8 @@
  * \ingroup bke
  */
 
+#include <string.h>
+
 #include "atomic_ops.h"
 
 #include "MEM_guardedalloc.h"
@@ -29,15 +31,19 @@
 #include "DNA_meshdata_types.h"
 #include "DNA_object_types.h"
 
+#include "BLI_bitmap.h"
 #include "BLI_math_geom.h"
+#include "BLI_string.h"
 #include "BLI_threads.h"
 
 #include "BKE_bvhutils.h"
+#include "BKE_customdata.h"
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
 #include "BKE_mesh_runtime.h"
 #include "BKE_shrinkwrap.h"
 #include "BKE_subdiv_ccg.h"
+#include "BKE_subsurf.h"
 
 /* -------------------------------------------------------------------- */
 /** \name Mesh Runtime Struct Utils
@@ -61,9 +67,13 @@ void BKE_mesh_runtime_reset_on_copy(Mesh *mesh, const int UNUSED(flag))
   Mesh_Runtime *runtime = &mesh->runtime;
 
   runtime->mesh_eval = NULL;
+  runtime->eval_shared = NULL;
+  runtime->eval_shared_users = 0;
   runtime->edit_data = NULL;
   runtime->batch_cache = NULL;
+  runtime->batch_cache_topology = NULL;
   runtime->subdiv_ccg = NULL;
+  runtime->shared_topology = NULL;
   memset(&runtime->looptris, 0, sizeof(runtime->looptris));
   runtime->bvh_cache = NULL;
   runtime->shrinkwrap_data = NULL;
@@ -84,6 +94,11 @@ void BKE_mesh_runtime_clear_cache(Mesh *mesh)
     BKE_id_free(NULL, mesh->runtime.mesh_eval);
     mesh->runtime.mesh_eval = NULL;
   }
+  BKE_mesh_runtime_eval_shared_clear(mesh);
+  if (mesh->runtime.batch_cache_topology != NULL) {
+    BKE_mesh_runtime_batch_cache_discard(NULL, mesh->runtime.batch_cache_topology);
+    mesh->runtime.batch_cache_topology = NULL;
+  }
   BKE_mesh_runtime_clear_geometry(mesh);
   BKE_mesh_batch_cache_free(mesh);
   BKE_mesh_runtime_clear_edit_data(mesh);
@@ -240,6 +255,470 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Mesh Shared Topology
+ *
+ * Evaluated meshes which only differ in their vertex positions can share all their other data:
+ * the edge, loop and polygon arrays and the attribute layers. The arrays are owned by a reference
+ * counted #MeshSharedTopology, and the custom data layers of every mesh using them are flagged
+ * with #CD_FLAG_NOFREE. Code writing to them has to duplicate them first, either with
+ * #CustomData_duplicate_referenced_layer like for any other referenced layer, or with
+ * #BKE_mesh_runtime_shared_topology_ensure_mutable.
+ * \{ */
+
+typedef struct MeshSharedTopology {
+  int users;
+  struct MEdge *medge;
+  struct MLoop *mloop;
+  struct MPoly *mpoly;
+  /** Layers owned by the shared topology, including the ones above. */
+  CustomData vdata, edata, ldata, pdata;
+  int totvert, totedge, totloop, totpoly;
+} MeshSharedTopology;
+
+/* Protects moving the ownership of the layers of a mesh into its #MeshSharedTopology,
+ * since the same source mesh can be copied from multiple threads. */
+static ThreadMutex shared_topology_lock = BLI_MUTEX_INITIALIZER;
+
+/** Vertex positions and the data derived from them, which are expected to change. */
+static bool mesh_layer_depends_on_positions(const int type)
+{
+  return ELEM(type, CD_MVERT, CD_NORMAL, CD_TANGENT, CD_MLOOPTANGENT, CD_SHAPEKEY);
+}
+
+/**
+ * Move ownership of the owned layers of \a data into \a r_shared_data. Layers which are
+ * already referenced from elsewhere stay as they are.
+ */
+static void mesh_shared_topology_take_layers(CustomData *data,
+                                             const int totelem,
+                                             CustomData *r_shared_data)
+{
+  CustomData_reset(r_shared_data);
+  for (int i = 0; i < data->totlayer; i++) {
+    CustomDataLayer *layer = &data->layers[i];
+    if ((layer->flag & CD_FLAG_NOFREE) || layer->data == NULL ||
+        mesh_layer_depends_on_positions(layer->type)) {
+      continue;
+    }
+    CustomData_add_layer_named(
+        r_shared_data, layer->type, CD_ASSIGN, layer->data, totelem, layer->name);
+    layer->flag |= CD_FLAG_NOFREE;
+  }
+}
+
+static MeshSharedTopology *mesh_shared_topology_ensure(Mesh *mesh)
+{
+  BLI_mutex_lock(&shared_topology_lock);
+  MeshSharedTopology *shared = mesh->runtime.shared_topology;
+  if (shared == NULL) {
+    shared = MEM_callocN(sizeof(MeshSharedTopology), __func__);
+    shared->users = 1;
+    shared->totvert = mesh->totvert;
+    shared->totedge = mesh->totedge;
+    shared->totloop = mesh->totloop;
+    shared->totpoly = mesh->totpoly;
+    mesh_shared_topology_take_layers(&mesh->vdata, mesh->totvert, &shared->vdata);
+    mesh_shared_topology_take_layers(&mesh->edata, mesh->totedge, &shared->edata);
+    mesh_shared_topology_take_layers(&mesh->ldata, mesh->totloop, &shared->ldata);
+    mesh_shared_topology_take_layers(&mesh->pdata, mesh->totpoly, &shared->pdata);
+    shared->medge = CustomData_get_layer(&shared->edata, CD_MEDGE);
+    shared->mloop = CustomData_get_layer(&shared->ldata, CD_MLOOP);
+    shared->mpoly = CustomData_get_layer(&shared->pdata, CD_MPOLY);
+    mesh->runtime.shared_topology = shared;
+  }
+  BLI_mutex_unlock(&shared_topology_lock);
+  return shared;
+}
+
+static bool mesh_shared_topology_owns_layer(const CustomData *shared_data, const void *data)
+{
+  for (int i = 0; i < shared_data->totlayer; i++) {
+    if (shared_data->layers[i].data == data) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool mesh_shared_topology_owns(const MeshSharedTopology *shared, const void *data)
+{
+  return data != NULL && (mesh_shared_topology_owns_layer(&shared->vdata, data) ||
+                          mesh_shared_topology_owns_layer(&shared->edata, data) ||
+                          mesh_shared_topology_owns_layer(&shared->ldata, data) ||
+                          mesh_shared_topology_owns_layer(&shared->pdata, data));
+}
+
+/* Duplicate all referenced layers, except the ones owned by the shared topology. */
+static void mesh_shared_topology_duplicate_other_layers(CustomData *data,
+                                                        const MeshSharedTopology *shared,
+                                                        const int totelem)
+{
+  for (int i = 0; i < data->totlayer; i++) {
+    const CustomDataLayer *layer = &data->layers[i];
+    if (!(layer->flag & CD_FLAG_NOFREE) || mesh_shared_topology_owns(shared, layer->data)) {
+      continue;
+    }
+    const int n = i - CustomData_get_layer_index(data, layer->type);
+    CustomData_duplicate_referenced_layer_n(data, layer->type, n, totelem);
+  }
+}
+
+/* Duplicate all layers owned by the shared topology. */
+static bool mesh_shared_topology_duplicate_layers(CustomData *data,
+                                                  const MeshSharedTopology *shared,
+                                                  const int totelem)
+{
+  bool changed = false;
+  for (int i = 0; i < data->totlayer; i++) {
+    const CustomDataLayer *layer = &data->layers[i];
+    if (mesh_shared_topology_owns(shared, layer->data)) {
+      const int n = i - CustomData_get_layer_index(data, layer->type);
+      CustomData_duplicate_referenced_layer_n(data, layer->type, n, totelem);
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+/**
+ * Copy a mesh for evaluation like #BKE_mesh_copy_for_eval, but share all data besides vertex
+ * positions (and the data derived from them) with the source mesh instead of duplicating it.
+ * This makes copies of meshes that are only deformed or get new attributes much cheaper, since
+ * only the data that is actually written to is duplicated later on.
+ *
+ * \note The source mesh must own its data, since it has to give up ownership of it.
+ * Layers of the source that are already referenced from elsewhere are duplicated.
+ */
+Mesh *BKE_mesh_copy_for_eval_shared_topology(Mesh *source)
+{
+  MeshSharedTopology *shared = mesh_shared_topology_ensure(source);
+
+  Mesh *result = BKE_mesh_copy_for_eval(source, true);
+  mesh_shared_topology_duplicate_other_layers(&result->vdata, shared, result->totvert);
+  mesh_shared_topology_duplicate_other_layers(&result->edata, shared, result->totedge);
+  mesh_shared_topology_duplicate_other_layers(&result->ldata, shared, result->totloop);
+  mesh_shared_topology_duplicate_other_layers(&result->pdata, shared, result->totpoly);
+  mesh_shared_topology_duplicate_other_layers(&result->fdata, shared, result->totface);
+  BKE_mesh_update_customdata_pointers(result, false);
+
+  atomic_add_and_fetch_int32(&shared->users, 1);
+  result->runtime.shared_topology = shared;
+  return result;
+}
+
+/**
+ * Give the mesh its own copy of the data it shares with other meshes.
+ * Must be called before the edge, loop or polygon arrays or any other layer is changed in place.
+ */
+void BKE_mesh_runtime_shared_topology_ensure_mutable(Mesh *mesh)
+{
+  const MeshSharedTopology *shared = mesh->runtime.shared_topology;
+  if (shared == NULL) {
+    return;
+  }
+  bool changed = false;
+  changed |= mesh_shared_topology_duplicate_layers(&mesh->vdata, shared, mesh->totvert);
+  changed |= mesh_shared_topology_duplicate_layers(&mesh->edata, shared, mesh->totedge);
+  changed |= mesh_shared_topology_duplicate_layers(&mesh->ldata, shared, mesh->totloop);
+  changed |= mesh_shared_topology_duplicate_layers(&mesh->pdata, shared, mesh->totpoly);
+  if (changed) {
+    BKE_mesh_update_customdata_pointers(mesh, false);
+  }
+}
+
+/**
+ * Release the reference to the shared topology of the mesh. The custom data layers of the mesh
+ * must not be used anymore, so this should only be called when its geometry is freed.
+ */
+void BKE_mesh_runtime_shared_topology_release(Mesh *mesh)
+{
+  MeshSharedTopology *shared = mesh->runtime.shared_topology;
+  if (shared == NULL) {
+    return;
+  }
+  mesh->runtime.shared_topology = NULL;
+  if (atomic_sub_and_fetch_int32(&shared->users, 1) == 0) {
+    CustomData_free(&shared->vdata, shared->totvert);
+    CustomData_free(&shared->edata, shared->totedge);
+    CustomData_free(&shared->ldata, shared->totloop);
+    CustomData_free(&shared->pdata, shared->totpoly);
+    MEM_freeN(shared);
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Mesh Data Keys
+ *
+ * A cheap way to check that the data of a mesh is the same as before. Layers are compared by
+ * their data pointers, so neither creating nor matching a key reads the layers. Caches which
+ * only have to be updated for new positions leave them out of the key, in which case only the
+ * vertex flags are copied, since they are stored in the same array as the positions.
+ * \{ */
+
+typedef struct MeshDataKeyLayer {
+  int type;
+  char name[64]; /* MAX_CUSTOMDATA_LAYER_NAME */
+  const void *data;
+} MeshDataKeyLayer;
+
+typedef struct MeshDataKey {
+  int totvert, totedge, totloop, totpoly;
+  short flag;
+  char cd_flag;
+  bool use_positions;
+  int layers_len;
+  MeshDataKeyLayer *layers;
+  /** Flag and bevel weight of every vertex. */
+  char (*vert_flags)[2];
+} MeshDataKey;
+
+static bool mesh_data_key_uses_layer(const CustomDataLayer *layer, const bool use_positions)
+{
+  if (layer->data == NULL) {
+    return false;
+  }
+  if (layer->type == CD_MVERT) {
+    return use_positions;
+  }
+  return !mesh_layer_depends_on_positions(layer->type);
+}
+
+static void mesh_data_key_add_layers(MeshDataKey *key, const CustomData *data)
+{
+  for (int i = 0; i < data->totlayer; i++) {
+    const CustomDataLayer *layer = &data->layers[i];
+    if (mesh_data_key_uses_layer(layer, key->use_positions)) {
+      MeshDataKeyLayer *key_layer = &key->layers[key->layers_len++];
+      key_layer->type = layer->type;
+      STRNCPY(key_layer->name, layer->name);
+      key_layer->data = layer->data;
+    }
+  }
+}
+
+static bool mesh_data_key_layers_match(const MeshDataKey *key,
+                                       const CustomData *data,
+                                       int *layer_index)
+{
+  for (int i = 0; i < data->totlayer; i++) {
+    const CustomDataLayer *layer = &data->layers[i];
+    if (!mesh_data_key_uses_layer(layer, key->use_positions)) {
+      continue;
+    }
+    if (*layer_index == key->layers_len) {
+      return false;
+    }
+    const MeshDataKeyLayer *key_layer = &key->layers[(*layer_index)++];
+    if (key_layer->data != layer->data || key_layer->type != layer->type ||
+        !STREQ(key_layer->name, layer->name)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Create a key of the data of \a mesh, including the vertex positions when \a use_positions is
+ * true.
+ *
+ * Layers owned by the mesh are freed with it, after which another mesh can get different data
+ * at the same address. Unless the caller makes sure that can't happen (for example by checking
+ * the dependency graph tags of the ID owning the data), pass false for \a allow_owned_layers,
+ * which returns NULL for meshes that own some of their layers.
+ */
+MeshDataKey *BKE_mesh_runtime_data_key_new(const Mesh *mesh,
+                                           const bool use_positions,
+                                           const bool allow_owned_layers)
+{
+  const CustomData *datas[4] = {&mesh->vdata, &mesh->edata, &mesh->ldata, &mesh->pdata};
+  int layers_len = 0;
+  for (int i = 0; i < ARRAY_SIZE(datas); i++) {
+    for (int j = 0; j < datas[i]->totlayer; j++) {
+      const CustomDataLayer *layer = &datas[i]->layers[j];
+      if (!mesh_data_key_uses_layer(layer, use_positions)) {
+        continue;
+      }
+      if (!allow_owned_layers && !(layer->flag & CD_FLAG_NOFREE)) {
+        return NULL;
+      }
+      layers_len++;
+    }
+  }
+
+  MeshDataKey *key = MEM_callocN(sizeof(MeshDataKey), __func__);
+  key->totvert = mesh->totvert;
+  key->totedge = mesh->totedge;
+  key->totloop = mesh->totloop;
+  key->totpoly = mesh->totpoly;
+  key->flag = mesh->flag;
+  key->cd_flag = mesh->cd_flag;
+  key->use_positions = use_positions;
+  key->layers = MEM_malloc_arrayN(layers_len, sizeof(MeshDataKeyLayer), __func__);
+  for (int i = 0; i < ARRAY_SIZE(datas); i++) {
+    mesh_data_key_add_layers(key, datas[i]);
+  }
+  if (mesh->mvert != NULL && !use_positions) {
+    key->vert_flags = MEM_malloc_arrayN(mesh->totvert, sizeof(*key->vert_flags), __func__);
+    for (int i = 0; i < mesh->totvert; i++) {
+      key->vert_flags[i][0] = mesh->mvert[i].flag;
+      key->vert_flags[i][1] = mesh->mvert[i].bweight;
+    }
+  }
+  return key;
+}
+
+/**
+ * Check whether the data of \a mesh in \a key is the same as when the key was created.
+ */
+bool BKE_mesh_runtime_data_key_matches(const MeshDataKey *key, const Mesh *mesh)
+{
+  if (key->totvert != mesh->totvert || key->totedge != mesh->totedge ||
+      key->totloop != mesh->totloop || key->totpoly != mesh->totpoly ||
+      key->flag != mesh->flag || key->cd_flag != mesh->cd_flag ||
+      (!key->use_positions && (key->vert_flags != NULL) != (mesh->mvert != NULL))) {
+    return false;
+  }
+  int layer_index = 0;
+  if (!mesh_data_key_layers_match(key, &mesh->vdata, &layer_index) ||
+      !mesh_data_key_layers_match(key, &mesh->edata, &layer_index) ||
+      !mesh_data_key_layers_match(key, &mesh->ldata, &layer_index) ||
+      !mesh_data_key_layers_match(key, &mesh->pdata, &layer_index) ||
+      layer_index != key->layers_len) {
+    return false;
+  }
+  if (key->vert_flags != NULL) {
+    for (int i = 0; i < mesh->totvert; i++) {
+      if (key->vert_flags[i][0] != mesh->mvert[i].flag ||
+          key->vert_flags[i][1] != mesh->mvert[i].bweight) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void BKE_mesh_runtime_data_key_free(MeshDataKey *key)
+{
+  MEM_SAFE_FREE(key->layers);
+  MEM_SAFE_FREE(key->vert_flags);
+  MEM_freeN(key);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Shared Evaluated Meshes
+ *
+ * Objects using the same mesh with identical modifier stacks (e.g. linked duplicates) get the
+ * same result. The first object evaluated in a depsgraph update stores its result in the input
+ * mesh, the others use it instead of evaluating their modifiers again. Every object using the
+ * shared result and the input mesh hold a reference to it.
+ * \{ */
+
+/** Shared result stored in the input mesh, with the key and its data in a single allocation. */
+typedef struct MeshEvalShared {
+  Mesh *mesh;
+  /** Depsgraph update count the result is valid for. */
+  int update;
+  MeshEvalSharedKey key;
+  /* The key data follows the struct. */
+} MeshEvalShared;
+
+static bool mesh_eval_shared_matches(const MeshEvalShared *shared,
+                                     const MeshEvalSharedKey *key,
+                                     const int update)
+{
+  return shared->update == update && shared->key.hash == key->hash &&
+         shared->key.data_len == key->data_len &&
+         memcmp(shared->key.data, key->data, key->data_len) == 0;
+}
+
+/**
+ * Get the shared result of the modifier stack with the given key evaluated in the given
+ * depsgraph update, adding a user to it.
+ * \return The evaluated mesh, or NULL when there is none.
+ */
+Mesh *BKE_mesh_runtime_eval_shared_get(Mesh *mesh, const MeshEvalSharedKey *key, const int update)
+{
+  Mesh *mesh_eval = NULL;
+  BLI_mutex_lock(mesh->runtime.eval_mutex);
+  const MeshEvalShared *shared = mesh->runtime.eval_shared;
+  if (shared != NULL && mesh_eval_shared_matches(shared, key, update)) {
+    atomic_add_and_fetch_int32(&shared->mesh->runtime.eval_shared_users, 1);
+    mesh_eval = shared->mesh;
+  }
+  BLI_mutex_unlock(mesh->runtime.eval_mutex);
+  return mesh_eval;
+}
+
+/**
+ * Share the result of a modifier stack evaluated from \a mesh by a single object, replacing the
+ * result stored for a previous update or another modifier stack.
+ */
+void BKE_mesh_runtime_eval_shared_store(Mesh *mesh,
+                                        Mesh *mesh_eval,
+                                        const MeshEvalSharedKey *key,
+                                        const int update)
+{
+  BLI_assert(mesh_eval->runtime.eval_shared_users == 0);
+  MeshEvalShared *shared = MEM_mallocN(sizeof(*shared) + key->data_len, __func__);
+  memcpy(shared + 1, key->data, key->data_len);
+  shared->mesh = mesh_eval;
+  shared->update = update;
+  shared->key.data = shared + 1;
+  shared->key.data_len = key->data_len;
+  shared->key.hash = key->hash;
+
+  MeshEvalShared *shared_old = NULL;
+  BLI_mutex_lock(mesh->runtime.eval_mutex);
+  /* Another object could have stored the same result while this one was evaluated. */
+  if (mesh->runtime.eval_shared == NULL ||
+      !mesh_eval_shared_matches(mesh->runtime.eval_shared, key, update)) {
+    mesh_eval->runtime.eval_shared_users = 2;
+    shared_old = mesh->runtime.eval_shared;
+    mesh->runtime.eval_shared = shared;
+    shared = NULL;
+  }
+  BLI_mutex_unlock(mesh->runtime.eval_mutex);
+
+  if (shared != NULL) {
+    MEM_freeN(shared);
+  }
+  if (shared_old != NULL) {
+    BKE_mesh_eval_delete(shared_old->mesh);
+    MEM_freeN(shared_old);
+  }
+}
+
+/**
+ * Remove the reference of the input mesh to its shared result.
+ */
+void BKE_mesh_runtime_eval_shared_clear(Mesh *mesh)
+{
+  if (mesh->runtime.eval_shared != NULL) {
+    BKE_mesh_eval_delete(mesh->runtime.eval_shared->mesh);
+    MEM_freeN(mesh->runtime.eval_shared);
+    mesh->runtime.eval_shared = NULL;
+  }
+}
+
+/**
+ * Remove a user from an evaluated mesh.
+ * \return True when the mesh is not used anymore and has to be freed.
+ */
+bool BKE_mesh_runtime_eval_shared_release(Mesh *mesh_eval)
+{
+  if (mesh_eval->runtime.eval_shared_users == 0) {
+    return true;
+  }
+  return atomic_sub_and_fetch_int32(&mesh_eval->runtime.eval_shared_users, 1) == 0;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Mesh Batch Cache Callbacks
  * \{ */
@@ -261,6 +740,268 @@ void BKE_mesh_batch_cache_free(Mesh *me)
   }
 }
 
+/**
+ * Copy of the data of an evaluated mesh that its draw cache depends on, besides the vertex
+ * positions and the data derived from them.
+ */
+typedef struct MeshBatchCacheTopology {
+  /**
+   * Key of the data the copy was made from, to skip comparing the data when the layers are the
+   * same. NULL when the mesh owns some of its layers, which can be freed and reallocated at the
+   * same address with other data.
+   */
+  MeshDataKey *key;
+  short totcol;
+  char is_original;
+  size_t data_len;
+  /* The data follows the struct. */
+} MeshBatchCacheTopology;
+
+static void mesh_runtime_data_layers_foreach(const CustomData *data,
+                                             const int totelem,
+                                             const bool use_positions,
+                                             MeshDataFn fn,
+                                             void *user_data)
+{
+  fn(user_data, &totelem, sizeof(totelem));
+  for (int i = 0; i < data->totlayer; i++) {
+    const CustomDataLayer *layer = &data->layers[i];
+    if (layer->data == NULL ||
+        (layer->type != CD_MVERT && mesh_layer_depends_on_positions(layer->type))) {
+      /* Data derived from the positions. */
+      continue;
+    }
+    fn(user_data, &layer->type, sizeof(layer->type));
+    fn(user_data, layer->name, strlen(layer->name) + 1);
+    if (layer->type == CD_MVERT && !use_positions) {
+      const MVert *mvert = layer->data;
+      for (int j = 0; j < totelem; j++) {
+        const char flags[2] = {mvert[j].flag, mvert[j].bweight};
+        fn(user_data, flags, sizeof(flags));
+      }
+    }
+    else if (layer->type == CD_MDEFORMVERT) {
+      const MDeformVert *dverts = layer->data;
+      for (int j = 0; j < totelem; j++) {
+        fn(user_data, &dverts[j].totweight, sizeof(dverts[j].totweight));
+        fn(user_data, dverts[j].dw, sizeof(MDeformWeight) * (size_t)dverts[j].totweight);
+      }
+    }
+    else if (layer->type == CD_MDISPS) {
+      const MDisps *mdisps = layer->data;
+      for (int j = 0; j < totelem; j++) {
+        fn(user_data, &mdisps[j].totdisp, sizeof(mdisps[j].totdisp));
+        fn(user_data, &mdisps[j].level, sizeof(mdisps[j].level));
+        if (mdisps[j].disps != NULL) {
+          fn(user_data, mdisps[j].disps, sizeof(*mdisps[j].disps) * (size_t)mdisps[j].totdisp);
+        }
+        if (mdisps[j].hidden != NULL) {
+          fn(user_data, mdisps[j].hidden, BLI_BITMAP_SIZE(mdisps[j].totdisp));
+        }
+      }
+    }
+    else if (layer->type == CD_GRID_PAINT_MASK) {
+      const GridPaintMask *masks = layer->data;
+      for (int j = 0; j < totelem; j++) {
+        fn(user_data, &masks[j].level, sizeof(masks[j].level));
+        if (masks[j].data != NULL && masks[j].level > 0) {
+          const int grid_size = BKE_ccg_gridsize((int)masks[j].level);
+          fn(user_data, masks[j].data, sizeof(float) * (size_t)(grid_size * grid_size));
+        }
+      }
+    }
+    else {
+      fn(user_data, layer->data, (size_t)CustomData_sizeof(layer->type) * (size_t)totelem);
+    }
+  }
+}
+
+/**
+ * Pass the data of \a mesh to \a fn, for caches which compare it to the data they were built
+ * from. The vertex positions are only included when \a use_positions is true, data derived from
+ * them never is. Arrays referenced by the elements of a layer, like the weights of deform
+ * vertices, are passed instead of their addresses, which change on every copy of the mesh.
+ */
+void BKE_mesh_runtime_data_foreach(const Mesh *mesh,
+                                   const bool use_positions,
+                                   MeshDataFn fn,
+                                   void *user_data)
+{
+  mesh_runtime_data_layers_foreach(&mesh->vdata, mesh->totvert, use_positions, fn, user_data);
+  mesh_runtime_data_layers_foreach(&mesh->edata, mesh->totedge, use_positions, fn, user_data);
+  mesh_runtime_data_layers_foreach(&mesh->ldata, mesh->totloop, use_positions, fn, user_data);
+  mesh_runtime_data_layers_foreach(&mesh->pdata, mesh->totpoly, use_positions, fn, user_data);
+  fn(user_data, &mesh->flag, sizeof(mesh->flag));
+  fn(user_data, &mesh->cd_flag, sizeof(mesh->cd_flag));
+}
+
+/** Pass everything but the vertex positions and the data derived from them to \a fn. */
+static void mesh_runtime_topology_foreach(const Mesh *mesh, MeshDataFn fn, void *user_data)
+{
+  BKE_mesh_runtime_data_foreach(mesh, false, fn, user_data);
+  fn(user_data, &mesh->totcol, sizeof(mesh->totcol));
+  fn(user_data, &mesh->runtime.is_original, sizeof(mesh->runtime.is_original));
+}
+
+typedef struct MeshTopologyIter {
+  char *data;
+  size_t offset;
+  size_t data_len;
+  bool is_equal;
+} MeshTopologyIter;
+
+static void mesh_runtime_topology_size_fn(void *user_data,
+                                          const void *UNUSED(data),
+                                          const size_t size)
+{
+  MeshTopologyIter *iter = user_data;
+  iter->offset += size;
+}
+
+static void mesh_runtime_topology_copy_fn(void *user_data, const void *data, const size_t size)
+{
+  MeshTopologyIter *iter = user_data;
+  memcpy(iter->data + iter->offset, data, size);
+  iter->offset += size;
+}
+
+static void mesh_runtime_topology_compare_fn(void *user_data, const void *data, const size_t size)
+{
+  MeshTopologyIter *iter = user_data;
+  if (!iter->is_equal || size == 0) {
+    return;
+  }
+  if (iter->offset + size > iter->data_len || memcmp(iter->data + iter->offset, data, size) != 0) {
+    iter->is_equal = false;
+  }
+  iter->offset += size;
+}
+
+static MeshBatchCacheTopology *mesh_runtime_topology_copy(const Mesh *mesh)
+{
+  MeshTopologyIter iter = {NULL};
+  mesh_runtime_topology_foreach(mesh, mesh_runtime_topology_size_fn, &iter);
+
+  MeshBatchCacheTopology *topology = MEM_mallocN(sizeof(*topology) + iter.offset, __func__);
+  topology->key = BKE_mesh_runtime_data_key_new(mesh, false, false);
+  topology->totcol = mesh->totcol;
+  topology->is_original = mesh->runtime.is_original;
+  topology->data_len = iter.offset;
+  iter.data = (char *)(topology + 1);
+  iter.offset = 0;
+  mesh_runtime_topology_foreach(mesh, mesh_runtime_topology_copy_fn, &iter);
+  return topology;
+}
+
+static void mesh_runtime_topology_free(MeshBatchCacheTopology *topology)
+{
+  if (topology->key != NULL) {
+    BKE_mesh_runtime_data_key_free(topology->key);
+  }
+  MEM_freeN(topology);
+}
+
+/**
+ * Check the data of \a mesh against the key of \a topology, without reading the layers. The
+ * layers referenced by the key belong to the input of the modifier stack, they can only have
+ * been changed or reallocated when \a mesh_input was tagged for an update.
+ */
+static bool mesh_runtime_topology_key_matches(const Mesh *mesh,
+                                              const Mesh *mesh_input,
+                                              const MeshBatchCacheTopology *topology)
+{
+  return topology->key != NULL && (mesh_input->id.recalc & ID_RECALC_ALL) == 0 &&
+         topology->totcol == mesh->totcol && topology->is_original == mesh->runtime.is_original &&
+         BKE_mesh_runtime_data_key_matches(topology->key, mesh);
+}
+
+static bool mesh_runtime_topology_equals(const Mesh *mesh, const MeshBatchCacheTopology *topology)
+{
+  MeshTopologyIter iter = {NULL};
+  iter.data = (char *)(topology + 1);
+  iter.data_len = topology->data_len;
+  iter.is_equal = true;
+  mesh_runtime_topology_foreach(mesh, mesh_runtime_topology_compare_fn, &iter);
+  return iter.is_equal && iter.offset == topology->data_len;
+}
+
+/**
+ * Detach the draw cache from an evaluated mesh that is about to be freed, so that its
+ * replacement can reuse it, see #BKE_mesh_runtime_batch_cache_restore.
+ *
+ * \note Only runtime data of \a mesh is accessed, its custom data layers may reference data
+ * that is freed already.
+ */
+void *BKE_mesh_runtime_batch_cache_take(Mesh *mesh, MeshBatchCacheTopology **r_topology)
+{
+  void *batch_cache = mesh->runtime.batch_cache;
+  *r_topology = mesh->runtime.batch_cache_topology;
+  mesh->runtime.batch_cache = NULL;
+  mesh->runtime.batch_cache_topology = NULL;
+  return batch_cache;
+}
+
+/**
+ * Free a draw cache taken from an evaluated mesh that is not given to another one.
+ */
+void BKE_mesh_runtime_batch_cache_discard(void *batch_cache, MeshBatchCacheTopology *topology)
+{
+  if (topology != NULL) {
+    mesh_runtime_topology_free(topology);
+  }
+  if (batch_cache == NULL) {
+    return;
+  }
+  /* Free the cache through a temporary mesh, the callback only uses its runtime data. */
+  Mesh mesh_tmp = {{NULL}};
+  mesh_tmp.runtime.batch_cache = batch_cache;
+  BKE_mesh_batch_cache_free(&mesh_tmp);
+}
+
+/**
+ * Give the draw cache taken from the previous evaluated mesh to \a mesh, its replacement.
+ * When \a mesh only differs in vertex positions from the data the cache was built from, only
+ * the parts of the cache depending on them are tagged dirty, otherwise the whole cache is.
+ * \a mesh_input is the input of the modifier stack \a mesh is the result of.
+ *
+ * Meshes are only compared when a draw cache is handed over, so evaluations which are never
+ * drawn (render, background) don't pay for it. The layer pointers and element counts are
+ * compared first, the data only when they differ. A cache created for a new mesh is fully
+ * rebuilt on the next evaluation, since there is nothing to compare to yet.
+ */
+void BKE_mesh_runtime_batch_cache_restore(Mesh *mesh,
+                                          const Mesh *mesh_input,
+                                          void *batch_cache,
+                                          MeshBatchCacheTopology *topology)
+{
+  if (batch_cache == NULL || mesh->runtime.batch_cache != NULL) {
+    BKE_mesh_runtime_batch_cache_discard(batch_cache, topology);
+    return;
+  }
+  mesh->runtime.batch_cache = batch_cache;
+  if (topology != NULL && mesh_runtime_topology_key_matches(mesh, mesh_input, topology)) {
+    /* The same layers as before, the copy stays valid for the next evaluation. */
+    mesh->runtime.batch_cache_topology = topology;
+    BKE_mesh_batch_cache_dirty_tag(mesh, BKE_MESH_BATCH_DIRTY_DEFORM);
+    return;
+  }
+  if (topology != NULL && mesh_runtime_topology_equals(mesh, topology)) {
+    /* The same data in other layers, only the key has to be updated. */
+    if (topology->key != NULL) {
+      BKE_mesh_runtime_data_key_free(topology->key);
+    }
+    topology->key = BKE_mesh_runtime_data_key_new(mesh, false, false);
+    mesh->runtime.batch_cache_topology = topology;
+    BKE_mesh_batch_cache_dirty_tag(mesh, BKE_MESH_BATCH_DIRTY_DEFORM);
+    return;
+  }
+  if (topology != NULL) {
+    mesh_runtime_topology_free(topology);
+  }
+  mesh->runtime.batch_cache_topology = mesh_runtime_topology_copy(mesh);
+  BKE_mesh_batch_cache_dirty_tag(mesh, BKE_MESH_BATCH_DIRTY_ALL);
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
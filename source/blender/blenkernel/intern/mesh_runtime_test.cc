@@ -0,0 +1,230 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_float3.hh"
+#include "BLI_span.hh"
+
+#include "BKE_customdata.h"
+#include "BKE_geometry_set.hh"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "tests/blenkernel_testing.hh"
+
+namespace blender::bke::tests {
+
+using MeshRuntimeTest = MeshTest;
+
+TEST_F(MeshRuntimeTest, shared_topology_copy)
+{
+  Mesh *mesh = create_grid_mesh(1);
+  Mesh *copy = BKE_mesh_copy_for_eval_shared_topology(mesh);
+
+  EXPECT_EQ(copy->runtime.shared_topology, mesh->runtime.shared_topology);
+  EXPECT_EQ(copy->mloop, mesh->mloop);
+  EXPECT_EQ(copy->medge, mesh->medge);
+  EXPECT_EQ(copy->mpoly, mesh->mpoly);
+  /* Vertices are not shared, since they are expected to be changed. */
+  EXPECT_NE(copy->mvert, mesh->mvert);
+  EXPECT_TRUE(CustomData_is_referenced_layer(&copy->ldata, CD_MLOOP));
+  EXPECT_TRUE(CustomData_is_referenced_layer(&mesh->ldata, CD_MLOOP));
+  EXPECT_FALSE(CustomData_is_referenced_layer(&copy->vdata, CD_MVERT));
+
+  /* Freeing the source mesh must keep the shared arrays alive for the copy. */
+  const uint loop_vert = mesh->mloop[2].v;
+  const uint edge_vert = mesh->medge[3].v2;
+  BKE_id_free(nullptr, mesh);
+  EXPECT_EQ(copy->mloop[2].v, loop_vert);
+  EXPECT_EQ(copy->medge[3].v2, edge_vert);
+
+  BKE_id_free(nullptr, copy);
+}
+
+TEST_F(MeshRuntimeTest, shared_topology_attributes)
+{
+  Mesh *mesh = create_grid_mesh(1);
+  float *values = (float *)CustomData_add_layer_named(
+      &mesh->pdata, CD_PROP_FLOAT, CD_CALLOC, nullptr, mesh->totpoly, "value");
+  values[0] = 1.0f;
+  Mesh *copy = BKE_mesh_copy_for_eval_shared_topology(mesh);
+
+  /* Attributes are shared with the topology and stay alive after the source is freed. */
+  EXPECT_EQ(CustomData_get_layer_named(&copy->pdata, CD_PROP_FLOAT, "value"), values);
+  BKE_id_free(nullptr, mesh);
+  EXPECT_EQ(values[0], 1.0f);
+
+  /* Making the topology unique duplicates the attributes too. */
+  BKE_mesh_runtime_shared_topology_ensure_mutable(copy);
+  EXPECT_NE(CustomData_get_layer_named(&copy->pdata, CD_PROP_FLOAT, "value"), values);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&copy->pdata, CD_PROP_FLOAT));
+
+  BKE_id_free(nullptr, copy);
+}
+
+TEST_F(MeshRuntimeTest, shared_topology_write)
+{
+  Mesh *mesh = create_grid_mesh(1);
+  Mesh *copy = BKE_mesh_copy_for_eval_shared_topology(mesh);
+
+  /* Writing to a shared layer has to make it unique first. */
+  copy->mpoly = (MPoly *)CustomData_duplicate_referenced_layer(
+      &copy->pdata, CD_MPOLY, copy->totpoly);
+  EXPECT_NE(copy->mpoly, mesh->mpoly);
+  copy->mpoly[0].mat_nr = 1;
+  EXPECT_EQ(mesh->mpoly[0].mat_nr, 0);
+
+  BKE_id_free(nullptr, copy);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshRuntimeTest, shared_topology_write_in_place)
+{
+  Mesh *mesh = create_grid_mesh(2);
+  const Array<MEdge> edges(Span<MEdge>(mesh->medge, mesh->totedge));
+  const Array<MLoop> loops(Span<MLoop>(mesh->mloop, mesh->totloop));
+  const Array<MPoly> polys(Span<MPoly>(mesh->mpoly, mesh->totpoly));
+
+  /* Functions changing the topology in place must not change the meshes sharing it. */
+  Mesh *copy_edges = BKE_mesh_copy_for_eval_shared_topology(mesh);
+  BKE_mesh_calc_edges(copy_edges, false, true);
+  EXPECT_NE(copy_edges->mloop, mesh->mloop);
+
+  Mesh *copy_loose = BKE_mesh_copy_for_eval_shared_topology(mesh);
+  BKE_mesh_calc_edges_loose(copy_loose);
+  EXPECT_NE(copy_loose->medge, mesh->medge);
+
+  Mesh *copy_validate = BKE_mesh_copy_for_eval_shared_topology(mesh);
+  copy_validate->mloop = (MLoop *)CustomData_duplicate_referenced_layer(
+      &copy_validate->ldata, CD_MLOOP, copy_validate->totloop);
+  copy_validate->mloop[0].e = copy_validate->totedge;
+  BKE_mesh_validate(copy_validate, false, false);
+  EXPECT_NE(copy_validate->medge, mesh->medge);
+  EXPECT_NE(copy_validate->mpoly, mesh->mpoly);
+
+  Mesh *copy_normals = BKE_mesh_copy_for_eval_shared_topology(mesh);
+  Array<float3> normals(copy_normals->totloop, float3(0.0f, 0.0f, 1.0f));
+  normals[0] = float3(1.0f, 0.0f, 0.0f);
+  BKE_mesh_set_custom_normals(copy_normals, (float(*)[3])normals.data());
+  EXPECT_NE(copy_normals->medge, mesh->medge);
+
+  EXPECT_EQ(memcmp(mesh->medge, edges.data(), sizeof(MEdge) * edges.size()), 0);
+  EXPECT_EQ(memcmp(mesh->mloop, loops.data(), sizeof(MLoop) * loops.size()), 0);
+  EXPECT_EQ(memcmp(mesh->mpoly, polys.data(), sizeof(MPoly) * polys.size()), 0);
+
+  /* Copies sharing the topology still see the original arrays. */
+  Mesh *copy_read = BKE_mesh_copy_for_eval_shared_topology(mesh);
+  EXPECT_EQ(copy_read->mloop, mesh->mloop);
+  EXPECT_EQ(memcmp(copy_read->mloop, loops.data(), sizeof(MLoop) * loops.size()), 0);
+
+  BKE_id_free(nullptr, copy_read);
+  BKE_id_free(nullptr, copy_normals);
+  BKE_id_free(nullptr, copy_validate);
+  BKE_id_free(nullptr, copy_loose);
+  BKE_id_free(nullptr, copy_edges);
+  BKE_id_free(nullptr, mesh);
+}
+
+/* Deformed copy of \a mesh, which references everything else like an evaluated mesh. */
+static Mesh *copy_deformed(Mesh *mesh, const float offset)
+{
+  Mesh *copy = BKE_mesh_copy_for_eval(mesh, true);
+  copy->mvert = (MVert *)CustomData_duplicate_referenced_layer(
+      &copy->vdata, CD_MVERT, copy->totvert);
+  for (const int i : IndexRange(copy->totvert)) {
+    copy->mvert[i].co[2] += offset;
+  }
+  return copy;
+}
+
+TEST_F(MeshRuntimeTest, data_key)
+{
+  Mesh *mesh = create_grid_mesh(2);
+
+  /* The layers of the mesh are freed with it, so it can only be keyed when that is allowed. */
+  EXPECT_EQ(BKE_mesh_runtime_data_key_new(mesh, false, false), nullptr);
+  MeshDataKey *key_owned = BKE_mesh_runtime_data_key_new(mesh, false, true);
+  ASSERT_NE(key_owned, nullptr);
+  EXPECT_TRUE(BKE_mesh_runtime_data_key_matches(key_owned, mesh));
+  BKE_mesh_runtime_data_key_free(key_owned);
+
+  Mesh *deformed = copy_deformed(mesh, 0.0f);
+  MeshDataKey *key = BKE_mesh_runtime_data_key_new(deformed, false, false);
+  ASSERT_NE(key, nullptr);
+
+  /* Vertex positions are ignored. */
+  Mesh *deformed_again = copy_deformed(mesh, 1.0f);
+  EXPECT_TRUE(BKE_mesh_runtime_data_key_matches(key, deformed_again));
+
+  /* Unless they are part of the key. */
+  MeshDataKey *key_positions = BKE_mesh_runtime_data_key_new(deformed, true, true);
+  EXPECT_TRUE(BKE_mesh_runtime_data_key_matches(key_positions, deformed));
+  EXPECT_FALSE(BKE_mesh_runtime_data_key_matches(key_positions, deformed_again));
+  BKE_mesh_runtime_data_key_free(key_positions);
+
+  /* Vertex flags are compared by value, since they are stored with the positions. */
+  deformed_again->mvert[3].flag |= ME_HIDE;
+  EXPECT_FALSE(BKE_mesh_runtime_data_key_matches(key, deformed_again));
+  deformed_again->mvert[3].flag &= ~ME_HIDE;
+  EXPECT_TRUE(BKE_mesh_runtime_data_key_matches(key, deformed_again));
+
+  /* Other data is compared by pointer, writing to it makes it unique first. */
+  deformed_again->mpoly = (MPoly *)CustomData_duplicate_referenced_layer(
+      &deformed_again->pdata, CD_MPOLY, deformed_again->totpoly);
+  EXPECT_FALSE(BKE_mesh_runtime_data_key_matches(key, deformed_again));
+
+  /* New layers and different element counts don't match either. */
+  Mesh *with_uv = copy_deformed(mesh, 0.0f);
+  CustomData_add_layer(&with_uv->ldata, CD_MLOOPUV, CD_CALLOC, nullptr, with_uv->totloop);
+  EXPECT_FALSE(BKE_mesh_runtime_data_key_matches(key, with_uv));
+  Mesh *other = create_grid_mesh(3);
+  EXPECT_FALSE(BKE_mesh_runtime_data_key_matches(key, other));
+
+  BKE_mesh_runtime_data_key_free(key);
+  for (Mesh *mesh_iter : {other, with_uv, deformed_again, deformed, mesh}) {
+    BKE_id_free(nullptr, mesh_iter);
+  }
+}
+
+TEST_F(MeshRuntimeTest, component_copy)
+{
+  /* Owned meshes give their topology to the copy. */
+  Mesh *mesh = create_grid_mesh(1);
+  MeshComponent component;
+  component.replace(mesh, GeometryOwnershipType::Owned);
+  GeometryComponent *copy = component.copy();
+  EXPECT_NE(mesh->runtime.shared_topology, nullptr);
+  EXPECT_TRUE(CustomData_is_referenced_layer(&mesh->ldata, CD_MLOOP));
+  delete copy;
+
+  /* Meshes which aren't owned by the component are left untouched. */
+  Mesh *mesh_editable = create_grid_mesh(1);
+  MeshComponent component_editable;
+  component_editable.replace(mesh_editable, GeometryOwnershipType::Editable);
+  copy = component_editable.copy();
+  EXPECT_EQ(mesh_editable->runtime.shared_topology, nullptr);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&mesh_editable->ldata, CD_MLOOP));
+  EXPECT_NE(static_cast<MeshComponent *>(copy)->get_for_read()->mloop, mesh_editable->mloop);
+  delete copy;
+  BKE_id_free(nullptr, mesh_editable);
+}
+
+}  // namespace blender::bke::tests
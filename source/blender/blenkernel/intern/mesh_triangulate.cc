@@ -0,0 +1,373 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bke
+ *
+ * Triangulation of a #Mesh without converting it to #BMesh. The result is the same as with
+ * #BM_mesh_triangulate, but all polygons are processed in parallel and the custom data of the
+ * new mesh is gathered layer by layer from the original mesh.
+ */
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+
+#include "BLI_array.hh"
+#include "BLI_float2.hh"
+#include "BLI_heap.h"
+#include "BLI_map.hh"
+#include "BLI_math_geom.h"
+#include "BLI_math_vector.h"
+#include "BLI_memarena.h"
+#include "BLI_polyfill_2d.h"
+#include "BLI_polyfill_2d_beautify.h"
+#include "BLI_task.hh"
+#include "BLI_vector.hh"
+
+#include "BKE_customdata.h"
+#include "BKE_mesh.h"
+
+namespace blender::bke::mesh_triangulate {
+
+static bool poly_is_triangulated(const MPoly &poly, const int min_vertices)
+{
+  return poly.totloop > 3 && poly.totloop >= min_vertices;
+}
+
+/**
+ * Same as the area based rotation cost of #BM_verts_calc_rotate_beauty: check if the edge from
+ * \a v1 to \a v3 gives better results than the edge from \a v2 to \a v4.
+ */
+static float quad_calc_rotate_beauty(const float v1[3],
+                                     const float v2[3],
+                                     const float v3[3],
+                                     const float v4[3])
+{
+  const float eps = 1e-5;
+  float no_a[3], no_b[3];
+  float no[3];
+  float axis_mat[3][3];
+  float v1_xy[2], v2_xy[2], v3_xy[2], v4_xy[2];
+
+  cross_tri_v3(no_a, v2, v3, v4);
+  cross_tri_v3(no_b, v2, v4, v1);
+  add_v3_v3v3(no, no_a, no_b);
+  const float no_scale = normalize_v3(no);
+  if (UNLIKELY(no_scale == 0.0f)) {
+    return FLT_MAX;
+  }
+
+  axis_dominant_v3_to_m3(axis_mat, no);
+  mul_v2_m3v3(v1_xy, axis_mat, v1);
+  mul_v2_m3v3(v2_xy, axis_mat, v2);
+  mul_v2_m3v3(v3_xy, axis_mat, v3);
+  mul_v2_m3v3(v4_xy, axis_mat, v4);
+
+  /* Ignore faces that are already flipped or both degenerate. */
+  if (!(signum_i_ex(cross_tri_v2(v2_xy, v3_xy, v4_xy) / no_scale, eps) +
+        signum_i_ex(cross_tri_v2(v2_xy, v4_xy, v1_xy) / no_scale, eps))) {
+    return FLT_MAX;
+  }
+
+  return BLI_polyfill_beautify_quad_rotate_calc_ex(v1_xy, v2_xy, v3_xy, v4_xy, false, nullptr);
+}
+
+/**
+ * Choose the diagonal of a quad. Returns true when the quad is split between its first and third
+ * corner, and false when it is split between the second and fourth corner.
+ */
+static bool quad_split_first_third(const MVert *mvert, const MLoop *loops, const int quad_method)
+{
+  switch (quad_method) {
+    case MOD_TRIANGULATE_QUAD_FIXED:
+      return true;
+    case MOD_TRIANGULATE_QUAD_ALTERNATE:
+      return false;
+    case MOD_TRIANGULATE_QUAD_SHORTEDGE: {
+      const float d1 = len_squared_v3v3(mvert[loops[0].v].co, mvert[loops[2].v].co);
+      const float d2 = len_squared_v3v3(mvert[loops[1].v].co, mvert[loops[3].v].co);
+      return (d2 - d1) > 0.0f;
+    }
+    case MOD_TRIANGULATE_QUAD_BEAUTY:
+    default: {
+      const float *v1 = mvert[loops[1].v].co;
+      const float *v2 = mvert[loops[2].v].co;
+      const float *v3 = mvert[loops[3].v].co;
+      const float *v4 = mvert[loops[0].v].co;
+      /* First check if the quad is concave on either diagonal. */
+      const int flip_flag = is_quad_flip_v3(v1, v2, v3, v4);
+      if (UNLIKELY(flip_flag & (1 << 0))) {
+        return true;
+      }
+      if (UNLIKELY(flip_flag & (1 << 1))) {
+        return false;
+      }
+      if (UNLIKELY(loops[1].v == loops[3].v)) {
+        return true;
+      }
+      return quad_calc_rotate_beauty(v1, v2, v3, v4) > 0.0f;
+    }
+  }
+}
+
+/** Data that is reused for all polygons that are triangulated by one thread. */
+struct TriangulateData {
+  MemArena *arena = nullptr;
+  Heap *heap = nullptr;
+  Vector<float2> projverts;
+  Vector<uint> tris;
+  /* Maps a diagonal, given by its sorted corner indices in the polygon, to its edge index. */
+  Map<std::pair<uint, uint>, int> diagonals;
+
+  ~TriangulateData()
+  {
+    if (arena) {
+      BLI_memarena_free(arena);
+    }
+    if (heap) {
+      BLI_heap_free(heap, nullptr);
+    }
+  }
+};
+
+/**
+ * Compute the triangles of a polygon with at least four corners. The corner indices of the
+ * triangles are written to `data.tris`, relative to the start of the polygon.
+ */
+static void poly_calc_tris(const Mesh &mesh,
+                           const MPoly &poly,
+                           const int quad_method,
+                           const int ngon_method,
+                           TriangulateData &data)
+{
+  const MLoop *loops = &mesh.mloop[poly.loopstart];
+  const int size = poly.totloop;
+  data.tris.resize((size - 2) * 3);
+  uint(*tris)[3] = reinterpret_cast<uint(*)[3]>(data.tris.data());
+
+  if (size == 4) {
+    if (quad_split_first_third(mesh.mvert, loops, quad_method)) {
+      ARRAY_SET_ITEMS(tris[0], 0, 1, 2);
+      ARRAY_SET_ITEMS(tris[1], 0, 2, 3);
+    }
+    else {
+      ARRAY_SET_ITEMS(tris[0], 1, 2, 3);
+      ARRAY_SET_ITEMS(tris[1], 1, 3, 0);
+    }
+    return;
+  }
+
+  if (data.arena == nullptr) {
+    data.arena = BLI_memarena_new(BLI_POLYFILL_ARENA_SIZE, __func__);
+  }
+
+  float normal[3];
+  float axis_mat[3][3];
+  BKE_mesh_calc_poly_normal(&poly, loops, mesh.mvert, normal);
+  axis_dominant_v3_to_m3_negate(axis_mat, normal);
+
+  data.projverts.resize(size);
+  for (const int i : IndexRange(size)) {
+    mul_v2_m3v3(data.projverts[i], axis_mat, mesh.mvert[loops[i].v].co);
+  }
+  const float(*projverts)[2] = reinterpret_cast<const float(*)[2]>(data.projverts.data());
+
+  BLI_polyfill_calc_arena(projverts, size, 1, tris, data.arena);
+  if (ngon_method == MOD_TRIANGULATE_NGON_BEAUTY) {
+    if (data.heap == nullptr) {
+      data.heap = BLI_heap_new_ex(BLI_POLYFILL_ALLOC_NGON_RESERVE);
+    }
+    BLI_polyfill_beautify(projverts, size, tris, data.arena, data.heap);
+  }
+  BLI_memarena_clear(data.arena);
+}
+
+/**
+ * Copy all layers of \a src to the layers with the same type and name in \a dst, where
+ * `src_indices` contains the source element of every destination element. Runs of consecutive
+ * source elements (untouched polygons, corners of a triangle) are copied at once.
+ */
+static void copy_custom_data_by_map(const CustomData &src,
+                                    CustomData &dst,
+                                    Span<int> src_indices,
+                                    const CustomDataMask skip_mask)
+{
+  for (const int dst_layer : IndexRange(dst.totlayer)) {
+    const CustomDataLayer &layer = dst.layers[dst_layer];
+    if (CD_TYPE_AS_MASK(layer.type) & skip_mask) {
+      continue;
+    }
+    const int src_layer = CustomData_get_named_layer_index(&src, layer.type, layer.name);
+    if (src_layer == -1) {
+      continue;
+    }
+    parallel_for(src_indices.index_range(), 4096, [&](IndexRange range) {
+      int run_start = range.start();
+      for (const int i : range) {
+        const int next = i + 1;
+        if (next < range.one_after_last() && src_indices[next] == src_indices[i] + 1) {
+          continue;
+        }
+        const int run_len = next - run_start;
+        CustomData_copy_data_layer(
+            &src, &dst, src_layer, dst_layer, src_indices[run_start], run_start, run_len);
+        run_start = next;
+      }
+    });
+  }
+}
+
+static Mesh *triangulate(const Mesh &mesh,
+                         const int quad_method,
+                         const int ngon_method,
+                         const int min_vertices)
+{
+  Span<MPoly> polys{mesh.mpoly, mesh.totpoly};
+
+  /* Compute where the data of every polygon starts in the new mesh. Every triangulated polygon
+   * with N corners is replaced by N - 2 triangles and adds N - 3 edges. */
+  Array<int> poly_offsets(polys.size() + 1);
+  Array<int> loop_offsets(polys.size() + 1);
+  Array<int> edge_offsets(polys.size() + 1);
+  poly_offsets[0] = 0;
+  loop_offsets[0] = 0;
+  edge_offsets[0] = mesh.totedge;
+  for (const int i : polys.index_range()) {
+    const MPoly &poly = polys[i];
+    const bool triangulate = poly_is_triangulated(poly, min_vertices);
+    poly_offsets[i + 1] = poly_offsets[i] + (triangulate ? poly.totloop - 2 : 1);
+    loop_offsets[i + 1] = loop_offsets[i] + (triangulate ? (poly.totloop - 2) * 3 : poly.totloop);
+    edge_offsets[i + 1] = edge_offsets[i] + (triangulate ? poly.totloop - 3 : 0);
+  }
+  const int result_polys_num = poly_offsets.last();
+  const int result_loops_num = loop_offsets.last();
+  const int result_edges_num = edge_offsets.last();
+
+  Mesh *result = BKE_mesh_new_nomain_from_template(
+      &mesh, mesh.totvert, result_edges_num, 0, result_loops_num, result_polys_num);
+
+  CustomData_copy_data(&mesh.vdata, &result->vdata, 0, 0, mesh.totvert);
+  CustomData_copy_data(&mesh.edata, &result->edata, 0, 0, mesh.totedge);
+
+  MutableSpan<MEdge> edges{result->medge, result->totedge};
+  parallel_for(IndexRange(mesh.totedge), 4096, [&](IndexRange range) {
+    for (const int i : range) {
+      edges[i].flag |= ME_EDGEDRAW | ME_EDGERENDER;
+    }
+  });
+  int *edge_origindex = (int *)CustomData_get_layer(&result->edata, CD_ORIGINDEX);
+  if (edge_origindex != nullptr) {
+    for (const int i : IndexRange(mesh.totedge, result_edges_num - mesh.totedge)) {
+      edge_origindex[i] = ORIGINDEX_NONE;
+    }
+  }
+
+  /* The source of every new polygon and corner, used to copy the remaining custom data. */
+  Array<int> poly_src(result_polys_num);
+  Array<int> loop_src(result_loops_num);
+  MutableSpan<MPoly> result_polys{result->mpoly, result->totpoly};
+  MutableSpan<MLoop> result_loops{result->mloop, result->totloop};
+
+  parallel_for(polys.index_range(), 1024, [&](IndexRange range) {
+    TriangulateData data;
+    for (const int poly_index : range) {
+      const MPoly &poly = polys[poly_index];
+      const MLoop *loops = &mesh.mloop[poly.loopstart];
+      const int dst_poly = poly_offsets[poly_index];
+      const int dst_loop = loop_offsets[poly_index];
+
+      if (!poly_is_triangulated(poly, min_vertices)) {
+        MPoly &result_poly = result_polys[dst_poly];
+        result_poly = poly;
+        result_poly.loopstart = dst_loop;
+        poly_src[dst_poly] = poly_index;
+        for (const int i : IndexRange(poly.totloop)) {
+          result_loops[dst_loop + i] = loops[i];
+          loop_src[dst_loop + i] = poly.loopstart + i;
+        }
+        continue;
+      }
+
+      poly_calc_tris(mesh, poly, quad_method, ngon_method, data);
+      const uint(*tris)[3] = reinterpret_cast<const uint(*)[3]>(data.tris.data());
+      const uint size = (uint)poly.totloop;
+      int next_edge = edge_offsets[poly_index];
+      data.diagonals.clear();
+
+      /* Find the edge between two corners of the polygon, adding a new edge for diagonals. */
+      auto corner_edge = [&](const uint a, const uint b) -> int {
+        if (b == (a + 1) % size) {
+          return loops[a].e;
+        }
+        if (a == (b + 1) % size) {
+          return loops[b].e;
+        }
+        const std::pair<uint, uint> key = a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+        return data.diagonals.lookup_or_add_cb(key, [&]() {
+          MEdge &edge = edges[next_edge];
+          edge.v1 = loops[key.first].v;
+          edge.v2 = loops[key.second].v;
+          edge.flag = ME_EDGEDRAW | ME_EDGERENDER;
+          return next_edge++;
+        });
+      };
+
+      for (const int tri_index : IndexRange(poly.totloop - 2)) {
+        const uint *tri = tris[tri_index];
+        MPoly &result_poly = result_polys[dst_poly + tri_index];
+        result_poly = poly;
+        result_poly.loopstart = dst_loop + tri_index * 3;
+        result_poly.totloop = 3;
+        poly_src[dst_poly + tri_index] = poly_index;
+        for (const int i : IndexRange(3)) {
+          const int result_loop = result_poly.loopstart + i;
+          result_loops[result_loop].v = loops[tri[i]].v;
+          result_loops[result_loop].e = corner_edge(tri[i], tri[(i + 1) % 3]);
+          loop_src[result_loop] = poly.loopstart + (int)tri[i];
+        }
+      }
+      BLI_assert(next_edge == edge_offsets[poly_index + 1]);
+    }
+  });
+
+  copy_custom_data_by_map(mesh.pdata, result->pdata, poly_src, CD_MASK_MPOLY);
+  copy_custom_data_by_map(mesh.ldata, result->ldata, loop_src, CD_MASK_MLOOP);
+
+  result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+
+  return result;
+}
+
+}  // namespace blender::bke::mesh_triangulate
+
+/**
+ * Triangulate all polygons with at least \a min_vertices corners, the other polygons are kept
+ * as they are. The original edges keep their indices, new edges are added after them.
+ *
+ * \param quad_method: One of the #MOD_TRIANGULATE_QUAD_BEAUTY values.
+ * \param ngon_method: One of the #MOD_TRIANGULATE_NGON_BEAUTY values.
+ */
+Mesh *BKE_mesh_triangulate(const Mesh *mesh,
+                           const int quad_method,
+                           const int ngon_method,
+                           const int min_vertices)
+{
+  return blender::bke::mesh_triangulate::triangulate(
+      *mesh, quad_method, ngon_method, min_vertices);
+}
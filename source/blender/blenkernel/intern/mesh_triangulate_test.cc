@@ -0,0 +1,168 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "testing/testing.h"
+
+#include <cmath>
+
+#include "BKE_customdata.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "BLI_math_base.h"
+#include "BLI_math_vector.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+
+#include "tests/blenkernel_testing.hh"
+
+namespace blender::bke::tests {
+
+using MeshTriangulateTest = MeshTest;
+
+/* Create a mesh with a quad and a regular polygon with `ngon_size` corners next to it. */
+static Mesh *create_quad_and_ngon_mesh(const int ngon_size)
+{
+  const int verts_num = 4 + ngon_size;
+  const int loops_num = 4 + ngon_size;
+  Mesh *mesh = BKE_mesh_new_nomain(verts_num, 0, 0, loops_num, 2);
+
+  const float quad_positions[4][3] = {{-3, -1, 0}, {-2, -1, 0}, {-2, 1, 0}, {-3, 1, 0}};
+  for (int i = 0; i < 4; i++) {
+    copy_v3_v3(mesh->mvert[i].co, quad_positions[i]);
+    mesh->mloop[i].v = i;
+  }
+  for (int i = 0; i < ngon_size; i++) {
+    const float angle = 2.0f * (float)M_PI * i / ngon_size;
+    MVert &vert = mesh->mvert[4 + i];
+    vert.co[0] = cosf(angle);
+    vert.co[1] = sinf(angle);
+    vert.co[2] = 0.0f;
+    mesh->mloop[4 + i].v = 4 + i;
+  }
+  mesh->mpoly[0].loopstart = 0;
+  mesh->mpoly[0].totloop = 4;
+  mesh->mpoly[1].loopstart = 4;
+  mesh->mpoly[1].totloop = ngon_size;
+  mesh->mpoly[1].mat_nr = 1;
+
+  BKE_mesh_calc_edges(mesh, false, false);
+  BKE_mesh_calc_normals(mesh);
+  return mesh;
+}
+
+static float mesh_area(const Mesh *mesh)
+{
+  float area = 0.0f;
+  for (int i = 0; i < mesh->totpoly; i++) {
+    const MPoly &poly = mesh->mpoly[i];
+    area += BKE_mesh_calc_poly_area(&poly, &mesh->mloop[poly.loopstart], mesh->mvert);
+  }
+  return area;
+}
+
+TEST_F(MeshTriangulateTest, all_polygons)
+{
+  Mesh *mesh = create_quad_and_ngon_mesh(7);
+  Mesh *result = BKE_mesh_triangulate(
+      mesh, MOD_TRIANGULATE_QUAD_BEAUTY, MOD_TRIANGULATE_NGON_BEAUTY, 4);
+
+  EXPECT_EQ(result->totvert, mesh->totvert);
+  EXPECT_EQ(result->totpoly, 2 + 5);
+  EXPECT_EQ(result->totloop, result->totpoly * 3);
+  EXPECT_EQ(result->totedge, mesh->totedge + 1 + 4);
+  EXPECT_TRUE(BKE_mesh_is_valid(result));
+  EXPECT_NEAR(mesh_area(result), mesh_area(mesh), 1e-5f);
+
+  /* Original edges keep their indices. */
+  for (int i = 0; i < mesh->totedge; i++) {
+    EXPECT_EQ(result->medge[i].v1, mesh->medge[i].v1);
+    EXPECT_EQ(result->medge[i].v2, mesh->medge[i].v2);
+  }
+  /* Triangles of a polygon are stored in place and keep the polygon's attributes. */
+  for (int i = 0; i < 2; i++) {
+    EXPECT_EQ(result->mpoly[i].mat_nr, 0);
+  }
+  for (int i = 2; i < result->totpoly; i++) {
+    EXPECT_EQ(result->mpoly[i].mat_nr, 1);
+  }
+
+  BKE_id_free(nullptr, result);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshTriangulateTest, min_vertices)
+{
+  Mesh *mesh = create_quad_and_ngon_mesh(6);
+  Mesh *result = BKE_mesh_triangulate(
+      mesh, MOD_TRIANGULATE_QUAD_FIXED, MOD_TRIANGULATE_NGON_EARCLIP, 5);
+
+  /* Only the hexagon is triangulated. */
+  EXPECT_EQ(result->totpoly, 1 + 4);
+  EXPECT_EQ(result->mpoly[0].totloop, 4);
+  EXPECT_EQ(result->totedge, mesh->totedge + 3);
+  EXPECT_TRUE(BKE_mesh_is_valid(result));
+  EXPECT_NEAR(mesh_area(result), mesh_area(mesh), 1e-5f);
+
+  BKE_id_free(nullptr, result);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshTriangulateTest, quad_methods)
+{
+  Mesh *mesh = create_quad_and_ngon_mesh(3);
+  /* Make the diagonal between the second and fourth corner the shortest. */
+  mesh->mvert[0].co[0] = -3.5f;
+
+  Mesh *fixed = BKE_mesh_triangulate(
+      mesh, MOD_TRIANGULATE_QUAD_FIXED, MOD_TRIANGULATE_NGON_BEAUTY, 4);
+  EXPECT_EQ(fixed->mloop[0].v, 0);
+  EXPECT_EQ(fixed->mloop[2].v, 2);
+
+  Mesh *shortedge = BKE_mesh_triangulate(
+      mesh, MOD_TRIANGULATE_QUAD_SHORTEDGE, MOD_TRIANGULATE_NGON_BEAUTY, 4);
+  EXPECT_EQ(shortedge->mloop[0].v, 1);
+  EXPECT_EQ(shortedge->mloop[2].v, 3);
+
+  BKE_id_free(nullptr, shortedge);
+  BKE_id_free(nullptr, fixed);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshTriangulateTest, custom_data)
+{
+  Mesh *mesh = create_quad_and_ngon_mesh(5);
+  float *weights = (float *)CustomData_add_layer_named(
+      &mesh->ldata, CD_PROP_FLOAT, CD_CALLOC, nullptr, mesh->totloop, "weight");
+  for (int i = 0; i < mesh->totloop; i++) {
+    weights[i] = (float)mesh->mloop[i].v;
+  }
+
+  Mesh *result = BKE_mesh_triangulate(
+      mesh, MOD_TRIANGULATE_QUAD_BEAUTY, MOD_TRIANGULATE_NGON_BEAUTY, 4);
+  const float *result_weights = (const float *)CustomData_get_layer_named(
+      &result->ldata, CD_PROP_FLOAT, "weight");
+  ASSERT_NE(result_weights, nullptr);
+  for (int i = 0; i < result->totloop; i++) {
+    EXPECT_EQ(result_weights[i], (float)result->mloop[i].v);
+  }
+
+  BKE_id_free(nullptr, result);
+  BKE_id_free(nullptr, mesh);
+}
+
+}  // namespace blender::bke::tests
@@ -42,6 +42,7 @@
 #include "BKE_customdata.h"
 #include "BKE_deform.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 
 #include "DEG_depsgraph.h"
 
@@ -1054,6 +1055,9 @@ bool BKE_mesh_validate(Mesh *me, const bool do_verbose, const bool cddata_check_
     CLOG_INFO(&LOG, 0, "MESH: %s", me->id.name + 2);
   }
 
+  /* Invalid elements are fixed in place. */
+  BKE_mesh_runtime_shared_topology_ensure_mutable(me);
+
   is_valid &= BKE_mesh_validate_all_customdata(&me->vdata,
                                                me->totvert,
                                                &me->edata,
@@ -1211,6 +1215,8 @@ void BKE_mesh_strip_loose_polysloops(Mesh *me)
   /* New loops idx! */
   int *new_idx = MEM_mallocN(sizeof(int) * me->totloop, __func__);
 
+  BKE_mesh_runtime_shared_topology_ensure_mutable(me);
+
   for (a = b = 0, p = me->mpoly; a < me->totpoly; a++, p++) {
     bool invalid = false;
     int i = p->loopstart;
@@ -1281,6 +1287,8 @@ void BKE_mesh_strip_loose_edges(Mesh *me)
   int a, b;
   unsigned int *new_idx = MEM_mallocN(sizeof(int) * me->totedge, __func__);
 
+  BKE_mesh_runtime_shared_topology_ensure_mutable(me);
+
   for (a = b = 0, e = me->medge; a < me->totedge; a++, e++) {
     if (e->v1 != e->v2) {
       if (a != b) {
@@ -1529,6 +1537,8 @@ void BKE_mesh_calc_edges_legacy(Mesh *me, const bool use_old)
 
 void BKE_mesh_calc_edges_loose(Mesh *mesh)
 {
+  BKE_mesh_runtime_shared_topology_ensure_mutable(mesh);
+
   MEdge *med = mesh->medge;
   for (int i = 0; i < mesh->totedge; i++, med++) {
     med->flag |= ME_LOOSEEDGE;
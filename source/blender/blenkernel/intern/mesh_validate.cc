@@ -31,6 +31,7 @@
 
 #include "BKE_customdata.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 
 namespace blender::bke::calc_edges {
 
@@ -229,6 +230,9 @@ void BKE_mesh_calc_edges(Mesh *mesh, bool keep_existing_edges, const bool select
   using namespace blender::bke;
   using namespace blender::bke::calc_edges;
 
+  /* Loops are given their new edge indices in place. */
+  BKE_mesh_runtime_shared_topology_ensure_mutable(mesh);
+
   /* Parallelization is achieved by having multiple hash tables for different subsets of edges.
    * Each edge is assigned to one of the hash maps based on the lower bits of a hash value. */
   const int parallel_maps = get_parallel_maps_count(mesh);
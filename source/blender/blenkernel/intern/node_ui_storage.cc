@@ -163,3 +163,19 @@ void BKE_nodetree_attribute_hint_add(bNodeTree &ntree,
   NodeUIStorage &node_ui_storage = node_ui_storage_ensure(ntree, context, node);
   node_ui_storage.attribute_name_hints.add_as(attribute_name);
 }
+
+/**
+ * Accumulate execution statistics of a node, used to find the nodes that are the most expensive
+ * to evaluate. A node can be executed more than once per evaluation when it is part of a node
+ * group that is used multiple times.
+ */
+void BKE_nodetree_exec_stats_add(bNodeTree &ntree,
+                                 const NodeTreeEvaluationContext &context,
+                                 const bNode &node,
+                                 const blender::timeit::Nanoseconds exec_time,
+                                 const int64_t exec_memory_delta)
+{
+  NodeUIStorage &node_ui_storage = node_ui_storage_ensure(ntree, context, node);
+  node_ui_storage.exec_time += exec_time;
+  node_ui_storage.exec_memory_delta += exec_memory_delta;
+}
@@ -118,6 +118,7 @@
 #include "BKE_material.h"
 #include "BKE_mball.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 #include "BKE_mesh_wrapper.h"
 #include "BKE_modifier.h"
 #include "BKE_multires.h"
@@ -318,6 +319,8 @@ static void object_free_data(ID *id)
     ob->runtime.curve_cache = NULL;
   }
 
+  mesh_modifier_stack_cache_free(ob);
+
   BKE_previewimg_free(&ob->preview);
 }
 
@@ -1794,6 +1797,7 @@ void BKE_object_free_caches(Object *object)
    */
   if ((object->base_flag & BASE_FROM_DUPLI) == 0) {
     BKE_object_free_derived_caches(object);
+    mesh_modifier_stack_cache_free(object);
     update_flag |= ID_RECALC_GEOMETRY;
   }
 
@@ -5058,6 +5062,7 @@ void BKE_object_runtime_reset_on_copy(Object *object, const int UNUSED(flag))
   runtime->gpd_eval = NULL;
   runtime->mesh_deform_eval = NULL;
   runtime->curve_cache = NULL;
+  runtime->modifier_stack_cache = NULL;
   runtime->object_as_temp_mesh = NULL;
   runtime->object_as_temp_curve = NULL;
   runtime->geometry_set_eval = NULL;
@@ -384,7 +384,11 @@ void BKE_object_eval_uber_data(Depsgraph *depsgraph, Scene *scene, Object *ob)
   DEG_debug_print_eval(depsgraph, __func__, ob->id.name, ob);
   BLI_assert(ob->type != OB_ARMATURE);
   BKE_object_handle_data_update(depsgraph, scene, ob);
-  BKE_object_batch_cache_dirty_tag(ob);
+  /* Evaluated meshes owned by the object are new, the draw cache they took over from the previous
+   * result is tagged already, see #BKE_mesh_runtime_batch_cache_restore. */
+  if (!(ob->type == OB_MESH && ob->runtime.data_eval != NULL && ob->runtime.is_data_eval_owned)) {
+    BKE_object_batch_cache_dirty_tag(ob);
+  }
 }
 
 void BKE_object_eval_ptcache_reset(Depsgraph *depsgraph, Scene *scene, Object *object)
@@ -429,7 +433,10 @@ void BKE_object_data_select_update(Depsgraph *depsgraph, ID *object_data)
 void BKE_object_select_update(Depsgraph *depsgraph, Object *object)
 {
   DEG_debug_print_eval(depsgraph, __func__, object->id.name, object);
-  if (object->type == OB_MESH && !object->runtime.is_data_eval_owned) {
+  /* Evaluated meshes not owned by the object, or shared with other objects, can be updated from
+   * multiple threads. */
+  if (object->type == OB_MESH && (!object->runtime.is_data_eval_owned ||
+                                  ((Mesh *)object->data)->runtime.eval_shared_users != 0)) {
     Mesh *mesh_input = (Mesh *)object->runtime.data_orig;
     Mesh_Runtime *mesh_runtime = &mesh_input->runtime;
     BLI_mutex_lock(mesh_runtime->eval_mutex);
@@ -1418,6 +1418,7 @@ static void sculptsession_free_pbvh(Object *object)
     BKE_pbvh_free(ss->pbvh);
     ss->pbvh = NULL;
   }
+  ss->pbvh_refit_pending = false;
 
   MEM_SAFE_FREE(ss->pmap);
   MEM_SAFE_FREE(ss->pmap_mem);
@@ -1764,7 +1765,15 @@ void BKE_sculpt_update_object_before_eval(Object *ob)
       /* We free pbvh on changes, except in the middle of drawing a stroke
        * since it can't deal with changing PVBH node organization, we hope
        * topology does not change in the meantime .. weak. */
-      sculptsession_free_pbvh(ob);
+      if (ss->pbvh && BKE_pbvh_type(ss->pbvh) == PBVH_FACES && (ob->mode & OB_MODE_ALL_SCULPT)) {
+        /* Most updates only move vertices, keep the tree and its topology maps so it can be
+         * refit after evaluation instead of being rebuilt. */
+        ss->pbvh_refit_pending = true;
+        MEM_SAFE_FREE(ss->persistent_base);
+      }
+      else {
+        sculptsession_free_pbvh(ob);
+      }
 
       BKE_sculptsession_free_deformMats(ob->sculpt);
 
@@ -2146,6 +2155,26 @@ static PBVH *build_pbvh_from_regular_mesh(Object *ob, Mesh *me_eval_deform, bool
   return pbvh;
 }
 
+/* Refit the PBVH kept over a mesh update, see #SculptSession.pbvh_refit_pending. */
+static void refit_pbvh_from_regular_mesh(Object *ob, Mesh *me_eval_deform, bool respect_hide)
+{
+  Mesh *me = BKE_object_get_original_mesh(ob);
+  PBVH *pbvh = ob->sculpt->pbvh;
+  BKE_pbvh_respect_hide_set(pbvh, respect_hide);
+
+  BKE_sculpt_sync_face_set_visibility(me, NULL);
+
+  BKE_pbvh_refit_mesh(pbvh, me);
+
+  const bool is_deformed = check_sculpt_object_deformed(ob, true);
+  if (is_deformed && me_eval_deform != NULL) {
+    int totvert;
+    float(*v_cos)[3] = BKE_mesh_vert_coords_alloc(me_eval_deform, &totvert);
+    BKE_pbvh_vert_coords_apply(pbvh, v_cos, totvert);
+    MEM_freeN(v_cos);
+  }
+}
+
 static PBVH *build_pbvh_from_ccg(Object *ob, SubdivCCG *subdiv_ccg, bool respect_hide)
 {
   CCGKey key;
@@ -2182,6 +2211,19 @@ PBVH *BKE_sculpt_object_pbvh_ensure(Depsgraph *depsgraph, Object *ob)
   }
 
   PBVH *pbvh = ob->sculpt->pbvh;
+  if (pbvh != NULL && ob->sculpt->pbvh_refit_pending) {
+    ob->sculpt->pbvh_refit_pending = false;
+    Object *object_eval = DEG_get_evaluated_object(depsgraph, ob);
+    Mesh *mesh_eval = object_eval->data;
+    if (ob->type == OB_MESH && ob->sculpt->bm == NULL && mesh_eval->runtime.subdiv_ccg == NULL &&
+        BKE_pbvh_mesh_topology_matches(pbvh, BKE_object_get_original_mesh(ob))) {
+      refit_pbvh_from_regular_mesh(ob, object_eval->runtime.mesh_deform_eval, respect_hide);
+      return pbvh;
+    }
+    sculptsession_free_pbvh(ob);
+    pbvh = NULL;
+  }
+
   if (pbvh != NULL) {
     /* NOTE: It is possible that grids were re-allocated due to modifier
      * stack. Need to update those pointers. */
@@ -2213,6 +2255,7 @@ PBVH *BKE_sculpt_object_pbvh_ensure(Depsgraph *depsgraph, Object *ob)
   }
 
   ob->sculpt->pbvh = pbvh;
+  ob->sculpt->pbvh_refit_pending = false;
   return pbvh;
 }
 
@@ -24,6 +24,7 @@
 
 #include "BLI_bitmap.h"
 #include "BLI_ghash.h"
+#include "BLI_hash.h"
 #include "BLI_math.h"
 #include "BLI_rand.h"
 #include "BLI_task.h"
@@ -32,6 +33,7 @@
 #include "DNA_meshdata_types.h"
 
 #include "BKE_ccg.h"
+#include "BKE_customdata.h"
 #include "BKE_mesh.h" /* for BKE_mesh_calc_normals */
 #include "BKE_paint.h"
 #include "BKE_pbvh.h"
@@ -171,28 +173,6 @@ static bool grid_materials_match(const DMFlagMat *f1, const DMFlagMat *f2)
   return ((f1->flag & ME_SMOOTH) == (f2->flag & ME_SMOOTH) && (f1->mat_nr == f2->mat_nr));
 }
 
-/* Adapted from BLI_kdopbvh.c */
-/* Returns the index of the first element on the right of the partition */
-static int partition_indices(int *prim_indices, int lo, int hi, int axis, float mid, BBC *prim_bbc)
-{
-  int i = lo, j = hi;
-  for (;;) {
-    for (; prim_bbc[prim_indices[i]].bcentroid[axis] < mid; i++) {
-      /* pass */
-    }
-    for (; mid < prim_bbc[prim_indices[j]].bcentroid[axis]; j--) {
-      /* pass */
-    }
-
-    if (!(i < j)) {
-      return i;
-    }
-
-    SWAP(int, prim_indices[i], prim_indices[j]);
-    i++;
-  }
-}
-
 /* Returns the index of the first element on the right of the partition */
 static int partition_indices_material(PBVH *pbvh, int lo, int hi)
 {
@@ -250,56 +230,72 @@ void pbvh_grow_nodes(PBVH *pbvh, int totnode)
   pbvh->totnode = totnode;
 }
 
-/* Add a vertex to the map, with a positive value for unique vertices and
- * a negative value for additional vertices */
-static int map_insert_vert(
-    PBVH *pbvh, GHash *map, unsigned int *face_verts, unsigned int *uniq_verts, int vertex)
+static int compare_int(const void *a, const void *b)
 {
-  void *key, **value_p;
+  const int i1 = *(const int *)a, i2 = *(const int *)b;
+  return (i1 > i2) - (i1 < i2);
+}
 
-  key = POINTER_FROM_INT(vertex);
-  if (!BLI_ghash_ensure_p(map, key, &value_p)) {
-    int value_i;
-    if (BLI_BITMAP_TEST(pbvh->vert_bitmap, vertex) == 0) {
-      BLI_BITMAP_ENABLE(pbvh->vert_bitmap, vertex);
-      value_i = *uniq_verts;
-      (*uniq_verts)++;
+/* Index of `value` in the sorted array, which must contain it. */
+static int sorted_array_find_int(const int *array, int len, const int value)
+{
+  int lo = 0;
+  while (len > 1) {
+    const int half = len / 2;
+    if (array[lo + half] <= value) {
+      lo += half;
     }
-    else {
-      value_i = ~(*face_verts);
-      (*face_verts)++;
+    len -= half;
+  }
+  BLI_assert(array[lo] == value);
+  return lo;
+}
+
+/* Lower `*p` to `value` when it's smaller. */
+static void atomic_min_int32(int32_t *p, const int32_t value)
+{
+  int32_t prev = *p;
+  while (value < prev) {
+    const int32_t orig = atomic_cas_int32(p, prev, value);
+    if (orig == prev) {
+      break;
     }
-    *value_p = POINTER_FROM_INT(value_i);
-    return value_i;
+    prev = orig;
   }
+}
 
-  return POINTER_AS_INT(*value_p);
+/* Claim the vertices of a leaf node, the leaf with the lowest index
+ * in the nodes array owns a vertex shared by several leaves. */
+static void build_mesh_leaf_vert_owner(PBVH *pbvh, const int node_index)
+{
+  const PBVHNode *node = &pbvh->nodes[node_index];
+  for (int i = 0; i < node->totprim; i++) {
+    const MLoopTri *lt = &pbvh->looptri[node->prim_indices[i]];
+    for (int j = 0; j < 3; j++) {
+      atomic_min_int32(&pbvh->vert_owner[pbvh->mloop[lt->tri[j]].v], node_index);
+    }
+  }
 }
 
-/* Find vertices used by the faces in this node and update the draw buffers */
-static void build_mesh_leaf_node(PBVH *pbvh, PBVHNode *node)
+/* Find vertices used by the faces in this node and update the draw buffers,
+ * vertices owned by the node are unique, see #build_mesh_leaf_vert_owner. */
+static void build_mesh_leaf_node(PBVH *pbvh, const int node_index)
 {
+  PBVHNode *node = &pbvh->nodes[node_index];
   bool has_visible = false;
 
-  node->uniq_verts = node->face_verts = 0;
   const int totface = node->totprim;
 
-  /* reserve size is rough guess */
-  GHash *map = BLI_ghash_int_new_ex("build_mesh_leaf_node gh", 2 * totface);
-
-  int(*face_vert_indices)[3] = MEM_mallocN(sizeof(int[3]) * totface, "bvh node face vert indices");
-
-  node->face_vert_indices = (const int(*)[3])face_vert_indices;
-
   if (pbvh->respect_hide == false) {
     has_visible = true;
   }
 
+  /* Sorted array of the vertices used by the faces, without duplicates. */
+  int *verts = MEM_mallocN(sizeof(int) * totface * 3, "bvh node verts");
   for (int i = 0; i < totface; i++) {
     const MLoopTri *lt = &pbvh->looptri[node->prim_indices[i]];
     for (int j = 0; j < 3; j++) {
-      face_vert_indices[i][j] = map_insert_vert(
-          pbvh, map, &node->face_verts, &node->uniq_verts, pbvh->mloop[lt->tri[j]].v);
+      verts[i * 3 + j] = pbvh->mloop[lt->tri[j]].v;
     }
 
     if (has_visible == false) {
@@ -308,39 +304,49 @@ static void build_mesh_leaf_node(PBVH *pbvh, PBVHNode *node)
       }
     }
   }
+  qsort(verts, totface * 3, sizeof(int), compare_int);
+  int verts_len = 0;
+  for (int i = 0; i < totface * 3; i++) {
+    if (verts_len == 0 || verts[verts_len - 1] != verts[i]) {
+      verts[verts_len++] = verts[i];
+    }
+  }
 
-  int *vert_indices = MEM_callocN(sizeof(int) * (node->uniq_verts + node->face_verts),
-                                  "bvh node vert indices");
-  node->vert_indices = vert_indices;
-
-  /* Build the vertex list, unique verts first */
-  GHashIterator gh_iter;
-  GHASH_ITER (gh_iter, map) {
-    void *value = BLI_ghashIterator_getValue(&gh_iter);
-    int ndx = POINTER_AS_INT(value);
-
-    if (ndx < 0) {
-      ndx = -ndx + node->uniq_verts - 1;
+  node->uniq_verts = 0;
+  for (int i = 0; i < verts_len; i++) {
+    if (pbvh->vert_owner[verts[i]] == node_index) {
+      node->uniq_verts++;
     }
+  }
+  node->face_verts = verts_len - node->uniq_verts;
 
-    vert_indices[ndx] = POINTER_AS_INT(BLI_ghashIterator_getKey(&gh_iter));
+  /* Build the vertex list, unique verts first */
+  int *vert_indices = MEM_mallocN(sizeof(int) * verts_len, "bvh node vert indices");
+  int *verts_local = MEM_mallocN(sizeof(int) * verts_len, "bvh node verts local");
+  int uniq_index = 0, face_index = node->uniq_verts;
+  for (int i = 0; i < verts_len; i++) {
+    int *index = (pbvh->vert_owner[verts[i]] == node_index) ? &uniq_index : &face_index;
+    verts_local[i] = *index;
+    vert_indices[(*index)++] = verts[i];
   }
+  node->vert_indices = vert_indices;
 
+  int(*face_vert_indices)[3] = MEM_mallocN(sizeof(int[3]) * totface, "bvh node face vert indices");
   for (int i = 0; i < totface; i++) {
-    const int sides = 3;
-
-    for (int j = 0; j < sides; j++) {
-      if (face_vert_indices[i][j] < 0) {
-        face_vert_indices[i][j] = -face_vert_indices[i][j] + node->uniq_verts - 1;
-      }
+    const MLoopTri *lt = &pbvh->looptri[node->prim_indices[i]];
+    for (int j = 0; j < 3; j++) {
+      const int vert = pbvh->mloop[lt->tri[j]].v;
+      face_vert_indices[i][j] = verts_local[sorted_array_find_int(verts, verts_len, vert)];
     }
   }
+  node->face_vert_indices = (const int(*)[3])face_vert_indices;
+
+  MEM_freeN(verts_local);
+  MEM_freeN(verts);
 
   BKE_pbvh_node_mark_rebuild_draw(node);
 
   BKE_pbvh_node_fully_hidden_set(node, !has_visible);
-
-  BLI_ghash_free(map, NULL, NULL);
 }
 
 static void update_vb(PBVH *pbvh, PBVHNode *node, BBC *prim_bbc, int offset, int count)
@@ -413,21 +419,19 @@ static void build_grid_leaf_node(PBVH *pbvh, PBVHNode *node)
   BKE_pbvh_node_mark_rebuild_draw(node);
 }
 
-static void build_leaf(PBVH *pbvh, int node_index, BBC *prim_bbc, int offset, int count)
+static void build_leaf(PBVH *pbvh, int node_index, BBC *prim_bbc)
 {
-  pbvh->nodes[node_index].flag |= PBVH_Leaf;
-
-  pbvh->nodes[node_index].prim_indices = pbvh->prim_indices + offset;
-  pbvh->nodes[node_index].totprim = count;
+  PBVHNode *node = &pbvh->nodes[node_index];
+  const int offset = (int)(node->prim_indices - pbvh->prim_indices);
 
   /* Still need vb for searches */
-  update_vb(pbvh, &pbvh->nodes[node_index], prim_bbc, offset, count);
+  update_vb(pbvh, node, prim_bbc, offset, node->totprim);
 
   if (pbvh->looptri) {
-    build_mesh_leaf_node(pbvh, pbvh->nodes + node_index);
+    build_mesh_leaf_node(pbvh, node_index);
   }
   else {
-    build_grid_leaf_node(pbvh, pbvh->nodes + node_index);
+    build_grid_leaf_node(pbvh, node);
   }
 }
 
@@ -465,19 +469,195 @@ static bool leaf_needs_material_split(PBVH *pbvh, int offset, int count)
   return false;
 }
 
+/* Number of bins for the surface area heuristic. */
+#define SAH_BINS 16
+/* Build nodes with fewer primitives on the current thread. */
+#define BUILD_TASK_PRIMS_MIN 4096
+/* Use threads to bin the primitives of nodes with more primitives. */
+#define BUILD_BIN_PARALLEL_PRIMS_MIN 100000
+
+/* Temporary tree of primitive ranges, which is built in parallel
+ * and then stored in #PBVH.nodes in depth first order, see #build_flatten. */
+typedef struct PBVHBuildNode {
+  int offset, count;
+  bool is_leaf;
+  /* Pair of children for inner nodes. */
+  struct PBVHBuildNode *children;
+} PBVHBuildNode;
+
+typedef struct PBVHBuildData {
+  PBVH *pbvh;
+  BBC *prim_bbc;
+} PBVHBuildData;
+
+typedef struct SAHBin {
+  BB bb;
+  int count;
+} SAHBin;
+
+typedef struct SAHBinData {
+  const PBVH *pbvh;
+  const BBC *prim_bbc;
+  int offset;
+  int axis;
+  float min, scale;
+} SAHBinData;
+
+static float BB_half_area(const BB *bb)
+{
+  float dim[3];
+  sub_v3_v3v3(dim, bb->bmax, bb->bmin);
+  return dim[0] * dim[1] + dim[1] * dim[2] + dim[2] * dim[0];
+}
+
+BLI_INLINE int sah_bin_index(const SAHBinData *data, const BBC *bbc)
+{
+  const int bin = (int)((bbc->bcentroid[data->axis] - data->min) * data->scale);
+  return clamp_i(bin, 0, SAH_BINS - 1);
+}
+
+static void sah_bins_reset(SAHBin *bins)
+{
+  for (int i = 0; i < SAH_BINS; i++) {
+    BB_reset(&bins[i].bb);
+    bins[i].count = 0;
+  }
+}
+
+static void sah_bin_task_cb(void *__restrict userdata,
+                            const int i,
+                            const TaskParallelTLS *__restrict tls)
+{
+  const SAHBinData *data = userdata;
+  SAHBin *bins = tls->userdata_chunk;
+  const BBC *bbc = &data->prim_bbc[data->pbvh->prim_indices[data->offset + i]];
+  SAHBin *bin = &bins[sah_bin_index(data, bbc)];
+  BB_expand_with_bb(&bin->bb, (BB *)bbc);
+  bin->count++;
+}
+
+static void sah_bin_reduce(const void *__restrict UNUSED(userdata),
+                           void *__restrict chunk_join,
+                           void *__restrict chunk)
+{
+  SAHBin *bins_join = chunk_join;
+  SAHBin *bins = chunk;
+  for (int i = 0; i < SAH_BINS; i++) {
+    BB_expand_with_bb(&bins_join[i].bb, &bins[i].bb);
+    bins_join[i].count += bins[i].count;
+  }
+}
+
+/* Adapted from BLI_kdopbvh.c */
+/* Returns the index of the first element on the right of the partition,
+ * the elements in bins before `split_bin` are moved to the left. */
+static int partition_indices_sah(
+    int *prim_indices, int lo, int hi, const SAHBinData *data, const int split_bin)
+{
+  int i = lo, j = hi;
+  for (;;) {
+    for (; i <= hi && sah_bin_index(data, &data->prim_bbc[prim_indices[i]]) < split_bin; i++) {
+      /* pass */
+    }
+    for (; j >= lo && sah_bin_index(data, &data->prim_bbc[prim_indices[j]]) >= split_bin; j--) {
+      /* pass */
+    }
+
+    if (!(i < j)) {
+      return i;
+    }
+
+    SWAP(int, prim_indices[i], prim_indices[j]);
+    i++;
+    j--;
+  }
+}
+
+/* Split the primitives with a binned surface area heuristic along the axis with the
+ * widest range of primitive centroids, returns the first index on the right side. */
+static int partition_sah(PBVH *pbvh, BB *cb, BBC *prim_bbc, int offset, int count)
+{
+  const int axis = BB_widest_axis(cb);
+  const float range = cb->bmax[axis] - cb->bmin[axis];
+  if (!(range > FLT_EPSILON)) {
+    /* All centroids in the same place, any split works. */
+    return offset + count / 2;
+  }
+
+  SAHBinData data = {
+      .pbvh = pbvh,
+      .prim_bbc = prim_bbc,
+      .offset = offset,
+      .axis = axis,
+      .min = cb->bmin[axis],
+      .scale = SAH_BINS / range,
+  };
+  SAHBin bins[SAH_BINS];
+  sah_bins_reset(bins);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = count > BUILD_BIN_PARALLEL_PRIMS_MIN;
+  settings.min_iter_per_thread = BUILD_BIN_PARALLEL_PRIMS_MIN / 4;
+  settings.userdata_chunk = bins;
+  settings.userdata_chunk_size = sizeof(bins);
+  settings.func_reduce = sah_bin_reduce;
+  BLI_task_parallel_range(0, count, &data, sah_bin_task_cb, &settings);
+
+  /* Cost of the left side for every split, sweeping from the left. */
+  float cost_left[SAH_BINS];
+  BB bb;
+  BB_reset(&bb);
+  int count_left = 0;
+  for (int i = 0; i < SAH_BINS - 1; i++) {
+    BB_expand_with_bb(&bb, &bins[i].bb);
+    count_left += bins[i].count;
+    cost_left[i + 1] = count_left ? count_left * BB_half_area(&bb) : FLT_MAX;
+  }
+
+  int split_bin = -1;
+  float cost_best = FLT_MAX;
+  BB_reset(&bb);
+  int count_right = 0;
+  for (int i = SAH_BINS - 1; i > 0; i--) {
+    BB_expand_with_bb(&bb, &bins[i].bb);
+    count_right += bins[i].count;
+    if (count_right == 0 || count_right == count) {
+      continue;
+    }
+    const float cost = cost_left[i] + count_right * BB_half_area(&bb);
+    if (cost <= cost_best) {
+      cost_best = cost;
+      split_bin = i;
+    }
+  }
+
+  if (split_bin == -1) {
+    return offset + count / 2;
+  }
+  return partition_indices_sah(pbvh->prim_indices, offset, offset + count - 1, &data, split_bin);
+}
+
+static void build_sub(TaskPool *pool, PBVHBuildData *data, PBVHBuildNode *node, BB *cb);
+
+static void build_sub_task_cb(TaskPool *__restrict pool, void *taskdata)
+{
+  build_sub(pool, BLI_task_pool_user_data(pool), taskdata, NULL);
+}
+
 /* Recursively build a node in the tree
- *
- * vb is the voxel box around all of the primitives contained in
- * this node.
  *
  * cb is the bounding box around all the centroids of the primitives
  * contained in this node
  *
- * offset and start indicate a range in the array of primitive indices
+ * The node's offset and count indicate a range in the array of primitive indices,
+ * large child nodes are built by other tasks of the pool.
  */
-
-static void build_sub(PBVH *pbvh, int node_index, BB *cb, BBC *prim_bbc, int offset, int count)
+static void build_sub(TaskPool *pool, PBVHBuildData *data, PBVHBuildNode *node, BB *cb)
 {
+  PBVH *pbvh = data->pbvh;
+  BBC *prim_bbc = data->prim_bbc;
+  const int offset = node->offset, count = node->count;
   int end;
   BB cb_backing;
 
@@ -485,20 +665,12 @@ static void build_sub(PBVH *pbvh, int node_index, BB *cb, BBC *prim_bbc, int off
   const bool below_leaf_limit = count <= pbvh->leaf_limit;
   if (below_leaf_limit) {
     if (!leaf_needs_material_split(pbvh, offset, count)) {
-      build_leaf(pbvh, node_index, prim_bbc, offset, count);
+      node->is_leaf = true;
       return;
     }
   }
 
-  /* Add two child nodes */
-  pbvh->nodes[node_index].children_offset = pbvh->totnode;
-  pbvh_grow_nodes(pbvh, pbvh->totnode + 2);
-
-  /* Update parent node bounding box */
-  update_vb(pbvh, &pbvh->nodes[node_index], prim_bbc, offset, count);
-
   if (!below_leaf_limit) {
-    /* Find axis with widest range of primitive centroids */
     if (!cb) {
       cb = &cb_backing;
       BB_reset(cb);
@@ -506,15 +678,9 @@ static void build_sub(PBVH *pbvh, int node_index, BB *cb, BBC *prim_bbc, int off
         BB_expand(cb, prim_bbc[pbvh->prim_indices[i]].bcentroid);
       }
     }
-    const int axis = BB_widest_axis(cb);
 
-    /* Partition primitives along that axis */
-    end = partition_indices(pbvh->prim_indices,
-                            offset,
-                            offset + count - 1,
-                            axis,
-                            (cb->bmax[axis] + cb->bmin[axis]) * 0.5f,
-                            prim_bbc);
+    /* Partition primitives along the widest axis */
+    end = partition_sah(pbvh, cb, prim_bbc, offset, count);
   }
   else {
     /* Partition primitives by material */
@@ -522,13 +688,63 @@ static void build_sub(PBVH *pbvh, int node_index, BB *cb, BBC *prim_bbc, int off
   }
 
   /* Build children */
-  build_sub(pbvh, pbvh->nodes[node_index].children_offset, NULL, prim_bbc, offset, end - offset);
-  build_sub(pbvh,
-            pbvh->nodes[node_index].children_offset + 1,
-            NULL,
-            prim_bbc,
-            end,
-            offset + count - end);
+  node->children = MEM_callocN(sizeof(PBVHBuildNode[2]), "PBVHBuildNode");
+  node->children[0].offset = offset;
+  node->children[0].count = end - offset;
+  node->children[1].offset = end;
+  node->children[1].count = offset + count - end;
+
+  if (pool && node->children[0].count > BUILD_TASK_PRIMS_MIN) {
+    BLI_task_pool_push(pool, build_sub_task_cb, &node->children[0], false, NULL);
+  }
+  else {
+    build_sub(pool, data, &node->children[0], NULL);
+  }
+  build_sub(pool, data, &node->children[1], NULL);
+}
+
+/* Store the temporary tree in the nodes array in the same order as a serial recursive build,
+ * the children of a node are added when the node is visited. */
+static void build_flatten(PBVH *pbvh, PBVHBuildNode *build_node, int node_index)
+{
+  if (build_node->is_leaf) {
+    PBVHNode *node = &pbvh->nodes[node_index];
+    node->flag |= PBVH_Leaf;
+    node->prim_indices = pbvh->prim_indices + build_node->offset;
+    node->totprim = build_node->count;
+    return;
+  }
+
+  const int children_offset = pbvh->totnode;
+  pbvh->nodes[node_index].flag &= ~PBVH_Leaf;
+  pbvh->nodes[node_index].children_offset = children_offset;
+  pbvh_grow_nodes(pbvh, pbvh->totnode + 2);
+
+  build_flatten(pbvh, &build_node->children[0], children_offset);
+  build_flatten(pbvh, &build_node->children[1], children_offset + 1);
+  MEM_freeN(build_node->children);
+}
+
+typedef struct PBVHBuildLeavesData {
+  PBVH *pbvh;
+  BBC *prim_bbc;
+  const int *leaves;
+} PBVHBuildLeavesData;
+
+static void build_leaf_vert_owner_task_cb(void *__restrict userdata,
+                                          const int i,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PBVHBuildLeavesData *data = userdata;
+  build_mesh_leaf_vert_owner(data->pbvh, data->leaves[i]);
+}
+
+static void build_leaf_task_cb(void *__restrict userdata,
+                               const int i,
+                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PBVHBuildLeavesData *data = userdata;
+  build_leaf(data->pbvh, data->leaves[i], data->prim_bbc);
 }
 
 static void pbvh_build(PBVH *pbvh, BB *cb, BBC *prim_bbc, int totprim)
@@ -552,8 +768,154 @@ static void pbvh_build(PBVH *pbvh, BB *cb, BBC *prim_bbc, int totprim)
     }
   }
 
+  /* Partition the primitives in parallel. */
+  PBVHBuildData data = {
+      .pbvh = pbvh,
+      .prim_bbc = prim_bbc,
+  };
+  PBVHBuildNode root = {
+      .offset = 0,
+      .count = totprim,
+  };
+  TaskPool *pool = BLI_task_pool_create(&data, TASK_PRIORITY_HIGH);
+  build_sub(pool, &data, &root, cb);
+  BLI_task_pool_work_and_wait(pool);
+  BLI_task_pool_free(pool);
+
   pbvh->totnode = 1;
-  build_sub(pbvh, 0, cb, prim_bbc, 0, totprim);
+  build_flatten(pbvh, &root, 0);
+
+  int *leaves = MEM_mallocN(sizeof(int) * pbvh->totnode, __func__);
+  int leaves_num = 0;
+  for (int i = 0; i < pbvh->totnode; i++) {
+    if (pbvh->nodes[i].flag & PBVH_Leaf) {
+      leaves[leaves_num++] = i;
+    }
+  }
+
+  PBVHBuildLeavesData leaves_data = {
+      .pbvh = pbvh,
+      .prim_bbc = prim_bbc,
+      .leaves = leaves,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  if (pbvh->looptri) {
+    BLI_task_parallel_range(0, leaves_num, &leaves_data, build_leaf_vert_owner_task_cb, &settings);
+  }
+  BLI_task_parallel_range(0, leaves_num, &leaves_data, build_leaf_task_cb, &settings);
+  MEM_freeN(leaves);
+
+  /* Children are stored after their parent, so inner nodes can be updated in reverse order. */
+  for (int i = pbvh->totnode - 1; i >= 0; i--) {
+    PBVHNode *node = &pbvh->nodes[i];
+    if (!(node->flag & PBVH_Leaf)) {
+      update_node_vb(pbvh, node);
+      node->orig_vb = node->vb;
+    }
+  }
+}
+
+typedef struct PBVHPrimBBCData {
+  const PBVH *pbvh;
+  BBC *prim_bbc;
+} PBVHPrimBBCData;
+
+static void pbvh_prim_bbc_task_cb(void *__restrict userdata,
+                                  const int i,
+                                  const TaskParallelTLS *__restrict tls)
+{
+  const PBVHPrimBBCData *data = userdata;
+  const PBVH *pbvh = data->pbvh;
+  BBC *bbc = data->prim_bbc + i;
+
+  BB_reset((BB *)bbc);
+
+  if (pbvh->looptri) {
+    const MLoopTri *lt = &pbvh->looptri[i];
+    for (int j = 0; j < 3; j++) {
+      BB_expand((BB *)bbc, pbvh->verts[pbvh->mloop[lt->tri[j]].v].co);
+    }
+  }
+  else {
+    const CCGKey *key = &pbvh->gridkey;
+    CCGElem *grid = pbvh->grids[i];
+    for (int j = 0; j < key->grid_area; j++) {
+      BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
+    }
+  }
+
+  BBC_update_centroid(bbc);
+
+  BB_expand(tls->userdata_chunk, bbc->bcentroid);
+}
+
+static void pbvh_prim_bbc_reduce(const void *__restrict UNUSED(userdata),
+                                 void *__restrict chunk_join,
+                                 void *__restrict chunk)
+{
+  BB_expand_with_bb(chunk_join, chunk);
+}
+
+/* Calculate the bounds and centroid of every primitive in parallel,
+ * `r_cb` is the bounding box around all centroids. */
+static void pbvh_prim_bbc_calc(const PBVH *pbvh, BBC *prim_bbc, const int totprim, BB *r_cb)
+{
+  PBVHPrimBBCData data = {
+      .pbvh = pbvh,
+      .prim_bbc = prim_bbc,
+  };
+  BB_reset(r_cb);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  settings.userdata_chunk = r_cb;
+  settings.userdata_chunk_size = sizeof(*r_cb);
+  settings.func_reduce = pbvh_prim_bbc_reduce;
+  BLI_task_parallel_range(0, totprim, &data, pbvh_prim_bbc_task_cb, &settings);
+}
+
+/* Hash of the mesh data the node layout depends on: connectivity, and the material and shading
+ * the leaves are split by. Coordinates are not included, moving vertices only needs a refit. */
+static uint pbvh_mesh_topology_hash(const Mesh *mesh)
+{
+  uint hash = BLI_hash_int_3d((uint)mesh->totvert, (uint)mesh->totpoly, (uint)mesh->totloop);
+
+  for (int i = 0; i < mesh->totpoly; i++) {
+    const MPoly *mp = &mesh->mpoly[i];
+    hash = BLI_hash_int_3d(hash, (uint)mp->loopstart, (uint)mp->totloop);
+    hash = BLI_hash_int_3d(hash, (uint)mp->mat_nr, (uint)(mp->flag & ME_SMOOTH));
+  }
+  for (int i = 0; i < mesh->totloop; i++) {
+    hash = BLI_hash_int_2d(hash, mesh->mloop[i].v);
+  }
+
+  return hash;
+}
+
+/* Hash of the hidden state the mesh draw buffers and fully hidden leaves depend on. */
+static uint pbvh_mesh_visibility_hash(const PBVH *pbvh, const Mesh *mesh)
+{
+  uint hash = (uint)pbvh->respect_hide;
+
+  for (int i = 0; i < mesh->totvert; i++) {
+    if (mesh->mvert[i].flag & ME_HIDE) {
+      hash = BLI_hash_int_2d(hash, (uint)i);
+    }
+  }
+
+  const int *face_sets = CustomData_get_layer(&mesh->pdata, CD_SCULPT_FACE_SETS);
+  if (face_sets) {
+    for (int i = 0; i < mesh->totpoly; i++) {
+      if (face_sets[i] <= SCULPT_FACE_SET_NONE) {
+        hash = BLI_hash_int_2d(hash, (uint)(mesh->totvert + i));
+      }
+    }
+  }
+
+  return hash;
 }
 
 /**
@@ -583,7 +945,8 @@ void BKE_pbvh_build_mesh(PBVH *pbvh,
   pbvh->mloop = mloop;
   pbvh->looptri = looptri;
   pbvh->verts = verts;
-  pbvh->vert_bitmap = BLI_BITMAP_NEW(totvert, "bvh->vert_bitmap");
+  pbvh->vert_owner = MEM_mallocN(sizeof(int) * totvert, "bvh->vert_owner");
+  copy_vn_i(pbvh->vert_owner, totvert, INT_MAX);
   pbvh->totvert = totvert;
   pbvh->leaf_limit = LEAF_LIMIT;
   pbvh->vdata = vdata;
@@ -593,33 +956,19 @@ void BKE_pbvh_build_mesh(PBVH *pbvh,
   pbvh->face_sets_color_seed = mesh->face_sets_color_seed;
   pbvh->face_sets_color_default = mesh->face_sets_color_default;
 
-  BB_reset(&cb);
+  pbvh->topology_hash = pbvh_mesh_topology_hash(mesh);
+  pbvh->visibility_hash = pbvh_mesh_visibility_hash(pbvh, mesh);
 
   /* For each face, store the AABB and the AABB centroid */
   prim_bbc = MEM_mallocN(sizeof(BBC) * looptri_num, "prim_bbc");
-
-  for (int i = 0; i < looptri_num; i++) {
-    const MLoopTri *lt = &looptri[i];
-    const int sides = 3;
-    BBC *bbc = prim_bbc + i;
-
-    BB_reset((BB *)bbc);
-
-    for (int j = 0; j < sides; j++) {
-      BB_expand((BB *)bbc, verts[pbvh->mloop[lt->tri[j]].v].co);
-    }
-
-    BBC_update_centroid(bbc);
-
-    BB_expand(&cb, bbc->bcentroid);
-  }
+  pbvh_prim_bbc_calc(pbvh, prim_bbc, looptri_num, &cb);
 
   if (looptri_num) {
     pbvh_build(pbvh, &cb, prim_bbc, looptri_num);
   }
 
   MEM_freeN(prim_bbc);
-  MEM_freeN(pbvh->vert_bitmap);
+  MEM_SAFE_FREE(pbvh->vert_owner);
 }
 
 /* Do a full rebuild with on Grids data structure */
@@ -642,32 +991,111 @@ void BKE_pbvh_build_grids(PBVH *pbvh,
   pbvh->grid_hidden = grid_hidden;
   pbvh->leaf_limit = max_ii(LEAF_LIMIT / (gridsize * gridsize), 1);
 
-  BB cb;
-  BB_reset(&cb);
-
   /* For each grid, store the AABB and the AABB centroid */
+  BB cb;
   BBC *prim_bbc = MEM_mallocN(sizeof(BBC) * totgrid, "prim_bbc");
+  pbvh_prim_bbc_calc(pbvh, prim_bbc, totgrid, &cb);
 
-  for (int i = 0; i < totgrid; i++) {
-    CCGElem *grid = grids[i];
-    BBC *bbc = prim_bbc + i;
+  if (totgrid) {
+    pbvh_build(pbvh, &cb, prim_bbc, totgrid);
+  }
 
-    BB_reset((BB *)bbc);
+  MEM_freeN(prim_bbc);
+}
 
-    for (int j = 0; j < gridsize * gridsize; j++) {
-      BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
+static void pbvh_refit_leaf_task_cb(void *__restrict userdata,
+                                    const int n,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PBVH *pbvh = userdata;
+  PBVHNode *node = &pbvh->nodes[n];
+
+  if (node->flag & PBVH_Leaf) {
+    update_node_vb(pbvh, node);
+    node->orig_vb = node->vb;
+    node->flag |= PBVH_UpdateNormals | PBVH_UpdateDrawBuffers | PBVH_UpdateRedraw;
+    node->flag &= ~(PBVH_UpdateBB | PBVH_UpdateOriginalBB);
+  }
+}
+
+/**
+ * Recompute the bounds of all nodes from the current vertex positions, leaves in parallel and
+ * then the inner nodes bottom-up. The node layout and draw buffers are kept, so this is only
+ * valid when the topology of the data the tree was built from did not change.
+ */
+void BKE_pbvh_refit(PBVH *pbvh)
+{
+  TaskParallelSettings settings;
+  BKE_pbvh_parallel_range_settings(&settings, true, pbvh->totnode);
+  BLI_task_parallel_range(0, pbvh->totnode, pbvh, pbvh_refit_leaf_task_cb, &settings);
+
+  /* Children are stored after their parent, so inner nodes can be updated in reverse order. */
+  for (int i = pbvh->totnode - 1; i >= 0; i--) {
+    PBVHNode *node = &pbvh->nodes[i];
+    if (!(node->flag & PBVH_Leaf)) {
+      update_node_vb(pbvh, node);
+      node->orig_vb = node->vb;
+      node->flag &= ~(PBVH_UpdateBB | PBVH_UpdateOriginalBB);
     }
+  }
+}
 
-    BBC_update_centroid(bbc);
+/* Whether a mesh PBVH can be refit to `mesh` instead of being rebuilt. */
+bool BKE_pbvh_mesh_topology_matches(const PBVH *pbvh, const Mesh *mesh)
+{
+  if (pbvh->type != PBVH_FACES || pbvh->totvert != mesh->totvert ||
+      pbvh->totprim != poly_to_tri_count(mesh->totpoly, mesh->totloop)) {
+    return false;
+  }
+  return pbvh->topology_hash == pbvh_mesh_topology_hash(mesh);
+}
 
-    BB_expand(&cb, bbc->bcentroid);
+/**
+ * Update a mesh PBVH for new data of `mesh` with the same topology, which may have been
+ * reallocated, see #BKE_pbvh_mesh_topology_matches. Deformed coordinates are reset to the
+ * mesh coordinates and need to be applied again.
+ */
+void BKE_pbvh_refit_mesh(PBVH *pbvh, Mesh *mesh)
+{
+  BLI_assert(BKE_pbvh_mesh_topology_matches(pbvh, mesh));
+
+  /* Draw buffers store the loops and are sized by the visible triangles. */
+  const uint visibility_hash = pbvh_mesh_visibility_hash(pbvh, mesh);
+  const bool rebuild_draw = (pbvh->mloop != mesh->mloop);
+  const bool update_visibility = (pbvh->visibility_hash != visibility_hash);
+
+  if (pbvh->deformed) {
+    MEM_freeN(pbvh->verts);
+    pbvh->deformed = false;
   }
 
-  if (totgrid) {
-    pbvh_build(pbvh, &cb, prim_bbc, totgrid);
+  pbvh->mesh = mesh;
+  pbvh->mpoly = mesh->mpoly;
+  pbvh->mloop = mesh->mloop;
+  pbvh->verts = mesh->mvert;
+  pbvh->vdata = &mesh->vdata;
+  pbvh->ldata = &mesh->ldata;
+  pbvh->pdata = &mesh->pdata;
+  pbvh->face_sets_color_seed = mesh->face_sets_color_seed;
+  pbvh->face_sets_color_default = mesh->face_sets_color_default;
+  pbvh->visibility_hash = visibility_hash;
+
+  for (int i = 0; i < pbvh->totnode; i++) {
+    PBVHNode *node = &pbvh->nodes[i];
+    if (!(node->flag & PBVH_Leaf)) {
+      continue;
+    }
+    BKE_pbvh_node_mark_update_mask(node);
+    BKE_pbvh_node_mark_update_color(node);
+    if (update_visibility) {
+      BKE_pbvh_node_mark_update_visibility(node);
+    }
+    else if (rebuild_draw) {
+      BKE_pbvh_node_mark_rebuild_draw(node);
+    }
   }
 
-  MEM_freeN(prim_bbc);
+  BKE_pbvh_refit(pbvh);
 }
 
 PBVH *BKE_pbvh_new(void)
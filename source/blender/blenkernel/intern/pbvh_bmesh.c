@@ -25,6 +25,7 @@
 #include "BLI_heap_simple.h"
 #include "BLI_math.h"
 #include "BLI_memarena.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_DerivedMesh.h"
@@ -753,8 +754,16 @@ typedef struct {
   int cd_vert_mask_offset;
   int cd_vert_node_offset;
   int cd_face_node_offset;
+  /* When set, edges are collected here instead of being inserted into the queue,
+   * see #edge_queue_create_from_nodes. */
+  BLI_Buffer *candidates;
 } EdgeQueueContext;
 
+typedef struct EdgeQueueCandidate {
+  BMEdge *e;
+  float priority;
+} EdgeQueueCandidate;
+
 /* only tag'd edges are in the queue */
 #ifdef USE_EDGEQUEUE_TAG
 #  define EDGE_QUEUE_TEST(e) (BM_elem_flag_test((CHECK_TYPE_INLINE(e, BMEdge *), e), BM_ELEM_TAG))
@@ -833,6 +842,18 @@ static bool check_mask(EdgeQueueContext *eq_ctx, BMVert *v)
   return BM_ELEM_CD_GET_FLOAT(v, eq_ctx->cd_vert_mask_offset) < 1.0f;
 }
 
+static void edge_queue_heap_insert(EdgeQueueContext *eq_ctx, BMEdge *e, float priority)
+{
+  BMVert **pair = BLI_mempool_alloc(eq_ctx->pool);
+  pair[0] = e->v1;
+  pair[1] = e->v2;
+  BLI_heapsimple_insert(eq_ctx->q->heap, priority, pair);
+#ifdef USE_EDGEQUEUE_TAG
+  BLI_assert(EDGE_QUEUE_TEST(e) == false);
+  EDGE_QUEUE_ENABLE(e);
+#endif
+}
+
 static void edge_queue_insert(EdgeQueueContext *eq_ctx, BMEdge *e, float priority)
 {
   /* Don't let topology update affect fully masked vertices. This used to
@@ -845,14 +866,13 @@ static void edge_queue_insert(EdgeQueueContext *eq_ctx, BMEdge *e, float priorit
        (check_mask(eq_ctx, e->v1) || check_mask(eq_ctx, e->v2))) &&
       !(BM_elem_flag_test_bool(e->v1, BM_ELEM_HIDDEN) ||
         BM_elem_flag_test_bool(e->v2, BM_ELEM_HIDDEN))) {
-    BMVert **pair = BLI_mempool_alloc(eq_ctx->pool);
-    pair[0] = e->v1;
-    pair[1] = e->v2;
-    BLI_heapsimple_insert(eq_ctx->q->heap, priority, pair);
-#ifdef USE_EDGEQUEUE_TAG
-    BLI_assert(EDGE_QUEUE_TEST(e) == false);
-    EDGE_QUEUE_ENABLE(e);
-#endif
+    if (eq_ctx->candidates) {
+      EdgeQueueCandidate candidate = {e, priority};
+      BLI_buffer_append(eq_ctx->candidates, EdgeQueueCandidate, candidate);
+    }
+    else {
+      edge_queue_heap_insert(eq_ctx, e, priority);
+    }
   }
 }
 
@@ -990,6 +1010,87 @@ static void short_edge_queue_face_add(EdgeQueueContext *eq_ctx, BMFace *f)
   }
 }
 
+typedef struct EdgeQueueCreateData {
+  const EdgeQueueContext *eq_ctx;
+  PBVH *pbvh;
+  const int *nodes;
+  BLI_Buffer *candidates;
+  void (*face_add)(EdgeQueueContext *eq_ctx, BMFace *f);
+} EdgeQueueCreateData;
+
+static void edge_queue_create_task_cb(void *__restrict userdata,
+                                      const int n,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  EdgeQueueCreateData *data = userdata;
+  PBVHNode *node = &data->pbvh->nodes[data->nodes[n]];
+
+  /* Edges are only read here, the queue tags are all cleared. */
+  EdgeQueueContext eq_ctx = *data->eq_ctx;
+  eq_ctx.candidates = &data->candidates[n];
+
+  GSetIterator gs_iter;
+  GSET_ITER (gs_iter, node->bm_faces) {
+    BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
+
+    data->face_add(&eq_ctx, f);
+  }
+}
+
+/* Check the faces of all leaf nodes marked for topology update. The nodes are checked in
+ * parallel, then their edges are inserted in node order, giving the same queue as adding
+ * the faces one by one. */
+static void edge_queue_create_from_nodes(EdgeQueueContext *eq_ctx,
+                                         PBVH *pbvh,
+                                         void (*face_add)(EdgeQueueContext *eq_ctx, BMFace *f))
+{
+  int *nodes = MEM_mallocN(sizeof(*nodes) * pbvh->totnode, __func__);
+  int totnode = 0;
+
+  for (int n = 0; n < pbvh->totnode; n++) {
+    PBVHNode *node = &pbvh->nodes[n];
+
+    /* Check leaf nodes marked for topology update */
+    if ((node->flag & PBVH_Leaf) && (node->flag & PBVH_UpdateTopology) &&
+        !(node->flag & PBVH_FullyHidden)) {
+      nodes[totnode++] = n;
+    }
+  }
+
+  BLI_Buffer *candidates = MEM_mallocN(sizeof(*candidates) * totnode, __func__);
+  for (int i = 0; i < totnode; i++) {
+    BLI_buffer_field_init(&candidates[i], EdgeQueueCandidate);
+  }
+
+  EdgeQueueCreateData data = {
+      .eq_ctx = eq_ctx,
+      .pbvh = pbvh,
+      .nodes = nodes,
+      .candidates = candidates,
+      .face_add = face_add,
+  };
+
+  TaskParallelSettings settings;
+  BKE_pbvh_parallel_range_settings(&settings, true, totnode);
+  BLI_task_parallel_range(0, totnode, &data, edge_queue_create_task_cb, &settings);
+
+  for (int i = 0; i < totnode; i++) {
+    for (int j = 0; j < (int)candidates[i].count; j++) {
+      const EdgeQueueCandidate *candidate = &BLI_buffer_at(&candidates[i], EdgeQueueCandidate, j);
+#ifdef USE_EDGEQUEUE_TAG
+      if (EDGE_QUEUE_TEST(candidate->e)) {
+        continue;
+      }
+#endif
+      edge_queue_heap_insert(eq_ctx, candidate->e, candidate->priority);
+    }
+    BLI_buffer_field_free(&candidates[i]);
+  }
+
+  MEM_freeN(candidates);
+  MEM_freeN(nodes);
+}
+
 /* Create a priority queue containing vertex pairs connected by a long
  * edge as defined by PBVH.bm_max_edge_len.
  *
@@ -1035,22 +1136,7 @@ static void long_edge_queue_create(EdgeQueueContext *eq_ctx,
   pbvh_bmesh_edge_tag_verify(pbvh);
 #endif
 
-  for (int n = 0; n < pbvh->totnode; n++) {
-    PBVHNode *node = &pbvh->nodes[n];
-
-    /* Check leaf nodes marked for topology update */
-    if ((node->flag & PBVH_Leaf) && (node->flag & PBVH_UpdateTopology) &&
-        !(node->flag & PBVH_FullyHidden)) {
-      GSetIterator gs_iter;
-
-      /* Check each face */
-      GSET_ITER (gs_iter, node->bm_faces) {
-        BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
-
-        long_edge_queue_face_add(eq_ctx, f);
-      }
-    }
-  }
+  edge_queue_create_from_nodes(eq_ctx, pbvh, long_edge_queue_face_add);
 }
 
 /* Create a priority queue containing vertex pairs connected by a
@@ -1094,22 +1180,7 @@ static void short_edge_queue_create(EdgeQueueContext *eq_ctx,
     eq_ctx->q->edge_queue_tri_in_range = edge_queue_tri_in_sphere;
   }
 
-  for (int n = 0; n < pbvh->totnode; n++) {
-    PBVHNode *node = &pbvh->nodes[n];
-
-    /* Check leaf nodes marked for topology update */
-    if ((node->flag & PBVH_Leaf) && (node->flag & PBVH_UpdateTopology) &&
-        !(node->flag & PBVH_FullyHidden)) {
-      GSetIterator gs_iter;
-
-      /* Check each face */
-      GSET_ITER (gs_iter, node->bm_faces) {
-        BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
-
-        short_edge_queue_face_add(eq_ctx, f);
-      }
-    }
-  }
+  edge_queue_create_from_nodes(eq_ctx, pbvh, short_edge_queue_face_add);
 }
 
 /*************************** Topology update **************************/
@@ -1953,7 +2024,13 @@ void BKE_pbvh_build_bmesh(PBVH *pbvh,
   MEM_freeN(nodeinfo);
 }
 
-/* Collapse short edges, subdivide long edges */
+/**
+ * Collapse short edges, subdivide long edges.
+ *
+ * Only building the edge queues runs in parallel. The splits and collapses are applied serially
+ * in queue order: they allocate from the single element pools of the BMesh and record every
+ * change in the same #BMLog, neither of which is thread-safe.
+ */
 bool BKE_pbvh_bmesh_update_topology(PBVH *pbvh,
                                     PBVHTopologyUpdateMode mode,
                                     const float center[3],
@@ -20,6 +20,10 @@
  * \ingroup bli
  */
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* Axis-aligned bounding box */
 typedef struct {
   float bmin[3], bmax[3];
@@ -137,6 +141,10 @@ struct PBVH {
   CustomData *vdata;
   CustomData *ldata;
   CustomData *pdata;
+  /* Hashes of the mesh data the node layout and the draw buffers were built from,
+   * to tell whether the tree can be refit instead of rebuilt, see #BKE_pbvh_refit_mesh. */
+  uint topology_hash;
+  uint visibility_hash;
 
   int face_sets_color_seed;
   int face_sets_color_default;
@@ -151,8 +159,9 @@ struct PBVH {
   BLI_bitmap **grid_hidden;
 
   /* Only used during BVH build and update,
-   * don't need to remain valid after */
-  BLI_bitmap *vert_bitmap;
+   * don't need to remain valid after:
+   * the index of the leaf node owning each vertex as one of its unique vertices. */
+  int *vert_owner;
 
 #ifdef PERFCNTRS
   int perf_modified;
@@ -234,3 +243,7 @@ bool pbvh_bmesh_node_nearest_to_ray(PBVHNode *node,
                                     bool use_original);
 
 void pbvh_bmesh_normals_update(PBVHNode **nodes, int totnode);
+
+#ifdef __cplusplus
+}
+#endif
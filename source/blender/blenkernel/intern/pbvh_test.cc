@@ -0,0 +1,345 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <cmath>
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_lib_id.h"
+#include "BKE_customdata.h"
+#include "BKE_mesh.h"
+#include "BKE_pbvh.h"
+
+#include "BLI_array.hh"
+#include "BLI_math.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+
+#include "bmesh.h"
+#include "bmesh_tools.h"
+
+#include "tests/blenkernel_testing.hh"
+
+#include "pbvh_intern.h"
+
+namespace blender::bke::tests {
+
+class PBVHTest : public MeshTest {
+ public:
+  Mesh *mesh = nullptr;
+  MLoopTri *looptri = nullptr;
+  int looptri_num = 0;
+  PBVH *pbvh = nullptr;
+
+  void TearDown() override
+  {
+    /* The PBVH owns the loop triangles. */
+    if (pbvh) {
+      BKE_pbvh_free(pbvh);
+    }
+    if (mesh) {
+      BKE_id_free(nullptr, mesh);
+    }
+  }
+
+  /* Create a `resolution` by `resolution` grid of quads on a wavy surface,
+   * the quads in the upper half use a second material. */
+  void create_grid_mesh(const int resolution)
+  {
+    mesh = tests::create_grid_mesh(
+        resolution, [](int x, int y) { return sinf(x * 0.1f) * cosf(y * 0.2f); });
+    for (int i = 0; i < mesh->totpoly; i++) {
+      mesh->mpoly[i].mat_nr = (i / resolution >= resolution / 2) ? 1 : 0;
+    }
+  }
+
+  /* Build a PBVH for the grid created by #create_grid_mesh. */
+  void build_grid(const int resolution)
+  {
+    create_grid_mesh(resolution);
+
+    looptri_num = poly_to_tri_count(mesh->totpoly, mesh->totloop);
+    looptri = (MLoopTri *)MEM_malloc_arrayN(looptri_num, sizeof(MLoopTri), __func__);
+    BKE_mesh_recalc_looptri(
+        mesh->mloop, mesh->mpoly, mesh->mvert, mesh->totloop, mesh->totpoly, looptri);
+
+    pbvh = BKE_pbvh_new();
+    BKE_pbvh_build_mesh(pbvh,
+                        mesh,
+                        mesh->mpoly,
+                        mesh->mloop,
+                        mesh->mvert,
+                        mesh->totvert,
+                        &mesh->vdata,
+                        &mesh->ldata,
+                        &mesh->pdata,
+                        looptri,
+                        looptri_num);
+  }
+
+  /* Check that every node has the tight bounds of its vertices or children. */
+  void expect_bounds_tight()
+  {
+    for (int i = pbvh->totnode - 1; i >= 0; i--) {
+      const PBVHNode &node = pbvh->nodes[i];
+      BB bb;
+      BB_reset(&bb);
+      if (node.flag & PBVH_Leaf) {
+        for (int j = 0; j < node.uniq_verts + node.face_verts; j++) {
+          BB_expand(&bb, mesh->mvert[node.vert_indices[j]].co);
+        }
+      }
+      else {
+        BB_expand_with_bb(&bb, &pbvh->nodes[node.children_offset].vb);
+        BB_expand_with_bb(&bb, &pbvh->nodes[node.children_offset + 1].vb);
+      }
+      EXPECT_V3_NEAR(node.vb.bmin, bb.bmin, 0.0f);
+      EXPECT_V3_NEAR(node.vb.bmax, bb.bmax, 0.0f);
+      EXPECT_V3_NEAR(node.orig_vb.bmin, bb.bmin, 0.0f);
+      EXPECT_V3_NEAR(node.orig_vb.bmax, bb.bmax, 0.0f);
+    }
+  }
+
+  static bool bb_contains(const BB &bb, const float co[3])
+  {
+    for (int i = 0; i < 3; i++) {
+      if (co[i] < bb.bmin[i] || co[i] > bb.bmax[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+TEST_F(PBVHTest, build_mesh)
+{
+  build_grid(150);
+
+  PBVHNode **nodes;
+  int totnode;
+  BKE_pbvh_search_gather(pbvh, nullptr, nullptr, &nodes, &totnode);
+  EXPECT_GT(totnode, 4);
+
+  Array<int> prim_leaf(looptri_num, -1);
+  Array<int> vert_leaf(mesh->totvert, -1);
+  for (int n = 0; n < totnode; n++) {
+    const PBVHNode *node = nodes[n];
+    EXPECT_LE(node->totprim, pbvh->leaf_limit);
+
+    /* Every vertex is unique in exactly one leaf. */
+    const int verts_num = node->uniq_verts + node->face_verts;
+    for (int i = 0; i < verts_num; i++) {
+      const int vert = node->vert_indices[i];
+      EXPECT_TRUE(bb_contains(node->vb, mesh->mvert[vert].co));
+      if (i < (int)node->uniq_verts) {
+        EXPECT_EQ(vert_leaf[vert], -1);
+        vert_leaf[vert] = n;
+      }
+    }
+
+    /* Every triangle is in exactly one leaf, with a single material per leaf. */
+    const int mat_nr = mesh->mpoly[looptri[node->prim_indices[0]].poly].mat_nr;
+    for (int i = 0; i < node->totprim; i++) {
+      const MLoopTri &lt = looptri[node->prim_indices[i]];
+      EXPECT_EQ(prim_leaf[node->prim_indices[i]], -1);
+      prim_leaf[node->prim_indices[i]] = n;
+      EXPECT_EQ(mesh->mpoly[lt.poly].mat_nr, mat_nr);
+      for (int j = 0; j < 3; j++) {
+        const int local = node->face_vert_indices[i][j];
+        ASSERT_GE(local, 0);
+        ASSERT_LT(local, verts_num);
+        EXPECT_EQ(node->vert_indices[local], mesh->mloop[lt.tri[j]].v);
+      }
+    }
+  }
+  for (int i = 0; i < looptri_num; i++) {
+    EXPECT_NE(prim_leaf[i], -1);
+  }
+  for (int i = 0; i < mesh->totvert; i++) {
+    EXPECT_NE(vert_leaf[i], -1);
+  }
+  MEM_freeN(nodes);
+
+  /* Inner nodes contain their children. */
+  for (int i = 0; i < pbvh->totnode; i++) {
+    const PBVHNode &node = pbvh->nodes[i];
+    if (node.flag & PBVH_Leaf) {
+      continue;
+    }
+    for (int c = 0; c < 2; c++) {
+      const PBVHNode &child = pbvh->nodes[node.children_offset + c];
+      EXPECT_GT(node.children_offset, i);
+      EXPECT_TRUE(bb_contains(node.vb, child.vb.bmin));
+      EXPECT_TRUE(bb_contains(node.vb, child.vb.bmax));
+    }
+  }
+}
+
+TEST_F(PBVHTest, refit)
+{
+  build_grid(100);
+  expect_bounds_tight();
+
+  for (int i = 0; i < mesh->totvert; i++) {
+    float *co = mesh->mvert[i].co;
+    co[2] = co[2] * 3.0f + co[0] * 0.5f;
+    co[0] *= 2.0f;
+  }
+  BKE_pbvh_refit(pbvh);
+  expect_bounds_tight();
+
+  for (int i = 0; i < pbvh->totnode; i++) {
+    const PBVHNode &node = pbvh->nodes[i];
+    EXPECT_EQ(node.flag & (PBVH_UpdateBB | PBVH_UpdateOriginalBB), 0);
+    if (node.flag & PBVH_Leaf) {
+      EXPECT_TRUE(node.flag & PBVH_UpdateDrawBuffers);
+      EXPECT_TRUE(node.flag & PBVH_UpdateNormals);
+    }
+  }
+}
+
+TEST_F(PBVHTest, refit_mesh)
+{
+  build_grid(60);
+  EXPECT_TRUE(BKE_pbvh_mesh_topology_matches(pbvh, mesh));
+  /* Like after drawing, the draw buffers exist. */
+  for (int i = 0; i < pbvh->totnode; i++) {
+    pbvh->nodes[i].flag = (PBVHNodeFlags)(pbvh->nodes[i].flag &
+                                          ~(PBVH_RebuildDrawBuffers | PBVH_UpdateVisibility));
+  }
+
+  /* Moving vertices keeps the topology. */
+  for (int i = 0; i < mesh->totvert; i++) {
+    mesh->mvert[i].co[2] += 1.0f;
+  }
+  EXPECT_TRUE(BKE_pbvh_mesh_topology_matches(pbvh, mesh));
+  BKE_pbvh_refit_mesh(pbvh, mesh);
+  expect_bounds_tight();
+  for (int i = 0; i < pbvh->totnode; i++) {
+    EXPECT_FALSE(pbvh->nodes[i].flag & PBVH_RebuildDrawBuffers);
+  }
+
+  /* Hiding a vertex changes the visibility but not the topology. */
+  mesh->mvert[0].flag |= ME_HIDE;
+  EXPECT_TRUE(BKE_pbvh_mesh_topology_matches(pbvh, mesh));
+  BKE_pbvh_refit_mesh(pbvh, mesh);
+  for (int i = 0; i < pbvh->totnode; i++) {
+    const PBVHNode &node = pbvh->nodes[i];
+    if (node.flag & PBVH_Leaf) {
+      EXPECT_TRUE(node.flag & PBVH_UpdateVisibility);
+      EXPECT_TRUE(node.flag & PBVH_RebuildDrawBuffers);
+    }
+  }
+
+  /* Materials and connectivity change the layout. */
+  mesh->mpoly[0].mat_nr = 1;
+  EXPECT_FALSE(BKE_pbvh_mesh_topology_matches(pbvh, mesh));
+  mesh->mpoly[0].mat_nr = 0;
+  EXPECT_TRUE(BKE_pbvh_mesh_topology_matches(pbvh, mesh));
+  std::swap(mesh->mloop[0].v, mesh->mloop[1].v);
+  EXPECT_FALSE(BKE_pbvh_mesh_topology_matches(pbvh, mesh));
+}
+
+/* Triangulate the grid into a BMesh with the layers used by dynamic topology sculpting. */
+static BMesh *dyntopo_bmesh_from_mesh(const Mesh *mesh, int *r_cd_vert_node, int *r_cd_face_node)
+{
+  BMesh *bm = bmesh_from_mesh(mesh);
+  BM_mesh_triangulate(bm,
+                      MOD_TRIANGULATE_QUAD_BEAUTY,
+                      MOD_TRIANGULATE_NGON_EARCLIP,
+                      4,
+                      false,
+                      nullptr,
+                      nullptr,
+                      nullptr);
+  BM_data_layer_add(bm, &bm->vdata, CD_PAINT_MASK);
+  BM_data_layer_add_named(bm, &bm->vdata, CD_PROP_INT32, "_dyntopo_node_id");
+  BM_data_layer_add_named(bm, &bm->pdata, CD_PROP_INT32, "_dyntopo_node_id");
+  *r_cd_vert_node = CustomData_get_offset(&bm->vdata, CD_PROP_INT32);
+  *r_cd_face_node = CustomData_get_offset(&bm->pdata, CD_PROP_INT32);
+  return bm;
+}
+
+static float bmesh_edge_length_max(BMesh *bm)
+{
+  float len_max = 0.0f;
+  BMIter iter;
+  BMEdge *e;
+  BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
+    len_max = max_ff(len_max, BM_edge_calc_length(e));
+  }
+  return len_max;
+}
+
+/* Every face is in the leaf its node index points to. */
+static void expect_bmesh_faces_in_nodes(PBVH *pbvh, BMesh *bm, const int cd_face_node)
+{
+  int faces_num = 0;
+  for (int i = 0; i < pbvh->totnode; i++) {
+    PBVHNode *node = &pbvh->nodes[i];
+    if (!(node->flag & PBVH_Leaf)) {
+      continue;
+    }
+    GSetIterator gs_iter;
+    GSET_ITER (gs_iter, node->bm_faces) {
+      BMFace *f = (BMFace *)BLI_gsetIterator_getKey(&gs_iter);
+      EXPECT_EQ(f->len, 3);
+      EXPECT_EQ(BM_ELEM_CD_GET_INT(f, cd_face_node), i);
+      faces_num++;
+    }
+  }
+  EXPECT_EQ(faces_num, bm->totface);
+}
+
+TEST_F(PBVHTest, bmesh_update_topology)
+{
+  create_grid_mesh(40);
+  int cd_vert_node, cd_face_node;
+  BMesh *bm = dyntopo_bmesh_from_mesh(mesh, &cd_vert_node, &cd_face_node);
+  BMLog *bm_log = BM_log_create(bm);
+  /* Like a sculpt undo step, topology changes are logged to the current entry. */
+  BMLogEntry *bm_log_entry = BM_log_entry_add(bm_log);
+
+  pbvh = BKE_pbvh_new();
+  BKE_pbvh_build_bmesh(pbvh, bm, false, bm_log, cd_vert_node, cd_face_node);
+  const float center[3] = {20.0f, 20.0f, 0.0f};
+  const float radius = 100.0f;
+
+  /* Subdivide everything to half the original edge length. */
+  BKE_pbvh_bmesh_detail_size_set(pbvh, 0.5f);
+  const int faces_num_orig = bm->totface;
+  for (int i = 0; i < pbvh->totnode; i++) {
+    if (pbvh->nodes[i].flag & PBVH_Leaf) {
+      BKE_pbvh_node_mark_topology_update(&pbvh->nodes[i]);
+    }
+  }
+  EXPECT_TRUE(BKE_pbvh_bmesh_update_topology(
+      pbvh, PBVH_Subdivide, center, nullptr, radius, false, false));
+  EXPECT_GT(bm->totface, faces_num_orig * 4);
+  EXPECT_LE(bmesh_edge_length_max(bm), 0.5f);
+  expect_bmesh_faces_in_nodes(pbvh, bm, cd_face_node);
+
+  /* Collapse back to a coarser mesh. */
+  BKE_pbvh_bmesh_detail_size_set(pbvh, 4.0f);
+  const int faces_num_dense = bm->totface;
+  for (int i = 0; i < pbvh->totnode; i++) {
+    if (pbvh->nodes[i].flag & PBVH_Leaf) {
+      BKE_pbvh_node_mark_topology_update(&pbvh->nodes[i]);
+    }
+  }
+  EXPECT_TRUE(BKE_pbvh_bmesh_update_topology(
+      pbvh, PBVH_Collapse, center, nullptr, radius, false, false));
+  EXPECT_LT(bm->totface, faces_num_dense / 4);
+  expect_bmesh_faces_in_nodes(pbvh, bm, cd_face_node);
+
+  BKE_pbvh_free(pbvh);
+  pbvh = nullptr;
+  BM_log_entry_drop(bm_log_entry);
+  BM_log_free(bm_log);
+  BM_mesh_free(bm);
+}
+
+}  // namespace blender::bke::tests
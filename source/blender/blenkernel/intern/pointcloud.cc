@@ -44,6 +44,7 @@
 #include "BKE_modifier.h"
 #include "BKE_object.h"
 #include "BKE_pointcloud.h"
+#include "BKE_pointcloud_spatial_index.hh"
 
 #include "BLT_translation.h"
 
@@ -90,6 +91,7 @@ static void pointcloud_copy_data(Main *UNUSED(bmain), ID *id_dst, const ID *id_s
   BKE_pointcloud_update_customdata_pointers(pointcloud_dst);
 
   pointcloud_dst->batch_cache = nullptr;
+  pointcloud_dst->spatial_index = nullptr;
 }
 
 static void pointcloud_free_data(ID *id)
@@ -97,6 +99,7 @@ static void pointcloud_free_data(ID *id)
   PointCloud *pointcloud = (PointCloud *)id;
   BKE_animdata_free(&pointcloud->id, false);
   BKE_pointcloud_batch_cache_free(pointcloud);
+  BKE_pointcloud_spatial_index_free(pointcloud);
   CustomData_free(&pointcloud->pdata, pointcloud->totpoint);
   MEM_SAFE_FREE(pointcloud->mat);
 }
@@ -149,6 +152,9 @@ static void pointcloud_blend_read_data(BlendDataReader *reader, ID *id)
 
   /* Materials */
   BLO_read_pointer_array(reader, (void **)&pointcloud->mat);
+
+  /* Runtime data. */
+  pointcloud->spatial_index = nullptr;
 }
 
 static void pointcloud_blend_read_lib(BlendLibReader *reader, ID *id)
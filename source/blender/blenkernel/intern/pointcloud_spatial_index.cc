@@ -0,0 +1,381 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bke
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#include "atomic_ops.h"
+
+#include "BLI_math_vector.h"
+#include "BLI_task.hh"
+
+#include "DNA_pointcloud_types.h"
+
+#include "BKE_pointcloud_spatial_index.hh"
+
+namespace blender::bke {
+
+/** The grid resolution is chosen to get about this many points per cell on average. */
+static constexpr int POINTS_PER_CELL = 4;
+/** Limits memory usage for very unevenly distributed points. */
+static constexpr int MAX_CELLS_PER_AXIS = 1024;
+
+static void compute_bounds(Span<float3> positions, float3 &r_min, float3 &r_max)
+{
+  const int64_t chunk_size = 4096;
+  const int64_t chunks_num = (positions.size() + chunk_size - 1) / chunk_size;
+  Array<float3> chunk_min(chunks_num, float3(FLT_MAX));
+  Array<float3> chunk_max(chunks_num, float3(-FLT_MAX));
+
+  parallel_for(IndexRange(chunks_num), 1, [&](IndexRange range) {
+    for (const int64_t chunk : range) {
+      const IndexRange chunk_range = positions.index_range().slice(
+          chunk * chunk_size, std::min(chunk_size, positions.size() - chunk * chunk_size));
+      for (const float3 &position : positions.slice(chunk_range)) {
+        minmax_v3v3_v3(chunk_min[chunk], chunk_max[chunk], position);
+      }
+    }
+  });
+
+  r_min = float3(FLT_MAX);
+  r_max = float3(-FLT_MAX);
+  for (const int64_t chunk : IndexRange(chunks_num)) {
+    minmax_v3v3_v3(r_min, r_max, chunk_min[chunk]);
+    minmax_v3v3_v3(r_min, r_max, chunk_max[chunk]);
+  }
+}
+
+static float compute_cell_size(const float3 &extent, const int64_t cells_num)
+{
+  /* Ignore flat dimensions, otherwise points that lie in a plane (which is common for scanned
+   * data) would end up in very few cells. */
+  double volume = 1.0;
+  int used_dimensions = 0;
+  for (int axis = 0; axis < 3; axis++) {
+    if (extent[axis] > FLT_EPSILON) {
+      volume *= extent[axis];
+      used_dimensions++;
+    }
+  }
+  if (used_dimensions == 0) {
+    return 1.0f;
+  }
+  const float cell_size = (float)std::pow(volume / cells_num, 1.0 / used_dimensions);
+  if (!(cell_size > 0.0f) || !std::isfinite(cell_size)) {
+    return 1.0f;
+  }
+  return cell_size;
+}
+
+PointCloudSpatialIndex::PointCloudSpatialIndex(Span<float3> positions)
+{
+  const int points_num = positions.size();
+
+  float3 max;
+  compute_bounds(positions, min_, max);
+  if (points_num == 0) {
+    min_ = max = float3(0.0f);
+  }
+
+  const float3 extent = max - min_;
+  cell_size_ = compute_cell_size(extent, std::max(points_num / POINTS_PER_CELL, 1));
+  for (int axis = 0; axis < 3; axis++) {
+    cell_size_ = std::max(cell_size_, extent[axis] / (MAX_CELLS_PER_AXIS - 1));
+  }
+  for (int axis = 0; axis < 3; axis++) {
+    dims_[axis] = std::min((int)(extent[axis] / cell_size_) + 1, MAX_CELLS_PER_AXIS);
+  }
+  const int cells_num = dims_[0] * dims_[1] * dims_[2];
+
+  /* Count the points in every cell. */
+  Array<int> point_cells(points_num);
+  cell_offsets_.reinitialize(cells_num + 1);
+  cell_offsets_.fill(0);
+  parallel_for(positions.index_range(), 4096, [&](IndexRange range) {
+    for (const int i : range) {
+      const float3 &position = positions[i];
+      const int cell = this->cell_index(this->cell_coord(position.x, 0),
+                                        this->cell_coord(position.y, 1),
+                                        this->cell_coord(position.z, 2));
+      point_cells[i] = cell;
+      atomic_add_and_fetch_int32(&cell_offsets_[cell], 1);
+    }
+  });
+
+  /* Turn the counts into offsets with an exclusive prefix sum. */
+  int offset = 0;
+  for (const int cell : IndexRange(cells_num)) {
+    const int count = cell_offsets_[cell];
+    cell_offsets_[cell] = offset;
+    offset += count;
+  }
+  cell_offsets_[cells_num] = offset;
+
+  /* Scatter the point indices into their cells. */
+  Array<int> cell_fill(cells_num, 0);
+  sorted_indices_.reinitialize(points_num);
+  parallel_for(positions.index_range(), 4096, [&](IndexRange range) {
+    for (const int i : range) {
+      const int cell = point_cells[i];
+      const int index_in_cell = atomic_fetch_and_add_int32(&cell_fill[cell], 1);
+      sorted_indices_[cell_offsets_[cell] + index_in_cell] = i;
+    }
+  });
+
+  /* The scatter order depends on scheduling, sort to make queries deterministic. */
+  sorted_positions_.reinitialize(points_num);
+  parallel_for(IndexRange(cells_num), 1024, [&](IndexRange range) {
+    for (const int cell : range) {
+      int *cell_begin = sorted_indices_.data() + cell_offsets_[cell];
+      int *cell_end = sorted_indices_.data() + cell_offsets_[cell + 1];
+      std::sort(cell_begin, cell_end);
+      for (const int *index = cell_begin; index != cell_end; index++) {
+        sorted_positions_[index - sorted_indices_.data()] = positions[*index];
+      }
+    }
+  });
+}
+
+int PointCloudSpatialIndex::cell_coord(const float value, const int axis) const
+{
+  const int coord = (int)((value - min_[axis]) / cell_size_);
+  return std::clamp(coord, 0, dims_[axis] - 1);
+}
+
+int PointCloudSpatialIndex::cell_index(const int x, const int y, const int z) const
+{
+  return (z * dims_[1] + y) * dims_[0] + x;
+}
+
+/**
+ * Insert a point into the sorted list of the nearest points found so far,
+ * the furthest point is dropped when the list is full.
+ */
+static void nearest_n_insert(MutableSpan<int> r_indices,
+                             MutableSpan<float> r_distances_sq,
+                             const int index,
+                             const float distance_sq)
+{
+  int i = r_indices.size() - 1;
+  if (distance_sq >= r_distances_sq[i]) {
+    return;
+  }
+  for (; i > 0 && r_distances_sq[i - 1] > distance_sq; i--) {
+    r_indices[i] = r_indices[i - 1];
+    r_distances_sq[i] = r_distances_sq[i - 1];
+  }
+  r_indices[i] = index;
+  r_distances_sq[i] = distance_sq;
+}
+
+void PointCloudSpatialIndex::find_nearest_n_single(const float3 &position,
+                                                   const int k,
+                                                   MutableSpan<int> r_indices,
+                                                   MutableSpan<float> r_distances_sq) const
+{
+  r_indices.fill(-1);
+  r_distances_sq.fill(FLT_MAX);
+
+  const int center[3] = {
+      this->cell_coord(position.x, 0),
+      this->cell_coord(position.y, 1),
+      this->cell_coord(position.z, 2),
+  };
+
+  auto visit_cell = [&](const int x, const int y, const int z) {
+    const int cell = this->cell_index(x, y, z);
+    const int start = cell_offsets_[cell];
+    const int end = cell_offsets_[cell + 1];
+    for (const int i : IndexRange(start, end - start)) {
+      const float distance_sq = float3::distance_squared(position, sorted_positions_[i]);
+      nearest_n_insert(r_indices, r_distances_sq, sorted_indices_[i], distance_sq);
+    }
+  };
+
+  /* Visit shells of cells with increasing distance from the center cell, until no closer point
+   * can be found in the cells that have not been visited yet. */
+  for (int ring = 0;; ring++) {
+    int lo[3], hi[3];
+    for (int axis = 0; axis < 3; axis++) {
+      lo[axis] = center[axis] - ring;
+      hi[axis] = center[axis] + ring;
+    }
+
+    for (int z = std::max(lo[2], 0); z <= std::min(hi[2], dims_[2] - 1); z++) {
+      for (int y = std::max(lo[1], 0); y <= std::min(hi[1], dims_[1] - 1); y++) {
+        if (ELEM(z, lo[2], hi[2]) || ELEM(y, lo[1], hi[1])) {
+          for (int x = std::max(lo[0], 0); x <= std::min(hi[0], dims_[0] - 1); x++) {
+            visit_cell(x, y, z);
+          }
+        }
+        else {
+          /* Only the first and last cell of inner rows are part of the shell. */
+          if (lo[0] >= 0) {
+            visit_cell(lo[0], y, z);
+          }
+          if (hi[0] < dims_[0] && hi[0] != lo[0]) {
+            visit_cell(hi[0], y, z);
+          }
+        }
+      }
+    }
+
+    /* Find the smallest distance to a cell outside of the visited block of cells. */
+    float bound = FLT_MAX;
+    for (int axis = 0; axis < 3; axis++) {
+      if (lo[axis] > 0) {
+        bound = std::min(bound, position[axis] - (min_[axis] + lo[axis] * cell_size_));
+      }
+      if (hi[axis] < dims_[axis] - 1) {
+        bound = std::min(bound, min_[axis] + (hi[axis] + 1) * cell_size_ - position[axis]);
+      }
+    }
+    if (bound == FLT_MAX) {
+      /* All cells have been visited. */
+      break;
+    }
+    bound = std::max(bound, 0.0f);
+    if (r_indices[k - 1] != -1 && bound * bound >= r_distances_sq[k - 1]) {
+      break;
+    }
+  }
+}
+
+void PointCloudSpatialIndex::find_nearest_n(Span<float3> query_positions,
+                                            const int k,
+                                            MutableSpan<int> r_indices,
+                                            MutableSpan<float> r_distances_sq) const
+{
+  BLI_assert(k > 0);
+  BLI_assert(r_indices.size() == query_positions.size() * k);
+  BLI_assert(r_distances_sq.size() == query_positions.size() * k);
+
+  parallel_for(query_positions.index_range(), 256, [&](IndexRange range) {
+    for (const int i : range) {
+      this->find_nearest_n_single(query_positions[i],
+                                  k,
+                                  r_indices.slice(i * k, k),
+                                  r_distances_sq.slice(i * k, k));
+    }
+  });
+}
+
+template<typename Func>
+void PointCloudSpatialIndex::foreach_point_in_radius(const float3 &position,
+                                                     const float radius,
+                                                     const Func &func) const
+{
+  const float radius_sq = radius * radius;
+  const int lo[3] = {
+      this->cell_coord(position.x - radius, 0),
+      this->cell_coord(position.y - radius, 1),
+      this->cell_coord(position.z - radius, 2),
+  };
+  const int hi[3] = {
+      this->cell_coord(position.x + radius, 0),
+      this->cell_coord(position.y + radius, 1),
+      this->cell_coord(position.z + radius, 2),
+  };
+  for (int z = lo[2]; z <= hi[2]; z++) {
+    for (int y = lo[1]; y <= hi[1]; y++) {
+      /* Cells in a row are stored consecutively, so their points are as well. */
+      const int start = cell_offsets_[this->cell_index(lo[0], y, z)];
+      const int end = cell_offsets_[this->cell_index(hi[0], y, z) + 1];
+      for (const int i : IndexRange(start, end - start)) {
+        if (float3::distance_squared(position, sorted_positions_[i]) <= radius_sq) {
+          func(sorted_indices_[i]);
+        }
+      }
+    }
+  }
+}
+
+void PointCloudSpatialIndex::find_in_radius(Span<float3> query_positions,
+                                            const float radius,
+                                            MutableSpan<int> r_offsets,
+                                            Array<int> &r_indices) const
+{
+  BLI_assert(r_offsets.size() == query_positions.size() + 1);
+
+  /* Count the points of every query first, so that the result can be written in parallel. */
+  parallel_for(query_positions.index_range(), 256, [&](IndexRange range) {
+    for (const int i : range) {
+      int count = 0;
+      this->foreach_point_in_radius(query_positions[i], radius, [&](const int UNUSED(index)) {
+        count++;
+      });
+      r_offsets[i] = count;
+    }
+  });
+
+  int offset = 0;
+  for (const int i : query_positions.index_range()) {
+    const int count = r_offsets[i];
+    r_offsets[i] = offset;
+    offset += count;
+  }
+  r_offsets.last() = offset;
+
+  r_indices.reinitialize(offset);
+  parallel_for(query_positions.index_range(), 256, [&](IndexRange range) {
+    for (const int i : range) {
+      int result_index = r_offsets[i];
+      this->foreach_point_in_radius(
+          query_positions[i], radius, [&](const int index) { r_indices[result_index++] = index; });
+    }
+  });
+}
+
+}  // namespace blender::bke
+
+using blender::bke::PointCloudSpatialIndex;
+
+/* Use a global mutex because otherwise it would have to be stored directly in the
+ * PointCloud struct in DNA. */
+static std::mutex spatial_index_mutex;
+
+/**
+ * Get the spatial index of the point cloud, building it if necessary. This only updates a cache
+ * and can be called from multiple threads at the same time. The cache is freed whenever the
+ * point cloud is accessed for writing through a geometry component.
+ */
+const PointCloudSpatialIndex &BKE_pointcloud_spatial_index_ensure(const PointCloud &pointcloud)
+{
+  if (pointcloud.spatial_index == nullptr) {
+    std::lock_guard<std::mutex> lock(spatial_index_mutex);
+    /* Check again-- another thread may have built the index while this one waited. */
+    if (pointcloud.spatial_index == nullptr) {
+      blender::Span<blender::float3> positions{(const blender::float3 *)pointcloud.co,
+                                               pointcloud.totpoint};
+      PointCloudSpatialIndex *spatial_index = new PointCloudSpatialIndex(positions);
+      const_cast<PointCloud &>(pointcloud).spatial_index = spatial_index;
+    }
+  }
+  return *static_cast<const PointCloudSpatialIndex *>(pointcloud.spatial_index);
+}
+
+void BKE_pointcloud_spatial_index_free(PointCloud *pointcloud)
+{
+  if (pointcloud->spatial_index != nullptr) {
+    delete static_cast<PointCloudSpatialIndex *>(pointcloud->spatial_index);
+    pointcloud->spatial_index = nullptr;
+  }
+}
@@ -0,0 +1,117 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "testing/testing.h"
+
+#include <algorithm>
+
+#include "BKE_pointcloud_spatial_index.hh"
+
+#include "BLI_rand.hh"
+#include "BLI_vector.hh"
+
+namespace blender::bke::tests {
+
+static Array<float3> random_positions(const int size, const bool flat)
+{
+  RandomNumberGenerator rng(42);
+  Array<float3> positions(size);
+  for (float3 &position : positions) {
+    position = float3(rng.get_float(), rng.get_float(), flat ? 0.0f : rng.get_float()) * 10.0f;
+  }
+  return positions;
+}
+
+static void test_find_nearest_n(Span<float3> positions, const int k)
+{
+  PointCloudSpatialIndex index(positions);
+  EXPECT_EQ(index.size(), positions.size());
+
+  Array<float3> query = random_positions(100, false);
+  Array<int> indices(query.size() * k);
+  Array<float> distances_sq(query.size() * k);
+  index.find_nearest_n(query, k, indices, distances_sq);
+
+  for (const int i : query.index_range()) {
+    Vector<float> expected;
+    for (const float3 &position : positions) {
+      expected.append(float3::distance_squared(query[i], position));
+    }
+    std::sort(expected.begin(), expected.end());
+    for (const int j : IndexRange(k)) {
+      if (j < expected.size()) {
+        EXPECT_FLOAT_EQ(distances_sq[i * k + j], expected[j]);
+        EXPECT_FLOAT_EQ(float3::distance_squared(query[i], positions[indices[i * k + j]]),
+                        expected[j]);
+      }
+      else {
+        EXPECT_EQ(indices[i * k + j], -1);
+      }
+    }
+  }
+}
+
+TEST(pointcloud_spatial_index, FindNearest)
+{
+  test_find_nearest_n(random_positions(1000, false), 1);
+}
+
+TEST(pointcloud_spatial_index, FindNearestN)
+{
+  test_find_nearest_n(random_positions(1000, false), 8);
+}
+
+TEST(pointcloud_spatial_index, FindNearestNFlat)
+{
+  test_find_nearest_n(random_positions(1000, true), 4);
+}
+
+TEST(pointcloud_spatial_index, FindNearestNFewPoints)
+{
+  test_find_nearest_n(random_positions(3, false), 5);
+}
+
+TEST(pointcloud_spatial_index, FindInRadius)
+{
+  Array<float3> positions = random_positions(1000, false);
+  PointCloudSpatialIndex index(positions);
+
+  const float radius = 1.5f;
+  Array<float3> query = random_positions(50, false);
+  Array<int> offsets(query.size() + 1);
+  Array<int> indices;
+  index.find_in_radius(query, radius, offsets, indices);
+  EXPECT_EQ(offsets.last(), indices.size());
+
+  for (const int i : query.index_range()) {
+    Vector<int> expected;
+    for (const int point : positions.index_range()) {
+      if (float3::distance_squared(query[i], positions[point]) <= radius * radius) {
+        expected.append(point);
+      }
+    }
+    Vector<int> found;
+    for (const int j : IndexRange(offsets[i], offsets[i + 1] - offsets[i])) {
+      found.append(indices[j]);
+    }
+    std::sort(found.begin(), found.end());
+    ASSERT_EQ(found.size(), expected.size());
+    for (const int j : expected.index_range()) {
+      EXPECT_EQ(found[j], expected[j]);
+    }
+  }
+}
+
+}  // namespace blender::bke::tests
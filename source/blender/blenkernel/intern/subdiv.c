@@ -22,6 +22,7 @@
  */
 
 #include "BKE_subdiv.h"
+#include "BKE_subdiv_mesh.h"
 
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
@@ -198,6 +199,12 @@ void BKE_subdiv_free(Subdiv *subdiv)
   if (subdiv->cache_.face_ptex_offset != NULL) {
     MEM_freeN(subdiv->cache_.face_ptex_offset);
   }
+  if (subdiv->cache_.mesh_limit_stencils != NULL) {
+    BKE_subdiv_mesh_limit_stencils_free(subdiv->cache_.mesh_limit_stencils);
+  }
+  if (subdiv->cache_.mesh_topology != NULL) {
+    BKE_subdiv_mesh_topology_cache_free(subdiv->cache_.mesh_topology);
+  }
   MEM_freeN(subdiv);
 }
 
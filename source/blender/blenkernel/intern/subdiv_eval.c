@@ -28,6 +28,7 @@
 
 #include "BLI_bitmap.h"
 #include "BLI_math_vector.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_customdata.h"
@@ -35,6 +36,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "opensubdiv_capi_type.h"
 #include "opensubdiv_evaluator_capi.h"
 #include "opensubdiv_topology_refiner_capi.h"
 
@@ -61,9 +63,11 @@ bool BKE_subdiv_eval_begin(Subdiv *subdiv)
   return true;
 }
 
-static void set_coarse_positions(Subdiv *subdiv,
-                                 const Mesh *mesh,
-                                 const float (*coarse_vertex_cos)[3])
+/* Gather positions of vertices which are used by faces, in the order of coarse vertices of
+ * OpenSubdiv. Returns number of such vertices. */
+static int get_manifold_coarse_positions(const Mesh *mesh,
+                                         const float (*coarse_vertex_cos)[3],
+                                         float (*r_positions)[3])
 {
   const MVert *mvert = mesh->mvert;
   const MLoop *mloop = mesh->mloop;
@@ -80,8 +84,8 @@ static void set_coarse_positions(Subdiv *subdiv,
       BLI_BITMAP_ENABLE(vertex_used_map, loop->v);
     }
   }
-  for (int vertex_index = 0, manifold_vertex_index = 0; vertex_index < mesh->totvert;
-       vertex_index++) {
+  int manifold_vertex_index = 0;
+  for (int vertex_index = 0; vertex_index < mesh->totvert; vertex_index++) {
     if (!BLI_BITMAP_TEST_BOOL(vertex_used_map, vertex_index)) {
       continue;
     }
@@ -93,10 +97,23 @@ static void set_coarse_positions(Subdiv *subdiv,
       const MVert *vertex = &mvert[vertex_index];
       vertex_co = vertex->co;
     }
-    subdiv->evaluator->setCoarsePositions(subdiv->evaluator, vertex_co, manifold_vertex_index, 1);
+    copy_v3_v3(r_positions[manifold_vertex_index], vertex_co);
     manifold_vertex_index++;
   }
   MEM_freeN(vertex_used_map);
+  return manifold_vertex_index;
+}
+
+static void set_coarse_positions(Subdiv *subdiv,
+                                 const Mesh *mesh,
+                                 const float (*coarse_vertex_cos)[3])
+{
+  float(*positions)[3] = MEM_malloc_arrayN(mesh->totvert, sizeof(float[3]), __func__);
+  const int num_positions = get_manifold_coarse_positions(mesh, coarse_vertex_cos, positions);
+  if (num_positions != 0) {
+    subdiv->evaluator->setCoarsePositions(subdiv->evaluator, &positions[0][0], 0, num_positions);
+  }
+  MEM_freeN(positions);
 }
 
 static void set_face_varying_data_from_uv(Subdiv *subdiv,
@@ -395,3 +412,116 @@ void BKE_subdiv_eval_limit_patch_resolution_point_and_short_normal(Subdiv *subdi
     }
   }
 }
+
+/* ============================= Limit stencils ============================= */
+
+SubdivLimitStencils *BKE_subdiv_eval_limit_stencils_new(const int num_points)
+{
+  SubdivLimitStencils *stencils = MEM_callocN(sizeof(SubdivLimitStencils), __func__);
+  stencils->num_points = num_points;
+  stencils->ptex_face_indices = MEM_malloc_arrayN(num_points, sizeof(int), __func__);
+  stencils->uvs = MEM_malloc_arrayN(num_points, sizeof(float[2]), __func__);
+  return stencils;
+}
+
+void BKE_subdiv_eval_limit_stencils_free(SubdivLimitStencils *stencils)
+{
+  if (stencils->opensubdiv_stencils != NULL) {
+    openSubdiv_deleteLimitStencils(stencils->opensubdiv_stencils);
+  }
+  MEM_freeN(stencils->ptex_face_indices);
+  MEM_freeN(stencils->uvs);
+  MEM_freeN(stencils);
+}
+
+bool BKE_subdiv_eval_limit_stencils_build(Subdiv *subdiv, SubdivLimitStencils *stencils)
+{
+  BLI_assert(stencils->opensubdiv_stencils == NULL);
+  OpenSubdiv_Evaluator *evaluator = subdiv->evaluator;
+  if (evaluator == NULL) {
+    return false;
+  }
+  OpenSubdiv_PatchCoord *patch_coords = MEM_malloc_arrayN(
+      stencils->num_points, sizeof(OpenSubdiv_PatchCoord), __func__);
+  for (int i = 0; i < stencils->num_points; i++) {
+    patch_coords[i].ptex_face = stencils->ptex_face_indices[i];
+    patch_coords[i].u = stencils->uvs[i][0];
+    patch_coords[i].v = stencils->uvs[i][1];
+  }
+  stencils->opensubdiv_stencils = evaluator->createLimitStencils(
+      evaluator, patch_coords, stencils->num_points);
+  MEM_freeN(patch_coords);
+  return stencils->opensubdiv_stencils != NULL;
+}
+
+typedef struct LimitStencilsEvalData {
+  Subdiv *subdiv;
+  const SubdivLimitStencils *stencils;
+  const float (*coarse_positions)[3];
+  float (*r_P)[3];
+  float (*r_dPdu)[3];
+  float (*r_dPdv)[3];
+} LimitStencilsEvalData;
+
+static void limit_stencils_eval_cb(void *__restrict userdata,
+                                   const int point_index,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  LimitStencilsEvalData *data = userdata;
+  const SubdivLimitStencils *stencils = data->stencils;
+  const OpenSubdiv_LimitStencils *opensubdiv_stencils = stencils->opensubdiv_stencils;
+  float *P = data->r_P[point_index];
+  float *dPdu = data->r_dPdu[point_index];
+  float *dPdv = data->r_dPdv[point_index];
+  zero_v3(P);
+  zero_v3(dPdu);
+  zero_v3(dPdv);
+  const int start = opensubdiv_stencils->offsets[point_index];
+  const int end = opensubdiv_stencils->offsets[point_index + 1];
+  for (int i = start; i < end; i++) {
+    const float *co = data->coarse_positions[opensubdiv_stencils->indices[i]];
+    madd_v3_v3fl(P, co, opensubdiv_stencils->weights[i]);
+    madd_v3_v3fl(dPdu, co, opensubdiv_stencils->du_weights[i]);
+    madd_v3_v3fl(dPdv, co, opensubdiv_stencils->dv_weights[i]);
+  }
+  /* Use the same workaround for degenerate derivatives as the single point evaluation. */
+  const int ptex_face_index = stencils->ptex_face_indices[point_index];
+  if (ptex_face_index != -1 &&
+      ((is_zero_v3(dPdu) || is_zero_v3(dPdv)) || equals_v3v3(dPdu, dPdv))) {
+    BKE_subdiv_eval_limit_point_and_derivatives(data->subdiv,
+                                                ptex_face_index,
+                                                stencils->uvs[point_index][0],
+                                                stencils->uvs[point_index][1],
+                                                P,
+                                                dPdu,
+                                                dPdv);
+  }
+}
+
+void BKE_subdiv_eval_limit_stencils(Subdiv *subdiv,
+                                    const SubdivLimitStencils *stencils,
+                                    const Mesh *mesh,
+                                    const float (*coarse_vertex_cos)[3],
+                                    float (*r_P)[3],
+                                    float (*r_dPdu)[3],
+                                    float (*r_dPdv)[3])
+{
+  BLI_assert(stencils->opensubdiv_stencils != NULL);
+  float(*coarse_positions)[3] = MEM_malloc_arrayN(mesh->totvert, sizeof(float[3]), __func__);
+  get_manifold_coarse_positions(mesh, coarse_vertex_cos, coarse_positions);
+
+  LimitStencilsEvalData data = {
+      .subdiv = subdiv,
+      .stencils = stencils,
+      .coarse_positions = (const float(*)[3])coarse_positions,
+      .r_P = r_P,
+      .r_dPdu = r_dPdu,
+      .r_dPdv = r_dPdv,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, stencils->num_points, &data, limit_stencils_eval_cb, &settings);
+
+  MEM_freeN(coarse_positions);
+}
@@ -30,11 +30,15 @@
 #include "DNA_meshdata_types.h"
 
 #include "BLI_alloca.h"
+#include "BLI_math_base.h"
 #include "BLI_math_vector.h"
+#include "BLI_task.h"
 
 #include "BKE_customdata.h"
 #include "BKE_key.h"
+#include "BKE_lib_id.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 #include "BKE_subdiv.h"
 #include "BKE_subdiv_eval.h"
 #include "BKE_subdiv_foreach.h"
@@ -76,6 +80,16 @@ typedef struct SubdivMeshContext {
    * when it's not possible is when displacement is used. */
   bool can_evaluate_normals;
   bool have_displacement;
+  /* Limit positions and derivatives evaluated from cached stencils, NULL when points are to be
+   * evaluated one by one. First num_limit_vertices elements correspond to subdivided vertices,
+   * they are followed by points of every-corner and every-edge callbacks. */
+  float (*limit_P)[3];
+  float (*limit_dPdu)[3];
+  float (*limit_dPdv)[3];
+  int num_limit_vertices;
+  /* Index of the next point of every-corner and every-edge callbacks, which are run from a
+   * single thread. */
+  int limit_boundary_point_index;
 } SubdivMeshContext;
 
 static void subdiv_mesh_ctx_cache_uv_layers(SubdivMeshContext *ctx)
@@ -117,6 +131,9 @@ static void subdiv_mesh_context_free(SubdivMeshContext *ctx)
 {
   MEM_SAFE_FREE(ctx->accumulated_normals);
   MEM_SAFE_FREE(ctx->accumulated_counters);
+  MEM_SAFE_FREE(ctx->limit_P);
+  MEM_SAFE_FREE(ctx->limit_dPdu);
+  MEM_SAFE_FREE(ctx->limit_dPdv);
 }
 
 /** \} */
@@ -454,14 +471,37 @@ static void subdiv_mesh_tls_free(void *tls_v)
 /** \name Evaluation helper functions
  * \{ */
 
-static void eval_final_point_and_vertex_normal(Subdiv *subdiv,
+static void eval_limit_point(const SubdivMeshContext *ctx,
+                             const int ptex_face_index,
+                             const float u,
+                             const float v,
+                             const int subdiv_vertex_index,
+                             float r_P[3])
+{
+  if (ctx->limit_P != NULL) {
+    copy_v3_v3(r_P, ctx->limit_P[subdiv_vertex_index]);
+    return;
+  }
+  BKE_subdiv_eval_limit_point(ctx->subdiv, ptex_face_index, u, v, r_P);
+}
+
+static void eval_final_point_and_vertex_normal(const SubdivMeshContext *ctx,
                                                const int ptex_face_index,
                                                const float u,
                                                const float v,
+                                               const int subdiv_vertex_index,
                                                float r_P[3],
                                                short r_N[3])
 {
-  if (subdiv->displacement_evaluator == NULL) {
+  Subdiv *subdiv = ctx->subdiv;
+  if (ctx->limit_P != NULL) {
+    float N[3];
+    copy_v3_v3(r_P, ctx->limit_P[subdiv_vertex_index]);
+    cross_v3_v3v3(N, ctx->limit_dPdu[subdiv_vertex_index], ctx->limit_dPdv[subdiv_vertex_index]);
+    normalize_v3(N);
+    normal_float_to_short_v3(r_N, N);
+  }
+  else if (subdiv->displacement_evaluator == NULL) {
     BKE_subdiv_eval_limit_point_and_short_normal(subdiv, ptex_face_index, u, v, r_P, r_N);
   }
   else {
@@ -484,7 +524,15 @@ static void subdiv_accumulate_vertex_normal_and_displacement(SubdivMeshContext *
   Subdiv *subdiv = ctx->subdiv;
   const int subdiv_vertex_index = subdiv_vert - ctx->subdiv_mesh->mvert;
   float dummy_P[3], dPdu[3], dPdv[3], D[3];
-  BKE_subdiv_eval_limit_point_and_derivatives(subdiv, ptex_face_index, u, v, dummy_P, dPdu, dPdv);
+  if (ctx->limit_P != NULL) {
+    const int point_index = ctx->num_limit_vertices + ctx->limit_boundary_point_index++;
+    copy_v3_v3(dPdu, ctx->limit_dPdu[point_index]);
+    copy_v3_v3(dPdv, ctx->limit_dPdv[point_index]);
+  }
+  else {
+    BKE_subdiv_eval_limit_point_and_derivatives(
+        subdiv, ptex_face_index, u, v, dummy_P, dPdu, dPdv);
+  }
   /* Accumulate normal. */
   if (ctx->can_evaluate_normals) {
     float N[3];
@@ -585,7 +633,7 @@ static void evaluate_vertex_and_apply_displacement_copy(const SubdivMeshContext
   }
   /* Copy custom data and evaluate position. */
   subdiv_vertex_data_copy(ctx, coarse_vert, subdiv_vert);
-  BKE_subdiv_eval_limit_point(ctx->subdiv, ptex_face_index, u, v, subdiv_vert->co);
+  eval_limit_point(ctx, ptex_face_index, u, v, subdiv_vertex_index, subdiv_vert->co);
   /* Apply displacement. */
   add_v3_v3(subdiv_vert->co, D);
   /* Copy normal from accumulated storage. */
@@ -618,7 +666,7 @@ static void evaluate_vertex_and_apply_displacement_interpolate(
   }
   /* Interpolate custom data and evaluate position. */
   subdiv_vertex_data_interpolate(ctx, subdiv_vert, vertex_interpolation, u, v);
-  BKE_subdiv_eval_limit_point(ctx->subdiv, ptex_face_index, u, v, subdiv_vert->co);
+  eval_limit_point(ctx, ptex_face_index, u, v, subdiv_vertex_index, subdiv_vert->co);
   /* Apply displacement. */
   add_v3_v3(subdiv_vert->co, D);
   /* Copy normal from accumulated storage. */
@@ -783,7 +831,6 @@ static void subdiv_mesh_vertex_inner(const SubdivForeachContext *foreach_context
 {
   SubdivMeshContext *ctx = foreach_context->user_data;
   SubdivMeshTLS *tls = tls_v;
-  Subdiv *subdiv = ctx->subdiv;
   const Mesh *coarse_mesh = ctx->coarse_mesh;
   const MPoly *coarse_mpoly = coarse_mesh->mpoly;
   const MPoly *coarse_poly = &coarse_mpoly[coarse_poly_index];
@@ -793,7 +840,7 @@ static void subdiv_mesh_vertex_inner(const SubdivForeachContext *foreach_context
   subdiv_mesh_ensure_vertex_interpolation(ctx, tls, coarse_poly, coarse_corner);
   subdiv_vertex_data_interpolate(ctx, subdiv_vert, &tls->vertex_interpolation, u, v);
   eval_final_point_and_vertex_normal(
-      subdiv, ptex_face_index, u, v, subdiv_vert->co, subdiv_vert->no);
+      ctx, ptex_face_index, u, v, subdiv_vertex_index, subdiv_vert->co, subdiv_vert->no);
   subdiv_mesh_tag_center_vertex(coarse_poly, subdiv_vert, u, v);
 }
 
@@ -1188,6 +1235,505 @@ static void setup_foreach_callbacks(const SubdivMeshContext *subdiv_context,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Limit stencils
+ *
+ * Patch coordinates of all vertices are recorded once for the given topology and resolution,
+ * and converted to stencils. On the following updates positions and derivatives of all vertices
+ * are evaluated at once from the stencils, which is much cheaper than evaluating patches of every
+ * vertex separately.
+ *
+ * Building the stencils costs more than evaluating the vertices once, so they are only built when
+ * the same topology and resolution is evaluated a second time. A subdivision which is only
+ * evaluated once, like the one of the Subdivide geometry node, never builds them.
+ * \{ */
+
+typedef struct SubdivMeshLimitStencils {
+  /* Settings and coarse mesh dimensions the stencils were created for. */
+  int resolution;
+  int coarse_totvert;
+  int coarse_totedge;
+  int coarse_totloop;
+  int coarse_totpoly;
+  /* Stencils of all subdivided vertices, followed by stencils of points of every-corner and
+   * every-edge callbacks, in the order of the callbacks. NULL until the topology is evaluated
+   * again, or when the evaluator doesn't support stencils. */
+  int num_subdiv_vertices;
+  SubdivLimitStencils *stencils;
+  /* Building the stencils was attempted and failed, don't try again for this topology. */
+  bool is_unsupported;
+  /* Some of the vertices are created from loose geometry, and are not on the limit surface. */
+  bool has_loose_vertices;
+  /* Subdivided vertices which are on coarse corners and edges. Normals of those are averaged
+   * over the points in range [boundary_point_offsets[i], boundary_point_offsets[i + 1]) of
+   * boundary_points, which are indices relative to the first point after the vertices. */
+  int num_boundary_vertices;
+  int *boundary_vertices;
+  int *boundary_point_offsets;
+  int *boundary_points;
+} SubdivMeshLimitStencils;
+
+typedef struct LimitStencilsRecordContext {
+  int num_subdiv_vertices;
+  int *ptex_face_indices;
+  float (*uvs)[2];
+  int num_boundary_points;
+  int boundary_points_capacity;
+  int *boundary_ptex_face_indices;
+  float (*boundary_uvs)[2];
+  int *boundary_vertex_indices;
+} LimitStencilsRecordContext;
+
+static bool limit_stencils_record_topology_info(const SubdivForeachContext *foreach_context,
+                                                const int num_vertices,
+                                                const int UNUSED(num_edges),
+                                                const int UNUSED(num_loops),
+                                                const int UNUSED(num_polygons))
+{
+  LimitStencilsRecordContext *ctx = foreach_context->user_data;
+  ctx->num_subdiv_vertices = num_vertices;
+  ctx->ptex_face_indices = MEM_malloc_arrayN(num_vertices, sizeof(int), __func__);
+  ctx->uvs = MEM_calloc_arrayN(num_vertices, sizeof(float[2]), __func__);
+  /* Vertices which are not visited (loose ones) are not evaluated from the limit surface. */
+  for (int i = 0; i < num_vertices; i++) {
+    ctx->ptex_face_indices[i] = -1;
+  }
+  return true;
+}
+
+static void limit_stencils_record_vertex(const SubdivForeachContext *foreach_context,
+                                         const int ptex_face_index,
+                                         const float u,
+                                         const float v,
+                                         const int subdiv_vertex_index)
+{
+  LimitStencilsRecordContext *ctx = foreach_context->user_data;
+  ctx->ptex_face_indices[subdiv_vertex_index] = ptex_face_index;
+  ctx->uvs[subdiv_vertex_index][0] = u;
+  ctx->uvs[subdiv_vertex_index][1] = v;
+}
+
+static void limit_stencils_record_boundary_point(const SubdivForeachContext *foreach_context,
+                                                 const int ptex_face_index,
+                                                 const float u,
+                                                 const float v,
+                                                 const int subdiv_vertex_index)
+{
+  LimitStencilsRecordContext *ctx = foreach_context->user_data;
+  if (ctx->num_boundary_points == ctx->boundary_points_capacity) {
+    ctx->boundary_points_capacity = max_ii(1024, ctx->boundary_points_capacity * 2);
+    ctx->boundary_ptex_face_indices = MEM_reallocN(
+        ctx->boundary_ptex_face_indices, sizeof(int) * ctx->boundary_points_capacity);
+    ctx->boundary_uvs = MEM_reallocN(ctx->boundary_uvs,
+                                     sizeof(float[2]) * ctx->boundary_points_capacity);
+    ctx->boundary_vertex_indices = MEM_reallocN(ctx->boundary_vertex_indices,
+                                                sizeof(int) * ctx->boundary_points_capacity);
+  }
+  const int point_index = ctx->num_boundary_points++;
+  ctx->boundary_ptex_face_indices[point_index] = ptex_face_index;
+  ctx->boundary_uvs[point_index][0] = u;
+  ctx->boundary_uvs[point_index][1] = v;
+  ctx->boundary_vertex_indices[point_index] = subdiv_vertex_index;
+}
+
+static void limit_stencils_record_every_corner(const SubdivForeachContext *foreach_context,
+                                               void *UNUSED(tls),
+                                               const int ptex_face_index,
+                                               const float u,
+                                               const float v,
+                                               const int UNUSED(coarse_vertex_index),
+                                               const int UNUSED(coarse_poly_index),
+                                               const int UNUSED(coarse_corner),
+                                               const int subdiv_vertex_index)
+{
+  limit_stencils_record_boundary_point(
+      foreach_context, ptex_face_index, u, v, subdiv_vertex_index);
+}
+
+static void limit_stencils_record_every_edge(const SubdivForeachContext *foreach_context,
+                                             void *UNUSED(tls),
+                                             const int ptex_face_index,
+                                             const float u,
+                                             const float v,
+                                             const int UNUSED(coarse_edge_index),
+                                             const int UNUSED(coarse_poly_index),
+                                             const int UNUSED(coarse_corner),
+                                             const int subdiv_vertex_index)
+{
+  limit_stencils_record_boundary_point(
+      foreach_context, ptex_face_index, u, v, subdiv_vertex_index);
+}
+
+static void limit_stencils_record_corner_or_edge(const SubdivForeachContext *foreach_context,
+                                                 void *UNUSED(tls),
+                                                 const int ptex_face_index,
+                                                 const float u,
+                                                 const float v,
+                                                 const int UNUSED(coarse_element_index),
+                                                 const int UNUSED(coarse_poly_index),
+                                                 const int UNUSED(coarse_corner),
+                                                 const int subdiv_vertex_index)
+{
+  limit_stencils_record_vertex(foreach_context, ptex_face_index, u, v, subdiv_vertex_index);
+}
+
+static void limit_stencils_record_inner(const SubdivForeachContext *foreach_context,
+                                        void *UNUSED(tls),
+                                        const int ptex_face_index,
+                                        const float u,
+                                        const float v,
+                                        const int UNUSED(coarse_poly_index),
+                                        const int UNUSED(coarse_corner),
+                                        const int subdiv_vertex_index)
+{
+  limit_stencils_record_vertex(foreach_context, ptex_face_index, u, v, subdiv_vertex_index);
+}
+
+/* Group points of every-corner and every-edge callbacks by the vertex they belong to. */
+static void limit_stencils_group_boundary_points(SubdivMeshLimitStencils *mesh_stencils,
+                                                 const int *boundary_vertex_indices,
+                                                 const int num_boundary_points)
+{
+  const int num_subdiv_vertices = mesh_stencils->num_subdiv_vertices;
+  /* Maps subdivided vertex to its index in boundary_vertices, -1 if it is not there. */
+  int *boundary_vertex_map = MEM_malloc_arrayN(num_subdiv_vertices, sizeof(int), __func__);
+  for (int i = 0; i < num_subdiv_vertices; i++) {
+    boundary_vertex_map[i] = -1;
+  }
+  int num_boundary_vertices = 0;
+  int *boundary_vertices = MEM_malloc_arrayN(
+      max_ii(num_boundary_points, 1), sizeof(int), __func__);
+  int *offsets = MEM_calloc_arrayN(num_boundary_points + 1, sizeof(int), __func__);
+  for (int i = 0; i < num_boundary_points; i++) {
+    const int vertex_index = boundary_vertex_indices[i];
+    if (boundary_vertex_map[vertex_index] == -1) {
+      boundary_vertex_map[vertex_index] = num_boundary_vertices;
+      boundary_vertices[num_boundary_vertices++] = vertex_index;
+    }
+    offsets[boundary_vertex_map[vertex_index] + 1]++;
+  }
+  for (int i = 0; i < num_boundary_vertices; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+  int *points = MEM_malloc_arrayN(max_ii(num_boundary_points, 1), sizeof(int), __func__);
+  int *fill = MEM_dupallocN(offsets);
+  for (int i = 0; i < num_boundary_points; i++) {
+    const int boundary_vertex = boundary_vertex_map[boundary_vertex_indices[i]];
+    points[fill[boundary_vertex]++] = i;
+  }
+  MEM_freeN(fill);
+  MEM_freeN(boundary_vertex_map);
+  mesh_stencils->num_boundary_vertices = num_boundary_vertices;
+  mesh_stencils->boundary_vertices = boundary_vertices;
+  mesh_stencils->boundary_point_offsets = offsets;
+  mesh_stencils->boundary_points = points;
+}
+
+static SubdivMeshLimitStencils *limit_stencils_new(const SubdivToMeshSettings *settings,
+                                                   const Mesh *coarse_mesh)
+{
+  SubdivMeshLimitStencils *mesh_stencils = MEM_callocN(sizeof(SubdivMeshLimitStencils),
+                                                       __func__);
+  mesh_stencils->resolution = settings->resolution;
+  mesh_stencils->coarse_totvert = coarse_mesh->totvert;
+  mesh_stencils->coarse_totedge = coarse_mesh->totedge;
+  mesh_stencils->coarse_totloop = coarse_mesh->totloop;
+  mesh_stencils->coarse_totpoly = coarse_mesh->totpoly;
+  return mesh_stencils;
+}
+
+static bool limit_stencils_build(Subdiv *subdiv,
+                                 SubdivMeshLimitStencils *mesh_stencils,
+                                 const SubdivToMeshSettings *settings,
+                                 const Mesh *coarse_mesh)
+{
+  LimitStencilsRecordContext record_context = {0};
+  SubdivForeachContext foreach_context = {0};
+  foreach_context.topology_info = limit_stencils_record_topology_info;
+  foreach_context.vertex_every_corner = limit_stencils_record_every_corner;
+  foreach_context.vertex_every_edge = limit_stencils_record_every_edge;
+  foreach_context.vertex_corner = limit_stencils_record_corner_or_edge;
+  foreach_context.vertex_edge = limit_stencils_record_corner_or_edge;
+  foreach_context.vertex_inner = limit_stencils_record_inner;
+  foreach_context.user_data = &record_context;
+  BKE_subdiv_foreach_subdiv_geometry(subdiv, &foreach_context, settings, coarse_mesh);
+
+  const int num_subdiv_vertices = record_context.num_subdiv_vertices;
+  const int num_boundary_points = record_context.num_boundary_points;
+  SubdivLimitStencils *stencils = BKE_subdiv_eval_limit_stencils_new(num_subdiv_vertices +
+                                                                     num_boundary_points);
+  if (num_subdiv_vertices != 0) {
+    memcpy(stencils->ptex_face_indices,
+           record_context.ptex_face_indices,
+           sizeof(int) * num_subdiv_vertices);
+    memcpy(stencils->uvs, record_context.uvs, sizeof(float[2]) * num_subdiv_vertices);
+  }
+  if (num_boundary_points != 0) {
+    memcpy(&stencils->ptex_face_indices[num_subdiv_vertices],
+           record_context.boundary_ptex_face_indices,
+           sizeof(int) * num_boundary_points);
+    memcpy(&stencils->uvs[num_subdiv_vertices],
+           record_context.boundary_uvs,
+           sizeof(float[2]) * num_boundary_points);
+  }
+
+  const bool is_built = BKE_subdiv_eval_limit_stencils_build(subdiv, stencils);
+  if (is_built) {
+    mesh_stencils->num_subdiv_vertices = num_subdiv_vertices;
+    mesh_stencils->stencils = stencils;
+    for (int i = 0; i < num_subdiv_vertices; i++) {
+      if (record_context.ptex_face_indices[i] == -1) {
+        mesh_stencils->has_loose_vertices = true;
+        break;
+      }
+    }
+    limit_stencils_group_boundary_points(
+        mesh_stencils, record_context.boundary_vertex_indices, num_boundary_points);
+  }
+  else {
+    BKE_subdiv_eval_limit_stencils_free(stencils);
+  }
+
+  MEM_SAFE_FREE(record_context.ptex_face_indices);
+  MEM_SAFE_FREE(record_context.uvs);
+  MEM_SAFE_FREE(record_context.boundary_ptex_face_indices);
+  MEM_SAFE_FREE(record_context.boundary_uvs);
+  MEM_SAFE_FREE(record_context.boundary_vertex_indices);
+  return is_built;
+}
+
+static bool limit_stencils_match(const SubdivMeshLimitStencils *mesh_stencils,
+                                 const SubdivToMeshSettings *settings,
+                                 const Mesh *coarse_mesh)
+{
+  return mesh_stencils->resolution == settings->resolution &&
+         mesh_stencils->coarse_totvert == coarse_mesh->totvert &&
+         mesh_stencils->coarse_totedge == coarse_mesh->totedge &&
+         mesh_stencils->coarse_totloop == coarse_mesh->totloop &&
+         mesh_stencils->coarse_totpoly == coarse_mesh->totpoly;
+}
+
+/* Get stencils for the current topology and resolution, building them when it is evaluated for
+ * the second time. Returns NULL when vertices are to be evaluated one by one. */
+static const SubdivMeshLimitStencils *limit_stencils_ensure(Subdiv *subdiv,
+                                                            const SubdivToMeshSettings *settings,
+                                                            const Mesh *coarse_mesh)
+{
+  SubdivMeshLimitStencils *mesh_stencils = subdiv->cache_.mesh_limit_stencils;
+  if (mesh_stencils != NULL && !limit_stencils_match(mesh_stencils, settings, coarse_mesh)) {
+    BKE_subdiv_mesh_limit_stencils_free(mesh_stencils);
+    subdiv->cache_.mesh_limit_stencils = NULL;
+    mesh_stencils = NULL;
+  }
+  if (subdiv->evaluator == NULL) {
+    return NULL;
+  }
+  if (mesh_stencils == NULL) {
+    /* Only remember the topology, it might not be evaluated again. */
+    subdiv->cache_.mesh_limit_stencils = limit_stencils_new(settings, coarse_mesh);
+    return NULL;
+  }
+  if (mesh_stencils->stencils == NULL && !mesh_stencils->is_unsupported) {
+    mesh_stencils->is_unsupported = !limit_stencils_build(
+        subdiv, mesh_stencils, settings, coarse_mesh);
+  }
+  return mesh_stencils->stencils != NULL ? mesh_stencils : NULL;
+}
+
+static void subdiv_mesh_eval_limit_stencils(SubdivMeshContext *ctx,
+                                            const SubdivMeshLimitStencils *mesh_stencils)
+{
+  const SubdivLimitStencils *stencils = mesh_stencils->stencils;
+  const int num_points = stencils->num_points;
+  ctx->limit_P = MEM_malloc_arrayN(num_points, sizeof(float[3]), "subdiv limit P");
+  ctx->limit_dPdu = MEM_malloc_arrayN(num_points, sizeof(float[3]), "subdiv limit dPdu");
+  ctx->limit_dPdv = MEM_malloc_arrayN(num_points, sizeof(float[3]), "subdiv limit dPdv");
+  ctx->num_limit_vertices = mesh_stencils->num_subdiv_vertices;
+  ctx->limit_boundary_point_index = 0;
+  BKE_subdiv_eval_limit_stencils(ctx->subdiv,
+                                 stencils,
+                                 ctx->coarse_mesh,
+                                 NULL,
+                                 ctx->limit_P,
+                                 ctx->limit_dPdu,
+                                 ctx->limit_dPdv);
+}
+
+void BKE_subdiv_mesh_limit_stencils_free(SubdivMeshLimitStencils *mesh_stencils)
+{
+  if (mesh_stencils->stencils != NULL) {
+    BKE_subdiv_eval_limit_stencils_free(mesh_stencils->stencils);
+  }
+  MEM_SAFE_FREE(mesh_stencils->boundary_vertices);
+  MEM_SAFE_FREE(mesh_stencils->boundary_point_offsets);
+  MEM_SAFE_FREE(mesh_stencils->boundary_points);
+  MEM_freeN(mesh_stencils);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Topology cache
+ *
+ * For deforming meshes everything but positions and normals of the subdivided mesh stays the
+ * same between updates. The previous result is kept together with a key of the coarse mesh it
+ * was created from, see #BKE_mesh_runtime_data_key_new. As long as the key matches, new results
+ * share all data besides vertices with the cached mesh (including interpolated UV maps and other
+ * attributes), and only vertex positions and normals are evaluated.
+ * \{ */
+
+typedef struct SubdivMeshTopologyCache {
+  /* Settings the cached mesh was created with. */
+  int resolution;
+  bool use_optimal_display;
+  /* Key of the coarse mesh data, vertex positions and normals are ignored. */
+  struct MeshDataKey *coarse_key;
+  /* Subdivided mesh, its data is shared with results created from the cache. */
+  Mesh *subdiv_mesh;
+} SubdivMeshTopologyCache;
+
+static bool topology_cache_match(const SubdivMeshTopologyCache *cache,
+                                 const SubdivToMeshSettings *settings,
+                                 const Mesh *coarse_mesh)
+{
+  return cache->resolution == settings->resolution &&
+         cache->use_optimal_display == settings->use_optimal_display &&
+         BKE_mesh_runtime_data_key_matches(cache->coarse_key, coarse_mesh);
+}
+
+static void topology_cache_store(Subdiv *subdiv,
+                                 const SubdivToMeshSettings *settings,
+                                 const Mesh *coarse_mesh,
+                                 Mesh *subdiv_mesh)
+{
+  if (subdiv->cache_.mesh_topology != NULL) {
+    BKE_subdiv_mesh_topology_cache_free(subdiv->cache_.mesh_topology);
+    subdiv->cache_.mesh_topology = NULL;
+  }
+  /* Layers owned by the coarse mesh are freed after this update, and new ones could get the same
+   * address. Those referenced from the original mesh stay valid until it is changed, in which
+   * case the cache is cleared, see #BKE_subdiv_mesh_topology_cache_clear. */
+  struct MeshDataKey *coarse_key = BKE_mesh_runtime_data_key_new(coarse_mesh, false, false);
+  if (coarse_key == NULL) {
+    return;
+  }
+  SubdivMeshTopologyCache *cache = MEM_callocN(sizeof(SubdivMeshTopologyCache), __func__);
+  cache->resolution = settings->resolution;
+  cache->use_optimal_display = settings->use_optimal_display;
+  cache->coarse_key = coarse_key;
+  cache->subdiv_mesh = BKE_mesh_copy_for_eval_shared_topology(subdiv_mesh);
+  subdiv->cache_.mesh_topology = cache;
+}
+
+typedef struct TopologyCacheVerticesData {
+  const SubdivMeshLimitStencils *mesh_stencils;
+  const float (*limit_P)[3];
+  const float (*limit_dPdu)[3];
+  const float (*limit_dPdv)[3];
+  MVert *mvert;
+} TopologyCacheVerticesData;
+
+static void topology_cache_vertex_cb(void *__restrict userdata,
+                                     const int vertex_index,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const TopologyCacheVerticesData *data = userdata;
+  MVert *vertex = &data->mvert[vertex_index];
+  float N[3];
+  copy_v3_v3(vertex->co, data->limit_P[vertex_index]);
+  cross_v3_v3v3(N, data->limit_dPdu[vertex_index], data->limit_dPdv[vertex_index]);
+  normalize_v3(N);
+  normal_float_to_short_v3(vertex->no, N);
+}
+
+static void topology_cache_boundary_vertex_cb(void *__restrict userdata,
+                                              const int boundary_vertex_index,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const TopologyCacheVerticesData *data = userdata;
+  const SubdivMeshLimitStencils *mesh_stencils = data->mesh_stencils;
+  const int num_subdiv_vertices = mesh_stencils->num_subdiv_vertices;
+  float N_sum[3] = {0.0f, 0.0f, 0.0f};
+  for (int i = mesh_stencils->boundary_point_offsets[boundary_vertex_index];
+       i < mesh_stencils->boundary_point_offsets[boundary_vertex_index + 1];
+       i++) {
+    const int point_index = num_subdiv_vertices + mesh_stencils->boundary_points[i];
+    float N[3];
+    cross_v3_v3v3(N, data->limit_dPdu[point_index], data->limit_dPdv[point_index]);
+    normalize_v3(N);
+    add_v3_v3(N_sum, N);
+  }
+  normalize_v3(N_sum);
+  MVert *vertex = &data->mvert[mesh_stencils->boundary_vertices[boundary_vertex_index]];
+  normal_float_to_short_v3(vertex->no, N_sum);
+}
+
+/* Create subdivided mesh from the topology cache, evaluating positions and normals only.
+ * Returns NULL if the cache can not be used. */
+static Mesh *subdiv_mesh_from_topology_cache(Subdiv *subdiv,
+                                             const SubdivToMeshSettings *settings,
+                                             const Mesh *coarse_mesh,
+                                             const SubdivMeshLimitStencils *mesh_stencils)
+{
+  SubdivMeshTopologyCache *cache = subdiv->cache_.mesh_topology;
+  if (cache == NULL) {
+    return NULL;
+  }
+  if (!topology_cache_match(cache, settings, coarse_mesh)) {
+    BKE_subdiv_mesh_topology_cache_clear(subdiv);
+    return NULL;
+  }
+  const SubdivLimitStencils *stencils = mesh_stencils->stencils;
+  float(*limit_P)[3] = MEM_malloc_arrayN(stencils->num_points, sizeof(float[3]), __func__);
+  float(*limit_dPdu)[3] = MEM_malloc_arrayN(stencils->num_points, sizeof(float[3]), __func__);
+  float(*limit_dPdv)[3] = MEM_malloc_arrayN(stencils->num_points, sizeof(float[3]), __func__);
+  BKE_subdiv_eval_limit_stencils(
+      subdiv, stencils, coarse_mesh, NULL, limit_P, limit_dPdu, limit_dPdv);
+
+  Mesh *result = BKE_mesh_copy_for_eval_shared_topology(cache->subdiv_mesh);
+  BLI_assert(result->totvert == mesh_stencils->num_subdiv_vertices);
+  TopologyCacheVerticesData data = {
+      .mesh_stencils = mesh_stencils,
+      .limit_P = (const float(*)[3])limit_P,
+      .limit_dPdu = (const float(*)[3])limit_dPdu,
+      .limit_dPdv = (const float(*)[3])limit_dPdv,
+      .mvert = result->mvert,
+  };
+  TaskParallelSettings parallel_settings;
+  BLI_parallel_range_settings_defaults(&parallel_settings);
+  parallel_settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(
+      0, result->totvert, &data, topology_cache_vertex_cb, &parallel_settings);
+  /* Normals of vertices on coarse corners and edges are averaged between adjacent faces. */
+  BLI_task_parallel_range(0,
+                          mesh_stencils->num_boundary_vertices,
+                          &data,
+                          topology_cache_boundary_vertex_cb,
+                          &parallel_settings);
+
+  MEM_freeN(limit_P);
+  MEM_freeN(limit_dPdu);
+  MEM_freeN(limit_dPdv);
+  return result;
+}
+
+void BKE_subdiv_mesh_topology_cache_free(SubdivMeshTopologyCache *cache)
+{
+  BKE_mesh_runtime_data_key_free(cache->coarse_key);
+  BKE_id_free(NULL, cache->subdiv_mesh);
+  MEM_freeN(cache);
+}
+
+void BKE_subdiv_mesh_topology_cache_clear(Subdiv *subdiv)
+{
+  if (subdiv->cache_.mesh_topology != NULL) {
+    BKE_subdiv_mesh_topology_cache_free(subdiv->cache_.mesh_topology);
+    subdiv->cache_.mesh_topology = NULL;
+  }
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Public entry point
  * \{ */
@@ -1218,6 +1764,30 @@ Mesh *BKE_subdiv_to_mesh(Subdiv *subdiv,
   subdiv_context.have_displacement = (subdiv->displacement_evaluator != NULL);
   subdiv_context.can_evaluate_normals = !subdiv_context.have_displacement &&
                                         subdiv_context.subdiv->settings.is_adaptive;
+  /* Evaluate all limit points at once when there is no displacement involved. */
+  const SubdivMeshLimitStencils *mesh_stencils = NULL;
+  if (subdiv_context.can_evaluate_normals) {
+    mesh_stencils = limit_stencils_ensure(subdiv, settings, coarse_mesh);
+  }
+  /* Only positions and normals are to be evaluated when the rest of the data is unchanged.
+   * Split normals of the coarse mesh depend on its positions, so they are interpolated anew. */
+  const bool use_topology_cache = mesh_stencils != NULL && !mesh_stencils->has_loose_vertices &&
+                                  !CustomData_has_layer(&coarse_mesh->ldata, CD_NORMAL);
+  if (use_topology_cache) {
+    BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
+    Mesh *result = subdiv_mesh_from_topology_cache(subdiv, settings, coarse_mesh, mesh_stencils);
+    BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
+    if (result != NULL) {
+      BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH);
+      return result;
+    }
+  }
+  else {
+    BKE_subdiv_mesh_topology_cache_clear(subdiv);
+  }
+  if (mesh_stencils != NULL) {
+    subdiv_mesh_eval_limit_stencils(&subdiv_context, mesh_stencils);
+  }
   /* Multi-threaded traversal/evaluation. */
   BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
   SubdivForeachContext foreach_context;
@@ -1234,6 +1804,9 @@ Mesh *BKE_subdiv_to_mesh(Subdiv *subdiv,
   if (!subdiv_context.can_evaluate_normals) {
     result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
   }
+  if (use_topology_cache) {
+    topology_cache_store(subdiv, settings, coarse_mesh, result);
+  }
   /* Free used memory. */
   subdiv_mesh_context_free(&subdiv_context);
   return result;
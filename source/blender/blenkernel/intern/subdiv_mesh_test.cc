@@ -0,0 +1,257 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "testing/testing.h"
+
+#include "BLI_float3.hh"
+
+#include "BKE_customdata.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_subdiv.h"
+#include "BKE_subdiv_eval.h"
+#include "BKE_subdiv_mesh.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "opensubdiv_evaluator_capi.h"
+
+#include "tests/blenkernel_testing.hh"
+
+namespace blender::bke::tests {
+
+class SubdivMeshTest : public MeshTest {
+ public:
+  static void SetUpTestSuite()
+  {
+    MeshTest::SetUpTestSuite();
+    BKE_subdiv_init();
+  }
+
+  static void TearDownTestSuite()
+  {
+    BKE_subdiv_exit();
+    MeshTest::TearDownTestSuite();
+  }
+};
+
+static SubdivSettings adaptive_subdiv_settings()
+{
+  SubdivSettings settings = {false};
+  settings.is_simple = false;
+  settings.is_adaptive = true;
+  settings.level = 3;
+  settings.use_creases = false;
+  settings.vtx_boundary_interpolation = SUBDIV_VTX_BOUNDARY_EDGE_ONLY;
+  settings.fvar_linear_interpolation = SUBDIV_FVAR_LINEAR_INTERPOLATION_BOUNDARIES;
+  return settings;
+}
+
+static Mesh *create_bumpy_grid_mesh(const float amplitude)
+{
+  return create_grid_mesh(
+      4, [&](int x, int y) { return amplitude * (float)((x * 7 + y * 3) % 5) * 0.25f; });
+}
+
+/* Subdivide the mesh with a subdivision which is only evaluated once. */
+static Mesh *subdivide_once(const Mesh *coarse_mesh, const SubdivToMeshSettings *mesh_settings)
+{
+  const SubdivSettings settings = adaptive_subdiv_settings();
+  Subdiv *subdiv = BKE_subdiv_new_from_mesh(&settings, coarse_mesh);
+  Mesh *result = BKE_subdiv_to_mesh(subdiv, mesh_settings, coarse_mesh);
+  BKE_subdiv_free(subdiv);
+  return result;
+}
+
+static void expect_same_vertices(const Mesh *expected, const Mesh *actual)
+{
+  ASSERT_NE(expected, nullptr);
+  ASSERT_NE(actual, nullptr);
+  ASSERT_EQ(expected->totvert, actual->totvert);
+  ASSERT_EQ(expected->totpoly, actual->totpoly);
+  for (int i = 0; i < expected->totvert; i++) {
+    EXPECT_V3_NEAR(expected->mvert[i].co, actual->mvert[i].co, 1e-5f);
+    for (int j = 0; j < 3; j++) {
+      EXPECT_NEAR(expected->mvert[i].no[j], actual->mvert[i].no[j], 2);
+    }
+  }
+}
+
+/* Limit stencils are only built when a subdivision is evaluated again for the same topology,
+ * results must not depend on whether they were used. */
+TEST_F(SubdivMeshTest, limit_stencils_match_point_evaluation)
+{
+  Mesh *coarse_mesh = create_bumpy_grid_mesh(1.0f);
+  const SubdivSettings settings = adaptive_subdiv_settings();
+  Subdiv *subdiv = BKE_subdiv_new_from_mesh(&settings, coarse_mesh);
+  if (subdiv->topology_refiner == nullptr) {
+    BKE_subdiv_free(subdiv);
+    BKE_id_free(nullptr, coarse_mesh);
+    GTEST_SKIP() << "Built without OpenSubdiv";
+  }
+
+  SubdivToMeshSettings mesh_settings;
+  mesh_settings.resolution = 5;
+  mesh_settings.use_optimal_display = false;
+
+  /* First evaluation goes point by point, the following ones use stencils. */
+  Mesh *first = BKE_subdiv_to_mesh(subdiv, &mesh_settings, coarse_mesh);
+  Mesh *second = BKE_subdiv_to_mesh(subdiv, &mesh_settings, coarse_mesh);
+  expect_same_vertices(first, second);
+
+  /* Deform the coarse mesh, the stencils of the same topology are reused. */
+  Mesh *deformed_mesh = create_bumpy_grid_mesh(-2.0f);
+  Mesh *deformed = BKE_subdiv_to_mesh(subdiv, &mesh_settings, deformed_mesh);
+  Mesh *deformed_once = subdivide_once(deformed_mesh, &mesh_settings);
+  expect_same_vertices(deformed_once, deformed);
+
+  /* A different resolution starts over with point evaluation. */
+  mesh_settings.resolution = 3;
+  Mesh *lower = BKE_subdiv_to_mesh(subdiv, &mesh_settings, deformed_mesh);
+  Mesh *lower_again = BKE_subdiv_to_mesh(subdiv, &mesh_settings, deformed_mesh);
+  Mesh *lower_once = subdivide_once(deformed_mesh, &mesh_settings);
+  expect_same_vertices(lower_once, lower);
+  expect_same_vertices(lower_once, lower_again);
+
+  for (Mesh *mesh :
+       {first, second, deformed, deformed_once, lower, lower_again, lower_once, deformed_mesh}) {
+    BKE_id_free(nullptr, mesh);
+  }
+  BKE_subdiv_free(subdiv);
+  BKE_id_free(nullptr, coarse_mesh);
+}
+
+/* Deformed copy of \a mesh, which references everything else like an evaluated mesh. */
+static Mesh *copy_deformed(Mesh *mesh, const float offset)
+{
+  Mesh *copy = BKE_mesh_copy_for_eval(mesh, true);
+  copy->mvert = (MVert *)CustomData_duplicate_referenced_layer(
+      &copy->vdata, CD_MVERT, copy->totvert);
+  for (int i = 0; i < copy->totvert; i++) {
+    copy->mvert[i].co[2] += offset * (float)(i % 3);
+  }
+  return copy;
+}
+
+/* Results of coarse meshes which only differ in positions share everything else. */
+TEST_F(SubdivMeshTest, topology_cache)
+{
+  Mesh *coarse_mesh = create_bumpy_grid_mesh(1.0f);
+  const SubdivSettings settings = adaptive_subdiv_settings();
+  Subdiv *subdiv = BKE_subdiv_new_from_mesh(&settings, coarse_mesh);
+  if (subdiv->topology_refiner == nullptr) {
+    BKE_subdiv_free(subdiv);
+    BKE_id_free(nullptr, coarse_mesh);
+    GTEST_SKIP() << "Built without OpenSubdiv";
+  }
+
+  SubdivToMeshSettings mesh_settings;
+  mesh_settings.resolution = 5;
+  mesh_settings.use_optimal_display = false;
+
+  /* The second evaluation builds the stencils and stores its result. */
+  Mesh *first_coarse = copy_deformed(coarse_mesh, 0.0f);
+  Mesh *first = BKE_subdiv_to_mesh(subdiv, &mesh_settings, first_coarse);
+  Mesh *second_coarse = copy_deformed(coarse_mesh, 0.5f);
+  Mesh *second = BKE_subdiv_to_mesh(subdiv, &mesh_settings, second_coarse);
+  EXPECT_NE(second->mloop, first->mloop);
+
+  Mesh *deformed_coarse = copy_deformed(coarse_mesh, -1.0f);
+  Mesh *deformed = BKE_subdiv_to_mesh(subdiv, &mesh_settings, deformed_coarse);
+  EXPECT_EQ(deformed->mloop, second->mloop);
+  EXPECT_EQ(deformed->mpoly, second->mpoly);
+  EXPECT_NE(deformed->mvert, second->mvert);
+  Mesh *deformed_once = subdivide_once(deformed_coarse, &mesh_settings);
+  expect_same_vertices(deformed_once, deformed);
+
+  /* Changing other data of the coarse mesh makes the cache invalid. */
+  Mesh *material_coarse = copy_deformed(coarse_mesh, -1.0f);
+  material_coarse->mpoly = (MPoly *)CustomData_duplicate_referenced_layer(
+      &material_coarse->pdata, CD_MPOLY, material_coarse->totpoly);
+  material_coarse->mpoly[0].mat_nr = 1;
+  Mesh *material = BKE_subdiv_to_mesh(subdiv, &mesh_settings, material_coarse);
+  EXPECT_NE(material->mpoly, second->mpoly);
+  EXPECT_EQ(material->mpoly[0].mat_nr, 1);
+  expect_same_vertices(deformed_once, material);
+
+  /* Coarse meshes owning their data are not cached, it could be reallocated at the same address
+   * with different contents. */
+  Mesh *owned = BKE_subdiv_to_mesh(subdiv, &mesh_settings, coarse_mesh);
+  Mesh *owned_again = BKE_subdiv_to_mesh(subdiv, &mesh_settings, coarse_mesh);
+  EXPECT_NE(owned_again->mloop, owned->mloop);
+
+  for (Mesh *mesh : {first,
+                     first_coarse,
+                     second,
+                     second_coarse,
+                     deformed,
+                     deformed_coarse,
+                     deformed_once,
+                     material,
+                     material_coarse,
+                     owned,
+                     owned_again}) {
+    BKE_id_free(nullptr, mesh);
+  }
+  BKE_subdiv_free(subdiv);
+  BKE_id_free(nullptr, coarse_mesh);
+}
+
+/* The sparse product over coarse positions does not depend on OpenSubdiv, so it is tested with
+ * hand-made weights of a single quad. */
+TEST_F(SubdivMeshTest, limit_stencils_evaluate_weights)
+{
+  Mesh *mesh = create_grid_mesh(1);
+
+  int offsets[] = {0, 4, 7};
+  int indices[] = {0, 1, 2, 3, 3, 1, 2};
+  float weights[] = {0.25f, 0.25f, 0.25f, 0.25f, 1.0f, 0.0f, 0.0f};
+  float du_weights[] = {-0.5f, 0.5f, -0.5f, 0.5f, 1.0f, -1.0f, 0.0f};
+  float dv_weights[] = {-0.5f, -0.5f, 0.5f, 0.5f, 1.0f, 0.0f, -1.0f};
+  OpenSubdiv_LimitStencils opensubdiv_stencils = {
+      2, offsets, indices, weights, du_weights, dv_weights};
+
+  SubdivLimitStencils *stencils = BKE_subdiv_eval_limit_stencils_new(2);
+  for (int i = 0; i < 2; i++) {
+    stencils->ptex_face_indices[i] = 0;
+    stencils->uvs[i][0] = stencils->uvs[i][1] = (float)i;
+  }
+  stencils->opensubdiv_stencils = &opensubdiv_stencils;
+
+  /* Not used as long as no derivative is degenerate. */
+  Subdiv subdiv = {};
+  float P[2][3], dPdu[2][3], dPdv[2][3];
+  BKE_subdiv_eval_limit_stencils(&subdiv, stencils, mesh, nullptr, P, dPdu, dPdv);
+  EXPECT_V3_NEAR(P[0], float3(0.5f, 0.5f, 0.0f), 1e-6f);
+  EXPECT_V3_NEAR(dPdu[0], float3(1.0f, 0.0f, 0.0f), 1e-6f);
+  EXPECT_V3_NEAR(dPdv[0], float3(0.0f, 1.0f, 0.0f), 1e-6f);
+  EXPECT_V3_NEAR(P[1], float3(1.0f, 1.0f, 0.0f), 1e-6f);
+  EXPECT_V3_NEAR(dPdu[1], float3(0.0f, 1.0f, 0.0f), 1e-6f);
+  EXPECT_V3_NEAR(dPdv[1], float3(1.0f, 0.0f, 0.0f), 1e-6f);
+
+  /* Deformed positions replace the ones of the mesh. */
+  const float coarse_vertex_cos[4][3] = {{0, 0, 2}, {1, 0, 2}, {0, 1, 2}, {1, 1, 6}};
+  BKE_subdiv_eval_limit_stencils(&subdiv, stencils, mesh, coarse_vertex_cos, P, dPdu, dPdv);
+  EXPECT_V3_NEAR(P[0], float3(0.5f, 0.5f, 3.0f), 1e-6f);
+  EXPECT_V3_NEAR(P[1], float3(1.0f, 1.0f, 6.0f), 1e-6f);
+  EXPECT_V3_NEAR(dPdu[1], float3(0.0f, 1.0f, 4.0f), 1e-6f);
+
+  stencils->opensubdiv_stencils = nullptr;
+  BKE_subdiv_eval_limit_stencils_free(stencils);
+  BKE_id_free(nullptr, mesh);
+}
+
+}  // namespace blender::bke::tests
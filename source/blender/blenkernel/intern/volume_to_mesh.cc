@@ -14,10 +14,9 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
-#include <vector>
-
-#include "BLI_float3.hh"
+#include "BLI_array.hh"
 #include "BLI_span.hh"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 
 #include "DNA_mesh_types.h"
@@ -41,11 +40,8 @@ namespace blender::bke {
 struct VolumeToMeshOp {
   const openvdb::GridBase &base_grid;
   const VolumeToMeshResolution resolution;
-  const float threshold;
-  const float adaptivity;
-  std::vector<openvdb::Vec3s> verts;
-  std::vector<openvdb::Vec3I> tris;
-  std::vector<openvdb::Vec4I> quads;
+  openvdb::tools::VolumeToMesh &mesher;
+  openvdb::Vec3s offset{0.0f};
 
   template<typename GridType> bool operator()()
   {
@@ -110,53 +106,100 @@ struct VolumeToMeshOp {
 
   template<typename GridType> void grid_to_mesh(const GridType &grid)
   {
-    openvdb::tools::volumeToMesh(
-        grid, this->verts, this->tris, this->quads, this->threshold, this->adaptivity);
+    /* Run the mesher directly instead of going through #openvdb::tools::volumeToMesh, which would
+     * copy the whole result into intermediate vectors before it is copied into the mesh again. The
+     * mesher itself is already multi-threaded over the leaf nodes of the grid. */
+    this->mesher(grid);
 
     /* Better align generated mesh with volume (see T85312). */
-    openvdb::Vec3s offset = grid.voxelSize() / 2.0f;
-    for (openvdb::Vec3s &position : this->verts) {
-      position += offset;
-    }
+    this->offset = grid.voxelSize() / 2.0f;
   }
 };
 
-static Mesh *new_mesh_from_openvdb_data(Span<openvdb::Vec3s> verts,
-                                        Span<openvdb::Vec3I> tris,
-                                        Span<openvdb::Vec4I> quads)
+/**
+ * Copy the mesher output into a new mesh. The polygon pools of the mesher are counted first to
+ * find the destination offsets of every pool, then all pools are written to the mesh in parallel.
+ * Every buffer of the mesher is freed as soon as it has been copied, so that peak memory usage
+ * stays close to the size of the output mesh.
+ */
+static Mesh *new_mesh_from_openvdb_mesher(openvdb::tools::VolumeToMesh &mesher,
+                                          const openvdb::Vec3s &offset)
 {
-  const int tot_loops = 3 * tris.size() + 4 * quads.size();
-  const int tot_polys = tris.size() + quads.size();
+  const int pools_num = mesher.polygonPoolListSize();
+  openvdb::tools::PolygonPoolList &pools = mesher.polygonPoolList();
+
+  /* Count pass: accumulate the triangle and quad offsets of every pool. All triangles are stored
+   * before all quads in the mesh. */
+  Array<int> tri_offsets(pools_num + 1);
+  Array<int> quad_offsets(pools_num + 1);
+  tri_offsets[0] = 0;
+  quad_offsets[0] = 0;
+  for (const int i : IndexRange(pools_num)) {
+    tri_offsets[i + 1] = tri_offsets[i] + pools[i].numTriangles();
+    quad_offsets[i + 1] = quad_offsets[i] + pools[i].numQuads();
+  }
+  const int tot_tris = tri_offsets.last();
+  const int tot_quads = quad_offsets.last();
 
-  Mesh *mesh = BKE_mesh_new_nomain(verts.size(), 0, 0, tot_loops, tot_polys);
+  const int tot_verts = mesher.pointListSize();
+  const int tot_loops = 3 * tot_tris + 4 * tot_quads;
+  const int tot_polys = tot_tris + tot_quads;
 
-  /* Write vertices. */
-  for (const int i : verts.index_range()) {
-    const blender::float3 co = blender::float3(verts[i].asV());
-    copy_v3_v3(mesh->mvert[i].co, co);
-  }
+  Mesh *mesh = BKE_mesh_new_nomain(tot_verts, 0, 0, tot_loops, tot_polys);
+  MutableSpan<MVert> mverts{mesh->mvert, mesh->totvert};
+  MutableSpan<MLoop> mloops{mesh->mloop, mesh->totloop};
+  MutableSpan<MPoly> mpolys{mesh->mpoly, mesh->totpoly};
 
-  /* Write triangles. */
-  for (const int i : tris.index_range()) {
-    mesh->mpoly[i].loopstart = 3 * i;
-    mesh->mpoly[i].totloop = 3;
-    for (int j = 0; j < 3; j++) {
-      /* Reverse vertex order to get correct normals. */
-      mesh->mloop[3 * i + j].v = tris[i][2 - j];
+  /* Write vertices. */
+  const openvdb::Vec3s *points = mesher.pointList().get();
+  parallel_for(mverts.index_range(), 4096, [&](IndexRange range) {
+    for (const int i : range) {
+      const openvdb::Vec3s co = points[i] + offset;
+      copy_v3_v3(mverts[i].co, co.asV());
     }
-  }
-
-  /* Write quads. */
-  const int poly_offset = tris.size();
-  const int loop_offset = tris.size() * 3;
-  for (const int i : quads.index_range()) {
-    mesh->mpoly[poly_offset + i].loopstart = loop_offset + 4 * i;
-    mesh->mpoly[poly_offset + i].totloop = 4;
-    for (int j = 0; j < 4; j++) {
-      /* Reverse vertex order to get correct normals. */
-      mesh->mloop[loop_offset + 4 * i + j].v = quads[i][3 - j];
+  });
+  mesher.pointList().reset();
+
+  /* Fill pass: every pool writes to its own disjoint range of polygons and loops. */
+  const int quad_poly_offset = tot_tris;
+  const int quad_loop_offset = 3 * tot_tris;
+  parallel_for(IndexRange(pools_num), 16, [&](IndexRange range) {
+    for (const int pool_index : range) {
+      openvdb::tools::PolygonPool &pool = pools[pool_index];
+
+      /* Write triangles. */
+      const int tri_start = tri_offsets[pool_index];
+      for (const int i : IndexRange(pool.numTriangles())) {
+        const int poly_index = tri_start + i;
+        const int loopstart = 3 * poly_index;
+        mpolys[poly_index].loopstart = loopstart;
+        mpolys[poly_index].totloop = 3;
+        const openvdb::Vec3I &tri = pool.triangle(i);
+        for (int j = 0; j < 3; j++) {
+          /* Reverse vertex order to get correct normals. */
+          mloops[loopstart + j].v = tri[2 - j];
+        }
+      }
+
+      /* Write quads. */
+      const int quad_start = quad_offsets[pool_index];
+      for (const int i : IndexRange(pool.numQuads())) {
+        const int poly_index = quad_poly_offset + quad_start + i;
+        const int loopstart = quad_loop_offset + 4 * (quad_start + i);
+        mpolys[poly_index].loopstart = loopstart;
+        mpolys[poly_index].totloop = 4;
+        const openvdb::Vec4I &quad = pool.quad(i);
+        for (int j = 0; j < 4; j++) {
+          /* Reverse vertex order to get correct normals. */
+          mloops[loopstart + j].v = quad[3 - j];
+        }
+      }
+
+      pool.clearTriangles();
+      pool.clearQuads();
     }
-  }
+  });
+  mesher.polygonPoolList().reset();
 
   BKE_mesh_calc_edges(mesh, false, false);
   BKE_mesh_calc_normals(mesh);
@@ -170,12 +213,13 @@ Mesh *volume_to_mesh(const openvdb::GridBase &grid,
 {
   const VolumeGridType grid_type = BKE_volume_grid_type_openvdb(grid);
 
-  VolumeToMeshOp to_mesh_op{grid, resolution, threshold, adaptivity};
+  openvdb::tools::VolumeToMesh mesher{threshold, adaptivity};
+  VolumeToMeshOp to_mesh_op{grid, resolution, mesher};
   if (!BKE_volume_grid_type_operation(grid_type, to_mesh_op)) {
     return nullptr;
   }
 
-  return new_mesh_from_openvdb_data(to_mesh_op.verts, to_mesh_op.tris, to_mesh_op.quads);
+  return new_mesh_from_openvdb_mesher(mesher, to_mesh_op.offset);
 }
 
 #endif /* WITH_OPENVDB */
@@ -0,0 +1,82 @@
+/* Apache License, Version 2.0 */
+
+#include "blenkernel_testing.hh"
+
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "CLG_log.h"
+
+#include "bmesh.h"
+
+namespace blender::bke::tests {
+
+void MeshTest::SetUpTestSuite()
+{
+  CLG_init();
+  BKE_idtype_init();
+}
+
+void MeshTest::TearDownTestSuite()
+{
+  CLG_exit();
+}
+
+Mesh *create_grid_mesh(const int resolution, GridHeightFn height_fn)
+{
+  const int verts_per_side = resolution + 1;
+  const int polys_num = resolution * resolution;
+  Mesh *mesh = BKE_mesh_new_nomain(
+      verts_per_side * verts_per_side, 0, 0, polys_num * 4, polys_num);
+
+  for (int y = 0; y < verts_per_side; y++) {
+    for (int x = 0; x < verts_per_side; x++) {
+      float *co = mesh->mvert[y * verts_per_side + x].co;
+      co[0] = (float)x;
+      co[1] = (float)y;
+      co[2] = height_fn ? height_fn(x, y) : 0.0f;
+    }
+  }
+  for (int y = 0; y < resolution; y++) {
+    for (int x = 0; x < resolution; x++) {
+      const int poly_index = y * resolution + x;
+      const int v = y * verts_per_side + x;
+      const int quad[4] = {v, v + 1, v + verts_per_side + 1, v + verts_per_side};
+      MPoly &poly = mesh->mpoly[poly_index];
+      poly.loopstart = poly_index * 4;
+      poly.totloop = 4;
+      for (int i = 0; i < 4; i++) {
+        mesh->mloop[poly.loopstart + i].v = quad[i];
+      }
+    }
+  }
+
+  BKE_mesh_calc_edges(mesh, false, false);
+  BKE_mesh_calc_normals(mesh);
+  return mesh;
+}
+
+BMesh *bmesh_from_mesh(const Mesh *mesh)
+{
+  BMeshCreateParams create_params = {0};
+  BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default, &create_params);
+  BMeshFromMeshParams from_params = {0};
+  from_params.calc_face_normal = true;
+  BM_mesh_bm_from_me(bm, mesh, &from_params);
+  BM_mesh_normals_update(bm);
+  return bm;
+}
+
+BMesh *create_grid_bmesh(const int resolution, GridHeightFn height_fn)
+{
+  Mesh *mesh = create_grid_mesh(resolution, height_fn);
+  BMesh *bm = bmesh_from_mesh(mesh);
+  BKE_id_free(nullptr, mesh);
+  return bm;
+}
+
+}  // namespace blender::bke::tests
@@ -0,0 +1,47 @@
+/* Apache License, Version 2.0 */
+
+#pragma once
+
+#include "testing/testing.h"
+
+#include "BLI_function_ref.hh"
+
+struct BMesh;
+struct Mesh;
+
+namespace blender::bke::tests {
+
+/* Test class that initializes just enough of Blender to create and free meshes.
+ *
+ * Usage:
+ *   TEST_F(MeshTest, my_mesh_test) {
+ *     ...
+ *   }
+ */
+class MeshTest : public ::testing::Test {
+ public:
+  static void SetUpTestSuite();
+  static void TearDownTestSuite();
+};
+
+/* Height of the grid vertex at the given row and column. */
+using GridHeightFn = FunctionRef<float(int x, int y)>;
+
+/**
+ * Create a `resolution` by `resolution` grid of quads in the XY plane, with a vertex at every
+ * integer coordinate. Vertices and polygons are ordered row by row, the loops of every polygon
+ * start at its lowest vertex. Edges and normals are calculated.
+ */
+Mesh *create_grid_mesh(int resolution, GridHeightFn height_fn = {});
+
+/**
+ * Convert a mesh to a BMesh like edit-mode does, with the face and vertex normals calculated.
+ */
+BMesh *bmesh_from_mesh(const Mesh *mesh);
+
+/**
+ * Create a BMesh of the grid from #create_grid_mesh.
+ */
+BMesh *create_grid_bmesh(int resolution, GridHeightFn height_fn = {});
+
+}  // namespace blender::bke::tests
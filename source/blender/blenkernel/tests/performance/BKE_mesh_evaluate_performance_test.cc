@@ -0,0 +1,153 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_geom.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_mesh.h"
+
+#include "DNA_meshdata_types.h"
+
+#include "PIL_time.h"
+
+#define NUM_RUN_AVERAGED 10
+
+/* Polygon arrays of a grid, without any Mesh ID so that only the evaluation code gets timed. */
+struct PolyGrid {
+  MVert *mverts;
+  MLoop *mloops;
+  MPoly *mpolys;
+  int verts_num;
+  int loops_num;
+  int polys_num;
+};
+
+/* Create a `resolution` by `resolution` grid of quads, or of twice as many triangles. */
+static PolyGrid poly_grid_create(const int resolution, const bool use_triangles)
+{
+  const int verts_per_side = resolution + 1;
+  const int corners = use_triangles ? 3 : 4;
+  PolyGrid grid;
+  grid.verts_num = verts_per_side * verts_per_side;
+  grid.polys_num = resolution * resolution * (use_triangles ? 2 : 1);
+  grid.loops_num = grid.polys_num * corners;
+  grid.mverts = (MVert *)MEM_calloc_arrayN(grid.verts_num, sizeof(MVert), __func__);
+  grid.mloops = (MLoop *)MEM_calloc_arrayN(grid.loops_num, sizeof(MLoop), __func__);
+  grid.mpolys = (MPoly *)MEM_calloc_arrayN(grid.polys_num, sizeof(MPoly), __func__);
+
+  for (int y = 0; y < verts_per_side; y++) {
+    for (int x = 0; x < verts_per_side; x++) {
+      float *co = grid.mverts[y * verts_per_side + x].co;
+      co[0] = (float)x;
+      co[1] = (float)y;
+      co[2] = sinf((float)x * 0.1f) * cosf((float)y * 0.1f);
+    }
+  }
+
+  int poly_index = 0;
+  for (int y = 0; y < resolution; y++) {
+    for (int x = 0; x < resolution; x++) {
+      const uint v = (uint)(y * verts_per_side + x);
+      const uint quad[4] = {v, v + 1, v + (uint)verts_per_side + 1, v + (uint)verts_per_side};
+      const uint tris[2][3] = {{quad[0], quad[1], quad[2]}, {quad[0], quad[2], quad[3]}};
+      for (int i = 0; i < (use_triangles ? 2 : 1); i++, poly_index++) {
+        MPoly *mp = &grid.mpolys[poly_index];
+        mp->loopstart = poly_index * corners;
+        mp->totloop = corners;
+        for (int j = 0; j < corners; j++) {
+          grid.mloops[mp->loopstart + j].v = use_triangles ? tris[i][j] : quad[j];
+        }
+      }
+    }
+  }
+  return grid;
+}
+
+static void poly_grid_free(PolyGrid *grid)
+{
+  MEM_freeN(grid->mverts);
+  MEM_freeN(grid->mloops);
+  MEM_freeN(grid->mpolys);
+}
+
+static void print_throughput(const char *id,
+                             const char *type,
+                             const int polys_num,
+                             const double time)
+{
+  printf("%s (%s): %d polygons in %f seconds: %.2f million polygons/s\n",
+         id,
+         type,
+         polys_num,
+         time,
+         (double)polys_num / time * 1e-6);
+}
+
+static void mesh_evaluate_performance(const bool use_triangles)
+{
+  PolyGrid grid = poly_grid_create(use_triangles ? 700 : 1000, use_triangles);
+  const char *type = use_triangles ? "triangles" : "quads";
+
+  float(*poly_normals)[3] = (float(*)[3])MEM_malloc_arrayN(
+      grid.polys_num, sizeof(*poly_normals), __func__);
+  MLoopTri *looptris = (MLoopTri *)MEM_malloc_arrayN(
+      poly_to_tri_count(grid.polys_num, grid.loops_num), sizeof(MLoopTri), __func__);
+
+  double time = PIL_check_seconds_timer();
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    BKE_mesh_calc_normals_poly(grid.mverts,
+                               nullptr,
+                               grid.verts_num,
+                               grid.mloops,
+                               grid.mpolys,
+                               grid.loops_num,
+                               grid.polys_num,
+                               poly_normals,
+                               true);
+  }
+  time = (PIL_check_seconds_timer() - time) / NUM_RUN_AVERAGED;
+  print_throughput("Polygon normals", type, grid.polys_num, time);
+
+  time = PIL_check_seconds_timer();
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    BKE_mesh_calc_normals_poly(grid.mverts,
+                               nullptr,
+                               grid.verts_num,
+                               grid.mloops,
+                               grid.mpolys,
+                               grid.loops_num,
+                               grid.polys_num,
+                               poly_normals,
+                               false);
+  }
+  time = (PIL_check_seconds_timer() - time) / NUM_RUN_AVERAGED;
+  print_throughput("Polygon and vertex normals", type, grid.polys_num, time);
+
+  time = PIL_check_seconds_timer();
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    BKE_mesh_recalc_looptri(
+        grid.mloops, grid.mpolys, grid.mverts, grid.loops_num, grid.polys_num, looptris);
+  }
+  time = (PIL_check_seconds_timer() - time) / NUM_RUN_AVERAGED;
+  print_throughput("Loop triangles", type, grid.polys_num, time);
+
+  MEM_freeN(looptris);
+  MEM_freeN(poly_normals);
+  poly_grid_free(&grid);
+}
+
+TEST(mesh_evaluate, Quads)
+{
+  mesh_evaluate_performance(false);
+}
+
+TEST(mesh_evaluate, Triangles)
+{
+  mesh_evaluate_performance(true);
+}
@@ -0,0 +1,47 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ * \brief Compact storage of the differences between two versions of an array of 32 bit words.
+ */
+
+#include "BLI_compiler_attrs.h"
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+unsigned int BLI_delta_codec_encode(const unsigned int before, const unsigned int after);
+unsigned int BLI_delta_codec_apply(const unsigned int value,
+                                   const unsigned int code,
+                                   const bool reverse);
+
+unsigned char *BLI_delta_codec_compress(const unsigned int *codes,
+                                        const size_t codes_len,
+                                        size_t *r_data_len) ATTR_WARN_UNUSED_RESULT
+    ATTR_NONNULL(3);
+bool BLI_delta_codec_decompress(const unsigned char *data,
+                                const size_t data_len,
+                                unsigned int *codes,
+                                const size_t codes_len) ATTR_WARN_UNUSED_RESULT;
+
+#ifdef __cplusplus
+}
+#endif
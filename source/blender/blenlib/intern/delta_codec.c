@@ -0,0 +1,164 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ *
+ * The difference between two words is taken on their bits, which restores the values exactly in
+ * both directions, even for floats. For nearby values it is a small integer, so the bytes of all
+ * differences are stored in planes (all the lowest bytes first) with runs of zeros collapsed.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_delta_codec.h"
+#include "BLI_utildefines.h"
+
+#include "BLI_strict_flags.h"
+
+/* Longest run of zeros or literal bytes behind a single control byte. */
+#define DELTA_CODEC_RUN_MAX 128
+
+/**
+ * Code for the difference from `before` to `after`.
+ */
+uint BLI_delta_codec_encode(const uint before, const uint after)
+{
+  /* Zig-zag encoding, so that small negative differences also have their high bytes cleared. */
+  const int diff = (int)(after - before);
+  return ((uint)diff << 1) ^ (uint)(diff >> 31);
+}
+
+/**
+ * Apply the difference of `code` to `value`, or remove it when `reverse` is set.
+ */
+uint BLI_delta_codec_apply(const uint value, const uint code, const bool reverse)
+{
+  const uint diff = (code >> 1) ^ (uint)(-(int)(code & 1));
+  return reverse ? value - diff : value + diff;
+}
+
+/**
+ * Compress the codes of #BLI_delta_codec_encode.
+ *
+ * \return The compressed data, NULL for empty input.
+ */
+uchar *BLI_delta_codec_compress(const uint *codes, const size_t codes_len, size_t *r_data_len)
+{
+  if (codes_len == 0) {
+    *r_data_len = 0;
+    return NULL;
+  }
+
+  const size_t bytes_len = codes_len * sizeof(uint);
+  uchar *planes = MEM_mallocN(bytes_len, __func__);
+  for (uint plane = 0; plane < 4; plane++) {
+    uchar *plane_bytes = planes + plane * codes_len;
+    for (size_t i = 0; i < codes_len; i++) {
+      plane_bytes[i] = (uchar)(codes[i] >> (plane * 8));
+    }
+  }
+
+  /* Control bytes with the high bit set are followed by nothing and stand for a run of zeros,
+   * otherwise they are followed by a run of literal bytes. */
+  const size_t data_len_max = bytes_len + bytes_len / DELTA_CODEC_RUN_MAX + 2;
+  uchar *data = MEM_mallocN(data_len_max, __func__);
+  size_t data_len = 0;
+
+  size_t i = 0;
+  while (i < bytes_len) {
+    size_t count = 1;
+    if (planes[i] == 0) {
+      while (i + count < bytes_len && count < DELTA_CODEC_RUN_MAX && planes[i + count] == 0) {
+        count++;
+      }
+      data[data_len++] = (uchar)(0x80 | (count - 1));
+    }
+    else {
+      /* Single zeros are cheaper to keep in the literal run. */
+      while (i + count < bytes_len && count < DELTA_CODEC_RUN_MAX &&
+             !(planes[i + count] == 0 && i + count + 1 < bytes_len &&
+               planes[i + count + 1] == 0)) {
+        count++;
+      }
+      data[data_len++] = (uchar)(count - 1);
+      memcpy(data + data_len, planes + i, count);
+      data_len += count;
+    }
+    i += count;
+  }
+  BLI_assert(data_len <= data_len_max);
+
+  MEM_freeN(planes);
+
+  *r_data_len = data_len;
+  return MEM_reallocN(data, data_len);
+}
+
+/**
+ * Decompress the data of #BLI_delta_codec_compress into `codes`.
+ *
+ * \return false when the data doesn't hold exactly `codes_len` codes, `codes` is then left in an
+ * undefined state.
+ */
+bool BLI_delta_codec_decompress(const uchar *data,
+                                const size_t data_len,
+                                uint *codes,
+                                const size_t codes_len)
+{
+  if (codes_len == 0 || data_len == 0) {
+    return codes_len == 0 && data_len == 0;
+  }
+
+  const size_t bytes_len = codes_len * sizeof(uint);
+  uchar *planes = MEM_mallocN(bytes_len, __func__);
+
+  bool valid = true;
+  size_t len = 0;
+  for (size_t i = 0; i < data_len;) {
+    const uchar control = data[i++];
+    const size_t count = (size_t)(control & 0x7f) + 1;
+    if (len + count > bytes_len) {
+      valid = false;
+      break;
+    }
+    if (control & 0x80) {
+      memset(planes + len, 0, count);
+    }
+    else {
+      if (i + count > data_len) {
+        valid = false;
+        break;
+      }
+      memcpy(planes + len, data + i, count);
+      i += count;
+    }
+    len += count;
+  }
+
+  valid &= (len == bytes_len);
+  if (valid) {
+    for (size_t j = 0; j < codes_len; j++) {
+      codes[j] = (uint)planes[j] | ((uint)planes[codes_len + j] << 8) |
+                 ((uint)planes[2 * codes_len + j] << 16) | ((uint)planes[3 * codes_len + j] << 24);
+    }
+  }
+
+  MEM_freeN(planes);
+  return valid;
+}
@@ -0,0 +1,113 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_delta_codec.h"
+#include "BLI_vector.hh"
+
+namespace blender::tests {
+
+static Vector<uint> delta_codes(Span<uint> before, Span<uint> after)
+{
+  Vector<uint> codes;
+  for (const int i : before.index_range()) {
+    codes.append(BLI_delta_codec_encode(before[i], after[i]));
+  }
+  return codes;
+}
+
+static Vector<uint> delta_round_trip(Span<uint> codes)
+{
+  size_t data_len;
+  uchar *data = BLI_delta_codec_compress(codes.data(), codes.size(), &data_len);
+  Vector<uint> result(codes.size(), 0u);
+  EXPECT_TRUE(BLI_delta_codec_decompress(data, data_len, result.data(), result.size()));
+  MEM_SAFE_FREE(data);
+  return result;
+}
+
+TEST(delta_codec, Empty)
+{
+  size_t data_len = 1;
+  uchar *data = BLI_delta_codec_compress(nullptr, 0, &data_len);
+  EXPECT_EQ(data, nullptr);
+  EXPECT_EQ(data_len, 0);
+  EXPECT_TRUE(BLI_delta_codec_decompress(nullptr, 0, nullptr, 0));
+}
+
+TEST(delta_codec, Unchanged)
+{
+  Vector<uint> values;
+  for (const int i : IndexRange(1000)) {
+    values.append((uint)i * 2654435761u);
+  }
+  Vector<uint> codes = delta_codes(values, values);
+  for (const uint code : codes) {
+    EXPECT_EQ(code, 0u);
+  }
+
+  size_t data_len;
+  uchar *data = BLI_delta_codec_compress(codes.data(), codes.size(), &data_len);
+  /* Only runs of zeros, one control byte for every #DELTA_CODEC_RUN_MAX bytes. */
+  EXPECT_EQ(data_len, codes.size() * sizeof(uint) / 128 + 1);
+  MEM_freeN(data);
+
+  EXPECT_EQ_ARRAY(codes.data(), delta_round_trip(codes).data(), codes.size());
+}
+
+TEST(delta_codec, FullyChanged)
+{
+  Vector<float> before, after;
+  for (const int i : IndexRange(1000)) {
+    before.append((float)i * 0.37f - 100.0f);
+    after.append(i % 3 ? before[i] + 1e-4f : -before[i] * 3.0f);
+  }
+  Span<uint> before_bits((const uint *)before.data(), before.size());
+  Span<uint> after_bits((const uint *)after.data(), after.size());
+
+  Vector<uint> codes = delta_round_trip(delta_codes(before_bits, after_bits));
+  for (const int i : before.index_range()) {
+    /* Exact in both directions. */
+    EXPECT_EQ(BLI_delta_codec_apply(before_bits[i], codes[i], false), after_bits[i]);
+    EXPECT_EQ(BLI_delta_codec_apply(after_bits[i], codes[i], true), before_bits[i]);
+  }
+
+  /* Extreme differences. */
+  Vector<uint> extremes = {0u, 1u, 0x7fffffffu, 0x80000000u, 0xffffffffu};
+  for (const uint a : extremes) {
+    for (const uint b : extremes) {
+      const uint code = BLI_delta_codec_encode(a, b);
+      EXPECT_EQ(BLI_delta_codec_apply(a, code, false), b);
+      EXPECT_EQ(BLI_delta_codec_apply(b, code, true), a);
+    }
+  }
+}
+
+TEST(delta_codec, MismatchedSize)
+{
+  Vector<uint> codes;
+  for (const int i : IndexRange(300)) {
+    codes.append(i % 5 ? 0u : (uint)i * 1000003u);
+  }
+  size_t data_len;
+  uchar *data = BLI_delta_codec_compress(codes.data(), codes.size(), &data_len);
+
+  Vector<uint> smaller(codes.size() - 1, 0u);
+  Vector<uint> larger(codes.size() + 1, 0u);
+  EXPECT_FALSE(BLI_delta_codec_decompress(data, data_len, smaller.data(), smaller.size()));
+  EXPECT_FALSE(BLI_delta_codec_decompress(data, data_len, larger.data(), larger.size()));
+  EXPECT_FALSE(BLI_delta_codec_decompress(data, data_len, nullptr, 0));
+  EXPECT_FALSE(BLI_delta_codec_decompress(nullptr, 0, larger.data(), larger.size()));
+
+  /* Truncated data. */
+  Vector<uint> result(codes.size(), 0u);
+  EXPECT_FALSE(BLI_delta_codec_decompress(data, data_len - 1, result.data(), result.size()));
+  EXPECT_TRUE(BLI_delta_codec_decompress(data, data_len, result.data(), result.size()));
+  EXPECT_EQ_ARRAY(codes.data(), result.data(), codes.size());
+
+  MEM_freeN(data);
+}
+
+}  // namespace blender::tests
@@ -31,7 +31,6 @@
 
 #include "MEM_guardedalloc.h"
 
-#include "BLI_ghash.h"
 #include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_mempool.h"
@@ -48,24 +47,23 @@
 struct BMLogEntry {
   struct BMLogEntry *next, *prev;
 
-  /* The following GHashes map from an element ID to one of the log
-   * types above */
+  /* The following pools hold the log records (types below) of the
+   * elements changed by this entry, every record stores the ID of its
+   * element. The pools are the only allocations of an entry, freeing
+   * them releases all of its records at once. */
 
   /* Elements that were in the previous entry, but have been
    * deleted */
-  GHash *deleted_verts;
-  GHash *deleted_faces;
+  BLI_mempool *deleted_verts;
+  BLI_mempool *deleted_faces;
   /* Elements that were not in the previous entry, but are in the
    * result of this entry */
-  GHash *added_verts;
-  GHash *added_faces;
+  BLI_mempool *added_verts;
+  BLI_mempool *added_faces;
 
   /* Vertices whose coordinates, mask value, or hflag have changed */
-  GHash *modified_verts;
-  GHash *modified_faces;
-
-  BLI_mempool *pool_verts;
-  BLI_mempool *pool_faces;
+  BLI_mempool *modified_verts;
+  BLI_mempool *modified_faces;
 
   /* This is only needed for dropping BMLogEntries while still in
    * dynamic-topology mode, as that should release vert/face IDs
@@ -77,6 +75,14 @@ struct BMLogEntry {
   BMLog *log;
 };
 
+typedef struct BMLogIdSlot {
+  /* The vertex or face with this ID */
+  void *elem;
+  /* The record of the element in the lookup entry of the log, for
+   * vertices in any of its pools, for faces only if added */
+  void *record;
+} BMLogIdSlot;
+
 struct BMLog {
   /* Tree of free IDs */
   struct RangeTreeUInt *unused_ids;
@@ -89,9 +95,16 @@ struct BMLog {
    *
    * The ID is needed because element pointers will change as they
    * are created and deleted.
+   *
+   * The range tree always hands out the lowest free ID, so the IDs
+   * stay dense and are used directly as indices in this array. The
+   * ID of each element is stored in a custom data layer of the
+   * BMesh, at the offsets below.
    */
-  GHash *id_to_elem;
-  GHash *elem_to_id;
+  BMLogIdSlot *ids;
+  uint ids_len;
+  int cd_vert_id_offset;
+  int cd_face_id_offset;
 
   /* All BMLogEntrys, ordered from earliest to most recent */
   ListBase entries;
@@ -105,72 +118,162 @@ struct BMLog {
    * entries have been applied (i.e. there is nothing left to redo.)
    */
   BMLogEntry *current_entry;
+
+  /* The entry whose records are referenced by the ID slots, only
+   * brought in sync with the current entry when changes are logged
+   * so undo and redo don't pay for it */
+  BMLogEntry *lookup_entry;
+};
+
+/* Which pool of its entry a BMLogVert is in */
+enum {
+  BM_LOG_VERT_ADDED = 1,
+  BM_LOG_VERT_MODIFIED = 2,
+  BM_LOG_VERT_DELETED = 3,
 };
 
 typedef struct {
+  uint id;
   float co[3];
   short no[3];
   char hflag;
+  char pool;
   float mask;
 } BMLogVert;
 
 typedef struct {
+  uint id;
   uint v_ids[3];
   char hflag;
 } BMLogFace;
 
+/* Records are allocated in chunks of this many elements */
+#define BM_LOG_POOL_CHUNK 512
+
+/* Name of the layers storing the element IDs */
+#define BM_LOG_ID_LAYER_NAME "_bm_log_id"
+
 /************************* Get/set element IDs ************************/
 
-/* bypass actual hashing, the keys don't overlap */
-#define logkey_hash BLI_ghashutil_inthash_p_simple
-#define logkey_cmp BLI_ghashutil_intcmp
+/* Ensure the ID slots array can be indexed with all IDs below id_len */
+static void bm_log_ids_reserve(BMLog *log, const uint ids_len)
+{
+  if (ids_len > log->ids_len) {
+    const uint ids_len_new = MAX2(ids_len, log->ids_len * 2);
+    log->ids = MEM_recallocN(log->ids, sizeof(*log->ids) * ids_len_new);
+    log->ids_len = ids_len_new;
+  }
+}
 
 /* Get the vertex's unique ID from the log */
 static uint bm_log_vert_id_get(BMLog *log, BMVert *v)
 {
-  BLI_assert(BLI_ghash_haskey(log->elem_to_id, v));
-  return POINTER_AS_UINT(BLI_ghash_lookup(log->elem_to_id, v));
+  const uint id = (uint)BM_ELEM_CD_GET_INT(v, log->cd_vert_id_offset);
+  BLI_assert(id < log->ids_len && log->ids[id].elem == v);
+  return id;
 }
 
 /* Set the vertex's unique ID in the log */
 static void bm_log_vert_id_set(BMLog *log, BMVert *v, uint id)
 {
-  void *vid = POINTER_FROM_UINT(id);
-
-  BLI_ghash_reinsert(log->id_to_elem, vid, v, NULL, NULL);
-  BLI_ghash_reinsert(log->elem_to_id, v, vid, NULL, NULL);
+  bm_log_ids_reserve(log, id + 1);
+  log->ids[id].elem = v;
+  BM_ELEM_CD_SET_INT(v, log->cd_vert_id_offset, (int)id);
 }
 
 /* Get a vertex from its unique ID */
 static BMVert *bm_log_vert_from_id(BMLog *log, uint id)
 {
-  void *key = POINTER_FROM_UINT(id);
-  BLI_assert(BLI_ghash_haskey(log->id_to_elem, key));
-  return BLI_ghash_lookup(log->id_to_elem, key);
+  BLI_assert(id < log->ids_len && log->ids[id].elem != NULL);
+  return log->ids[id].elem;
 }
 
 /* Get the face's unique ID from the log */
 static uint bm_log_face_id_get(BMLog *log, BMFace *f)
 {
-  BLI_assert(BLI_ghash_haskey(log->elem_to_id, f));
-  return POINTER_AS_UINT(BLI_ghash_lookup(log->elem_to_id, f));
+  const uint id = (uint)BM_ELEM_CD_GET_INT(f, log->cd_face_id_offset);
+  BLI_assert(id < log->ids_len && log->ids[id].elem == f);
+  return id;
 }
 
 /* Set the face's unique ID in the log */
 static void bm_log_face_id_set(BMLog *log, BMFace *f, uint id)
 {
-  void *fid = POINTER_FROM_UINT(id);
-
-  BLI_ghash_reinsert(log->id_to_elem, fid, f, NULL, NULL);
-  BLI_ghash_reinsert(log->elem_to_id, f, fid, NULL, NULL);
+  bm_log_ids_reserve(log, id + 1);
+  log->ids[id].elem = f;
+  BM_ELEM_CD_SET_INT(f, log->cd_face_id_offset, (int)id);
 }
 
 /* Get a face from its unique ID */
 static BMFace *bm_log_face_from_id(BMLog *log, uint id)
 {
-  void *key = POINTER_FROM_UINT(id);
-  BLI_assert(BLI_ghash_haskey(log->id_to_elem, key));
-  return BLI_ghash_lookup(log->id_to_elem, key);
+  BLI_assert(id < log->ids_len && log->ids[id].elem != NULL);
+  return log->ids[id].elem;
+}
+
+/* Get the offset of the layer storing element IDs, adding it if needed
+ *
+ * The layer is temporary so it isn't copied to the Mesh */
+static int bm_log_id_layer_ensure(BMesh *bm, CustomData *data)
+{
+  int layer_index = CustomData_get_named_layer_index(data, CD_PROP_INT32, BM_LOG_ID_LAYER_NAME);
+  if (layer_index == -1) {
+    BM_data_layer_add_named(bm, data, CD_PROP_INT32, BM_LOG_ID_LAYER_NAME);
+    layer_index = CustomData_get_named_layer_index(data, CD_PROP_INT32, BM_LOG_ID_LAYER_NAME);
+  }
+  data->layers[layer_index].flag |= CD_FLAG_TEMPORARY;
+  return data->layers[layer_index].offset;
+}
+
+static void bm_log_id_layers_ensure(BMesh *bm, BMLog *log)
+{
+  log->cd_vert_id_offset = bm_log_id_layer_ensure(bm, &bm->vdata);
+  log->cd_face_id_offset = bm_log_id_layer_ensure(bm, &bm->pdata);
+}
+
+/* Point the ID slots to the records of the entry in the given
+ * pool, or clear them */
+static void bm_log_lookup_fill(BMLog *log, BLI_mempool *pool, const bool use_records)
+{
+  BLI_mempool_iter iter;
+  uint *record;
+
+  BLI_mempool_iternew(pool, &iter);
+  while ((record = BLI_mempool_iterstep(&iter))) {
+    /* Both record types start with the ID */
+    const uint id = *record;
+    bm_log_ids_reserve(log, id + 1);
+    log->ids[id].record = use_records ? record : NULL;
+  }
+}
+
+static void bm_log_lookup_fill_entry(BMLog *log, BMLogEntry *entry, const bool use_records)
+{
+  bm_log_lookup_fill(log, entry->added_verts, use_records);
+  bm_log_lookup_fill(log, entry->modified_verts, use_records);
+  bm_log_lookup_fill(log, entry->deleted_verts, use_records);
+  bm_log_lookup_fill(log, entry->added_faces, use_records);
+}
+
+/* Make the ID slots reference the records of the current entry */
+static void bm_log_lookup_ensure(BMLog *log)
+{
+  if (log->lookup_entry != log->current_entry) {
+    if (log->lookup_entry) {
+      bm_log_lookup_fill_entry(log, log->lookup_entry, false);
+    }
+    if (log->current_entry) {
+      bm_log_lookup_fill_entry(log, log->current_entry, true);
+    }
+    log->lookup_entry = log->current_entry;
+  }
+}
+
+/* Get the record of a vertex in the current entry, if any */
+static BMLogVert *bm_log_vert_record(BMLog *log, uint id)
+{
+  BLI_assert(log->lookup_entry == log->current_entry);
+  return log->ids[id].record;
 }
 
 /************************ BMLogVert / BMLogFace ***********************/
@@ -205,22 +308,31 @@ static void bm_log_vert_bmvert_copy(BMLogVert *lv, BMVert *v, const int cd_vert_
   lv->hflag = v->head.hflag;
 }
 
-/* Allocate and initialize a BMLogVert */
-static BMLogVert *bm_log_vert_alloc(BMLog *log, BMVert *v, const int cd_vert_mask_offset)
+/* Allocate and initialize a BMLogVert in one of the pools of the
+ * current entry */
+static BMLogVert *bm_log_vert_alloc(
+    BMLog *log, BMVert *v, const int cd_vert_mask_offset, const uint v_id, const char pool)
 {
   BMLogEntry *entry = log->current_entry;
-  BMLogVert *lv = BLI_mempool_alloc(entry->pool_verts);
-
+  BLI_mempool *vert_pools[] = {
+      [BM_LOG_VERT_ADDED] = entry->added_verts,
+      [BM_LOG_VERT_MODIFIED] = entry->modified_verts,
+      [BM_LOG_VERT_DELETED] = entry->deleted_verts,
+  };
+  BMLogVert *lv = BLI_mempool_alloc(vert_pools[pool]);
+
+  lv->id = v_id;
+  lv->pool = pool;
   bm_log_vert_bmvert_copy(lv, v, cd_vert_mask_offset);
 
   return lv;
 }
 
-/* Allocate and initialize a BMLogFace */
-static BMLogFace *bm_log_face_alloc(BMLog *log, BMFace *f)
+/* Allocate and initialize a BMLogFace in one of the pools of the
+ * current entry */
+static BMLogFace *bm_log_face_alloc(BMLog *log, BMFace *f, const uint f_id, BLI_mempool *pool)
 {
-  BMLogEntry *entry = log->current_entry;
-  BMLogFace *lf = BLI_mempool_alloc(entry->pool_faces);
+  BMLogFace *lf = BLI_mempool_alloc(pool);
   BMVert *v[3];
 
   BLI_assert(f->len == 3);
@@ -228,6 +340,7 @@ static BMLogFace *bm_log_face_alloc(BMLog *log, BMFace *f)
   // BM_iter_as_array(NULL, BM_VERTS_OF_FACE, f, (void **)v, 3);
   BM_face_as_array_vert_tri(f, v);
 
+  lf->id = f_id;
   lf->v_ids[0] = bm_log_vert_id_get(log, v[0]);
   lf->v_ids[1] = bm_log_vert_id_get(log, v[1]);
   lf->v_ids[2] = bm_log_vert_id_get(log, v[2]);
@@ -238,32 +351,32 @@ static BMLogFace *bm_log_face_alloc(BMLog *log, BMFace *f)
 
 /************************ Helpers for undo/redo ***********************/
 
-static void bm_log_verts_unmake(BMesh *bm, BMLog *log, GHash *verts)
+static void bm_log_verts_unmake(BMesh *bm, BMLog *log, BLI_mempool *verts)
 {
   const int cd_vert_mask_offset = CustomData_get_offset(&bm->vdata, CD_PAINT_MASK);
 
-  GHashIterator gh_iter;
-  GHASH_ITER (gh_iter, verts) {
-    void *key = BLI_ghashIterator_getKey(&gh_iter);
-    BMLogVert *lv = BLI_ghashIterator_getValue(&gh_iter);
-    uint id = POINTER_AS_UINT(key);
-    BMVert *v = bm_log_vert_from_id(log, id);
+  BLI_mempool_iter iter;
+  BMLogVert *lv;
+  BLI_mempool_iternew(verts, &iter);
+  while ((lv = BLI_mempool_iterstep(&iter))) {
+    BMVert *v = bm_log_vert_from_id(log, lv->id);
 
     /* Ensure the log has the final values of the vertex before
      * deleting it */
     bm_log_vert_bmvert_copy(lv, v, cd_vert_mask_offset);
 
     BM_vert_kill(bm, v);
+    log->ids[lv->id].elem = NULL;
   }
 }
 
-static void bm_log_faces_unmake(BMesh *bm, BMLog *log, GHash *faces)
+static void bm_log_faces_unmake(BMesh *bm, BMLog *log, BLI_mempool *faces)
 {
-  GHashIterator gh_iter;
-  GHASH_ITER (gh_iter, faces) {
-    void *key = BLI_ghashIterator_getKey(&gh_iter);
-    uint id = POINTER_AS_UINT(key);
-    BMFace *f = bm_log_face_from_id(log, id);
+  BLI_mempool_iter iter;
+  BMLogFace *lf;
+  BLI_mempool_iternew(faces, &iter);
+  while ((lf = BLI_mempool_iterstep(&iter))) {
+    BMFace *f = bm_log_face_from_id(log, lf->id);
     BMEdge *e_tri[3];
     BMLoop *l_iter;
     int i;
@@ -275,6 +388,7 @@ static void bm_log_faces_unmake(BMesh *bm, BMLog *log, GHash *faces)
 
     /* Remove any unused edges */
     BM_face_kill(bm, f);
+    log->ids[lf->id].elem = NULL;
     for (i = 0; i < 3; i++) {
       if (BM_edge_is_wire(e_tri[i])) {
         BM_edge_kill(bm, e_tri[i]);
@@ -283,28 +397,28 @@ static void bm_log_faces_unmake(BMesh *bm, BMLog *log, GHash *faces)
   }
 }
 
-static void bm_log_verts_restore(BMesh *bm, BMLog *log, GHash *verts)
+static void bm_log_verts_restore(BMesh *bm, BMLog *log, BLI_mempool *verts)
 {
   const int cd_vert_mask_offset = CustomData_get_offset(&bm->vdata, CD_PAINT_MASK);
 
-  GHashIterator gh_iter;
-  GHASH_ITER (gh_iter, verts) {
-    void *key = BLI_ghashIterator_getKey(&gh_iter);
-    BMLogVert *lv = BLI_ghashIterator_getValue(&gh_iter);
+  BLI_mempool_iter iter;
+  BMLogVert *lv;
+  BLI_mempool_iternew(verts, &iter);
+  while ((lv = BLI_mempool_iterstep(&iter))) {
     BMVert *v = BM_vert_create(bm, lv->co, NULL, BM_CREATE_NOP);
     vert_mask_set(v, lv->mask, cd_vert_mask_offset);
     v->head.hflag = lv->hflag;
     normal_short_to_float_v3(v->no, lv->no);
-    bm_log_vert_id_set(log, v, POINTER_AS_UINT(key));
+    bm_log_vert_id_set(log, v, lv->id);
   }
 }
 
-static void bm_log_faces_restore(BMesh *bm, BMLog *log, GHash *faces)
+static void bm_log_faces_restore(BMesh *bm, BMLog *log, BLI_mempool *faces)
 {
-  GHashIterator gh_iter;
-  GHASH_ITER (gh_iter, faces) {
-    void *key = BLI_ghashIterator_getKey(&gh_iter);
-    BMLogFace *lf = BLI_ghashIterator_getValue(&gh_iter);
+  BLI_mempool_iter iter;
+  BMLogFace *lf;
+  BLI_mempool_iternew(faces, &iter);
+  while ((lf = BLI_mempool_iterstep(&iter))) {
     BMVert *v[3] = {
         bm_log_vert_from_id(log, lf->v_ids[0]),
         bm_log_vert_from_id(log, lf->v_ids[1]),
@@ -314,20 +428,19 @@ static void bm_log_faces_restore(BMesh *bm, BMLog *log, GHash *faces)
 
     f = BM_face_create_verts(bm, v, 3, NULL, BM_CREATE_NOP, true);
     f->head.hflag = lf->hflag;
-    bm_log_face_id_set(log, f, POINTER_AS_UINT(key));
+    bm_log_face_id_set(log, f, lf->id);
   }
 }
 
-static void bm_log_vert_values_swap(BMesh *bm, BMLog *log, GHash *verts)
+static void bm_log_vert_values_swap(BMesh *bm, BMLog *log, BLI_mempool *verts)
 {
   const int cd_vert_mask_offset = CustomData_get_offset(&bm->vdata, CD_PAINT_MASK);
 
-  GHashIterator gh_iter;
-  GHASH_ITER (gh_iter, verts) {
-    void *key = BLI_ghashIterator_getKey(&gh_iter);
-    BMLogVert *lv = BLI_ghashIterator_getValue(&gh_iter);
-    uint id = POINTER_AS_UINT(key);
-    BMVert *v = bm_log_vert_from_id(log, id);
+  BLI_mempool_iter iter;
+  BMLogVert *lv;
+  BLI_mempool_iternew(verts, &iter);
+  while ((lv = BLI_mempool_iterstep(&iter))) {
+    BMVert *v = bm_log_vert_from_id(log, lv->id);
     float mask;
     short normal[3];
 
@@ -342,14 +455,13 @@ static void bm_log_vert_values_swap(BMesh *bm, BMLog *log, GHash *verts)
   }
 }
 
-static void bm_log_face_values_swap(BMLog *log, GHash *faces)
+static void bm_log_face_values_swap(BMLog *log, BLI_mempool *faces)
 {
-  GHashIterator gh_iter;
-  GHASH_ITER (gh_iter, faces) {
-    void *key = BLI_ghashIterator_getKey(&gh_iter);
-    BMLogFace *lf = BLI_ghashIterator_getValue(&gh_iter);
-    uint id = POINTER_AS_UINT(key);
-    BMFace *f = bm_log_face_from_id(log, id);
+  BLI_mempool_iter iter;
+  BMLogFace *lf;
+  BLI_mempool_iternew(faces, &iter);
+  while ((lf = BLI_mempool_iterstep(&iter))) {
+    BMFace *f = bm_log_face_from_id(log, lf->id);
 
     SWAP(char, f->head.hflag, lf->hflag);
   }
@@ -381,16 +493,19 @@ static void bm_log_assign_ids(BMesh *bm, BMLog *log)
 static BMLogEntry *bm_log_entry_create(void)
 {
   BMLogEntry *entry = MEM_callocN(sizeof(BMLogEntry), __func__);
-
-  entry->deleted_verts = BLI_ghash_new(logkey_hash, logkey_cmp, __func__);
-  entry->deleted_faces = BLI_ghash_new(logkey_hash, logkey_cmp, __func__);
-  entry->added_verts = BLI_ghash_new(logkey_hash, logkey_cmp, __func__);
-  entry->added_faces = BLI_ghash_new(logkey_hash, logkey_cmp, __func__);
-  entry->modified_verts = BLI_ghash_new(logkey_hash, logkey_cmp, __func__);
-  entry->modified_faces = BLI_ghash_new(logkey_hash, logkey_cmp, __func__);
-
-  entry->pool_verts = BLI_mempool_create(sizeof(BMLogVert), 0, 64, BLI_MEMPOOL_NOP);
-  entry->pool_faces = BLI_mempool_create(sizeof(BMLogFace), 0, 64, BLI_MEMPOOL_NOP);
+  const int vert_size = sizeof(BMLogVert), face_size = sizeof(BMLogFace);
+
+  /* Pools only allocate their first chunk when used */
+  entry->deleted_verts = BLI_mempool_create(
+      vert_size, 0, BM_LOG_POOL_CHUNK, BLI_MEMPOOL_ALLOW_ITER);
+  entry->deleted_faces = BLI_mempool_create(
+      face_size, 0, BM_LOG_POOL_CHUNK, BLI_MEMPOOL_ALLOW_ITER);
+  entry->added_verts = BLI_mempool_create(vert_size, 0, BM_LOG_POOL_CHUNK, BLI_MEMPOOL_ALLOW_ITER);
+  entry->added_faces = BLI_mempool_create(face_size, 0, BM_LOG_POOL_CHUNK, BLI_MEMPOOL_ALLOW_ITER);
+  entry->modified_verts = BLI_mempool_create(
+      vert_size, 0, BM_LOG_POOL_CHUNK, BLI_MEMPOOL_ALLOW_ITER);
+  entry->modified_faces = BLI_mempool_create(
+      face_size, 0, BM_LOG_POOL_CHUNK, BLI_MEMPOOL_ALLOW_ITER);
 
   return entry;
 }
@@ -400,34 +515,35 @@ static BMLogEntry *bm_log_entry_create(void)
  * Note: does not free the log entry itself */
 static void bm_log_entry_free(BMLogEntry *entry)
 {
-  BLI_ghash_free(entry->deleted_verts, NULL, NULL);
-  BLI_ghash_free(entry->deleted_faces, NULL, NULL);
-  BLI_ghash_free(entry->added_verts, NULL, NULL);
-  BLI_ghash_free(entry->added_faces, NULL, NULL);
-  BLI_ghash_free(entry->modified_verts, NULL, NULL);
-  BLI_ghash_free(entry->modified_faces, NULL, NULL);
-
-  BLI_mempool_destroy(entry->pool_verts);
-  BLI_mempool_destroy(entry->pool_faces);
+  BLI_mempool_destroy(entry->deleted_verts);
+  BLI_mempool_destroy(entry->deleted_faces);
+  BLI_mempool_destroy(entry->added_verts);
+  BLI_mempool_destroy(entry->added_faces);
+  BLI_mempool_destroy(entry->modified_verts);
+  BLI_mempool_destroy(entry->modified_faces);
 }
 
-static void bm_log_id_ghash_retake(RangeTreeUInt *unused_ids, GHash *id_ghash)
+static void bm_log_id_pool_retake(RangeTreeUInt *unused_ids, BLI_mempool *pool)
 {
-  GHashIterator gh_iter;
-
-  GHASH_ITER (gh_iter, id_ghash) {
-    void *key = BLI_ghashIterator_getKey(&gh_iter);
-    uint id = POINTER_AS_UINT(key);
+  BLI_mempool_iter iter;
+  const uint *record;
 
-    range_tree_uint_retake(unused_ids, id);
+  BLI_mempool_iternew(pool, &iter);
+  while ((record = BLI_mempool_iterstep(&iter))) {
+    range_tree_uint_retake(unused_ids, *record);
   }
 }
 
-static int uint_compare(const void *a_v, const void *b_v)
+typedef struct BMLogIdIndex {
+  uint id;
+  uint index;
+} BMLogIdIndex;
+
+static int bm_log_id_index_compare(const void *a_v, const void *b_v)
 {
-  const uint *a = a_v;
-  const uint *b = b_v;
-  return (*a) < (*b);
+  const BMLogIdIndex *a = a_v;
+  const BMLogIdIndex *b = b_v;
+  return (a->id > b->id) - (a->id < b->id);
 }
 
 /* Remap IDs to contiguous indices
@@ -437,46 +553,53 @@ static int uint_compare(const void *a_v, const void *b_v)
  *    1 -> 0
  *   10 -> 3
  *    3 -> 1
+ *
+ * The IDs are replaced by their indices in place.
  */
-static GHash *bm_log_compress_ids_to_indices(uint *ids, uint totid)
+static void bm_log_compress_ids_to_indices(uint *ids, uint totid)
 {
-  GHash *map = BLI_ghash_int_new_ex(__func__, totid);
+  BMLogIdIndex *id_index = MEM_mallocN(sizeof(*id_index) * totid, __func__);
   uint i;
 
-  qsort(ids, totid, sizeof(*ids), uint_compare);
+  for (i = 0; i < totid; i++) {
+    id_index[i].id = ids[i];
+    id_index[i].index = i;
+  }
+
+  qsort(id_index, totid, sizeof(*id_index), bm_log_id_index_compare);
 
   for (i = 0; i < totid; i++) {
-    void *key = POINTER_FROM_UINT(ids[i]);
-    void *val = POINTER_FROM_UINT(i);
-    BLI_ghash_insert(map, key, val);
+    ids[id_index[i].index] = i;
   }
 
-  return map;
+  MEM_freeN(id_index);
 }
 
-/* Release all ID keys in id_ghash */
-static void bm_log_id_ghash_release(BMLog *log, GHash *id_ghash)
+/* Release all ID keys in the pool */
+static void bm_log_id_pool_release(BMLog *log, BLI_mempool *pool)
 {
-  GHashIterator gh_iter;
+  BLI_mempool_iter iter;
+  const uint *record;
 
-  GHASH_ITER (gh_iter, id_ghash) {
-    void *key = BLI_ghashIterator_getKey(&gh_iter);
-    uint id = POINTER_AS_UINT(key);
-    range_tree_uint_release(log->unused_ids, id);
+  BLI_mempool_iternew(pool, &iter);
+  while ((record = BLI_mempool_iterstep(&iter))) {
+    range_tree_uint_release(log->unused_ids, *record);
   }
 }
 
 /***************************** Public API *****************************/
 
-/* Allocate, initialize, and assign a new BMLog */
+/* Allocate, initialize, and assign a new BMLog
+ *
+ * Adds the layers storing element IDs to the BMesh, custom data
+ * offsets of layers added before may change. */
 BMLog *BM_log_create(BMesh *bm)
 {
   BMLog *log = MEM_callocN(sizeof(*log), __func__);
-  const uint reserve_num = (uint)(bm->totvert + bm->totface);
 
   log->unused_ids = range_tree_uint_alloc(0, (uint)-1);
-  log->id_to_elem = BLI_ghash_new_ex(logkey_hash, logkey_cmp, __func__, reserve_num);
-  log->elem_to_id = BLI_ghash_ptr_new_ex(__func__, reserve_num);
+  bm_log_ids_reserve(log, (uint)(bm->totvert + bm->totface));
+  bm_log_id_layers_ensure(bm, log);
 
   /* Assign IDs to all existing vertices and faces */
   bm_log_assign_ids(bm, log);
@@ -489,20 +612,25 @@ void BM_log_cleanup_entry(BMLogEntry *entry)
   BMLog *log = entry->log;
 
   if (log) {
+    if (log->lookup_entry == entry) {
+      bm_log_lookup_fill_entry(log, entry, false);
+      log->lookup_entry = NULL;
+    }
+
     /* Take all used IDs */
-    bm_log_id_ghash_retake(log->unused_ids, entry->deleted_verts);
-    bm_log_id_ghash_retake(log->unused_ids, entry->deleted_faces);
-    bm_log_id_ghash_retake(log->unused_ids, entry->added_verts);
-    bm_log_id_ghash_retake(log->unused_ids, entry->added_faces);
-    bm_log_id_ghash_retake(log->unused_ids, entry->modified_verts);
-    bm_log_id_ghash_retake(log->unused_ids, entry->modified_faces);
+    bm_log_id_pool_retake(log->unused_ids, entry->deleted_verts);
+    bm_log_id_pool_retake(log->unused_ids, entry->deleted_faces);
+    bm_log_id_pool_retake(log->unused_ids, entry->added_verts);
+    bm_log_id_pool_retake(log->unused_ids, entry->added_faces);
+    bm_log_id_pool_retake(log->unused_ids, entry->modified_verts);
+    bm_log_id_pool_retake(log->unused_ids, entry->modified_faces);
 
     /* delete entries to avoid releasing ids in node cleanup */
-    BLI_ghash_clear(entry->deleted_verts, NULL, NULL);
-    BLI_ghash_clear(entry->deleted_faces, NULL, NULL);
-    BLI_ghash_clear(entry->added_verts, NULL, NULL);
-    BLI_ghash_clear(entry->added_faces, NULL, NULL);
-    BLI_ghash_clear(entry->modified_verts, NULL, NULL);
+    BLI_mempool_clear(entry->deleted_verts);
+    BLI_mempool_clear(entry->deleted_faces);
+    BLI_mempool_clear(entry->added_verts);
+    BLI_mempool_clear(entry->added_faces);
+    BLI_mempool_clear(entry->modified_verts);
   }
 }
 
@@ -512,7 +640,7 @@ void BM_log_cleanup_entry(BMLogEntry *entry)
  * will be followed back to find the first entry.
  *
  * The unused IDs field of the log will be initialized by taking all
- * keys from all GHashes in the log entry.
+ * keys from all pools in the log entry.
  */
 BMLog *BM_log_from_existing_entries_create(BMesh *bm, BMLogEntry *entry)
 {
@@ -544,12 +672,12 @@ BMLog *BM_log_from_existing_entries_create(BMesh *bm, BMLogEntry *entry)
     entry->log = log;
 
     /* Take all used IDs */
-    bm_log_id_ghash_retake(log->unused_ids, entry->deleted_verts);
-    bm_log_id_ghash_retake(log->unused_ids, entry->deleted_faces);
-    bm_log_id_ghash_retake(log->unused_ids, entry->added_verts);
-    bm_log_id_ghash_retake(log->unused_ids, entry->added_faces);
-    bm_log_id_ghash_retake(log->unused_ids, entry->modified_verts);
-    bm_log_id_ghash_retake(log->unused_ids, entry->modified_faces);
+    bm_log_id_pool_retake(log->unused_ids, entry->deleted_verts);
+    bm_log_id_pool_retake(log->unused_ids, entry->deleted_faces);
+    bm_log_id_pool_retake(log->unused_ids, entry->added_verts);
+    bm_log_id_pool_retake(log->unused_ids, entry->added_faces);
+    bm_log_id_pool_retake(log->unused_ids, entry->modified_verts);
+    bm_log_id_pool_retake(log->unused_ids, entry->modified_faces);
   }
 
   return log;
@@ -564,13 +692,7 @@ void BM_log_free(BMLog *log)
     range_tree_uint_free(log->unused_ids);
   }
 
-  if (log->id_to_elem) {
-    BLI_ghash_free(log->id_to_elem, NULL, NULL);
-  }
-
-  if (log->elem_to_id) {
-    BLI_ghash_free(log->elem_to_id, NULL, NULL);
-  }
+  MEM_SAFE_FREE(log->ids);
 
   /* Clear the BMLog references within each entry, but do not free
    * the entries themselves */
@@ -593,8 +715,6 @@ void BM_log_mesh_elems_reorder(BMesh *bm, BMLog *log)
   uint *varr;
   uint *farr;
 
-  GHash *id_to_idx;
-
   BMIter bm_iter;
   BMVert *v;
   BMFace *f;
@@ -613,30 +733,23 @@ void BM_log_mesh_elems_reorder(BMesh *bm, BMLog *log)
     farr[i] = bm_log_face_id_get(log, f);
   }
 
-  /* Create BMVert index remap array */
-  id_to_idx = bm_log_compress_ids_to_indices(varr, (uint)bm->totvert);
-  BM_ITER_MESH_INDEX (v, &bm_iter, bm, BM_VERTS_OF_MESH, i) {
-    const uint id = bm_log_vert_id_get(log, v);
-    const void *key = POINTER_FROM_UINT(id);
-    const void *val = BLI_ghash_lookup(id_to_idx, key);
-    varr[i] = POINTER_AS_UINT(val);
-  }
-  BLI_ghash_free(id_to_idx, NULL, NULL);
-
-  /* Create BMFace index remap array */
-  id_to_idx = bm_log_compress_ids_to_indices(farr, (uint)bm->totface);
-  BM_ITER_MESH_INDEX (f, &bm_iter, bm, BM_FACES_OF_MESH, i) {
-    const uint id = bm_log_face_id_get(log, f);
-    const void *key = POINTER_FROM_UINT(id);
-    const void *val = BLI_ghash_lookup(id_to_idx, key);
-    farr[i] = POINTER_AS_UINT(val);
-  }
-  BLI_ghash_free(id_to_idx, NULL, NULL);
+  /* Create BMVert and BMFace index remap arrays */
+  bm_log_compress_ids_to_indices(varr, (uint)bm->totvert);
+  bm_log_compress_ids_to_indices(farr, (uint)bm->totface);
 
   BM_mesh_remap(bm, varr, NULL, farr);
 
   MEM_freeN(varr);
   MEM_freeN(farr);
+
+  /* Remapping moves the elements, their IDs move along in the custom
+   * data but the mapping from IDs has to be updated */
+  BM_ITER_MESH (v, &bm_iter, bm, BM_VERTS_OF_MESH) {
+    log->ids[BM_ELEM_CD_GET_INT(v, log->cd_vert_id_offset)].elem = v;
+  }
+  BM_ITER_MESH (f, &bm_iter, bm, BM_FACES_OF_MESH) {
+    log->ids[BM_ELEM_CD_GET_INT(f, log->cd_face_id_offset)].elem = f;
+  }
 }
 
 /* Start a new log entry and update the log entry list
@@ -673,6 +786,10 @@ BMLogEntry *BM_log_entry_add(BMLog *log)
   entry->log = log;
   log->current_entry = entry;
 
+  /* Changes are logged to the new entry from now on, possibly from
+   * multiple threads, get the lookup in sync before that. */
+  bm_log_lookup_ensure(log);
+
   return entry;
 }
 
@@ -728,16 +845,16 @@ void BM_log_entry_drop(BMLogEntry *entry)
      * Also, design wise, a first entry should not have any deleted vertices since it
      * should not have anything to delete them -from-
      */
-    // bm_log_id_ghash_release(log, entry->deleted_faces);
-    // bm_log_id_ghash_release(log, entry->deleted_verts);
+    // bm_log_id_pool_release(log, entry->deleted_faces);
+    // bm_log_id_pool_release(log, entry->deleted_verts);
   }
   else if (!entry->next) {
     /* Release IDs of elements that are added by this entry. Since
      * the entry is at the end of the undo stack, and it's being
      * deleted, those elements can never be restored. Their IDs
      * can go back into the pool. */
-    bm_log_id_ghash_release(log, entry->added_faces);
-    bm_log_id_ghash_release(log, entry->added_verts);
+    bm_log_id_pool_release(log, entry->added_faces);
+    bm_log_id_pool_release(log, entry->added_verts);
   }
   else {
     BLI_assert(!"Cannot drop BMLogEntry from middle");
@@ -746,6 +863,10 @@ void BM_log_entry_drop(BMLogEntry *entry)
   if (log->current_entry == entry) {
     log->current_entry = entry->prev;
   }
+  if (log->lookup_entry == entry) {
+    bm_log_lookup_fill_entry(log, entry, false);
+    log->lookup_entry = NULL;
+  }
 
   bm_log_entry_free(entry);
   BLI_freelinkN(&log->entries, entry);
@@ -761,6 +882,8 @@ void BM_log_undo(BMesh *bm, BMLog *log)
   if (entry) {
     log->current_entry = entry->prev;
 
+    bm_log_id_layers_ensure(bm, log);
+
     /* Delete added faces and verts */
     bm_log_faces_unmake(bm, log, entry->added_faces);
     bm_log_verts_unmake(bm, log, entry->added_verts);
@@ -798,6 +921,8 @@ void BM_log_redo(BMesh *bm, BMLog *log)
   log->current_entry = entry;
 
   if (entry) {
+    bm_log_id_layers_ensure(bm, log);
+
     /* Re-delete previously deleted faces and verts */
     bm_log_faces_unmake(bm, log, entry->deleted_faces);
     bm_log_verts_unmake(bm, log, entry->deleted_verts);
@@ -837,19 +962,20 @@ void BM_log_redo(BMesh *bm, BMLog *log)
  */
 void BM_log_vert_before_modified(BMLog *log, BMVert *v, const int cd_vert_mask_offset)
 {
-  BMLogEntry *entry = log->current_entry;
-  BMLogVert *lv;
   uint v_id = bm_log_vert_id_get(log, v);
-  void *key = POINTER_FROM_UINT(v_id);
-  void **val_p;
+  BMLogVert *lv;
+
+  bm_log_lookup_ensure(log);
 
   /* Find or create the BMLogVert entry */
-  if ((lv = BLI_ghash_lookup(entry->added_verts, key))) {
-    bm_log_vert_bmvert_copy(lv, v, cd_vert_mask_offset);
+  if ((lv = bm_log_vert_record(log, v_id))) {
+    if (lv->pool == BM_LOG_VERT_ADDED) {
+      bm_log_vert_bmvert_copy(lv, v, cd_vert_mask_offset);
+    }
   }
-  else if (!BLI_ghash_ensure_p(entry->modified_verts, key, &val_p)) {
-    lv = bm_log_vert_alloc(log, v, cd_vert_mask_offset);
-    *val_p = lv;
+  else {
+    lv = bm_log_vert_alloc(log, v, cd_vert_mask_offset, v_id, BM_LOG_VERT_MODIFIED);
+    log->ids[v_id].record = lv;
   }
 }
 
@@ -863,11 +989,12 @@ void BM_log_vert_added(BMLog *log, BMVert *v, const int cd_vert_mask_offset)
 {
   BMLogVert *lv;
   uint v_id = range_tree_uint_take_any(log->unused_ids);
-  void *key = POINTER_FROM_UINT(v_id);
+
+  bm_log_lookup_ensure(log);
 
   bm_log_vert_id_set(log, v, v_id);
-  lv = bm_log_vert_alloc(log, v, cd_vert_mask_offset);
-  BLI_ghash_insert(log->current_entry->added_verts, key, lv);
+  lv = bm_log_vert_alloc(log, v, cd_vert_mask_offset, v_id, BM_LOG_VERT_ADDED);
+  log->ids[v_id].record = lv;
 }
 
 /* Log a face before it is modified
@@ -877,12 +1004,9 @@ void BM_log_vert_added(BMLog *log, BMVert *v, const int cd_vert_mask_offset)
  */
 void BM_log_face_modified(BMLog *log, BMFace *f)
 {
-  BMLogFace *lf;
   uint f_id = bm_log_face_id_get(log, f);
-  void *key = POINTER_FROM_UINT(f_id);
 
-  lf = bm_log_face_alloc(log, f);
-  BLI_ghash_insert(log->current_entry->modified_faces, key, lf);
+  bm_log_face_alloc(log, f, f_id, log->current_entry->modified_faces);
 }
 
 /* Log a new face as added to the BMesh
@@ -895,14 +1019,15 @@ void BM_log_face_added(BMLog *log, BMFace *f)
 {
   BMLogFace *lf;
   uint f_id = range_tree_uint_take_any(log->unused_ids);
-  void *key = POINTER_FROM_UINT(f_id);
 
   /* Only triangles are supported for now */
   BLI_assert(f->len == 3);
 
+  bm_log_lookup_ensure(log);
+
   bm_log_face_id_set(log, f, f_id);
-  lf = bm_log_face_alloc(log, f);
-  BLI_ghash_insert(log->current_entry->added_faces, key, lf);
+  lf = bm_log_face_alloc(log, f, f_id, log->current_entry->added_faces);
+  log->ids[f_id].record = lf;
 }
 
 /* Log a vertex as removed from the BMesh
@@ -925,26 +1050,30 @@ void BM_log_vert_removed(BMLog *log, BMVert *v, const int cd_vert_mask_offset)
 {
   BMLogEntry *entry = log->current_entry;
   uint v_id = bm_log_vert_id_get(log, v);
-  void *key = POINTER_FROM_UINT(v_id);
+  BMLogVert *lv_prev;
 
-  /* if it has a key, it shouldn't be NULL */
-  BLI_assert(!!BLI_ghash_lookup(entry->added_verts, key) ==
-             !!BLI_ghash_haskey(entry->added_verts, key));
+  bm_log_lookup_ensure(log);
+  lv_prev = bm_log_vert_record(log, v_id);
 
-  if (BLI_ghash_remove(entry->added_verts, key, NULL, NULL)) {
+  if (lv_prev && lv_prev->pool == BM_LOG_VERT_ADDED) {
+    BLI_mempool_free(entry->added_verts, lv_prev);
+    log->ids[v_id].record = NULL;
     range_tree_uint_release(log->unused_ids, v_id);
   }
   else {
-    BMLogVert *lv, *lv_mod;
+    BMLogVert *lv;
+
+    BLI_assert(lv_prev == NULL || lv_prev->pool == BM_LOG_VERT_MODIFIED);
 
-    lv = bm_log_vert_alloc(log, v, cd_vert_mask_offset);
-    BLI_ghash_insert(entry->deleted_verts, key, lv);
+    lv = bm_log_vert_alloc(log, v, cd_vert_mask_offset, v_id, BM_LOG_VERT_DELETED);
+    log->ids[v_id].record = lv;
 
     /* If the vertex was modified before deletion, ensure that the
      * original vertex values are stored */
-    if ((lv_mod = BLI_ghash_lookup(entry->modified_verts, key))) {
-      (*lv) = (*lv_mod);
-      BLI_ghash_remove(entry->modified_verts, key, NULL, NULL);
+    if (lv_prev) {
+      (*lv) = (*lv_prev);
+      lv->pool = BM_LOG_VERT_DELETED;
+      BLI_mempool_free(entry->modified_verts, lv_prev);
     }
   }
 }
@@ -966,20 +1095,18 @@ void BM_log_face_removed(BMLog *log, BMFace *f)
 {
   BMLogEntry *entry = log->current_entry;
   uint f_id = bm_log_face_id_get(log, f);
-  void *key = POINTER_FROM_UINT(f_id);
+  BMLogFace *lf_added;
 
-  /* if it has a key, it shouldn't be NULL */
-  BLI_assert(!!BLI_ghash_lookup(entry->added_faces, key) ==
-             !!BLI_ghash_haskey(entry->added_faces, key));
+  bm_log_lookup_ensure(log);
+  lf_added = log->ids[f_id].record;
 
-  if (BLI_ghash_remove(entry->added_faces, key, NULL, NULL)) {
+  if (lf_added) {
+    BLI_mempool_free(entry->added_faces, lf_added);
+    log->ids[f_id].record = NULL;
     range_tree_uint_release(log->unused_ids, f_id);
   }
   else {
-    BMLogFace *lf;
-
-    lf = bm_log_face_alloc(log, f);
-    BLI_ghash_insert(entry->deleted_faces, key, lf);
+    bm_log_face_alloc(log, f, f_id, entry->deleted_faces);
   }
 }
 
@@ -992,13 +1119,7 @@ void BM_log_all_added(BMesh *bm, BMLog *log)
   BMFace *f;
 
   /* avoid unnecessary resizing on initialization */
-  if (BLI_ghash_len(log->current_entry->added_verts) == 0) {
-    BLI_ghash_reserve(log->current_entry->added_verts, (uint)bm->totvert);
-  }
-
-  if (BLI_ghash_len(log->current_entry->added_faces) == 0) {
-    BLI_ghash_reserve(log->current_entry->added_faces, (uint)bm->totface);
-  }
+  bm_log_ids_reserve(log, (uint)(bm->totvert + bm->totface));
 
   /* Log all vertices as newly created */
   BM_ITER_MESH (v, &bm_iter, bm, BM_VERTS_OF_MESH) {
@@ -1035,16 +1156,16 @@ void BM_log_before_all_removed(BMesh *bm, BMLog *log)
  * Does not modify the log or the vertex */
 const float *BM_log_original_vert_co(BMLog *log, BMVert *v)
 {
-  BMLogEntry *entry = log->current_entry;
   const BMLogVert *lv;
   uint v_id = bm_log_vert_id_get(log, v);
-  void *key = POINTER_FROM_UINT(v_id);
 
-  BLI_assert(entry);
+  BLI_assert(log->current_entry);
+
+  bm_log_lookup_ensure(log);
+  lv = bm_log_vert_record(log, v_id);
 
-  BLI_assert(BLI_ghash_haskey(entry->modified_verts, key));
+  BLI_assert(lv && lv->pool == BM_LOG_VERT_MODIFIED);
 
-  lv = BLI_ghash_lookup(entry->modified_verts, key);
   return lv->co;
 }
 
@@ -1053,16 +1174,16 @@ const float *BM_log_original_vert_co(BMLog *log, BMVert *v)
  * Does not modify the log or the vertex */
 const short *BM_log_original_vert_no(BMLog *log, BMVert *v)
 {
-  BMLogEntry *entry = log->current_entry;
   const BMLogVert *lv;
   uint v_id = bm_log_vert_id_get(log, v);
-  void *key = POINTER_FROM_UINT(v_id);
 
-  BLI_assert(entry);
+  BLI_assert(log->current_entry);
+
+  bm_log_lookup_ensure(log);
+  lv = bm_log_vert_record(log, v_id);
 
-  BLI_assert(BLI_ghash_haskey(entry->modified_verts, key));
+  BLI_assert(lv && lv->pool == BM_LOG_VERT_MODIFIED);
 
-  lv = BLI_ghash_lookup(entry->modified_verts, key);
   return lv->no;
 }
 
@@ -1071,31 +1192,31 @@ const short *BM_log_original_vert_no(BMLog *log, BMVert *v)
  * Does not modify the log or the vertex */
 float BM_log_original_mask(BMLog *log, BMVert *v)
 {
-  BMLogEntry *entry = log->current_entry;
   const BMLogVert *lv;
   uint v_id = bm_log_vert_id_get(log, v);
-  void *key = POINTER_FROM_UINT(v_id);
 
-  BLI_assert(entry);
+  BLI_assert(log->current_entry);
 
-  BLI_assert(BLI_ghash_haskey(entry->modified_verts, key));
+  bm_log_lookup_ensure(log);
+  lv = bm_log_vert_record(log, v_id);
+
+  BLI_assert(lv && lv->pool == BM_LOG_VERT_MODIFIED);
 
-  lv = BLI_ghash_lookup(entry->modified_verts, key);
   return lv->mask;
 }
 
 void BM_log_original_vert_data(BMLog *log, BMVert *v, const float **r_co, const short **r_no)
 {
-  BMLogEntry *entry = log->current_entry;
   const BMLogVert *lv;
   uint v_id = bm_log_vert_id_get(log, v);
-  void *key = POINTER_FROM_UINT(v_id);
 
-  BLI_assert(entry);
+  BLI_assert(log->current_entry);
+
+  bm_log_lookup_ensure(log);
+  lv = bm_log_vert_record(log, v_id);
 
-  BLI_assert(BLI_ghash_haskey(entry->modified_verts, key));
+  BLI_assert(lv && lv->pool == BM_LOG_VERT_MODIFIED);
 
-  lv = BLI_ghash_lookup(entry->modified_verts, key);
   *r_co = lv->co;
   *r_no = lv->no;
 }
@@ -0,0 +1,164 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <cmath>
+
+#include "BLI_array.hh"
+#include "BLI_math.h"
+
+#include "bmesh.h"
+#include "bmesh_tools.h"
+
+#include "tests/blenkernel_testing.hh"
+
+namespace blender::bmesh::tests {
+
+using BMeshDecimateTest = bke::tests::MeshTest;
+
+/* Create a `resolution` by `resolution` grid of quads on a wavy surface. */
+static BMesh *create_wavy_grid_bmesh(const int resolution)
+{
+  BMesh *bm = bke::tests::create_grid_bmesh(
+      resolution, [](int x, int y) { return sinf(x * 0.2f) * cosf(y * 0.15f) * 2.0f; });
+  BM_mesh_elem_index_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
+  return bm;
+}
+
+static float bmesh_area(BMesh *bm)
+{
+  BMIter iter;
+  BMFace *f;
+  float area = 0.0f;
+  BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+    area += BM_face_calc_area(f);
+  }
+  return area;
+}
+
+/* Check the topology of the joined partitions, #BM_mesh_validate is only available in debug. */
+static void expect_valid_mesh(BMesh *bm)
+{
+  BMIter iter;
+  BMVert *v;
+  BMEdge *e;
+  BMFace *f;
+  BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
+    /* No loose vertices. */
+    EXPECT_NE(v->e, nullptr);
+  }
+  BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
+    EXPECT_NE(e->v1, e->v2);
+    EXPECT_EQ(BM_edge_exists(e->v1, e->v2), e);
+    EXPECT_NE(e->l, nullptr);
+  }
+  BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+    EXPECT_GE(f->len, 3);
+    BMLoop *l_iter, *l_first;
+    l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+    do {
+      EXPECT_TRUE(BM_vert_in_edge(l_iter->e, l_iter->v));
+      EXPECT_TRUE(BM_vert_in_edge(l_iter->e, l_iter->next->v));
+    } while ((l_iter = l_iter->next) != l_first);
+  }
+}
+
+TEST_F(BMeshDecimateTest, collapse_parallel)
+{
+  const int resolution = 200;
+  BMesh *bm_serial = create_wavy_grid_bmesh(resolution);
+  BMesh *bm_parallel = create_wavy_grid_bmesh(resolution);
+  const float area = bmesh_area(bm_serial);
+
+  BM_mesh_decimate_collapse(bm_serial, 0.2f, nullptr, 0.0f, true, -1, 0.0f);
+  BM_mesh_decimate_collapse_parallel(bm_parallel, 0.2f, nullptr, 0.0f, true, 4);
+
+  /* Both reach the target triangle count, a collapse removes one or two triangles. */
+  const int tris_target = (int)(resolution * resolution * 2 * 0.2f);
+  EXPECT_LE(bm_serial->totface, tris_target);
+  EXPECT_LE(bm_parallel->totface, tris_target);
+  EXPECT_NEAR(bm_parallel->totface, bm_serial->totface, 2);
+  expect_valid_mesh(bm_parallel);
+
+  /* The shape is kept as well as with a single thread. */
+  EXPECT_NEAR(bmesh_area(bm_parallel), area, area * 0.01f);
+  EXPECT_NEAR(bmesh_area(bm_parallel), bmesh_area(bm_serial), area * 0.005f);
+
+  BM_mesh_free(bm_serial);
+  BM_mesh_free(bm_parallel);
+}
+
+TEST_F(BMeshDecimateTest, collapse_parallel_quads)
+{
+  const int resolution = 200;
+  BMesh *bm = create_wavy_grid_bmesh(resolution);
+
+  BM_mesh_decimate_collapse_parallel(bm, 0.5f, nullptr, 0.0f, false, 4);
+
+  int tris_len = 0;
+  BMIter iter;
+  BMFace *f;
+  BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+    tris_len += f->len - 2;
+  }
+  EXPECT_LE(tris_len, resolution * resolution);
+  EXPECT_LT(bm->totface, tris_len);
+  expect_valid_mesh(bm);
+
+  BM_mesh_free(bm);
+}
+
+TEST_F(BMeshDecimateTest, collapse_parallel_vertex_weights)
+{
+  const int resolution = 200;
+  BMesh *bm = create_wavy_grid_bmesh(resolution);
+
+  /* Lock the vertices of a column across all partitions. */
+  const float x_locked = (float)(resolution / 2);
+  Array<float> vweights(bm->totvert);
+  BMIter iter;
+  BMVert *v;
+  int i;
+  BM_ITER_MESH_INDEX (v, &iter, bm, BM_VERTS_OF_MESH, i) {
+    vweights[i] = (v->co[0] == x_locked) ? 0.0f : 1.0f;
+  }
+
+  BM_mesh_decimate_collapse_parallel(bm, 0.2f, vweights.data(), 1.0f, true, 4);
+
+  int locked_len = 0;
+  BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
+    if (v->co[0] == x_locked) {
+      locked_len++;
+    }
+  }
+  EXPECT_EQ(locked_len, resolution + 1);
+  expect_valid_mesh(bm);
+
+  BM_mesh_free(bm);
+}
+
+TEST_F(BMeshDecimateTest, collapse_parallel_small_mesh)
+{
+  /* Too small to split, the result matches the single threaded version. */
+  BMesh *bm_serial = create_wavy_grid_bmesh(30);
+  BMesh *bm_parallel = create_wavy_grid_bmesh(30);
+
+  BM_mesh_decimate_collapse(bm_serial, 0.3f, nullptr, 0.0f, false, -1, 0.0f);
+  BM_mesh_decimate_collapse_parallel(bm_parallel, 0.3f, nullptr, 0.0f, false, 4);
+
+  ASSERT_EQ(bm_parallel->totvert, bm_serial->totvert);
+  ASSERT_EQ(bm_parallel->totface, bm_serial->totface);
+  BMIter iter_serial, iter_parallel;
+  BMVert *v_serial = (BMVert *)BM_iter_new(&iter_serial, bm_serial, BM_VERTS_OF_MESH, nullptr);
+  BMVert *v_parallel = (BMVert *)BM_iter_new(
+      &iter_parallel, bm_parallel, BM_VERTS_OF_MESH, nullptr);
+  for (; v_serial; v_serial = (BMVert *)BM_iter_step(&iter_serial),
+                   v_parallel = (BMVert *)BM_iter_step(&iter_parallel)) {
+    EXPECT_V3_NEAR(v_parallel->co, v_serial->co, 0.0f);
+  }
+
+  BM_mesh_free(bm_serial);
+  BM_mesh_free(bm_parallel);
+}
+
+}  // namespace blender::bmesh::tests
@@ -0,0 +1,210 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "BKE_customdata.h"
+
+#include "BLI_math.h"
+
+#include "DNA_modifier_types.h"
+
+#include "bmesh.h"
+#include "bmesh_tools.h"
+
+#include "tests/blenkernel_testing.hh"
+
+namespace blender::bmesh::tests {
+
+using BMeshLogTest = bke::tests::MeshTest;
+
+/* Create a `resolution` by `resolution` grid of triangles with a paint mask, like the meshes of
+ * dynamic topology sculpting. */
+static BMesh *create_triangle_grid_bmesh(const int resolution)
+{
+  BMesh *bm = bke::tests::create_grid_bmesh(resolution);
+  BM_data_layer_add(bm, &bm->vdata, CD_PAINT_MASK);
+  BM_mesh_triangulate(bm,
+                      MOD_TRIANGULATE_QUAD_FIXED,
+                      MOD_TRIANGULATE_NGON_EARCLIP,
+                      4,
+                      false,
+                      nullptr,
+                      nullptr,
+                      nullptr);
+  return bm;
+}
+
+/* The mesh state independent of element order and pointers: the position and mask of every
+ * vertex, and the vertex positions of every face. */
+struct BMeshState {
+  std::vector<std::array<float, 4>> verts;
+  std::vector<std::array<float, 9>> faces;
+
+  bool operator==(const BMeshState &other) const
+  {
+    return verts == other.verts && faces == other.faces;
+  }
+};
+
+static BMeshState bmesh_state(BMesh *bm)
+{
+  const int cd_vert_mask_offset = CustomData_get_offset(&bm->vdata, CD_PAINT_MASK);
+  BMeshState state;
+  BMIter iter;
+  BMVert *v;
+  BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
+    state.verts.push_back(
+        {v->co[0], v->co[1], v->co[2], BM_ELEM_CD_GET_FLOAT(v, cd_vert_mask_offset)});
+  }
+  BMFace *f;
+  BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+    BMVert *f_verts[3];
+    BM_face_as_array_vert_tri(f, f_verts);
+    std::array<std::array<float, 3>, 3> cos;
+    for (int i = 0; i < 3; i++) {
+      cos[i] = {f_verts[i]->co[0], f_verts[i]->co[1], f_verts[i]->co[2]};
+    }
+    std::sort(cos.begin(), cos.end());
+    state.faces.push_back({cos[0][0],
+                           cos[0][1],
+                           cos[0][2],
+                           cos[1][0],
+                           cos[1][1],
+                           cos[1][2],
+                           cos[2][0],
+                           cos[2][1],
+                           cos[2][2]});
+  }
+  std::sort(state.verts.begin(), state.verts.end());
+  std::sort(state.faces.begin(), state.faces.end());
+  return state;
+}
+
+/* Move every other vertex up and mask it, logging it first. */
+static void bmesh_log_modify_verts(BMesh *bm, BMLog *log, const float offset)
+{
+  const int cd_vert_mask_offset = CustomData_get_offset(&bm->vdata, CD_PAINT_MASK);
+  BMIter iter;
+  BMVert *v;
+  int i;
+  BM_ITER_MESH_INDEX (v, &iter, bm, BM_VERTS_OF_MESH, i) {
+    if (i % 2 == 0) {
+      const float co_orig[3] = {v->co[0], v->co[1], v->co[2]};
+      BM_log_vert_before_modified(log, v, cd_vert_mask_offset);
+      /* Logging again keeps the values from before the first change. */
+      v->co[2] += offset;
+      BM_log_vert_before_modified(log, v, cd_vert_mask_offset);
+      BM_ELEM_CD_SET_FLOAT(v, cd_vert_mask_offset, offset);
+      EXPECT_V3_NEAR(BM_log_original_vert_co(log, v), co_orig, 0.0f);
+    }
+  }
+}
+
+/* Remove a vertex with its faces. */
+static void bmesh_log_remove_vert(BMesh *bm, BMLog *log, BMVert *v)
+{
+  const int cd_vert_mask_offset = CustomData_get_offset(&bm->vdata, CD_PAINT_MASK);
+  BMIter iter;
+  BMFace *f;
+  BM_ITER_ELEM (f, &iter, v, BM_FACES_OF_VERT) {
+    BM_log_face_removed(log, f);
+  }
+  BM_log_vert_removed(log, v, cd_vert_mask_offset);
+  BM_vert_kill(bm, v);
+}
+
+/* Add a vertex above the first face with a face to two of its vertices. */
+static BMVert *bmesh_log_add_vert(BMesh *bm, BMLog *log)
+{
+  const int cd_vert_mask_offset = CustomData_get_offset(&bm->vdata, CD_PAINT_MASK);
+  BMFace *f_first = (BMFace *)BM_iter_at_index(bm, BM_FACES_OF_MESH, nullptr, 0);
+  BMVert *f_verts[3];
+  BM_face_as_array_vert_tri(f_first, f_verts);
+
+  float co[3];
+  mid_v3_v3v3v3(co, f_verts[0]->co, f_verts[1]->co, f_verts[2]->co);
+  co[2] += 10.0f;
+  BMVert *v = BM_vert_create(bm, co, nullptr, BM_CREATE_NOP);
+  BM_log_vert_added(log, v, cd_vert_mask_offset);
+
+  BMVert *tri[3] = {f_verts[0], f_verts[1], v};
+  BMFace *f = BM_face_create_verts(bm, tri, 3, nullptr, BM_CREATE_NOP, true);
+  BM_log_face_added(log, f);
+  return v;
+}
+
+TEST_F(BMeshLogTest, undo_redo)
+{
+  BMesh *bm = create_triangle_grid_bmesh(8);
+  BMLog *log = BM_log_create(bm);
+
+  /* The IDs are stored in a layer that doesn't end up in the mesh. */
+  const int layer_index = CustomData_get_named_layer_index(
+      &bm->vdata, CD_PROP_INT32, "_bm_log_id");
+  ASSERT_NE(layer_index, -1);
+  EXPECT_EQ(bm->vdata.layers[layer_index].flag & CD_FLAG_TEMPORARY, CD_FLAG_TEMPORARY);
+
+  const BMeshState state_initial = bmesh_state(bm);
+
+  /* First entry: modify vertices, remove some which were modified and others which weren't, and
+   * add vertices, one of which is removed again. */
+  BMLogEntry *entry_a = BM_log_entry_add(log);
+  bmesh_log_modify_verts(bm, log, 1.0f);
+  bmesh_log_remove_vert(bm, log, (BMVert *)BM_iter_at_index(bm, BM_VERTS_OF_MESH, nullptr, 21));
+  bmesh_log_remove_vert(bm, log, (BMVert *)BM_iter_at_index(bm, BM_VERTS_OF_MESH, nullptr, 20));
+  bmesh_log_add_vert(bm, log);
+  bmesh_log_remove_vert(bm, log, bmesh_log_add_vert(bm, log));
+  BMFace *f_modified = (BMFace *)BM_iter_at_index(bm, BM_FACES_OF_MESH, nullptr, 10);
+  BM_log_face_modified(log, f_modified);
+  BM_elem_flag_enable(f_modified, BM_ELEM_HIDDEN);
+  const BMeshState state_a = bmesh_state(bm);
+  EXPECT_EQ(state_a.verts.size(), state_initial.verts.size() - 1);
+
+  /* Second entry: modify the result of the first one. */
+  BMLogEntry *entry_b = BM_log_entry_add(log);
+  bmesh_log_modify_verts(bm, log, 2.0f);
+  const BMeshState state_b = bmesh_state(bm);
+
+  BM_log_undo(bm, log);
+  EXPECT_TRUE(bmesh_state(bm) == state_a);
+  BM_log_undo(bm, log);
+  EXPECT_TRUE(bmesh_state(bm) == state_initial);
+  EXPECT_FALSE(BM_elem_flag_test(f_modified, BM_ELEM_HIDDEN));
+  EXPECT_EQ(BM_log_current_entry(log), nullptr);
+
+  BM_log_redo(bm, log);
+  EXPECT_TRUE(bmesh_state(bm) == state_a);
+  EXPECT_TRUE(BM_elem_flag_test(f_modified, BM_ELEM_HIDDEN));
+  EXPECT_EQ(BM_log_current_entry(log), entry_a);
+  BM_log_redo(bm, log);
+  EXPECT_TRUE(bmesh_state(bm) == state_b);
+  EXPECT_EQ(BM_log_current_entry(log), entry_b);
+
+  /* Undo once more and log a new entry in place of the second one, like the undo system. */
+  BM_log_undo(bm, log);
+  BM_log_entry_drop(entry_b);
+  BMLogEntry *entry_c = BM_log_entry_add(log);
+  bmesh_log_modify_verts(bm, log, 3.0f);
+  BM_log_undo(bm, log);
+  EXPECT_TRUE(bmesh_state(bm) == state_a);
+
+  /* Reordering keeps the log usable. */
+  BM_log_mesh_elems_reorder(bm, log);
+  BM_log_undo(bm, log);
+  EXPECT_TRUE(bmesh_state(bm) == state_initial);
+  BM_log_redo(bm, log);
+  EXPECT_TRUE(bmesh_state(bm) == state_a);
+
+  EXPECT_EQ(BM_log_length(log), 2);
+  BM_log_entry_drop(entry_c);
+  BM_log_entry_drop(entry_a);
+
+  BM_log_free(log);
+  BM_mesh_free(bm);
+}
+
+}  // namespace blender::bmesh::tests
@@ -0,0 +1,128 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "BKE_customdata.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "BLI_math.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "bmesh.h"
+
+#include "tests/blenkernel_testing.hh"
+
+using blender::bke::tests::bmesh_from_mesh;
+using blender::bke::tests::create_grid_mesh;
+
+using BMeshMeshConvertTest = blender::bke::tests::MeshTest;
+
+/* Create a grid with custom data and creases that is large enough to be converted on multiple
+ * threads. */
+static Mesh *create_attribute_grid_mesh(const int resolution)
+{
+  Mesh *mesh = create_grid_mesh(resolution, [](int x, int y) { return (float)((x * y) % 7); });
+
+  float *vert_weights = (float *)CustomData_add_layer_named(
+      &mesh->vdata, CD_PROP_FLOAT, CD_CALLOC, nullptr, mesh->totvert, "weight");
+  float *loop_weights = (float *)CustomData_add_layer_named(
+      &mesh->ldata, CD_PROP_FLOAT, CD_CALLOC, nullptr, mesh->totloop, "weight");
+  for (int i = 0; i < mesh->totvert; i++) {
+    vert_weights[i] = (float)i;
+  }
+  for (int i = 0; i < mesh->totloop; i++) {
+    loop_weights[i] = (float)i;
+  }
+  for (int i = 0; i < mesh->totpoly; i++) {
+    mesh->mpoly[i].mat_nr = i % 3;
+  }
+  for (int i = 0; i < mesh->totedge; i++) {
+    mesh->medge[i].crease = i % 256;
+  }
+  mesh->cd_flag |= ME_CDFLAG_EDGE_CREASE;
+  return mesh;
+}
+
+static void expect_meshes_equal(const Mesh *a, const Mesh *b)
+{
+  ASSERT_EQ(a->totvert, b->totvert);
+  ASSERT_EQ(a->totedge, b->totedge);
+  ASSERT_EQ(a->totloop, b->totloop);
+  ASSERT_EQ(a->totpoly, b->totpoly);
+
+  for (int i = 0; i < a->totvert; i++) {
+    EXPECT_V3_NEAR(a->mvert[i].co, b->mvert[i].co, 0.0f);
+  }
+  for (int i = 0; i < a->totedge; i++) {
+    EXPECT_EQ(a->medge[i].v1, b->medge[i].v1);
+    EXPECT_EQ(a->medge[i].v2, b->medge[i].v2);
+    EXPECT_EQ(a->medge[i].crease, b->medge[i].crease);
+  }
+  for (int i = 0; i < a->totloop; i++) {
+    EXPECT_EQ(a->mloop[i].v, b->mloop[i].v);
+    EXPECT_EQ(a->mloop[i].e, b->mloop[i].e);
+  }
+  for (int i = 0; i < a->totpoly; i++) {
+    EXPECT_EQ(a->mpoly[i].loopstart, b->mpoly[i].loopstart);
+    EXPECT_EQ(a->mpoly[i].totloop, b->mpoly[i].totloop);
+    EXPECT_EQ(a->mpoly[i].mat_nr, b->mpoly[i].mat_nr);
+  }
+
+  const float *a_vert_weights = (const float *)CustomData_get_layer_named(
+      &a->vdata, CD_PROP_FLOAT, "weight");
+  const float *b_vert_weights = (const float *)CustomData_get_layer_named(
+      &b->vdata, CD_PROP_FLOAT, "weight");
+  ASSERT_NE(b_vert_weights, nullptr);
+  for (int i = 0; i < a->totvert; i++) {
+    EXPECT_EQ(a_vert_weights[i], b_vert_weights[i]);
+  }
+
+  const float *a_loop_weights = (const float *)CustomData_get_layer_named(
+      &a->ldata, CD_PROP_FLOAT, "weight");
+  const float *b_loop_weights = (const float *)CustomData_get_layer_named(
+      &b->ldata, CD_PROP_FLOAT, "weight");
+  ASSERT_NE(b_loop_weights, nullptr);
+  for (int i = 0; i < a->totloop; i++) {
+    EXPECT_EQ(a_loop_weights[i], b_loop_weights[i]);
+  }
+}
+
+TEST_F(BMeshMeshConvertTest, round_trip)
+{
+  Mesh *mesh = create_attribute_grid_mesh(120);
+  BMesh *bm = bmesh_from_mesh(mesh);
+  EXPECT_EQ(bm->totvert, mesh->totvert);
+  EXPECT_EQ(bm->totface, mesh->totpoly);
+
+  Mesh *result = BKE_mesh_new_nomain(0, 0, 0, 0, 0);
+  BMeshToMeshParams to_params = {0};
+  BM_mesh_bm_to_me(nullptr, bm, result, &to_params);
+  expect_meshes_equal(mesh, result);
+
+  BM_mesh_free(bm);
+  BKE_id_free(nullptr, result);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(BMeshMeshConvertTest, round_trip_for_eval)
+{
+  Mesh *mesh = create_attribute_grid_mesh(120);
+  BMesh *bm = bmesh_from_mesh(mesh);
+
+  Mesh *result = (Mesh *)BKE_id_new_nomain(ID_ME, nullptr);
+  BM_mesh_bm_to_me_for_eval(bm, result, nullptr);
+  expect_meshes_equal(mesh, result);
+
+  const int *poly_origindex = (const int *)CustomData_get_layer(&result->pdata, CD_ORIGINDEX);
+  ASSERT_NE(poly_origindex, nullptr);
+  for (int i = 0; i < result->totpoly; i++) {
+    EXPECT_EQ(poly_origindex[i], i);
+  }
+
+  BM_mesh_free(bm);
+  BKE_id_free(nullptr, result);
+  BKE_id_free(nullptr, mesh);
+}
@@ -25,6 +25,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_alloca.h"
+#include "BLI_ghash.h"
 #include "BLI_heap.h"
 #include "BLI_linklist.h"
 #include "BLI_math.h"
@@ -32,6 +33,7 @@
 #include "BLI_polyfill_2d.h"
 #include "BLI_polyfill_2d_beautify.h"
 #include "BLI_quadric.h"
+#include "BLI_task.h"
 #include "BLI_utildefines_stack.h"
 
 #include "BKE_customdata.h"
@@ -1534,3 +1536,566 @@ void BM_mesh_decimate_collapse(BMesh *bm,
   /* quiet release build warning */
   (void)tot_edge_orig;
 }
+
+/* Parallel Decimate
+ * ***************** */
+
+/**
+ * Don't use partitions with fewer faces than this,
+ * the locked borders and the final pass outweigh the gain.
+ */
+#define PARALLEL_PARTITION_FACES_MIN 10000
+/** Resolution of the histogram used to give the partitions a similar number of faces. */
+#define PARALLEL_PARTITION_BINS 4096
+/** Rings of vertices around the partition borders which the final pass can collapse. */
+#define PARALLEL_BORDER_RINGS 3
+
+/** Values of #DecimateParallelData.vert_partition for vertices without a single partition. */
+enum {
+  VERT_PARTITION_NONE = -1,
+  VERT_PARTITION_BORDER = -2,
+};
+
+typedef struct DecimatePartition {
+  /** Faces of the source mesh, a slice of a shared array. */
+  BMFace **faces;
+  int faces_len;
+  /** Number of vertices only used by faces of this partition. */
+  int verts_interior_len;
+
+  BMesh *bm;
+  /** Number of vertices in `bm` before decimating. */
+  int verts_len;
+  /** Vertex index aligned, the source vertex for border vertices, NULL for interior vertices. */
+  BMVert **verts_border;
+  /** Vertex index aligned weights, zero for border vertices which must stay in place. */
+  float *vweights;
+} DecimatePartition;
+
+typedef struct DecimateParallelData {
+  BMesh *bm;
+  DecimatePartition *partitions;
+  /** Vertex index aligned partition index or one of the `VERT_PARTITION_*` values. */
+  const int *vert_partition;
+  /** Vertex index aligned index within the partition, for interior vertices only. */
+  const int *vert_interior_index;
+  const float *vweights;
+  float vweight_factor;
+  float factor;
+  bool do_triangulate;
+} DecimateParallelData;
+
+typedef struct FaceCoordData {
+  BMFace **faces;
+  int axis;
+  float *face_co;
+} FaceCoordData;
+
+static void bm_decim_face_coord_task(void *__restrict userdata,
+                                     const int index,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  FaceCoordData *data = userdata;
+  float center[3];
+  BM_face_calc_center_median(data->faces[index], center);
+  data->face_co[index] = center[data->axis];
+}
+
+/**
+ * Split the faces into slabs along the longest axis of the mesh bounds,
+ * with a similar number of faces in each slab.
+ *
+ * \note Requires a valid face table.
+ */
+static void bm_decim_partition_faces(BMesh *bm, const int partitions_num, int *r_face_partition)
+{
+  BMIter iter;
+  BMVert *v;
+  float min[3], max[3], size[3];
+
+  INIT_MINMAX(min, max);
+  BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
+    minmax_v3v3_v3(min, max, v->co);
+  }
+  sub_v3_v3v3(size, max, min);
+  const int axis = axis_dominant_v3_single(size);
+
+  float *face_co = MEM_malloc_arrayN(bm->totface, sizeof(*face_co), __func__);
+  FaceCoordData data = {
+      .faces = bm->ftable,
+      .axis = axis,
+      .face_co = face_co,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, bm->totface, &data, bm_decim_face_coord_task, &settings);
+
+  int *bins = MEM_calloc_arrayN(PARALLEL_PARTITION_BINS, sizeof(*bins), __func__);
+  const float bin_scale = (size[axis] > FLT_EPSILON) ? PARALLEL_PARTITION_BINS / size[axis] :
+                                                       0.0f;
+  for (int i = 0; i < bm->totface; i++) {
+    const int bin = (int)((face_co[i] - min[axis]) * bin_scale);
+    r_face_partition[i] = clamp_i(bin, 0, PARALLEL_PARTITION_BINS - 1);
+    bins[r_face_partition[i]]++;
+  }
+
+  /* Replace the face count of each bin with the partition it's assigned to. */
+  int faces_before = 0;
+  for (int i = 0; i < PARALLEL_PARTITION_BINS; i++) {
+    const int faces_len = bins[i];
+    const int64_t faces_mid = faces_before + faces_len / 2;
+    bins[i] = min_ii((int)(faces_mid * partitions_num / bm->totface), partitions_num - 1);
+    faces_before += faces_len;
+  }
+  for (int i = 0; i < bm->totface; i++) {
+    r_face_partition[i] = bins[r_face_partition[i]];
+  }
+
+  MEM_freeN(bins);
+  MEM_freeN(face_co);
+}
+
+/**
+ * Vertices used by faces of different partitions and vertices of loose edges
+ * are border vertices, they are shared by the partitions and never moved.
+ */
+static void bm_decim_partition_verts(BMesh *bm,
+                                     DecimatePartition *partitions,
+                                     const int partitions_num,
+                                     int *r_vert_partition,
+                                     int *r_vert_interior_index)
+{
+  BMIter iter;
+  BMVert *v;
+  BMEdge *e;
+  int i;
+
+  copy_vn_i(r_vert_partition, bm->totvert, VERT_PARTITION_NONE);
+
+  for (int p = 0; p < partitions_num; p++) {
+    DecimatePartition *partition = &partitions[p];
+    for (i = 0; i < partition->faces_len; i++) {
+      BMLoop *l_iter, *l_first;
+      l_iter = l_first = BM_FACE_FIRST_LOOP(partition->faces[i]);
+      do {
+        int *v_partition = &r_vert_partition[BM_elem_index_get(l_iter->v)];
+        if (*v_partition == VERT_PARTITION_NONE) {
+          *v_partition = p;
+        }
+        else if (*v_partition != p) {
+          *v_partition = VERT_PARTITION_BORDER;
+        }
+      } while ((l_iter = l_iter->next) != l_first);
+    }
+  }
+
+  BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
+    if (e->l == NULL) {
+      BMVert *e_verts[2] = {e->v1, e->v2};
+      for (int j = 0; j < 2; j++) {
+        int *v_partition = &r_vert_partition[BM_elem_index_get(e_verts[j])];
+        if (*v_partition != VERT_PARTITION_NONE) {
+          *v_partition = VERT_PARTITION_BORDER;
+        }
+      }
+    }
+  }
+
+  BM_ITER_MESH_INDEX (v, &iter, bm, BM_VERTS_OF_MESH, i) {
+    const int p = r_vert_partition[i];
+    if (p >= 0) {
+      r_vert_interior_index[i] = partitions[p].verts_interior_len++;
+    }
+  }
+}
+
+/**
+ * Copy face, loop and edge attributes, the faces must use matching vertices.
+ */
+static void bm_decim_face_attrs_copy(BMesh *bm_src,
+                                     BMesh *bm_dst,
+                                     const BMFace *f_src,
+                                     BMFace *f_dst)
+{
+  BMLoop *l_src = BM_FACE_FIRST_LOOP(f_src);
+  BMLoop *l_dst = BM_FACE_FIRST_LOOP(f_dst);
+
+  BM_elem_attrs_copy(bm_src, bm_dst, f_src, f_dst);
+  for (int i = 0; i < f_src->len; i++, l_src = l_src->next, l_dst = l_dst->next) {
+    BM_elem_attrs_copy(bm_src, bm_dst, l_src, l_dst);
+    BM_elem_attrs_copy(bm_src, bm_dst, l_src->e, l_dst->e);
+  }
+}
+
+static BMVert *bm_decim_partition_vert_copy(BMesh *bm_src, BMesh *bm_dst, BMVert *v_src)
+{
+  BMVert *v_dst = BM_vert_create(bm_dst, v_src->co, NULL, BM_CREATE_SKIP_CD);
+  BM_elem_attrs_copy(bm_src, bm_dst, v_src, v_dst);
+  /* Store the source index until all vertices are created. */
+  BM_elem_index_set(v_dst, BM_elem_index_get(v_src)); /* set_dirty! */
+  return v_dst;
+}
+
+/**
+ * Copy the faces of a partition into a new mesh.
+ */
+static void bm_decim_partition_copy(const DecimateParallelData *data,
+                                    DecimatePartition *partition)
+{
+  BMesh *bm_src = data->bm;
+  int loops_len = 0;
+  int f_verts_len = 0;
+  for (int i = 0; i < partition->faces_len; i++) {
+    loops_len += partition->faces[i]->len;
+    f_verts_len = max_ii(f_verts_len, partition->faces[i]->len);
+  }
+
+  const BMAllocTemplate allocsize = {
+      .totvert = partition->verts_interior_len,
+      .totedge = loops_len / 2,
+      .totloop = loops_len,
+      .totface = partition->faces_len,
+  };
+  BMesh *bm = BM_mesh_create(&allocsize, &((struct BMeshCreateParams){.use_toolflags = false}));
+  BM_mesh_copy_init_customdata_all_layers(bm, bm_src, BM_ALL, &allocsize);
+
+  BMVert **verts_interior = MEM_calloc_arrayN(
+      partition->verts_interior_len, sizeof(*verts_interior), __func__);
+  GHash *verts_border = BLI_ghash_ptr_new(__func__);
+  BMVert **f_verts = MEM_malloc_arrayN(f_verts_len, sizeof(*f_verts), __func__);
+
+  for (int i = 0; i < partition->faces_len; i++) {
+    BMFace *f_src = partition->faces[i];
+    BMLoop *l_iter, *l_first;
+    int j = 0;
+    l_iter = l_first = BM_FACE_FIRST_LOOP(f_src);
+    do {
+      BMVert *v_src = l_iter->v;
+      const int v_src_index = BM_elem_index_get(v_src);
+      if (data->vert_partition[v_src_index] == VERT_PARTITION_BORDER) {
+        void **val_p;
+        if (!BLI_ghash_ensure_p(verts_border, v_src, &val_p)) {
+          *val_p = bm_decim_partition_vert_copy(bm_src, bm, v_src);
+        }
+        f_verts[j] = *val_p;
+      }
+      else {
+        BMVert **v_dst_p = &verts_interior[data->vert_interior_index[v_src_index]];
+        if (*v_dst_p == NULL) {
+          *v_dst_p = bm_decim_partition_vert_copy(bm_src, bm, v_src);
+        }
+        f_verts[j] = *v_dst_p;
+      }
+    } while ((void)j++, (l_iter = l_iter->next) != l_first);
+
+    BMFace *f_dst = BM_face_create_verts(bm, f_verts, f_src->len, NULL, BM_CREATE_SKIP_CD, true);
+    bm_decim_face_attrs_copy(bm_src, bm, f_src, f_dst);
+  }
+
+  MEM_freeN(f_verts);
+  BLI_ghash_free(verts_border, NULL, NULL);
+  MEM_freeN(verts_interior);
+
+  /* Replace the source indices with the vertex indices of the partition. */
+  partition->verts_len = bm->totvert;
+  partition->verts_border = MEM_malloc_arrayN(bm->totvert, sizeof(BMVert *), __func__);
+  partition->vweights = MEM_malloc_arrayN(bm->totvert, sizeof(float), __func__);
+
+  BMIter iter;
+  BMVert *v;
+  int i;
+  BM_ITER_MESH_INDEX (v, &iter, bm, BM_VERTS_OF_MESH, i) {
+    const int v_src_index = BM_elem_index_get(v);
+    if (data->vert_partition[v_src_index] == VERT_PARTITION_BORDER) {
+      partition->verts_border[i] = bm_src->vtable[v_src_index];
+      partition->vweights[i] = 0.0f;
+    }
+    else {
+      partition->verts_border[i] = NULL;
+      partition->vweights[i] = data->vweights ? data->vweights[v_src_index] : 1.0f;
+    }
+    BM_elem_index_set(v, i); /* set_ok */
+  }
+  bm->elem_index_dirty &= ~BM_VERT;
+  BM_mesh_elem_index_ensure(bm, BM_EDGE | BM_FACE);
+
+  partition->bm = bm;
+}
+
+static void bm_decim_partition_task(void *__restrict userdata,
+                                    const int index,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const DecimateParallelData *data = userdata;
+  DecimatePartition *partition = &data->partitions[index];
+
+  if (partition->faces_len == 0) {
+    return;
+  }
+
+  bm_decim_partition_copy(data, partition);
+  BM_mesh_decimate_collapse(partition->bm,
+                            data->factor,
+                            partition->vweights,
+                            data->vweight_factor,
+                            data->do_triangulate,
+                            -1,
+                            0.0f);
+}
+
+/**
+ * Replace the faces of the source mesh with the decimated partitions.
+ *
+ * \return Vertex index aligned weights for the final pass,
+ * where only vertices close to the partition borders can be collapsed.
+ */
+static float *bm_decim_partitions_join(BMesh *bm,
+                                       DecimatePartition *partitions,
+                                       const int partitions_num,
+                                       const int *vert_partition,
+                                       const float *vweights,
+                                       int *r_tris_len)
+{
+  BMIter iter;
+  BMVert *v, *v_next;
+  BMEdge *e, *e_next;
+  BMFace *f, *f_next;
+  int i;
+
+  /* Only border vertices, loose vertices and loose edges remain. */
+  BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
+    BM_elem_flag_set(e, BM_ELEM_TAG, e->l != NULL);
+  }
+  BM_ITER_MESH_MUTABLE (f, f_next, &iter, bm, BM_FACES_OF_MESH) {
+    BM_face_kill(bm, f);
+  }
+  BM_ITER_MESH_MUTABLE (e, e_next, &iter, bm, BM_EDGES_OF_MESH) {
+    if (BM_elem_flag_test(e, BM_ELEM_TAG)) {
+      BM_edge_kill(bm, e);
+    }
+  }
+  BM_ITER_MESH_MUTABLE (v, v_next, &iter, bm, BM_VERTS_OF_MESH) {
+    if (vert_partition[BM_elem_index_get(v)] >= 0) {
+      BM_vert_kill(bm, v);
+    }
+  }
+
+  int verts_new_len = 0;
+  for (int p = 0; p < partitions_num; p++) {
+    verts_new_len += partitions[p].verts_interior_len;
+  }
+  float *vweights_new = MEM_malloc_arrayN(verts_new_len, sizeof(float), __func__);
+  verts_new_len = 0;
+
+  int tris_len = 0;
+  int f_verts_len = 32;
+  BMVert **f_verts = MEM_malloc_arrayN(f_verts_len, sizeof(*f_verts), __func__);
+
+  for (int p = 0; p < partitions_num; p++) {
+    DecimatePartition *partition = &partitions[p];
+    BMesh *bm_part = partition->bm;
+    if (bm_part == NULL) {
+      continue;
+    }
+
+    /* Collapsing doesn't change the indices of the remaining vertices. */
+    BMVert **verts_map = MEM_malloc_arrayN(partition->verts_len, sizeof(*verts_map), __func__);
+    BM_ITER_MESH (v, &iter, bm_part, BM_VERTS_OF_MESH) {
+      const int index = BM_elem_index_get(v);
+      BMVert *v_dst = partition->verts_border[index];
+      if (v_dst == NULL) {
+        v_dst = BM_vert_create(bm, v->co, NULL, BM_CREATE_SKIP_CD);
+        BM_elem_attrs_copy(bm_part, bm, v, v_dst);
+        /* Negative indices reference the weights of new vertices. */
+        BM_elem_index_set(v_dst, -1 - verts_new_len); /* set_dirty! */
+        vweights_new[verts_new_len++] = partition->vweights[index];
+      }
+      verts_map[index] = v_dst;
+    }
+
+    BM_ITER_MESH (f, &iter, bm_part, BM_FACES_OF_MESH) {
+      BMLoop *l_iter, *l_first;
+      int j = 0;
+      if (f->len > f_verts_len) {
+        f_verts_len = f->len;
+        MEM_freeN(f_verts);
+        f_verts = MEM_malloc_arrayN(f_verts_len, sizeof(*f_verts), __func__);
+      }
+      l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+      do {
+        f_verts[j] = verts_map[BM_elem_index_get(l_iter->v)];
+      } while ((void)j++, (l_iter = l_iter->next) != l_first);
+
+      BMFace *f_dst = BM_face_create_verts(bm, f_verts, f->len, NULL, BM_CREATE_SKIP_CD, true);
+      bm_decim_face_attrs_copy(bm_part, bm, f, f_dst);
+      tris_len += f->len - 2;
+    }
+
+    MEM_freeN(verts_map);
+    MEM_freeN(partition->verts_border);
+    MEM_freeN(partition->vweights);
+    BM_mesh_free(bm_part);
+    partition->bm = NULL;
+  }
+  MEM_freeN(f_verts);
+
+  /* Vertex rings around the borders, zero for vertices the final pass keeps in place. */
+  char *vert_ring = MEM_malloc_arrayN(bm->totvert, sizeof(*vert_ring), __func__);
+  float *vweights_final = MEM_malloc_arrayN(bm->totvert, sizeof(float), __func__);
+  BM_ITER_MESH_INDEX (v, &iter, bm, BM_VERTS_OF_MESH, i) {
+    const int index = BM_elem_index_get(v);
+    if (index < 0) {
+      vweights_final[i] = vweights_new[-1 - index];
+      vert_ring[i] = 0;
+    }
+    else {
+      vweights_final[i] = vweights ? vweights[index] : 1.0f;
+      vert_ring[i] = (vert_partition[index] == VERT_PARTITION_BORDER) ? 1 : 0;
+    }
+    BM_elem_index_set(v, i); /* set_ok */
+  }
+  bm->elem_index_dirty &= ~BM_VERT;
+  MEM_freeN(vweights_new);
+
+  for (char ring = 1; ring < PARALLEL_BORDER_RINGS; ring++) {
+    BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+      BMLoop *l_iter, *l_first;
+      bool is_ring = false;
+      l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+      do {
+        if (vert_ring[BM_elem_index_get(l_iter->v)] == ring) {
+          is_ring = true;
+          break;
+        }
+      } while ((l_iter = l_iter->next) != l_first);
+
+      if (is_ring) {
+        l_iter = l_first;
+        do {
+          char *v_ring = &vert_ring[BM_elem_index_get(l_iter->v)];
+          if (*v_ring == 0) {
+            *v_ring = ring + 1;
+          }
+        } while ((l_iter = l_iter->next) != l_first);
+      }
+    }
+  }
+
+  for (i = 0; i < bm->totvert; i++) {
+    if (vert_ring[i] == 0) {
+      vweights_final[i] = 0.0f;
+    }
+  }
+  MEM_freeN(vert_ring);
+
+  *r_tris_len = tris_len;
+  return vweights_final;
+}
+
+/**
+ * \brief BM_mesh_decimate_collapse_parallel
+ *
+ * Multi-threaded version of #BM_mesh_decimate_collapse (without symmetry support).
+ *
+ * The faces are split into spatial partitions which are decimated in parallel,
+ * vertices shared by several partitions are locked so the partitions can be joined again.
+ * A final pass then collapses the edges around the partition borders
+ * until the target face count is reached.
+ *
+ * The result isn't identical to the single threaded version,
+ * small meshes fall back to it.
+ *
+ * \param partitions_num: The maximum number of partitions, usually the number of threads.
+ */
+void BM_mesh_decimate_collapse_parallel(BMesh *bm,
+                                        const float factor,
+                                        float *vweights,
+                                        float vweight_factor,
+                                        const bool do_triangulate,
+                                        int partitions_num)
+{
+  partitions_num = min_ii(partitions_num, bm->totface / PARALLEL_PARTITION_FACES_MIN);
+  if (partitions_num < 2) {
+    BM_mesh_decimate_collapse(bm, factor, vweights, vweight_factor, do_triangulate, -1, 0.0f);
+    return;
+  }
+
+  BM_mesh_elem_index_ensure(bm, BM_VERT | BM_FACE);
+  BM_mesh_elem_table_ensure(bm, BM_VERT | BM_FACE);
+
+  /* The single threaded version triangulates before calculating the target. */
+  int tris_len = 0;
+  for (int i = 0; i < bm->totface; i++) {
+    tris_len += bm->ftable[i]->len - 2;
+  }
+  const int tris_target = tris_len * factor;
+
+  int *face_partition = MEM_malloc_arrayN(bm->totface, sizeof(*face_partition), __func__);
+  bm_decim_partition_faces(bm, partitions_num, face_partition);
+
+  /* Sort the faces by partition. */
+  DecimatePartition *partitions = MEM_calloc_arrayN(
+      partitions_num, sizeof(*partitions), __func__);
+  BMFace **faces = MEM_malloc_arrayN(bm->totface, sizeof(*faces), __func__);
+  for (int i = 0; i < bm->totface; i++) {
+    partitions[face_partition[i]].faces_len++;
+  }
+  int faces_offset = 0;
+  for (int p = 0; p < partitions_num; p++) {
+    partitions[p].faces = &faces[faces_offset];
+    faces_offset += partitions[p].faces_len;
+    partitions[p].faces_len = 0;
+  }
+  for (int i = 0; i < bm->totface; i++) {
+    DecimatePartition *partition = &partitions[face_partition[i]];
+    partition->faces[partition->faces_len++] = bm->ftable[i];
+  }
+  MEM_freeN(face_partition);
+
+  int *vert_partition = MEM_malloc_arrayN(bm->totvert, sizeof(*vert_partition), __func__);
+  int *vert_interior_index = MEM_malloc_arrayN(
+      bm->totvert, sizeof(*vert_interior_index), __func__);
+  bm_decim_partition_verts(bm, partitions, partitions_num, vert_partition, vert_interior_index);
+
+  /* Without weights all vertices use the same weight, which must not change the cost. */
+  if (vweights == NULL) {
+    vweight_factor = 0.0f;
+  }
+
+  DecimateParallelData data = {
+      .bm = bm,
+      .partitions = partitions,
+      .vert_partition = vert_partition,
+      .vert_interior_index = vert_interior_index,
+      .vweights = vweights,
+      .vweight_factor = vweight_factor,
+      .factor = factor,
+      .do_triangulate = do_triangulate,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, partitions_num, &data, bm_decim_partition_task, &settings);
+
+  MEM_freeN(vert_interior_index);
+  MEM_freeN(faces);
+
+  int tris_joined_len;
+  float *vweights_final = bm_decim_partitions_join(
+      bm, partitions, partitions_num, vert_partition, vweights, &tris_joined_len);
+  MEM_freeN(vert_partition);
+  MEM_freeN(partitions);
+
+  if (tris_joined_len > tris_target) {
+    BM_mesh_elem_index_ensure(bm, BM_EDGE | BM_FACE);
+    BM_mesh_decimate_collapse(bm,
+                              (float)tris_target / (float)tris_joined_len,
+                              vweights_final,
+                              vweight_factor,
+                              do_triangulate,
+                              -1,
+                              0.0f);
+  }
+  MEM_freeN(vweights_final);
+}
@@ -71,6 +71,9 @@ enum {
   /* A shrinkwrap modifier or constraint targeting this mesh needs information
    * about non-manifold boundary edges for the Target Normal Project mode. */
   DAG_EVAL_NEED_SHRINKWRAP_BOUNDARY = (1 << 1),
+  /* A modifier of this object uses the object transform, so its result depends on where the
+   * object is, see #DEG_add_modifier_to_transform_relation. */
+  DAG_EVAL_MODIFIERS_USE_TRANSFORM = (1 << 2),
 };
 
 #ifdef __cplusplus
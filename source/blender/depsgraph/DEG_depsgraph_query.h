@@ -64,6 +64,10 @@ eEvaluationMode DEG_get_mode(const Depsgraph *graph);
 /* Get time that depsgraph is being evaluated or was last evaluated at. */
 float DEG_get_ctime(const Depsgraph *graph);
 
+/* Get number of the evaluation that is running or ran last, it changes for every evaluation which
+ * has anything to update. */
+int DEG_get_update_count(const Depsgraph *graph);
+
 /* ********************* DEG evaluated data ******************* */
 
 /* Check if given ID type was tagged for update. */
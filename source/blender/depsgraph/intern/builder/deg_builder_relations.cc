@@ -316,6 +316,7 @@ void DepsgraphRelationBuilder::add_modifier_to_transform_relation(const DepsNode
   ComponentKey geometry_key(id, NodeType::GEOMETRY);
   /* Wire up the actual relation. */
   add_depends_on_transform_relation(id, geometry_key, description);
+  id_node->eval_flags |= DAG_EVAL_MODIFIERS_USE_TRANSFORM;
 }
 
 void DepsgraphRelationBuilder::add_customdata_mask(Object *object,
@@ -155,6 +155,9 @@ struct Depsgraph {
 
   bool is_evaluating;
 
+  /* Number of evaluations of the graph that had anything to update. */
+  int update_count;
+
   /* Is set to truth for dependency graph which are used for post-processing (compositor and
    * sequencer).
    * Such dependency graph needs all view layers (so render pipeline can access names), but it
@@ -79,6 +79,12 @@ float DEG_get_ctime(const Depsgraph *graph)
   return deg_graph->ctime;
 }
 
+int DEG_get_update_count(const Depsgraph *graph)
+{
+  const deg::Depsgraph *deg_graph = reinterpret_cast<const deg::Depsgraph *>(graph);
+  return deg_graph->update_count;
+}
+
 bool DEG_id_type_updated(const Depsgraph *graph, short id_type)
 {
   const deg::Depsgraph *deg_graph = reinterpret_cast<const deg::Depsgraph *>(graph);
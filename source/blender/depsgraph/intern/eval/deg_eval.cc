@@ -373,6 +373,7 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   graph->debug.begin_graph_evaluation();
 
   graph->is_evaluating = true;
+  graph->update_count++;
   depsgraph_ensure_view_layer(graph);
   /* Set up evaluation state. */
   DepsgraphEvalState state;
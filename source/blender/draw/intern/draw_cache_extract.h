@@ -78,6 +78,10 @@ typedef enum eMRDataType {
   MR_DATA_LOOPTRI = 1 << 3,
   /** Force loop normals calculation.  */
   MR_DATA_TAN_LOOP_NOR = 1 << 4,
+  /** Position of the triangles of every polygon in the material sorted index buffer. */
+  MR_DATA_POLYS_SORTED = 1 << 5,
+  /** Loop setting every edge and vertex in the lines and points index buffers. */
+  MR_DATA_ELEM_OWNER = 1 << 6,
 } eMRDataType;
 
 typedef enum eMRExtractType {
@@ -146,6 +150,20 @@ typedef struct MeshBufferCache {
   GPUIndexBuf **tris_per_mat;
 } MeshBufferCache;
 
+/**
+ * Data computed while extracting a #MeshBufferCache that only depends on the topology of the
+ * mesh, kept to speed up later extractions from the same mesh.
+ */
+typedef struct MeshBufferExtractionCache {
+  struct {
+    int edge_len;
+    int vert_len;
+    int *edges;
+    int *verts;
+    bool is_valid;
+  } loose_geom;
+} MeshBufferExtractionCache;
+
 typedef enum DRWBatchFlag {
   MBC_SURFACE = (1 << 0),
   MBC_SURFACE_WEIGHTS = (1 << 1),
@@ -191,6 +209,10 @@ typedef enum DRWBatchFlag {
 typedef struct MeshBatchCache {
   MeshBufferCache final, cage, uv_cage;
 
+  MeshBufferExtractionCache final_extraction_cache;
+  MeshBufferExtractionCache cage_extraction_cache;
+  MeshBufferExtractionCache uv_cage_extraction_cache;
+
   struct {
     /* Surfaces / Render */
     GPUBatch *surface;
@@ -263,6 +285,7 @@ typedef struct MeshBatchCache {
 void mesh_buffer_cache_create_requested(struct TaskGraph *task_graph,
                                         MeshBatchCache *cache,
                                         MeshBufferCache mbc,
+                                        MeshBufferExtractionCache *extraction_cache,
                                         Mesh *me,
                                         const bool is_editmode,
                                         const bool is_paint_mode,
@@ -274,4 +297,8 @@ void mesh_buffer_cache_create_requested(struct TaskGraph *task_graph,
                                         const DRW_MeshCDMask *cd_layer_used,
                                         const Scene *scene,
                                         const ToolSettings *ts,
-                                        const bool use_hide);
+                                        const bool use_hide,
+                                        const int chunk_size);
+
+/* Number of elements extracted by each range task, smaller meshes are extracted in one task. */
+#define MESH_EXTRACT_CHUNK_SIZE 8192
@@ -132,45 +132,82 @@ typedef struct MeshRenderData {
   float (*loop_normals)[3];
   float (*poly_normals)[3];
   int *lverts, *ledges;
+  struct {
+    /** Index of the first triangle of every polygon in the sorted buffer, -1 when hidden. */
+    int *tri_first_index;
+    /** Number of visible triangles of every material. */
+    int *mat_tri_len;
+    int visible_tri_len;
+  } poly_sorted;
+  struct {
+    /** Last loop using every edge, the only one setting the edge in the lines index buffer. */
+    int *edge_loop;
+    /**
+     * Last loop (or loose edge or loose vertex loop) using every vertex, the only one setting the
+     * vertex in the points index buffer.
+     */
+    int *vert_loop;
+  } elem_owner;
 } MeshRenderData;
 
+static void mesh_render_data_loose_geom_build(const MeshRenderData *mr,
+                                              MeshBufferExtractionCache *cache)
+{
+  int edge_loose_len = 0;
+  int vert_loose_len = 0;
+
+  BLI_bitmap *lvert_map = BLI_BITMAP_NEW(mr->vert_len, __func__);
+
+  int *ledges = MEM_mallocN(mr->edge_len * sizeof(*ledges), __func__);
+  const MEdge *med = mr->medge;
+  for (int med_index = 0; med_index < mr->edge_len; med_index++, med++) {
+    if (med->flag & ME_LOOSEEDGE) {
+      ledges[edge_loose_len++] = med_index;
+    }
+    /* Tag verts as not loose. */
+    BLI_BITMAP_ENABLE(lvert_map, med->v1);
+    BLI_BITMAP_ENABLE(lvert_map, med->v2);
+  }
+  if (edge_loose_len < mr->edge_len) {
+    ledges = MEM_reallocN(ledges, edge_loose_len * sizeof(*ledges));
+  }
+
+  int *lverts = MEM_mallocN(mr->vert_len * sizeof(*lverts), __func__);
+  for (int v = 0; v < mr->vert_len; v++) {
+    if (!BLI_BITMAP_TEST(lvert_map, v)) {
+      lverts[vert_loose_len++] = v;
+    }
+  }
+  if (vert_loose_len < mr->vert_len) {
+    lverts = MEM_reallocN(lverts, vert_loose_len * sizeof(*lverts));
+  }
+
+  MEM_freeN(lvert_map);
+
+  cache->loose_geom.edges = ledges;
+  cache->loose_geom.verts = lverts;
+  cache->loose_geom.edge_len = edge_loose_len;
+  cache->loose_geom.vert_len = vert_loose_len;
+  cache->loose_geom.is_valid = true;
+}
+
 static void mesh_render_data_update_loose_geom(MeshRenderData *mr,
+                                               MeshBufferExtractionCache *cache,
                                                const eMRIterType iter_type,
                                                const eMRDataType UNUSED(data_flag))
 {
   if (mr->extract_type != MR_EXTRACT_BMESH) {
     /* Mesh */
     if (iter_type & (MR_ITER_LEDGE | MR_ITER_LVERT)) {
-      mr->vert_loose_len = 0;
-      mr->edge_loose_len = 0;
-
-      BLI_bitmap *lvert_map = BLI_BITMAP_NEW(mr->vert_len, __func__);
-
-      mr->ledges = MEM_mallocN(mr->edge_len * sizeof(int), __func__);
-      const MEdge *med = mr->medge;
-      for (int med_index = 0; med_index < mr->edge_len; med_index++, med++) {
-        if (med->flag & ME_LOOSEEDGE) {
-          mr->ledges[mr->edge_loose_len++] = med_index;
-        }
-        /* Tag verts as not loose. */
-        BLI_BITMAP_ENABLE(lvert_map, med->v1);
-        BLI_BITMAP_ENABLE(lvert_map, med->v2);
-      }
-      if (mr->edge_loose_len < mr->edge_len) {
-        mr->ledges = MEM_reallocN(mr->ledges, mr->edge_loose_len * sizeof(*mr->ledges));
-      }
-
-      mr->lverts = MEM_mallocN(mr->vert_len * sizeof(*mr->lverts), __func__);
-      for (int v = 0; v < mr->vert_len; v++) {
-        if (!BLI_BITMAP_TEST(lvert_map, v)) {
-          mr->lverts[mr->vert_loose_len++] = v;
-        }
-      }
-      if (mr->vert_loose_len < mr->vert_len) {
-        mr->lverts = MEM_reallocN(mr->lverts, mr->vert_loose_len * sizeof(*mr->lverts));
+      /* Owned by the cache, which is cleared when the mesh is replaced by one with a different
+       * topology. Not done for #BMesh, its topology changes while editing. */
+      if (!cache->loose_geom.is_valid) {
+        mesh_render_data_loose_geom_build(mr, cache);
       }
-
-      MEM_freeN(lvert_map);
+      mr->ledges = cache->loose_geom.edges;
+      mr->lverts = cache->loose_geom.verts;
+      mr->edge_loose_len = cache->loose_geom.edge_len;
+      mr->vert_loose_len = cache->loose_geom.vert_len;
 
       mr->loop_loose_len = mr->vert_loose_len + (mr->edge_loose_len * 2);
     }
@@ -236,6 +273,178 @@ static void mesh_render_data_update_looptris(MeshRenderData *mr,
   }
 }
 
+/* Polygons are sorted in chunks to compute the offsets in parallel. */
+#define MR_POLYS_SORTED_CHUNK_SIZE 1024
+
+typedef struct PolysSortedTaskData {
+  const MeshRenderData *mr;
+  int *tri_first_index;
+  /** Triangle count, then offset, of every material in every chunk. */
+  int *chunk_mat_tri;
+} PolysSortedTaskData;
+
+BLI_INLINE int mesh_render_data_poly_mat_get(const MeshRenderData *mr, const int poly_index)
+{
+  if (mr->extract_type == MR_EXTRACT_BMESH) {
+    const BMFace *efa = BM_face_at_index(mr->bm, poly_index);
+    if (BM_elem_flag_test(efa, BM_ELEM_HIDDEN)) {
+      return -1;
+    }
+    return min_ii(efa->mat_nr, mr->mat_len - 1);
+  }
+  const MPoly *mp = &mr->mpoly[poly_index];
+  if (mr->use_hide && (mp->flag & ME_HIDE)) {
+    return -1;
+  }
+  return min_ii(mp->mat_nr, mr->mat_len - 1);
+}
+
+BLI_INLINE int mesh_render_data_poly_tri_len_get(const MeshRenderData *mr, const int poly_index)
+{
+  if (mr->extract_type == MR_EXTRACT_BMESH) {
+    return BM_face_at_index(mr->bm, poly_index)->len - 2;
+  }
+  return mr->mpoly[poly_index].totloop - 2;
+}
+
+static void mesh_render_data_polys_sorted_count_cb(void *__restrict userdata,
+                                                   const int chunk,
+                                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PolysSortedTaskData *data = userdata;
+  const MeshRenderData *mr = data->mr;
+  int *mat_tri_len = &data->chunk_mat_tri[chunk * mr->mat_len];
+  const int start = chunk * MR_POLYS_SORTED_CHUNK_SIZE;
+  const int end = min_ii(start + MR_POLYS_SORTED_CHUNK_SIZE, mr->poly_len);
+  for (int i = start; i < end; i++) {
+    const int mat = mesh_render_data_poly_mat_get(mr, i);
+    if (mat != -1) {
+      mat_tri_len[mat] += mesh_render_data_poly_tri_len_get(mr, i);
+    }
+  }
+}
+
+static void mesh_render_data_polys_sorted_assign_cb(void *__restrict userdata,
+                                                    const int chunk,
+                                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PolysSortedTaskData *data = userdata;
+  const MeshRenderData *mr = data->mr;
+  int *mat_tri_ofs = &data->chunk_mat_tri[chunk * mr->mat_len];
+  const int start = chunk * MR_POLYS_SORTED_CHUNK_SIZE;
+  const int end = min_ii(start + MR_POLYS_SORTED_CHUNK_SIZE, mr->poly_len);
+  for (int i = start; i < end; i++) {
+    const int mat = mesh_render_data_poly_mat_get(mr, i);
+    if (mat != -1) {
+      data->tri_first_index[i] = mat_tri_ofs[mat];
+      mat_tri_ofs[mat] += mesh_render_data_poly_tri_len_get(mr, i);
+    }
+    else {
+      data->tri_first_index[i] = -1;
+    }
+  }
+}
+
+/**
+ * Sort the triangles of visible polygons by material, keeping the polygon order within each
+ * material. Triangles are counted per material in every chunk of polygons, the offsets of every
+ * chunk come from a prefix sum over the materials then the chunks, so that the triangle indices
+ * can be assigned in parallel and extraction doesn't need a serial pass.
+ */
+static void mesh_render_data_update_polys_sorted(MeshRenderData *mr,
+                                                 const eMRDataType data_flag)
+{
+  if ((data_flag & MR_DATA_POLYS_SORTED) == 0) {
+    return;
+  }
+  const int chunks_len = divide_ceil_u(mr->poly_len, MR_POLYS_SORTED_CHUNK_SIZE);
+  PolysSortedTaskData data = {
+      .mr = mr,
+      .tri_first_index = MEM_mallocN(sizeof(int) * mr->poly_len, __func__),
+      .chunk_mat_tri = MEM_callocN(sizeof(int) * max_ii(chunks_len, 1) * mr->mat_len, __func__),
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  BLI_task_parallel_range(
+      0, chunks_len, &data, mesh_render_data_polys_sorted_count_cb, &settings);
+
+  int *mat_tri_len = MEM_callocN(sizeof(int) * mr->mat_len, __func__);
+  int ofs = 0;
+  for (int mat = 0; mat < mr->mat_len; mat++) {
+    for (int chunk = 0; chunk < chunks_len; chunk++) {
+      int *chunk_tri = &data.chunk_mat_tri[chunk * mr->mat_len + mat];
+      const int tri_len = *chunk_tri;
+      *chunk_tri = ofs;
+      ofs += tri_len;
+      mat_tri_len[mat] += tri_len;
+    }
+  }
+
+  BLI_task_parallel_range(
+      0, chunks_len, &data, mesh_render_data_polys_sorted_assign_cb, &settings);
+  MEM_freeN(data.chunk_mat_tri);
+
+  mr->poly_sorted.tri_first_index = data.tri_first_index;
+  mr->poly_sorted.mat_tri_len = mat_tri_len;
+  mr->poly_sorted.visible_tri_len = ofs;
+}
+
+/**
+ * Index buffer elements shared by several loops are only set by their owner, so that extraction
+ * ranges never write the same element. The owner is the last writer of a serial extraction.
+ */
+static void mesh_render_data_update_elem_owner(MeshRenderData *mr, const eMRDataType data_flag)
+{
+  if ((data_flag & MR_DATA_ELEM_OWNER) == 0) {
+    return;
+  }
+  int *edge_loop = MEM_mallocN(sizeof(int) * mr->edge_len, __func__);
+  int *vert_loop = MEM_mallocN(sizeof(int) * mr->vert_len, __func__);
+  copy_vn_i(edge_loop, mr->edge_len, -1);
+  copy_vn_i(vert_loop, mr->vert_len, -1);
+
+  if (mr->extract_type == MR_EXTRACT_BMESH) {
+    BMIter iter;
+    BMFace *efa;
+    BM_ITER_MESH (efa, &iter, mr->bm, BM_FACES_OF_MESH) {
+      BMLoop *l_iter, *l_first;
+      l_iter = l_first = BM_FACE_FIRST_LOOP(efa);
+      do {
+        const int l_index = BM_elem_index_get(l_iter);
+        int *e_owner = &edge_loop[BM_elem_index_get(l_iter->e)];
+        int *v_owner = &vert_loop[BM_elem_index_get(l_iter->v)];
+        *e_owner = max_ii(*e_owner, l_index);
+        *v_owner = max_ii(*v_owner, l_index);
+      } while ((l_iter = l_iter->next) != l_first);
+    }
+    for (int i = 0; i < mr->edge_loose_len; i++) {
+      const BMEdge *eed = BM_edge_at_index(mr->bm, mr->ledges[i]);
+      vert_loop[BM_elem_index_get(eed->v1)] = mr->loop_len + (i * 2);
+      vert_loop[BM_elem_index_get(eed->v2)] = mr->loop_len + (i * 2) + 1;
+    }
+  }
+  else {
+    const MLoop *ml = mr->mloop;
+    for (int ml_index = 0; ml_index < mr->loop_len; ml_index++, ml++) {
+      edge_loop[ml->e] = ml_index;
+      vert_loop[ml->v] = ml_index;
+    }
+    for (int i = 0; i < mr->edge_loose_len; i++) {
+      const MEdge *med = &mr->medge[mr->ledges[i]];
+      vert_loop[med->v1] = mr->loop_len + (i * 2);
+      vert_loop[med->v2] = mr->loop_len + (i * 2) + 1;
+    }
+  }
+  const int lvert_ofs = mr->loop_len + (mr->edge_loose_len * 2);
+  for (int i = 0; i < mr->vert_loose_len; i++) {
+    vert_loop[mr->lverts[i]] = lvert_ofs + i;
+  }
+
+  mr->elem_owner.edge_loop = edge_loop;
+  mr->elem_owner.vert_loop = vert_loop;
+}
+
 static void mesh_render_data_update_normals(MeshRenderData *mr,
                                             const eMRIterType UNUSED(iter_type),
                                             const eMRDataType data_flag)
@@ -317,6 +526,7 @@ static void mesh_render_data_update_normals(MeshRenderData *mr,
  * otherwise don't use modifiers as they are not from this object.
  */
 static MeshRenderData *mesh_render_data_create(Mesh *me,
+                                               MeshBufferExtractionCache *cache,
                                                const bool is_editmode,
                                                const bool is_paint_mode,
                                                const bool is_mode_active,
@@ -435,7 +645,7 @@ static MeshRenderData *mesh_render_data_create(Mesh *me,
     mr->poly_len = bm->totface;
     mr->tri_len = poly_to_tri_count(mr->poly_len, mr->loop_len);
   }
-  mesh_render_data_update_loose_geom(mr, iter_type, data_flag);
+  mesh_render_data_update_loose_geom(mr, cache, iter_type, data_flag);
 
   return mr;
 }
@@ -446,8 +656,15 @@ static void mesh_render_data_free(MeshRenderData *mr)
   MEM_SAFE_FREE(mr->poly_normals);
   MEM_SAFE_FREE(mr->loop_normals);
 
-  MEM_SAFE_FREE(mr->lverts);
-  MEM_SAFE_FREE(mr->ledges);
+  if (mr->extract_type == MR_EXTRACT_BMESH) {
+    MEM_SAFE_FREE(mr->lverts);
+    MEM_SAFE_FREE(mr->ledges);
+  }
+
+  MEM_SAFE_FREE(mr->poly_sorted.tri_first_index);
+  MEM_SAFE_FREE(mr->poly_sorted.mat_tri_len);
+  MEM_SAFE_FREE(mr->elem_owner.edge_loop);
+  MEM_SAFE_FREE(mr->elem_owner.vert_loop);
 
   MEM_freeN(mr);
 }
@@ -763,6 +980,8 @@ typedef void(ExtractFinishFn)(const MeshRenderData *mr,
                               struct MeshBatchCache *cache,
                               void *buffer,
                               void *data);
+typedef void *(ExtractTaskInitFn)(const MeshRenderData *mr, void *data);
+typedef void(ExtractTaskReduceFn)(const MeshRenderData *mr, void *data, void *task_data);
 
 typedef struct MeshExtract {
   /** Executed on main thread and return user data for iteration functions. */
@@ -776,6 +995,14 @@ typedef struct MeshExtract {
   ExtractLEdgeMeshFn *iter_ledge_mesh;
   ExtractLVertBMeshFn *iter_lvert_bm;
   ExtractLVertMeshFn *iter_lvert_mesh;
+  /**
+   * Optional, executed on the worker thread of each range task (only when the extraction is
+   * split), returns data local to the range that is passed to the iteration functions instead of
+   * the user data. Used when ranges can't write to the user data directly.
+   */
+  ExtractTaskInitFn *task_init;
+  /** Merges and frees the data of #task_init, called for every range in order before finish. */
+  ExtractTaskReduceFn *task_reduce;
   /** Executed on one worker thread after all elements iterations. */
   ExtractFinishFn *finish;
   /** Used to request common data. */
@@ -794,118 +1021,97 @@ BLI_INLINE eMRIterType mesh_extract_iter_type(const MeshExtract *ext)
   return type;
 }
 
+/* Range data for extractors whose user data is an index buffer builder. */
+static void *extract_elb_task_init(const MeshRenderData *UNUSED(mr), void *elb)
+{
+  GPUIndexBufBuilder *sub_builder = MEM_mallocN(sizeof(*sub_builder), __func__);
+  GPU_indexbuf_subbuilder_init(elb, sub_builder);
+  return sub_builder;
+}
+
+static void extract_elb_task_reduce(const MeshRenderData *UNUSED(mr),
+                                    void *elb,
+                                    void *sub_builder)
+{
+  GPU_indexbuf_join(elb, sub_builder);
+  MEM_freeN(sub_builder);
+}
+
 /** \} */
 
 /* ---------------------------------------------------------------------- */
 /** \name Extract Triangles Indices
  * \{ */
 
-typedef struct MeshExtract_Tri_Data {
-  GPUIndexBufBuilder elb;
-  int *tri_mat_start;
-  int *tri_mat_end;
-} MeshExtract_Tri_Data;
-
 static void *extract_tris_init(const MeshRenderData *mr,
                                struct MeshBatchCache *UNUSED(cache),
                                void *UNUSED(ibo))
 {
-  MeshExtract_Tri_Data *data = MEM_callocN(sizeof(*data), __func__);
-
-  size_t mat_tri_idx_size = sizeof(int) * mr->mat_len;
-  data->tri_mat_start = MEM_callocN(mat_tri_idx_size, __func__);
-  data->tri_mat_end = MEM_callocN(mat_tri_idx_size, __func__);
-
-  int *mat_tri_len = data->tri_mat_start;
-  /* Count how many triangle for each material. */
-  if (mr->extract_type == MR_EXTRACT_BMESH) {
-    BMIter iter;
-    BMFace *efa;
-    BM_ITER_MESH (efa, &iter, mr->bm, BM_FACES_OF_MESH) {
-      if (!BM_elem_flag_test(efa, BM_ELEM_HIDDEN)) {
-        int mat = min_ii(efa->mat_nr, mr->mat_len - 1);
-        mat_tri_len[mat] += efa->len - 2;
-      }
-    }
-  }
-  else {
-    const MPoly *mp = mr->mpoly;
-    for (int mp_index = 0; mp_index < mr->poly_len; mp_index++, mp++) {
-      if (!(mr->use_hide && (mp->flag & ME_HIDE))) {
-        int mat = min_ii(mp->mat_nr, mr->mat_len - 1);
-        mat_tri_len[mat] += mp->totloop - 2;
-      }
-    }
-  }
-  /* Accumulate triangle lengths per material to have correct offsets. */
-  int ofs = mat_tri_len[0];
-  mat_tri_len[0] = 0;
-  for (int i = 1; i < mr->mat_len; i++) {
-    int tmp = mat_tri_len[i];
-    mat_tri_len[i] = ofs;
-    ofs += tmp;
-  }
-
-  memcpy(data->tri_mat_end, mat_tri_len, mat_tri_idx_size);
-
-  int visible_tri_tot = ofs;
-  GPU_indexbuf_init(&data->elb, GPU_PRIM_TRIS, visible_tri_tot, mr->loop_len);
-
-  return data;
+  GPUIndexBufBuilder *elb = MEM_mallocN(sizeof(*elb), __func__);
+  /* Triangles are sorted by material, see #mesh_render_data_update_polys_sorted. */
+  GPU_indexbuf_init(elb, GPU_PRIM_TRIS, mr->poly_sorted.visible_tri_len, mr->loop_len);
+  return elb;
 }
 
-static void extract_tris_iter_looptri_bm(const MeshRenderData *mr,
-                                         const struct ExtractTriBMesh_Params *params,
-                                         void *_data)
+static void extract_tris_iter_poly_bm(const MeshRenderData *mr,
+                                      const ExtractPolyBMesh_Params *params,
+                                      void *elb)
 {
-  MeshExtract_Tri_Data *data = _data;
-  const int mat_last = mr->mat_len - 1;
-  EXTRACT_TRIS_LOOPTRI_FOREACH_BM_BEGIN(elt, _elt_index, params)
+  const int *tri_first_index = mr->poly_sorted.tri_first_index;
+  BMLoop *(*looptris)[3] = mr->edit_bmesh->looptris;
+  EXTRACT_POLY_FOREACH_BM_BEGIN(f, f_index, params, mr)
   {
-    if (!BM_elem_flag_test(elt[0]->f, BM_ELEM_HIDDEN)) {
-      int *mat_tri_ofs = data->tri_mat_end;
-      const int mat = min_ii(elt[0]->f->mat_nr, mat_last);
-      GPU_indexbuf_set_tri_verts(&data->elb,
-                                 mat_tri_ofs[mat]++,
+    const int tri_first = tri_first_index[f_index];
+    if (tri_first == -1) {
+      continue;
+    }
+    const int looptri_first = poly_to_tri_count(f_index,
+                                                BM_elem_index_get(BM_FACE_FIRST_LOOP(f)));
+    const int tri_len = f->len - 2;
+    for (int i = 0; i < tri_len; i++) {
+      BMLoop **elt = looptris[looptri_first + i];
+      GPU_indexbuf_set_tri_verts(elb,
+                                 tri_first + i,
                                  BM_elem_index_get(elt[0]),
                                  BM_elem_index_get(elt[1]),
                                  BM_elem_index_get(elt[2]));
     }
   }
-  EXTRACT_TRIS_LOOPTRI_FOREACH_BM_END;
+  EXTRACT_POLY_FOREACH_BM_END;
 }
 
-static void extract_tris_iter_looptri_mesh(const MeshRenderData *mr,
-                                           const struct ExtractTriMesh_Params *params,
-                                           void *_data)
+static void extract_tris_iter_poly_mesh(const MeshRenderData *mr,
+                                        const ExtractPolyMesh_Params *params,
+                                        void *elb)
 {
-  MeshExtract_Tri_Data *data = _data;
-  const int mat_last = mr->mat_len - 1;
-  EXTRACT_TRIS_LOOPTRI_FOREACH_MESH_BEGIN(mlt, _mlt_index, params)
+  const int *tri_first_index = mr->poly_sorted.tri_first_index;
+  EXTRACT_POLY_FOREACH_MESH_BEGIN(mp, mp_index, params, mr)
   {
-    const MPoly *mp = &mr->mpoly[mlt->poly];
-    if (!(mr->use_hide && (mp->flag & ME_HIDE))) {
-      int *mat_tri_ofs = data->tri_mat_end;
-      const int mat = min_ii(mp->mat_nr, mat_last);
-      GPU_indexbuf_set_tri_verts(
-          &data->elb, mat_tri_ofs[mat]++, mlt->tri[0], mlt->tri[1], mlt->tri[2]);
+    const int tri_first = tri_first_index[mp_index];
+    if (tri_first == -1) {
+      continue;
+    }
+    const MLoopTri *mlt = &mr->mlooptri[poly_to_tri_count(mp_index, mp->loopstart)];
+    const int tri_len = mp->totloop - 2;
+    for (int i = 0; i < tri_len; i++, mlt++) {
+      GPU_indexbuf_set_tri_verts(elb, tri_first + i, mlt->tri[0], mlt->tri[1], mlt->tri[2]);
     }
   }
-  EXTRACT_TRIS_LOOPTRI_FOREACH_MESH_END;
+  EXTRACT_POLY_FOREACH_MESH_END;
 }
 
 static void extract_tris_finish(const MeshRenderData *mr,
                                 struct MeshBatchCache *cache,
                                 void *ibo,
-                                void *_data)
+                                void *elb)
 {
-  MeshExtract_Tri_Data *data = _data;
-  GPU_indexbuf_build_in_place(&data->elb, ibo);
+  GPU_indexbuf_build_in_place(elb, ibo);
 
   /* Create ibo sub-ranges. Always do this to avoid error when the standard surface batch
    * is created before the surfaces-per-material. */
   if (mr->use_final_mesh && cache->final.tris_per_mat) {
     MeshBufferCache *mbc = &cache->final;
+    int mat_start = 0;
     for (int i = 0; i < mr->mat_len; i++) {
       /* These IBOs have not been queried yet but we create them just in case they are needed
        * later since they are not tracked by mesh_buffer_cache_create_requested(). */
@@ -913,25 +1119,25 @@ static void extract_tris_finish(const MeshRenderData *mr,
         mbc->tris_per_mat[i] = GPU_indexbuf_calloc();
       }
       /* Multiply by 3 because these are triangle indices. */
-      const int mat_start = data->tri_mat_start[i];
-      const int mat_end = data->tri_mat_end[i];
+      const int mat_tri_len = mr->poly_sorted.mat_tri_len[i];
       const int start = mat_start * 3;
-      const int len = (mat_end - mat_start) * 3;
+      const int len = mat_tri_len * 3;
       GPU_indexbuf_create_subrange_in_place(mbc->tris_per_mat[i], ibo, start, len);
+      mat_start += mat_tri_len;
     }
   }
-  MEM_freeN(data->tri_mat_start);
-  MEM_freeN(data->tri_mat_end);
-  MEM_freeN(data);
+  MEM_freeN(elb);
 }
 
 static const MeshExtract extract_tris = {
     .init = extract_tris_init,
-    .iter_looptri_bm = extract_tris_iter_looptri_bm,
-    .iter_looptri_mesh = extract_tris_iter_looptri_mesh,
+    .iter_poly_bm = extract_tris_iter_poly_bm,
+    .iter_poly_mesh = extract_tris_iter_poly_mesh,
+    .task_init = extract_elb_task_init,
+    .task_reduce = extract_elb_task_reduce,
     .finish = extract_tris_finish,
-    .data_flag = 0,
-    .use_threading = false,
+    .data_flag = MR_DATA_LOOPTRI | MR_DATA_POLYS_SORTED,
+    .use_threading = true,
 };
 
 /** \} */
@@ -956,13 +1162,17 @@ static void extract_lines_iter_poly_bm(const MeshRenderData *mr,
                                        void *elb)
 {
   /* Using poly & loop iterator would complicate accessing the adjacent loop. */
+  const int *edge_loop = mr->elem_owner.edge_loop;
   EXTRACT_POLY_FOREACH_BM_BEGIN(f, f_index, params, mr)
   {
     BMLoop *l_iter, *l_first;
     /* Use #BMLoop.prev to match mesh order (to avoid minor differences in data extraction). */
     l_iter = l_first = BM_FACE_FIRST_LOOP(f)->prev;
     do {
-      if (!BM_elem_flag_test(l_iter->e, BM_ELEM_HIDDEN)) {
+      if (edge_loop[BM_elem_index_get(l_iter->e)] != BM_elem_index_get(l_iter)) {
+        /* Another polygon sets this edge. */
+      }
+      else if (!BM_elem_flag_test(l_iter->e, BM_ELEM_HIDDEN)) {
         GPU_indexbuf_set_line_verts(elb,
                                     BM_elem_index_get(l_iter->e),
                                     BM_elem_index_get(l_iter),
@@ -983,6 +1193,7 @@ static void extract_lines_iter_poly_mesh(const MeshRenderData *mr,
   /* Using poly & loop iterator would complicate accessing the adjacent loop. */
   const MLoop *mloop = mr->mloop;
   const MEdge *medge = mr->medge;
+  const int *edge_loop = mr->elem_owner.edge_loop;
   if (mr->use_hide || (mr->extract_type == MR_EXTRACT_MAPPED) || (mr->e_origindex != NULL)) {
     EXTRACT_POLY_FOREACH_MESH_BEGIN(mp, mp_index, params, mr)
     {
@@ -991,9 +1202,12 @@ static void extract_lines_iter_poly_mesh(const MeshRenderData *mr,
       do {
         const MLoop *ml = &mloop[ml_index];
         const MEdge *med = &medge[ml->e];
-        if (!((mr->use_hide && (med->flag & ME_HIDE)) ||
-              ((mr->extract_type == MR_EXTRACT_MAPPED) && (mr->e_origindex) &&
-               (mr->e_origindex[ml->e] == ORIGINDEX_NONE)))) {
+        if (edge_loop[ml->e] != ml_index) {
+          /* Another polygon sets this edge. */
+        }
+        else if (!((mr->use_hide && (med->flag & ME_HIDE)) ||
+                   ((mr->extract_type == MR_EXTRACT_MAPPED) && (mr->e_origindex) &&
+                    (mr->e_origindex[ml->e] == ORIGINDEX_NONE)))) {
           GPU_indexbuf_set_line_verts(elb, ml->e, ml_index, ml_index_next);
         }
         else {
@@ -1010,7 +1224,9 @@ static void extract_lines_iter_poly_mesh(const MeshRenderData *mr,
       int ml_index = ml_index_last, ml_index_next = mp->loopstart;
       do {
         const MLoop *ml = &mloop[ml_index];
-        GPU_indexbuf_set_line_verts(elb, ml->e, ml_index, ml_index_next);
+        if (edge_loop[ml->e] == ml_index) {
+          GPU_indexbuf_set_line_verts(elb, ml->e, ml_index, ml_index_next);
+        }
       } while ((ml_index = ml_index_next++) != ml_index_last);
     }
     EXTRACT_POLY_FOREACH_MESH_END;
@@ -1075,9 +1291,11 @@ static const MeshExtract extract_lines = {
     .iter_poly_mesh = extract_lines_iter_poly_mesh,
     .iter_ledge_bm = extract_lines_iter_ledge_bm,
     .iter_ledge_mesh = extract_lines_iter_ledge_mesh,
+    .task_init = extract_elb_task_init,
+    .task_reduce = extract_elb_task_reduce,
     .finish = extract_lines_finish,
-    .data_flag = 0,
-    .use_threading = false,
+    .data_flag = MR_DATA_ELEM_OWNER,
+    .use_threading = true,
 };
 /** \} */
 
@@ -1112,9 +1330,11 @@ static const MeshExtract extract_lines_with_lines_loose = {
     .iter_poly_mesh = extract_lines_iter_poly_mesh,
     .iter_ledge_bm = extract_lines_iter_ledge_bm,
     .iter_ledge_mesh = extract_lines_iter_ledge_mesh,
+    .task_init = extract_elb_task_init,
+    .task_reduce = extract_elb_task_reduce,
     .finish = extract_lines_with_lines_loose_finish,
-    .data_flag = 0,
-    .use_threading = false,
+    .data_flag = MR_DATA_ELEM_OWNER,
+    .use_threading = true,
 };
 
 /** \} */
@@ -1132,10 +1352,16 @@ static void *extract_points_init(const MeshRenderData *mr,
   return elb;
 }
 
-BLI_INLINE void vert_set_bm(GPUIndexBufBuilder *elb, BMVert *eve, int l_index)
+BLI_INLINE void vert_set_bm(GPUIndexBufBuilder *elb,
+                            const MeshRenderData *mr,
+                            BMVert *eve,
+                            int l_index)
 {
   const int v_index = BM_elem_index_get(eve);
-  if (!BM_elem_flag_test(eve, BM_ELEM_HIDDEN)) {
+  if (mr->elem_owner.vert_loop[v_index] != l_index) {
+    /* Another loop sets this vertex. */
+  }
+  else if (!BM_elem_flag_test(eve, BM_ELEM_HIDDEN)) {
     GPU_indexbuf_set_point_vert(elb, v_index, l_index);
   }
   else {
@@ -1149,9 +1375,12 @@ BLI_INLINE void vert_set_mesh(GPUIndexBufBuilder *elb,
                               const int l_index)
 {
   const MVert *mv = &mr->mvert[v_index];
-  if (!((mr->use_hide && (mv->flag & ME_HIDE)) ||
-        ((mr->extract_type == MR_EXTRACT_MAPPED) && (mr->v_origindex) &&
-         (mr->v_origindex[v_index] == ORIGINDEX_NONE)))) {
+  if (mr->elem_owner.vert_loop[v_index] != l_index) {
+    /* Another loop sets this vertex. */
+  }
+  else if (!((mr->use_hide && (mv->flag & ME_HIDE)) ||
+             ((mr->extract_type == MR_EXTRACT_MAPPED) && (mr->v_origindex) &&
+              (mr->v_origindex[v_index] == ORIGINDEX_NONE)))) {
     GPU_indexbuf_set_point_vert(elb, v_index, l_index);
   }
   else {
@@ -1165,7 +1394,7 @@ static void extract_points_iter_poly_bm(const MeshRenderData *mr,
 {
   EXTRACT_POLY_AND_LOOP_FOREACH_BM_BEGIN(l, l_index, params, mr)
   {
-    vert_set_bm(elb, l->v, l_index);
+    vert_set_bm(elb, mr, l->v, l_index);
   }
   EXTRACT_POLY_AND_LOOP_FOREACH_BM_END(l);
 }
@@ -1187,8 +1416,8 @@ static void extract_points_iter_ledge_bm(const MeshRenderData *mr,
 {
   EXTRACT_LEDGE_FOREACH_BM_BEGIN(eed, ledge_index, params)
   {
-    vert_set_bm(elb, eed->v1, mr->loop_len + (ledge_index * 2));
-    vert_set_bm(elb, eed->v2, mr->loop_len + (ledge_index * 2) + 1);
+    vert_set_bm(elb, mr, eed->v1, mr->loop_len + (ledge_index * 2));
+    vert_set_bm(elb, mr, eed->v2, mr->loop_len + (ledge_index * 2) + 1);
   }
   EXTRACT_LEDGE_FOREACH_BM_END;
 }
@@ -1212,7 +1441,7 @@ static void extract_points_iter_lvert_bm(const MeshRenderData *mr,
   const int offset = mr->loop_len + (mr->edge_loose_len * 2);
   EXTRACT_LVERT_FOREACH_BM_BEGIN(eve, lvert_index, params)
   {
-    vert_set_bm(elb, eve, offset + lvert_index);
+    vert_set_bm(elb, mr, eve, offset + lvert_index);
   }
   EXTRACT_LVERT_FOREACH_BM_END;
 }
@@ -1246,9 +1475,11 @@ static const MeshExtract extract_points = {
     .iter_ledge_mesh = extract_points_iter_ledge_mesh,
     .iter_lvert_bm = extract_points_iter_lvert_bm,
     .iter_lvert_mesh = extract_points_iter_lvert_mesh,
+    .task_init = extract_elb_task_init,
+    .task_reduce = extract_elb_task_reduce,
     .finish = extract_points_finish,
-    .data_flag = 0,
-    .use_threading = false,
+    .data_flag = MR_DATA_ELEM_OWNER,
+    .use_threading = true,
 };
 
 /** \} */
@@ -3849,6 +4080,14 @@ static const MeshExtract extract_edituv_data = {
 /** \name Extract Edit UV area stretch
  * \{ */
 
+typedef struct MeshExtract_StretchArea_Data {
+  int16_t *vbo_data;
+  const MLoopUV *luv;
+  int cd_ofs;
+  /** Areas of the iterated polygons, the whole mesh once ranges are merged. */
+  float tot_area, tot_uv_area;
+} MeshExtract_StretchArea_Data;
+
 static void *extract_edituv_stretch_area_init(const MeshRenderData *mr,
                                               struct MeshBatchCache *UNUSED(cache),
                                               void *buf)
@@ -3862,7 +4101,16 @@ static void *extract_edituv_stretch_area_init(const MeshRenderData *mr,
   GPU_vertbuf_init_with_format(vbo, &format);
   GPU_vertbuf_data_alloc(vbo, mr->loop_len);
 
-  return NULL;
+  MeshExtract_StretchArea_Data *data = MEM_callocN(sizeof(*data), __func__);
+  data->vbo_data = (int16_t *)GPU_vertbuf_get_data(vbo);
+  if (mr->extract_type == MR_EXTRACT_BMESH) {
+    data->cd_ofs = CustomData_get_offset(&mr->bm->ldata, CD_MLOOPUV);
+  }
+  else {
+    BLI_assert(ELEM(mr->extract_type, MR_EXTRACT_MAPPED, MR_EXTRACT_MESH));
+    data->luv = CustomData_get_layer(&mr->me->ldata, CD_MLOOPUV);
+  }
+  return data;
 }
 
 BLI_INLINE float area_ratio_get(float area, float uvarea)
@@ -3880,83 +4128,87 @@ BLI_INLINE float area_ratio_to_stretch(float ratio, float tot_ratio, float inv_t
   return (ratio > 1.0f) ? (1.0f / ratio) : ratio;
 }
 
-static void mesh_edituv_stretch_area_finish(const MeshRenderData *mr,
-                                            struct MeshBatchCache *cache,
-                                            void *buf,
-                                            void *UNUSED(data))
+static void extract_edituv_stretch_area_iter_poly_bm(const MeshRenderData *mr,
+                                                     const ExtractPolyBMesh_Params *params,
+                                                     void *_data)
 {
-  float tot_area = 0.0f, tot_uv_area = 0.0f;
-  float *area_ratio = MEM_mallocN(sizeof(float) * mr->poly_len, __func__);
-
-  if (mr->extract_type == MR_EXTRACT_BMESH) {
-    CustomData *cd_ldata = &mr->bm->ldata;
-    int uv_ofs = CustomData_get_offset(cd_ldata, CD_MLOOPUV);
-
-    BMFace *efa;
-    BMIter f_iter;
-    int f;
-    BM_ITER_MESH_INDEX (efa, &f_iter, mr->bm, BM_FACES_OF_MESH, f) {
-      float area = BM_face_calc_area(efa);
-      float uvarea = BM_face_calc_area_uv(efa, uv_ofs);
-      tot_area += area;
-      tot_uv_area += uvarea;
-      area_ratio[f] = area_ratio_get(area, uvarea);
-    }
-  }
-  else {
-    BLI_assert(ELEM(mr->extract_type, MR_EXTRACT_MAPPED, MR_EXTRACT_MESH));
-    const MLoopUV *uv_data = CustomData_get_layer(&mr->me->ldata, CD_MLOOPUV);
-    const MPoly *mp = mr->mpoly;
-    for (int mp_index = 0; mp_index < mr->poly_len; mp_index++, mp++) {
-      float area = BKE_mesh_calc_poly_area(mp, &mr->mloop[mp->loopstart], mr->mvert);
-      float uvarea = BKE_mesh_calc_poly_uv_area(mp, uv_data);
-      tot_area += area;
-      tot_uv_area += uvarea;
-      area_ratio[mp_index] = area_ratio_get(area, uvarea);
+  MeshExtract_StretchArea_Data *data = _data;
+  EXTRACT_POLY_FOREACH_BM_BEGIN(f, f_index, params, mr)
+  {
+    const float area = BM_face_calc_area(f);
+    const float uvarea = BM_face_calc_area_uv(f, data->cd_ofs);
+    data->tot_area += area;
+    data->tot_uv_area += uvarea;
+    /* Copy face data for each loop. */
+    const int16_t stretch = area_ratio_get(area, uvarea) * SHRT_MAX;
+    int16_t *loop_stretch = &data->vbo_data[BM_elem_index_get(BM_FACE_FIRST_LOOP(f))];
+    for (int i = 0; i < f->len; i++) {
+      loop_stretch[i] = stretch;
     }
   }
+  EXTRACT_POLY_FOREACH_BM_END;
+}
 
-  cache->tot_area = tot_area;
-  cache->tot_uv_area = tot_uv_area;
-
-  /* Convert in place to avoid an extra allocation */
-  uint16_t *poly_stretch = (uint16_t *)area_ratio;
-  for (int mp_index = 0; mp_index < mr->poly_len; mp_index++) {
-    poly_stretch[mp_index] = area_ratio[mp_index] * SHRT_MAX;
+static void extract_edituv_stretch_area_iter_poly_mesh(const MeshRenderData *mr,
+                                                       const ExtractPolyMesh_Params *params,
+                                                       void *_data)
+{
+  MeshExtract_StretchArea_Data *data = _data;
+  EXTRACT_POLY_FOREACH_MESH_BEGIN(mp, mp_index, params, mr)
+  {
+    const float area = BKE_mesh_calc_poly_area(mp, &mr->mloop[mp->loopstart], mr->mvert);
+    const float uvarea = BKE_mesh_calc_poly_uv_area(mp, data->luv);
+    data->tot_area += area;
+    data->tot_uv_area += uvarea;
+    /* Copy face data for each loop. */
+    const int16_t stretch = area_ratio_get(area, uvarea) * SHRT_MAX;
+    int16_t *loop_stretch = &data->vbo_data[mp->loopstart];
+    for (int i = 0; i < mp->totloop; i++) {
+      loop_stretch[i] = stretch;
+    }
   }
+  EXTRACT_POLY_FOREACH_MESH_END;
+}
 
-  /* Copy face data for each loop. */
-  GPUVertBuf *vbo = buf;
-  uint16_t *loop_stretch = (uint16_t *)GPU_vertbuf_get_data(vbo);
+static void *extract_edituv_stretch_area_task_init(const MeshRenderData *UNUSED(mr), void *data)
+{
+  MeshExtract_StretchArea_Data *task_data = MEM_dupallocN(data);
+  task_data->tot_area = 0.0f;
+  task_data->tot_uv_area = 0.0f;
+  return task_data;
+}
 
-  if (mr->extract_type == MR_EXTRACT_BMESH) {
-    BMFace *efa;
-    BMIter f_iter;
-    int f, l_index = 0;
-    BM_ITER_MESH_INDEX (efa, &f_iter, mr->bm, BM_FACES_OF_MESH, f) {
-      for (int i = 0; i < efa->len; i++, l_index++) {
-        loop_stretch[l_index] = poly_stretch[f];
-      }
-    }
-  }
-  else {
-    BLI_assert(ELEM(mr->extract_type, MR_EXTRACT_MAPPED, MR_EXTRACT_MESH));
-    const MPoly *mp = mr->mpoly;
-    for (int mp_index = 0, l_index = 0; mp_index < mr->poly_len; mp_index++, mp++) {
-      for (int i = 0; i < mp->totloop; i++, l_index++) {
-        loop_stretch[l_index] = poly_stretch[mp_index];
-      }
-    }
-  }
+static void extract_edituv_stretch_area_task_reduce(const MeshRenderData *UNUSED(mr),
+                                                    void *_data,
+                                                    void *_task_data)
+{
+  MeshExtract_StretchArea_Data *data = _data;
+  MeshExtract_StretchArea_Data *task_data = _task_data;
+  data->tot_area += task_data->tot_area;
+  data->tot_uv_area += task_data->tot_uv_area;
+  MEM_freeN(task_data);
+}
 
-  MEM_freeN(area_ratio);
+static void extract_edituv_stretch_area_finish(const MeshRenderData *UNUSED(mr),
+                                               struct MeshBatchCache *cache,
+                                               void *UNUSED(buf),
+                                               void *_data)
+{
+  MeshExtract_StretchArea_Data *data = _data;
+  cache->tot_area = data->tot_area;
+  cache->tot_uv_area = data->tot_uv_area;
+  MEM_freeN(data);
 }
 
 static const MeshExtract extract_edituv_stretch_area = {
     .init = extract_edituv_stretch_area_init,
-    .finish = mesh_edituv_stretch_area_finish,
+    .iter_poly_bm = extract_edituv_stretch_area_iter_poly_bm,
+    .iter_poly_mesh = extract_edituv_stretch_area_iter_poly_mesh,
+    .task_init = extract_edituv_stretch_area_task_init,
+    .task_reduce = extract_edituv_stretch_area_task_reduce,
+    .finish = extract_edituv_stretch_area_finish,
     .data_flag = 0,
-    .use_threading = false,
+    .use_threading = true,
 };
 
 /** \} */
@@ -4139,6 +4391,19 @@ static void extract_edituv_stretch_angle_iter_poly_mesh(const MeshRenderData *mr
   EXTRACT_POLY_AND_LOOP_FOREACH_MESH_END;
 }
 
+/* The previous edges are kept in the data while iterating, every range needs its own copy. */
+static void *extract_edituv_stretch_angle_task_init(const MeshRenderData *UNUSED(mr), void *data)
+{
+  return MEM_dupallocN(data);
+}
+
+static void extract_edituv_stretch_angle_task_reduce(const MeshRenderData *UNUSED(mr),
+                                                     void *UNUSED(data),
+                                                     void *task_data)
+{
+  MEM_freeN(task_data);
+}
+
 static void extract_edituv_stretch_angle_finish(const MeshRenderData *UNUSED(mr),
                                                 struct MeshBatchCache *UNUSED(cache),
                                                 void *UNUSED(buf),
@@ -4151,9 +4416,11 @@ static const MeshExtract extract_edituv_stretch_angle = {
     .init = extract_edituv_stretch_angle_init,
     .iter_poly_bm = extract_edituv_stretch_angle_iter_poly_bm,
     .iter_poly_mesh = extract_edituv_stretch_angle_iter_poly_mesh,
+    .task_init = extract_edituv_stretch_angle_task_init,
+    .task_reduce = extract_edituv_stretch_angle_task_reduce,
     .finish = extract_edituv_stretch_angle_finish,
     .data_flag = 0,
-    .use_threading = false,
+    .use_threading = true,
 };
 
 /** \} */
@@ -5495,6 +5762,9 @@ static const MeshExtract extract_fdot_idx = {
  * \{ */
 typedef struct ExtractUserData {
   void *user_data;
+  /** Data of #MeshExtract.task_init for each range task, merged in order by the last task. */
+  void **task_user_datas;
+  int task_user_datas_len;
 } ExtractUserData;
 
 typedef enum ExtractTaskDataType {
@@ -5510,6 +5780,8 @@ typedef struct ExtractTaskData {
   ExtractTaskDataType tasktype;
   eMRIterType iter_type;
   int start, end;
+  /** Index of the range task in #ExtractUserData.task_user_datas. */
+  int task_index;
   /** Decremented each time a task is finished. */
   int32_t *task_counter;
   void *buf;
@@ -5542,6 +5814,7 @@ static ExtractTaskData *extract_task_data_create_mesh_extract(const MeshRenderDa
   taskdata->task_counter = task_counter;
   taskdata->start = 0;
   taskdata->end = INT_MAX;
+  taskdata->task_index = 0;
   return taskdata;
 }
 
@@ -5558,6 +5831,9 @@ static ExtractTaskData *extract_task_data_create_lines_loose(const MeshRenderDat
 static void extract_task_data_free(void *data)
 {
   ExtractTaskData *task_data = data;
+  if (task_data->user_data) {
+    MEM_SAFE_FREE(task_data->user_data->task_user_datas);
+  }
   MEM_SAFE_FREE(task_data->user_data);
   MEM_freeN(task_data);
 }
@@ -5651,17 +5927,26 @@ static void extract_run(void *__restrict taskdata)
 {
   ExtractTaskData *data = (ExtractTaskData *)taskdata;
   if (data->tasktype == EXTRACT_MESH_EXTRACT) {
-    mesh_extract_iter(data->mr,
-                      data->iter_type,
-                      data->start,
-                      data->end,
-                      data->extract,
-                      data->user_data->user_data);
-
-    /* If this is the last task, we do the finish function. */
+    ExtractUserData *extract_user_data = data->user_data;
+    const MeshExtract *extract = data->extract;
+    void *user_data = extract_user_data->user_data;
+    if (extract_user_data->task_user_datas != NULL) {
+      user_data = extract->task_init(data->mr, extract_user_data->user_data);
+      extract_user_data->task_user_datas[data->task_index] = user_data;
+    }
+
+    mesh_extract_iter(data->mr, data->iter_type, data->start, data->end, extract, user_data);
+
+    /* If this is the last task, we merge the ranges and do the finish function. */
     int remainin_tasks = atomic_sub_and_fetch_int32(data->task_counter, 1);
-    if (remainin_tasks == 0 && data->extract->finish != NULL) {
-      data->extract->finish(data->mr, data->cache, data->buf, data->user_data->user_data);
+    if (remainin_tasks == 0) {
+      for (int i = 0; i < extract_user_data->task_user_datas_len; i++) {
+        extract->task_reduce(
+            data->mr, extract_user_data->user_data, extract_user_data->task_user_datas[i]);
+      }
+      if (extract->finish != NULL) {
+        extract->finish(data->mr, data->cache, data->buf, extract_user_data->user_data);
+      }
     }
   }
   else if (data->tasktype == EXTRACT_LINES_LOOSE) {
@@ -5703,6 +5988,8 @@ static void mesh_extract_render_data_node_exec(void *__restrict task_data)
 
   mesh_render_data_update_normals(mr, iter_type, data_flag);
   mesh_render_data_update_looptris(mr, iter_type, data_flag);
+  mesh_render_data_update_polys_sorted(mr, data_flag);
+  mesh_render_data_update_elem_owner(mr, data_flag);
 }
 
 static struct TaskNode *mesh_extract_render_data_node_create(struct TaskGraph *task_graph,
@@ -5813,13 +6100,15 @@ static void extract_range_task_create(struct TaskGraph *task_graph,
                                       ExtractTaskData *taskdata,
                                       const eMRIterType type,
                                       int start,
-                                      int length)
+                                      int length,
+                                      int *task_index)
 {
   taskdata = MEM_dupallocN(taskdata);
   atomic_add_and_fetch_int32(taskdata->task_counter, 1);
   taskdata->iter_type = type;
   taskdata->start = start;
   taskdata->end = start + length;
+  taskdata->task_index = (*task_index)++;
   struct TaskNode *task_node = BLI_task_graph_node_create(
       task_graph, extract_run, taskdata, MEM_freeN);
   BLI_task_graph_edge_create(task_node_user_data_init, task_node);
@@ -5835,7 +6124,8 @@ static void extract_task_create(struct TaskGraph *task_graph,
                                 MeshBatchCache *cache,
                                 const MeshExtract *extract,
                                 void *buf,
-                                int32_t *task_counter)
+                                int32_t *task_counter,
+                                const int chunk_size)
 {
   BLI_assert(scene != NULL);
   const bool do_hq_normals = (scene->r.perf_flag & SCE_PERF_HQ_NORMALS) != 0 ||
@@ -5860,35 +6150,86 @@ static void extract_task_create(struct TaskGraph *task_graph,
       mr, cache, extract, buf, task_counter);
 
   /* Simple heuristic. */
-  const int chunk_size = 8192;
   const bool use_thread = (mr->loop_len + mr->loop_loose_len) > chunk_size;
   if (use_thread && extract->use_threading) {
+    if (extract->task_init != NULL) {
+      /* Ranges have their own data, allocate room for it in the shared user data. */
+      ExtractUserData *extract_user_data = taskdata->user_data;
+      int tasks_len = 0;
+      if (taskdata->iter_type & MR_ITER_LOOPTRI) {
+        tasks_len += divide_ceil_u(mr->tri_len, chunk_size);
+      }
+      if (taskdata->iter_type & MR_ITER_POLY) {
+        tasks_len += divide_ceil_u(mr->poly_len, chunk_size);
+      }
+      if (taskdata->iter_type & MR_ITER_LEDGE) {
+        tasks_len += divide_ceil_u(mr->edge_loose_len, chunk_size);
+      }
+      if (taskdata->iter_type & MR_ITER_LVERT) {
+        tasks_len += divide_ceil_u(mr->vert_loose_len, chunk_size);
+      }
+      /* At least one task is needed for the finish function to run. */
+      tasks_len = max_ii(tasks_len, 1);
+      extract_user_data->task_user_datas = MEM_callocN(sizeof(void *) * tasks_len, __func__);
+      extract_user_data->task_user_datas_len = tasks_len;
+    }
 
     /* Divide task into sensible chunks. */
+    int task_index = 0;
     if (taskdata->iter_type & MR_ITER_LOOPTRI) {
       for (int i = 0; i < mr->tri_len; i += chunk_size) {
-        extract_range_task_create(
-            task_graph, task_node_user_data_init, taskdata, MR_ITER_LOOPTRI, i, chunk_size);
+        extract_range_task_create(task_graph,
+                                  task_node_user_data_init,
+                                  taskdata,
+                                  MR_ITER_LOOPTRI,
+                                  i,
+                                  chunk_size,
+                                  &task_index);
       }
     }
     if (taskdata->iter_type & MR_ITER_POLY) {
       for (int i = 0; i < mr->poly_len; i += chunk_size) {
-        extract_range_task_create(
-            task_graph, task_node_user_data_init, taskdata, MR_ITER_POLY, i, chunk_size);
+        extract_range_task_create(task_graph,
+                                  task_node_user_data_init,
+                                  taskdata,
+                                  MR_ITER_POLY,
+                                  i,
+                                  chunk_size,
+                                  &task_index);
       }
     }
     if (taskdata->iter_type & MR_ITER_LEDGE) {
       for (int i = 0; i < mr->edge_loose_len; i += chunk_size) {
-        extract_range_task_create(
-            task_graph, task_node_user_data_init, taskdata, MR_ITER_LEDGE, i, chunk_size);
+        extract_range_task_create(task_graph,
+                                  task_node_user_data_init,
+                                  taskdata,
+                                  MR_ITER_LEDGE,
+                                  i,
+                                  chunk_size,
+                                  &task_index);
       }
     }
     if (taskdata->iter_type & MR_ITER_LVERT) {
       for (int i = 0; i < mr->vert_loose_len; i += chunk_size) {
-        extract_range_task_create(
-            task_graph, task_node_user_data_init, taskdata, MR_ITER_LVERT, i, chunk_size);
+        extract_range_task_create(task_graph,
+                                  task_node_user_data_init,
+                                  taskdata,
+                                  MR_ITER_LVERT,
+                                  i,
+                                  chunk_size,
+                                  &task_index);
       }
     }
+    if (task_index == 0) {
+      /* Nothing to iterate, still finish the buffer. */
+      extract_range_task_create(task_graph,
+                                task_node_user_data_init,
+                                taskdata,
+                                taskdata->iter_type,
+                                0,
+                                0,
+                                &task_index);
+    }
     BLI_addtail(user_data_init_task_datas, taskdata);
   }
   else if (use_thread) {
@@ -5908,6 +6249,7 @@ static void extract_task_create(struct TaskGraph *task_graph,
 void mesh_buffer_cache_create_requested(struct TaskGraph *task_graph,
                                         MeshBatchCache *cache,
                                         MeshBufferCache mbc,
+                                        MeshBufferExtractionCache *extraction_cache,
                                         Mesh *me,
 
                                         const bool is_editmode,
@@ -5920,7 +6262,8 @@ void mesh_buffer_cache_create_requested(struct TaskGraph *task_graph,
                                         const DRW_MeshCDMask *cd_layer_used,
                                         const Scene *scene,
                                         const ToolSettings *ts,
-                                        const bool use_hide)
+                                        const bool use_hide,
+                                        const int chunk_size)
 {
   /* For each mesh where batches needs to be updated a sub-graph will be added to the task_graph.
    * This sub-graph starts with an extract_render_data_node. This fills/converts the required data
@@ -5929,9 +6272,9 @@ void mesh_buffer_cache_create_requested(struct TaskGraph *task_graph,
    * Small extractions and extractions that can't be multi-threaded are grouped in a single
    * `extract_single_threaded_task_node`.
    *
-   * Other extractions will create a node for each loop exceeding 8192 items. these nodes are
-   * linked to the `user_data_init_task_node`. the `user_data_init_task_node` prepares the
-   * user_data needed for the extraction based on the data extracted from the mesh.
+   * Other extractions will create a node for each loop exceeding `chunk_size` items.
+   * these nodes are linked to the `user_data_init_task_node`. the `user_data_init_task_node`
+   * prepares the user_data needed for the extraction based on the data extracted from the mesh.
    * counters are used to check if the finalize of a task has to be called.
    *
    *                           Mesh extraction sub graph
@@ -6011,6 +6354,7 @@ void mesh_buffer_cache_create_requested(struct TaskGraph *task_graph,
 #endif
 
   MeshRenderData *mr = mesh_render_data_create(me,
+                                               extraction_cache,
                                                is_editmode,
                                                is_paint_mode,
                                                is_mode_active,
@@ -6055,7 +6399,8 @@ void mesh_buffer_cache_create_requested(struct TaskGraph *task_graph,
                         cache, \
                         &extract_##name, \
                         mbc.buf.name, \
-                        &task_counters[counter_used++]); \
+                        &task_counters[counter_used++], \
+                        chunk_size); \
   } \
   ((void)0)
 
@@ -6100,7 +6445,8 @@ void mesh_buffer_cache_create_requested(struct TaskGraph *task_graph,
                         cache,
                         lines_extractor,
                         mbc.ibo.lines,
-                        &task_counters[counter_used++]);
+                        &task_counters[counter_used++],
+                        chunk_size);
   }
   else {
     if (do_lines_loose_subbuffer) {
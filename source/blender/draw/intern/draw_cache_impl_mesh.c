@@ -31,6 +31,7 @@
 #include "BLI_edgehash.h"
 #include "BLI_listbase.h"
 #include "BLI_math_bits.h"
+#include "BLI_math_geom.h"
 #include "BLI_math_vector.h"
 #include "BLI_string.h"
 #include "BLI_task.h"
@@ -602,6 +603,47 @@ static void mesh_batch_cache_discard_uvedit(MeshBatchCache *cache)
   mesh_batch_cache_discard_surface_batches(cache);
 }
 
+/* Discard everything that depends on vertex positions, keeping index buffers and the vertex
+ * buffers of other attributes. */
+static void mesh_batch_cache_discard_deform(MeshBatchCache *cache, const Mesh *me)
+{
+  /* The triangulation of polygons with more than three sides can depend on the positions. */
+  const bool has_non_tris = me->totloop != poly_to_tri_count(me->totpoly, me->totloop) * 3;
+  if (has_non_tris) {
+    FOREACH_MESH_BUFFER_CACHE (cache, mbufcache) {
+      GPU_INDEXBUF_DISCARD_SAFE(mbufcache->ibo.tris);
+      GPU_INDEXBUF_DISCARD_SAFE(mbufcache->ibo.lines_adjacency);
+      GPU_INDEXBUF_DISCARD_SAFE(mbufcache->ibo.edituv_tris);
+    }
+    for (int i = 0; i < cache->mat_len; i++) {
+      GPU_INDEXBUF_DISCARD_SAFE(cache->final.tris_per_mat[i]);
+    }
+  }
+  FOREACH_MESH_BUFFER_CACHE (cache, mbufcache) {
+    GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.pos_nor);
+    GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.lnor);
+    GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.tan);
+    GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.edge_fac);
+    GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.edituv_stretch_area);
+    GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.edituv_stretch_angle);
+    GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.mesh_analysis);
+    GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.fdots_pos);
+    GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.fdots_nor);
+    GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.skin_roots);
+  }
+  /* All batches use at least one of these buffers. */
+  for (int i = 0; i < sizeof(cache->batch) / sizeof(void *); i++) {
+    GPUBatch **batch = (GPUBatch **)&cache->batch;
+    GPU_BATCH_DISCARD_SAFE(batch[i]);
+  }
+  mesh_batch_cache_discard_surface_batches(cache);
+
+  cache->tot_area = 0.0f;
+  cache->tot_uv_area = 0.0f;
+
+  cache->batch_ready = 0;
+}
+
 static void mesh_batch_cache_discard_uvedit_select(MeshBatchCache *cache)
 {
   FOREACH_MESH_BUFFER_CACHE (cache, mbufcache) {
@@ -674,6 +716,9 @@ void DRW_mesh_batch_cache_dirty_tag(Mesh *me, eMeshBatchDirtyMode mode)
     case BKE_MESH_BATCH_DIRTY_UVEDIT_ALL:
       mesh_batch_cache_discard_uvedit(cache);
       break;
+    case BKE_MESH_BATCH_DIRTY_DEFORM:
+      mesh_batch_cache_discard_deform(cache, me);
+      break;
     case BKE_MESH_BATCH_DIRTY_UVEDIT_SELECT:
       FOREACH_MESH_BUFFER_CACHE (cache, mbufcache) {
         GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.edituv_data);
@@ -692,6 +737,15 @@ void DRW_mesh_batch_cache_dirty_tag(Mesh *me, eMeshBatchDirtyMode mode)
   }
 }
 
+static void mesh_buffer_extraction_cache_clear(MeshBufferExtractionCache *extraction_cache)
+{
+  MEM_SAFE_FREE(extraction_cache->loose_geom.edges);
+  MEM_SAFE_FREE(extraction_cache->loose_geom.verts);
+  extraction_cache->loose_geom.edge_len = 0;
+  extraction_cache->loose_geom.vert_len = 0;
+  extraction_cache->loose_geom.is_valid = false;
+}
+
 static void mesh_batch_cache_clear(Mesh *me)
 {
   MeshBatchCache *cache = me->runtime.batch_cache;
@@ -699,6 +753,10 @@ static void mesh_batch_cache_clear(Mesh *me)
   if (!cache) {
     return;
   }
+  mesh_buffer_extraction_cache_clear(&cache->final_extraction_cache);
+  mesh_buffer_extraction_cache_clear(&cache->cage_extraction_cache);
+  mesh_buffer_extraction_cache_clear(&cache->uv_cage_extraction_cache);
+
   FOREACH_MESH_BUFFER_CACHE (cache, mbufcache) {
     GPUVertBuf **vbos = (GPUVertBuf **)&mbufcache->vbo;
     GPUIndexBuf **ibos = (GPUIndexBuf **)&mbufcache->ibo;
@@ -1529,6 +1587,7 @@ void DRW_mesh_batch_cache_create_requested(struct TaskGraph *task_graph,
     mesh_buffer_cache_create_requested(task_graph,
                                        cache,
                                        cache->uv_cage,
+                                       &cache->uv_cage_extraction_cache,
                                        me,
                                        is_editmode,
                                        is_paint_mode,
@@ -1540,13 +1599,15 @@ void DRW_mesh_batch_cache_create_requested(struct TaskGraph *task_graph,
                                        &cache->cd_used,
                                        scene,
                                        ts,
-                                       true);
+                                       true,
+                                       MESH_EXTRACT_CHUNK_SIZE);
   }
 
   if (do_cage) {
     mesh_buffer_cache_create_requested(task_graph,
                                        cache,
                                        cache->cage,
+                                       &cache->cage_extraction_cache,
                                        me,
                                        is_editmode,
                                        is_paint_mode,
@@ -1558,12 +1619,14 @@ void DRW_mesh_batch_cache_create_requested(struct TaskGraph *task_graph,
                                        &cache->cd_used,
                                        scene,
                                        ts,
-                                       true);
+                                       true,
+                                       MESH_EXTRACT_CHUNK_SIZE);
   }
 
   mesh_buffer_cache_create_requested(task_graph,
                                      cache,
                                      cache->final,
+                                     &cache->final_extraction_cache,
                                      me,
                                      is_editmode,
                                      is_paint_mode,
@@ -1575,7 +1638,8 @@ void DRW_mesh_batch_cache_create_requested(struct TaskGraph *task_graph,
                                      &cache->cd_used,
                                      scene,
                                      ts,
-                                     use_hide);
+                                     use_hide,
+                                     MESH_EXTRACT_CHUNK_SIZE);
 
   /* Ensure that all requested batches have finished.
    * Ideally we want to remove this sync, but there are cases where this doesn't work.
@@ -0,0 +1,241 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <iostream>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_index_range.hh"
+#include "BLI_math_matrix.h"
+#include "BLI_task.h"
+#include "BLI_timeit.hh"
+#include "BLI_vector.hh"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "GPU_batch.h"
+
+#include "gpu_index_buffer_private.hh"
+
+#include "tests/blenkernel_testing.hh"
+
+extern "C" {
+#include "intern/draw_cache_extract.h"
+}
+
+namespace blender::draw::tests {
+
+using DrawExtractMeshTest = bke::tests::MeshTest;
+
+/** Index buffer that is never uploaded, so the extracted indices can be read back. */
+class TestIndexBuf : public gpu::IndexBuf {
+ public:
+  /** Indices of the buffer, undoing the 16 bit compression of #IndexBuf::init. */
+  Vector<uint32_t> indices() const
+  {
+    BLI_assert(!is_subrange_);
+    Vector<uint32_t> indices(index_len_);
+    for (const int i : IndexRange(index_len_)) {
+      if (index_type_ == gpu::GPU_INDEX_U16) {
+        const uint16_t index = static_cast<const uint16_t *>(data_)[i];
+        indices[i] = (index == 0xFFFF) ? 0xFFFFFFFF : index + index_base_;
+      }
+      else {
+        indices[i] = static_cast<const uint32_t *>(data_)[i];
+      }
+    }
+    return indices;
+  }
+
+  uint32_t start() const
+  {
+    return index_start_;
+  }
+};
+
+static constexpr int MAT_LEN = 3;
+static constexpr int LOOSE_EDGE_LEN = 2;
+
+struct ExtractedIndexBuffers {
+  TestIndexBuf tris;
+  TestIndexBuf tris_per_mat[MAT_LEN];
+  TestIndexBuf lines;
+  TestIndexBuf lines_loose;
+  TestIndexBuf points;
+};
+
+/**
+ * A grid with materials, hidden elements, loose edges and a loose vertex, so that every kind of
+ * range (triangles, polygons, loose edges and loose vertices) is extracted. One loose edge uses a
+ * vertex of the grid, which is then set by a loose edge instead of a polygon.
+ */
+static Mesh *create_test_mesh(const int resolution)
+{
+  Mesh *grid = bke::tests::create_grid_mesh(resolution);
+  Mesh *mesh = BKE_mesh_new_nomain_from_template(
+      grid, grid->totvert + 3, grid->totedge + LOOSE_EDGE_LEN, 0, grid->totloop, grid->totpoly);
+  CustomData_copy_data(&grid->vdata, &mesh->vdata, 0, 0, grid->totvert);
+  CustomData_copy_data(&grid->edata, &mesh->edata, 0, 0, grid->totedge);
+  CustomData_copy_data(&grid->ldata, &mesh->ldata, 0, 0, grid->totloop);
+  CustomData_copy_data(&grid->pdata, &mesh->pdata, 0, 0, grid->totpoly);
+
+  const int loose_vert = grid->totvert;
+  for (const int i : IndexRange(3)) {
+    MVert &vert = mesh->mvert[loose_vert + i];
+    vert.co[0] = -1.0f - (float)i;
+    vert.co[1] = vert.co[2] = 0.0f;
+    vert.flag = 0;
+  }
+  for (const int i : IndexRange(LOOSE_EDGE_LEN)) {
+    MEdge &loose_edge = mesh->medge[grid->totedge + i];
+    loose_edge.v1 = (i == 0) ? loose_vert + 1 : 1;
+    loose_edge.v2 = loose_vert + 2;
+    loose_edge.flag = ME_EDGEDRAW | ME_EDGERENDER | ME_LOOSEEDGE;
+  }
+
+  mesh->totcol = MAT_LEN;
+  for (const int i : IndexRange(mesh->totpoly)) {
+    mesh->mpoly[i].mat_nr = i % MAT_LEN;
+    SET_FLAG_FROM_TEST(mesh->mpoly[i].flag, i % 11 == 0, ME_HIDE);
+  }
+  for (const int i : IndexRange(grid->totedge)) {
+    SET_FLAG_FROM_TEST(mesh->medge[i].flag, i % 13 == 0, ME_HIDE);
+  }
+  for (const int i : IndexRange(grid->totvert)) {
+    SET_FLAG_FROM_TEST(mesh->mvert[i].flag, i % 17 == 0, ME_HIDE);
+  }
+
+  BKE_id_free(nullptr, grid);
+  return mesh;
+}
+
+static void extract_index_buffers(Mesh *mesh, const int chunk_size, ExtractedIndexBuffers &r_ibos)
+{
+  GPUIndexBuf *tris_per_mat[MAT_LEN];
+  for (const int i : IndexRange(MAT_LEN)) {
+    tris_per_mat[i] = gpu::wrap(&r_ibos.tris_per_mat[i]);
+  }
+  MeshBatchCache cache = {};
+  cache.mat_len = MAT_LEN;
+  MeshBufferCache &mbc = cache.final;
+  mbc.ibo.tris = gpu::wrap(&r_ibos.tris);
+  mbc.ibo.lines = gpu::wrap(&r_ibos.lines);
+  mbc.ibo.lines_loose = gpu::wrap(&r_ibos.lines_loose);
+  mbc.ibo.points = gpu::wrap(&r_ibos.points);
+  mbc.tris_per_mat = tris_per_mat;
+
+  MeshBufferExtractionCache extraction_cache = {};
+  DRW_MeshCDMask cd_layer_used = {};
+  Scene scene = {};
+  float obmat[4][4];
+  unit_m4(obmat);
+
+  TaskGraph *task_graph = BLI_task_graph_create();
+  mesh_buffer_cache_create_requested(task_graph,
+                                     &cache,
+                                     mbc,
+                                     &extraction_cache,
+                                     mesh,
+                                     false,
+                                     false,
+                                     false,
+                                     obmat,
+                                     true,
+                                     false,
+                                     false,
+                                     &cd_layer_used,
+                                     &scene,
+                                     nullptr,
+                                     true,
+                                     chunk_size);
+  BLI_task_graph_work_and_wait(task_graph);
+  BLI_task_graph_free(task_graph);
+
+  MEM_SAFE_FREE(extraction_cache.loose_geom.edges);
+  MEM_SAFE_FREE(extraction_cache.loose_geom.verts);
+}
+
+static void expect_indices_eq(const TestIndexBuf &a, const TestIndexBuf &b)
+{
+  const Vector<uint32_t> indices_a = a.indices();
+  const Vector<uint32_t> indices_b = b.indices();
+  ASSERT_EQ(indices_a.size(), indices_b.size());
+  EXPECT_EQ_ARRAY(indices_a.data(), indices_b.data(), indices_a.size());
+}
+
+static void expect_subrange_eq(const TestIndexBuf &a, const TestIndexBuf &b)
+{
+  EXPECT_TRUE(a.is_init());
+  EXPECT_EQ(a.start(), b.start());
+  EXPECT_EQ(a.index_len_get(), b.index_len_get());
+}
+
+TEST_F(DrawExtractMeshTest, extract_index_buffers_split_matches_single_range)
+{
+  Mesh *mesh = create_test_mesh(40);
+
+  /* A chunk size larger than the mesh extracts everything in a single range. */
+  ExtractedIndexBuffers single_range;
+  extract_index_buffers(mesh, INT_MAX, single_range);
+
+  int visible_tri_len = 0;
+  for (const int i : IndexRange(mesh->totpoly)) {
+    visible_tri_len += (mesh->mpoly[i].flag & ME_HIDE) ? 0 : mesh->mpoly[i].totloop - 2;
+  }
+  EXPECT_EQ(single_range.tris.index_len_get(), visible_tri_len * 3);
+  /* Loose edges are added again at the end. */
+  EXPECT_EQ(single_range.lines.index_len_get(), (mesh->totedge + LOOSE_EDGE_LEN) * 2);
+  EXPECT_EQ(single_range.lines_loose.index_len_get(), LOOSE_EDGE_LEN * 2);
+  EXPECT_EQ(single_range.points.index_len_get(), mesh->totvert);
+  /* The grid vertex used by the second loose edge is set by that edge. */
+  EXPECT_EQ(single_range.points.indices()[1], mesh->totloop + 2);
+
+  /* Small chunk sizes split every extraction into many ranges. */
+  for (const int chunk_size : {1, 7, 100, 1000}) {
+    SCOPED_TRACE(chunk_size);
+    ExtractedIndexBuffers split;
+    extract_index_buffers(mesh, chunk_size, split);
+
+    expect_indices_eq(split.tris, single_range.tris);
+    expect_indices_eq(split.lines, single_range.lines);
+    expect_indices_eq(split.points, single_range.points);
+    expect_subrange_eq(split.lines_loose, single_range.lines_loose);
+    for (const int i : IndexRange(MAT_LEN)) {
+      expect_subrange_eq(split.tris_per_mat[i], single_range.tris_per_mat[i]);
+    }
+  }
+
+  BKE_id_free(nullptr, mesh);
+}
+
+/**
+ * Time the extraction of the index buffers of a large grid in a single range and split in ranges
+ * of the default size. Disabled by default, run it with: `blender_test
+ * --gtest_filter=*extract_index_buffers_performance* --gtest_also_run_disabled_tests`.
+ */
+TEST_F(DrawExtractMeshTest, DISABLED_extract_index_buffers_performance)
+{
+  Mesh *mesh = create_test_mesh(1000);
+  for (const int chunk_size : {INT_MAX, MESH_EXTRACT_CHUNK_SIZE}) {
+    timeit::Nanoseconds total_time{0};
+    for (int i = 0; i < 5; i++) {
+      ExtractedIndexBuffers ibos;
+      const timeit::TimePoint start = timeit::Clock::now();
+      extract_index_buffers(mesh, chunk_size, ibos);
+      total_time += timeit::Clock::now() - start;
+    }
+    std::cout << "Chunk size " << chunk_size << ": ";
+    timeit::print_duration(total_time / 5);
+    std::cout << "\n";
+  }
+  BKE_id_free(nullptr, mesh);
+}
+
+}  // namespace blender::draw::tests
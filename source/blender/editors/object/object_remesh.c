@@ -161,8 +161,9 @@ static int voxel_remesh_exec(bContext *C, wmOperator *op)
     BKE_mesh_calc_normals(new_mesh);
   }
 
-  if (mesh->flag & ME_REMESH_REPROJECT_VOLUME || mesh->flag & ME_REMESH_REPROJECT_PAINT_MASK ||
-      mesh->flag & ME_REMESH_REPROJECT_SCULPT_FACE_SETS) {
+  /* Clear the BVH trees of the original mesh once, they are then shared by all reprojections. */
+  if (mesh->flag & (ME_REMESH_REPROJECT_VOLUME | ME_REMESH_REPROJECT_PAINT_MASK |
+                    ME_REMESH_REPROJECT_SCULPT_FACE_SETS | ME_REMESH_REPROJECT_VERTEX_COLORS)) {
     BKE_mesh_runtime_clear_geometry(mesh);
   }
 
@@ -170,19 +171,15 @@ static int voxel_remesh_exec(bContext *C, wmOperator *op)
     BKE_shrinkwrap_remesh_target_project(new_mesh, mesh, ob);
   }
 
-  if (mesh->flag & ME_REMESH_REPROJECT_PAINT_MASK) {
-    BKE_mesh_remesh_reproject_paint_mask(new_mesh, mesh);
-  }
+  BKE_remesh_reproject_vertex_data(new_mesh,
+                                   mesh,
+                                   mesh->flag & ME_REMESH_REPROJECT_PAINT_MASK,
+                                   mesh->flag & ME_REMESH_REPROJECT_VERTEX_COLORS);
 
   if (mesh->flag & ME_REMESH_REPROJECT_SCULPT_FACE_SETS) {
     BKE_remesh_reproject_sculpt_face_sets(new_mesh, mesh);
   }
 
-  if (mesh->flag & ME_REMESH_REPROJECT_VERTEX_COLORS) {
-    BKE_mesh_runtime_clear_geometry(mesh);
-    BKE_remesh_reproject_vertex_paint(new_mesh, mesh);
-  }
-
   BKE_mesh_nomain_to_mesh(new_mesh, mesh, ob, &CD_MASK_MESH, true);
 
   if (mesh->flag & ME_REMESH_SMOOTH_NORMALS) {
@@ -34,6 +34,8 @@
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
 
+#include "atomic_ops.h"
+
 #include "BLT_translation.h"
 
 #include "PIL_time.h"
@@ -1192,6 +1194,185 @@ void SCULPT_floodfill_execute(
   }
 }
 
+/* Vertices are claimed by the front vertex with the lowest order, which is the one that would
+ * visit them first in #SCULPT_floodfill_execute. */
+#define FLOODFILL_NOT_VISITED INT_MAX
+#define FLOODFILL_VISITED -1
+#define FLOODFILL_CHUNK_SIZE 256
+
+typedef struct SculptFloodFillParallelData {
+  SculptSession *ss;
+  bool (*func)(SculptSession *ss, int from_v, int to_v, bool is_duplicate, void *userdata);
+  void *userdata;
+
+  const int *front;
+  int front_len;
+  /* Visiting order of the first vertex of the front, the orders of all fronts are consecutive. */
+  int front_order;
+  /* Order of the front vertex that visits every vertex, or one of the #FLOODFILL_ values. */
+  int *visited_by;
+
+  /* The next front of every chunk of the front, they are concatenated in order. */
+  int **chunk_next;
+  int *chunk_next_len;
+  int *chunk_next_alloc;
+} SculptFloodFillParallelData;
+
+static void floodfill_claim_task_cb(void *__restrict userdata,
+                                    const int i,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SculptFloodFillParallelData *data = userdata;
+  SculptSession *ss = data->ss;
+  const int from_v = data->front[i];
+  const int order = data->front_order + i;
+
+  SculptVertexNeighborIter ni;
+  SCULPT_VERTEX_DUPLICATES_AND_NEIGHBORS_ITER_BEGIN (ss, from_v, ni) {
+    const int to_v = ni.index;
+    int visited_by = data->visited_by[to_v];
+    if (visited_by <= order) {
+      continue;
+    }
+    if (!SCULPT_vertex_visible_get(ss, to_v)) {
+      continue;
+    }
+    while (visited_by > order) {
+      const int prev = atomic_cas_int32(&data->visited_by[to_v], visited_by, order);
+      if (prev == visited_by) {
+        break;
+      }
+      visited_by = prev;
+    }
+  }
+  SCULPT_VERTEX_NEIGHBORS_ITER_END(ni);
+}
+
+static void floodfill_visit_task_cb(void *__restrict userdata,
+                                    const int chunk,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SculptFloodFillParallelData *data = userdata;
+  SculptSession *ss = data->ss;
+  const int start = chunk * FLOODFILL_CHUNK_SIZE;
+  const int end = min_ii(start + FLOODFILL_CHUNK_SIZE, data->front_len);
+
+  data->chunk_next_len[chunk] = 0;
+  for (int i = start; i < end; i++) {
+    const int from_v = data->front[i];
+    const int order = data->front_order + i;
+
+    SculptVertexNeighborIter ni;
+    SCULPT_VERTEX_DUPLICATES_AND_NEIGHBORS_ITER_BEGIN (ss, from_v, ni) {
+      const int to_v = ni.index;
+      /* Only the claiming vertex accesses the vertex at this point. */
+      if (data->visited_by[to_v] != order) {
+        continue;
+      }
+      data->visited_by[to_v] = FLOODFILL_VISITED;
+
+      if (!data->func(ss, from_v, to_v, ni.is_duplicate, data->userdata)) {
+        continue;
+      }
+      if (data->chunk_next_len[chunk] == data->chunk_next_alloc[chunk]) {
+        data->chunk_next_alloc[chunk] = max_ii(data->chunk_next_alloc[chunk] * 2,
+                                               FLOODFILL_CHUNK_SIZE);
+        data->chunk_next[chunk] = MEM_reallocN(data->chunk_next[chunk],
+                                               sizeof(int) * data->chunk_next_alloc[chunk]);
+      }
+      data->chunk_next[chunk][data->chunk_next_len[chunk]++] = to_v;
+    }
+    SCULPT_VERTEX_NEIGHBORS_ITER_END(ni);
+  }
+}
+
+void SCULPT_floodfill_execute_parallel(
+    SculptSession *ss,
+    SculptFloodFill *flood,
+    bool (*func)(SculptSession *ss, int from_v, int to_v, bool is_duplicate, void *userdata),
+    void *userdata)
+{
+  const int totvert = SCULPT_vertex_count_get(ss);
+
+  int *visited_by = MEM_malloc_arrayN(totvert, sizeof(int), __func__);
+  for (int i = 0; i < totvert; i++) {
+    visited_by[i] = BLI_BITMAP_TEST(flood->visited_vertices, i) ? FLOODFILL_VISITED :
+                                                                  FLOODFILL_NOT_VISITED;
+  }
+
+  int front_len = (int)BLI_gsqueue_len(flood->queue);
+  int front_alloc = max_ii(front_len, FLOODFILL_CHUNK_SIZE);
+  int *front = MEM_malloc_arrayN(front_alloc, sizeof(int), __func__);
+  for (int i = 0; i < front_len; i++) {
+    BLI_gsqueue_pop(flood->queue, &front[i]);
+  }
+
+  SculptFloodFillParallelData data = {
+      .ss = ss,
+      .func = func,
+      .userdata = userdata,
+      .visited_by = visited_by,
+  };
+  int chunks_alloc = 0;
+
+  while (front_len > 0) {
+    const int chunks_len = (front_len + FLOODFILL_CHUNK_SIZE - 1) / FLOODFILL_CHUNK_SIZE;
+    if (chunks_len > chunks_alloc) {
+      data.chunk_next = MEM_recallocN(data.chunk_next, sizeof(int *) * chunks_len);
+      data.chunk_next_len = MEM_recallocN(data.chunk_next_len, sizeof(int) * chunks_len);
+      data.chunk_next_alloc = MEM_recallocN(data.chunk_next_alloc, sizeof(int) * chunks_len);
+      chunks_alloc = chunks_len;
+    }
+    data.front = front;
+    data.front_len = front_len;
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = FLOODFILL_CHUNK_SIZE;
+    BLI_task_parallel_range(0, front_len, &data, floodfill_claim_task_cb, &settings);
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = chunks_len > 1;
+    BLI_task_parallel_range(0, chunks_len, &data, floodfill_visit_task_cb, &settings);
+
+    /* The orders of the next front start after the ones of the current front. */
+    data.front_order += front_len;
+
+    front_len = 0;
+    for (int chunk = 0; chunk < chunks_len; chunk++) {
+      front_len += data.chunk_next_len[chunk];
+    }
+    if (front_len > front_alloc) {
+      front_alloc = front_len;
+      MEM_freeN(front);
+      front = MEM_malloc_arrayN(front_alloc, sizeof(int), __func__);
+    }
+    int *front_iter = front;
+    for (int chunk = 0; chunk < chunks_len; chunk++) {
+      memcpy(front_iter, data.chunk_next[chunk], sizeof(int) * data.chunk_next_len[chunk]);
+      front_iter += data.chunk_next_len[chunk];
+    }
+  }
+
+  for (int i = 0; i < totvert; i++) {
+    if (visited_by[i] == FLOODFILL_VISITED) {
+      BLI_BITMAP_ENABLE(flood->visited_vertices, i);
+    }
+  }
+
+  for (int chunk = 0; chunk < chunks_alloc; chunk++) {
+    MEM_SAFE_FREE(data.chunk_next[chunk]);
+  }
+  MEM_SAFE_FREE(data.chunk_next);
+  MEM_SAFE_FREE(data.chunk_next_len);
+  MEM_SAFE_FREE(data.chunk_next_alloc);
+  MEM_freeN(front);
+  MEM_freeN(visited_by);
+}
+
+#undef FLOODFILL_NOT_VISITED
+#undef FLOODFILL_VISITED
+#undef FLOODFILL_CHUNK_SIZE
+
 void SCULPT_floodfill_free(SculptFloodFill *flood)
 {
   MEM_SAFE_FREE(flood->visited_vertices);
@@ -2468,16 +2649,11 @@ static float brush_strength(const Sculpt *sd,
   }
 }
 
-/* Return a multiplier for brush strength on a particular vertex. */
-float SCULPT_brush_strength_factor(SculptSession *ss,
-                                   const Brush *br,
-                                   const float brush_point[3],
-                                   const float len,
-                                   const short vno[3],
-                                   const float fno[3],
-                                   const float mask,
-                                   const int vertex_index,
-                                   const int thread_id)
+/* Return the brush texture strength at a vertex. */
+static float sculpt_brush_texture_factor(SculptSession *ss,
+                                         const Brush *br,
+                                         const float brush_point[3],
+                                         const int thread_id)
 {
   StrokeCache *cache = ss->cache;
   const Scene *scene = cache->vc->scene;
@@ -2538,20 +2714,40 @@ float SCULPT_brush_strength_factor(SculptSession *ss,
     }
   }
 
-  /* Hardness. */
-  float final_len = len;
+  return avg;
+}
+
+/* Return the falloff distance of a vertex with the brush hardness applied. */
+BLI_INLINE float sculpt_brush_hardness_len(const StrokeCache *cache, const float len)
+{
   const float hardness = cache->paint_brush.hardness;
   float p = len / cache->radius;
   if (p < hardness) {
-    final_len = 0.0f;
+    return 0.0f;
   }
-  else if (hardness == 1.0f) {
-    final_len = cache->radius;
-  }
-  else {
-    p = (p - hardness) / (1.0f - hardness);
-    final_len = p * cache->radius;
+  if (hardness == 1.0f) {
+    return cache->radius;
   }
+  p = (p - hardness) / (1.0f - hardness);
+  return p * cache->radius;
+}
+
+/* Return a multiplier for brush strength on a particular vertex. */
+float SCULPT_brush_strength_factor(SculptSession *ss,
+                                   const Brush *br,
+                                   const float brush_point[3],
+                                   const float len,
+                                   const short vno[3],
+                                   const float fno[3],
+                                   const float mask,
+                                   const int vertex_index,
+                                   const int thread_id)
+{
+  StrokeCache *cache = ss->cache;
+  float avg = sculpt_brush_texture_factor(ss, br, brush_point, thread_id);
+
+  /* Hardness. */
+  const float final_len = sculpt_brush_hardness_len(cache, len);
 
   /* Falloff curve. */
   avg *= BKE_brush_curve_strength(br, final_len, cache->radius);
@@ -2566,6 +2762,156 @@ float SCULPT_brush_strength_factor(SculptSession *ss,
   return avg;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Brush Batches
+ *
+ * Brushes gather the vertices of a node that pass the brush test first, then compute the
+ * strength factors of all of them one step at a time, and finally write their result. Every step
+ * is a simple loop over flat arrays, which avoids the branches of the per vertex
+ * #SCULPT_brush_strength_factor for the steps that are disabled and lets the compiler vectorize
+ * the falloff math. The factors are the same as the ones of #SCULPT_brush_strength_factor.
+ * \{ */
+
+void SCULPT_brush_batch_init(SculptBrushBatch *batch,
+                             SculptSession *ss,
+                             const Brush *br,
+                             PBVHNode *node,
+                             const bool use_vec)
+{
+  int totvert;
+  BKE_pbvh_node_num_verts(ss->pbvh, node, &totvert, NULL);
+
+  const bool use_no = (br->flag & BRUSH_FRONTFACE) != 0;
+  const bool use_mvert = BKE_pbvh_type(ss->pbvh) == PBVH_FACES;
+  const size_t len = (size_t)max_ii(totvert, 1);
+
+  /* Use a single allocation, with the larger elements first to keep all of them aligned. */
+  size_t size = len * (sizeof(float[3]) + sizeof(float) * 2 + sizeof(int) * 2);
+  size += use_mvert ? len * sizeof(MVert *) : 0;
+  size += use_no ? len * sizeof(float[3]) : 0;
+  size += use_vec ? len * sizeof(float[3]) : 0;
+
+  char *data = MEM_mallocN(size, __func__);
+  memset(batch, 0, sizeof(*batch));
+  if (use_mvert) {
+    batch->mvert = (MVert **)data;
+    data += len * sizeof(MVert *);
+  }
+  batch->co = (float(*)[3])data;
+  data += len * sizeof(float[3]);
+  if (use_no) {
+    batch->no = (float(*)[3])data;
+    data += len * sizeof(float[3]);
+  }
+  if (use_vec) {
+    batch->vec = (float(*)[3])data;
+    data += len * sizeof(float[3]);
+  }
+  batch->factor = (float *)data;
+  data += len * sizeof(float);
+  batch->mask = (float *)data;
+  data += len * sizeof(float);
+  batch->node_index = (int *)data;
+  data += len * sizeof(int);
+  batch->vert_index = (int *)data;
+}
+
+/* Add a vertex that passed the brush test with its falloff distance, returns its index in the
+ * batch. */
+int SCULPT_brush_batch_add(SculptBrushBatch *batch,
+                           const PBVHVertexIter *vd,
+                           const float len,
+                           const float mask)
+{
+  const int i = batch->len++;
+  batch->node_index[i] = vd->i;
+  batch->vert_index[i] = vd->index;
+  copy_v3_v3(batch->co[i], vd->co);
+  batch->factor[i] = len;
+  batch->mask[i] = mask;
+  if (batch->no) {
+    if (vd->no) {
+      normal_short_to_float_v3(batch->no[i], vd->no);
+    }
+    else {
+      copy_v3_v3(batch->no[i], vd->fno);
+    }
+  }
+  if (batch->mvert) {
+    batch->mvert[i] = vd->mvert;
+  }
+  return i;
+}
+
+/* Replace the falloff distances of the batch with the brush strength factors. */
+void SCULPT_brush_batch_factors(SculptSession *ss,
+                                const Brush *br,
+                                SculptBrushBatch *batch,
+                                const int thread_id)
+{
+  StrokeCache *cache = ss->cache;
+  AutomaskingCache *automasking = cache->automasking;
+  float *factor = batch->factor;
+  const int len = batch->len;
+
+  /* Hardness. */
+  for (int i = 0; i < len; i++) {
+    factor[i] = sculpt_brush_hardness_len(cache, factor[i]);
+  }
+
+  /* Falloff curve. */
+  BKE_brush_curve_strength_array(br, factor, len, cache->radius);
+
+  if (br->mtex.tex) {
+    for (int i = 0; i < len; i++) {
+      factor[i] *= sculpt_brush_texture_factor(ss, br, batch->co[i], thread_id);
+    }
+  }
+
+  if (br->flag & BRUSH_FRONTFACE) {
+    const float *view_normal = cache->view_normal;
+    for (int i = 0; i < len; i++) {
+      const float dot = dot_v3v3(batch->no[i], view_normal);
+      factor[i] *= dot > 0.0f ? dot : 0.0f;
+    }
+  }
+
+  /* Paint mask. */
+  for (int i = 0; i < len; i++) {
+    factor[i] *= 1.0f - batch->mask[i];
+  }
+
+  /* Auto-masking. */
+  if (automasking && automasking->factor) {
+    for (int i = 0; i < len; i++) {
+      factor[i] *= automasking->factor[batch->vert_index[i]];
+    }
+  }
+  else if (automasking) {
+    for (int i = 0; i < len; i++) {
+      factor[i] *= SCULPT_automasking_factor_get(automasking, ss, batch->vert_index[i]);
+    }
+  }
+}
+
+void SCULPT_brush_batch_tag_update(const SculptBrushBatch *batch)
+{
+  if (batch->mvert) {
+    for (int i = 0; i < batch->len; i++) {
+      batch->mvert[i]->flag |= ME_VERT_PBVH_UPDATE;
+    }
+  }
+}
+
+void SCULPT_brush_batch_free(SculptBrushBatch *batch)
+{
+  /* All arrays share the allocation of the first one. */
+  MEM_freeN(batch->mvert ? (void *)batch->mvert : (void *)batch->co);
+  memset(batch, 0, sizeof(*batch));
+}
+
+/** \} */
+
 /* Test AABB against sphere. */
 bool SCULPT_search_sphere_cb(PBVHNode *node, void *data_v)
 {
@@ -3289,29 +3635,27 @@ static void do_draw_brush_task_cb_ex(void *__restrict userdata,
       ss, &test, data->brush->falloff_shape);
   const int thread_id = BLI_task_parallel_thread_id(tls);
 
+  SculptBrushBatch batch;
+  SCULPT_brush_batch_init(&batch, ss, brush, data->nodes[n], false);
+
   BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
   {
     if (!sculpt_brush_test_sq_fn(&test, vd.co)) {
       continue;
     }
-    /* Offset vertex. */
-    const float fade = SCULPT_brush_strength_factor(ss,
-                                                    brush,
-                                                    vd.co,
-                                                    sqrtf(test.dist),
-                                                    vd.no,
-                                                    vd.fno,
-                                                    vd.mask ? *vd.mask : 0.0f,
-                                                    vd.index,
-                                                    thread_id);
+    SCULPT_brush_batch_add(&batch, &vd, sqrtf(test.dist), vd.mask ? *vd.mask : 0.0f);
+  }
+  BKE_pbvh_vertex_iter_end;
 
-    mul_v3_v3fl(proxy[vd.i], offset, fade);
+  SCULPT_brush_batch_factors(ss, brush, &batch, thread_id);
 
-    if (vd.mvert) {
-      vd.mvert->flag |= ME_VERT_PBVH_UPDATE;
-    }
+  /* Offset vertices. */
+  for (int i = 0; i < batch.len; i++) {
+    mul_v3_v3fl(proxy[batch.node_index[i]], offset, batch.factor[i]);
   }
-  BKE_pbvh_vertex_iter_end;
+
+  SCULPT_brush_batch_tag_update(&batch);
+  SCULPT_brush_batch_free(&batch);
 }
 
 static void do_draw_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
@@ -5206,6 +5550,9 @@ static void do_clay_strips_brush_task_cb_ex(void *__restrict userdata,
   plane_from_point_normal_v3(test.plane_tool, area_co, area_no_sp);
   const int thread_id = BLI_task_parallel_thread_id(tls);
 
+  SculptBrushBatch batch;
+  SCULPT_brush_batch_init(&batch, ss, brush, data->nodes[n], true);
+
   BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
   {
     if (!SCULPT_brush_test_cube(&test, vd.co, mat, brush->tip_roundness)) {
@@ -5224,24 +5571,22 @@ static void do_clay_strips_brush_task_cb_ex(void *__restrict userdata,
     if (!SCULPT_plane_trim(ss->cache, brush, val)) {
       continue;
     }
-    /* The normal from the vertices is ignored, it causes glitch with planes, see: T44390. */
-    const float fade = bstrength * SCULPT_brush_strength_factor(ss,
-                                                                brush,
-                                                                vd.co,
-                                                                ss->cache->radius * test.dist,
-                                                                vd.no,
-                                                                vd.fno,
-                                                                vd.mask ? *vd.mask : 0.0f,
-                                                                vd.index,
-                                                                thread_id);
+    const int i = SCULPT_brush_batch_add(
+        &batch, &vd, ss->cache->radius * test.dist, vd.mask ? *vd.mask : 0.0f);
+    copy_v3_v3(batch.vec[i], val);
+  }
+  BKE_pbvh_vertex_iter_end;
 
-    mul_v3_v3fl(proxy[vd.i], val, fade);
+  /* The normal from the vertices is ignored, it causes glitch with planes, see: T44390. */
+  SCULPT_brush_batch_factors(ss, brush, &batch, thread_id);
 
-    if (vd.mvert) {
-      vd.mvert->flag |= ME_VERT_PBVH_UPDATE;
-    }
+  for (int i = 0; i < batch.len; i++) {
+    const float fade = bstrength * batch.factor[i];
+    mul_v3_v3fl(proxy[batch.node_index[i]], batch.vec[i], fade);
   }
-  BKE_pbvh_vertex_iter_end;
+
+  SCULPT_brush_batch_tag_update(&batch);
+  SCULPT_brush_batch_free(&batch);
 }
 
 static void do_clay_strips_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
@@ -474,7 +474,7 @@ static float *sculpt_expand_topology_falloff_create(Sculpt *sd, Object *ob, cons
   ExpandFloodFillData fdata;
   fdata.dists = dists;
 
-  SCULPT_floodfill_execute(ss, &flood, expand_topology_floodfill_cb, &fdata);
+  SCULPT_floodfill_execute_parallel(ss, &flood, expand_topology_floodfill_cb, &fdata);
   SCULPT_floodfill_free(&flood);
 
   return dists;
@@ -531,7 +531,7 @@ static float *sculpt_expand_normal_falloff_create(Sculpt *sd,
   fdata.edge_sensitivity = edge_sensitivity;
   SCULPT_vertex_normal_get(ss, v, fdata.original_normal);
 
-  SCULPT_floodfill_execute(ss, &flood, mask_expand_normal_floodfill_cb, &fdata);
+  SCULPT_floodfill_execute_parallel(ss, &flood, mask_expand_normal_floodfill_cb, &fdata);
   SCULPT_floodfill_free(&flood);
 
   for (int repeat = 0; repeat < 2; repeat++) {
@@ -878,7 +878,7 @@ static void sculpt_expand_topology_from_state_boundary(Object *ob,
 
   ExpandFloodFillData fdata;
   fdata.dists = dists;
-  SCULPT_floodfill_execute(ss, &flood, expand_topology_floodfill_cb, &fdata);
+  SCULPT_floodfill_execute_parallel(ss, &flood, expand_topology_floodfill_cb, &fdata);
   SCULPT_floodfill_free(&flood);
 
   expand_cache->vert_falloff = dists;
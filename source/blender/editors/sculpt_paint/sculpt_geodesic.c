@@ -28,6 +28,8 @@
 #include "BLI_math.h"
 #include "BLI_task.h"
 
+#include "atomic_ops.h"
+
 #include "BLT_translation.h"
 
 #include "DNA_brush_types.h"
@@ -76,40 +78,237 @@
 #include <stdlib.h>
 #define SCULPT_GEODESIC_VERTEX_NONE -1
 
-/* Propagate distance from v1 and v2 to v0. */
-static bool sculpt_geodesic_mesh_test_dist_add(
-    MVert *mvert, const int v0, const int v1, const int v2, float *dists, GSet *initial_vertices)
+/* The fronts are split in chunks of this size, each chunk collects its own results. */
+#define SCULPT_GEODESIC_CHUNK_SIZE 256
+
+typedef struct GeodesicChunks {
+  int **elems;
+  int *elems_len;
+  int *elems_alloc;
+  int chunks_alloc;
+} GeodesicChunks;
+
+static void sculpt_geodesic_chunks_ensure(GeodesicChunks *chunks, const int chunks_len)
+{
+  if (chunks_len <= chunks->chunks_alloc) {
+    return;
+  }
+  chunks->elems = MEM_recallocN(chunks->elems, sizeof(int *) * chunks_len);
+  chunks->elems_len = MEM_recallocN(chunks->elems_len, sizeof(int) * chunks_len);
+  chunks->elems_alloc = MEM_recallocN(chunks->elems_alloc, sizeof(int) * chunks_len);
+  chunks->chunks_alloc = chunks_len;
+}
+
+static void sculpt_geodesic_chunk_append(GeodesicChunks *chunks, const int chunk, const int elem)
 {
-  if (BLI_gset_haskey(initial_vertices, POINTER_FROM_INT(v0))) {
-    return false;
+  if (chunks->elems_len[chunk] == chunks->elems_alloc[chunk]) {
+    chunks->elems_alloc[chunk] = max_ii(chunks->elems_alloc[chunk] * 2,
+                                        SCULPT_GEODESIC_CHUNK_SIZE);
+    chunks->elems[chunk] = MEM_reallocN(chunks->elems[chunk],
+                                        sizeof(int) * chunks->elems_alloc[chunk]);
   }
+  chunks->elems[chunk][chunks->elems_len[chunk]++] = elem;
+}
 
-  BLI_assert(dists[v1] != FLT_MAX);
-  if (dists[v0] <= dists[v1]) {
-    return false;
+/* Concatenate the elements of all chunks into \a r_array, growing it when needed. */
+static int sculpt_geodesic_chunks_gather(GeodesicChunks *chunks,
+                                         const int chunks_len,
+                                         int **r_array,
+                                         int *r_array_alloc)
+{
+  int len = 0;
+  for (int chunk = 0; chunk < chunks_len; chunk++) {
+    len += chunks->elems_len[chunk];
+  }
+  if (len > *r_array_alloc) {
+    MEM_SAFE_FREE(*r_array);
+    *r_array = MEM_malloc_arrayN(len, sizeof(int), __func__);
+    *r_array_alloc = len;
+  }
+  int *array_iter = *r_array;
+  for (int chunk = 0; chunk < chunks_len; chunk++) {
+    memcpy(array_iter, chunks->elems[chunk], sizeof(int) * chunks->elems_len[chunk]);
+    array_iter += chunks->elems_len[chunk];
+    chunks->elems_len[chunk] = 0;
+  }
+  return len;
+}
+
+static void sculpt_geodesic_chunks_free(GeodesicChunks *chunks)
+{
+  for (int chunk = 0; chunk < chunks->chunks_alloc; chunk++) {
+    MEM_SAFE_FREE(chunks->elems[chunk]);
+  }
+  MEM_SAFE_FREE(chunks->elems);
+  MEM_SAFE_FREE(chunks->elems_len);
+  MEM_SAFE_FREE(chunks->elems_alloc);
+  chunks->chunks_alloc = 0;
+}
+
+static int sculpt_geodesic_chunks_len(const int len)
+{
+  return (len + SCULPT_GEODESIC_CHUNK_SIZE - 1) / SCULPT_GEODESIC_CHUNK_SIZE;
+}
+
+/**
+ * The distances are propagated one front of edges at a time. Every front only reads the
+ * distances of the previous front and writes the shorter distances it finds to a second array,
+ * so the result doesn't depend on the order in which the edges of the front are processed and
+ * the front can be processed in parallel.
+ */
+typedef struct GeodesicMeshData {
+  const MVert *verts;
+  const MEdge *edges;
+  const MPoly *mpoly;
+  const MLoop *mloop;
+  const MeshElemMap *epmap;
+  const MeshElemMap *vemap;
+  const int *face_sets;
+  const BLI_bitmap *initial_vertex;
+  const BLI_bitmap *affected_vertex;
+
+  /* Distances of the previous front. */
+  float *dists;
+  /* Distances found by the current front. */
+  float *dists_next;
+  /* Vertices whose distance changed and edges in the next front, to add them only once. */
+  uint8_t *vert_tag;
+  uint8_t *edge_tag;
+
+  const int *front;
+  int front_len;
+  GeodesicChunks chunks;
+} GeodesicMeshData;
+
+/* Propagate distance from v1 and v2 to v0, returns the distance of v0 including the new one. */
+static float sculpt_geodesic_mesh_test_dist_add(GeodesicMeshData *data,
+                                                const int chunk,
+                                                const int v0,
+                                                const int v1,
+                                                const int v2,
+                                                const float dist1,
+                                                const float dist2)
+{
+  const float dist_prev = data->dists[v0];
+  if (BLI_BITMAP_TEST(data->initial_vertex, v0)) {
+    return dist_prev;
+  }
+
+  BLI_assert(dist1 != FLT_MAX);
+  if (dist_prev <= dist1) {
+    return dist_prev;
   }
 
   float dist0;
   if (v2 != SCULPT_GEODESIC_VERTEX_NONE) {
-    BLI_assert(dists[v2] != FLT_MAX);
-    if (dists[v0] <= dists[v2]) {
-      return false;
+    BLI_assert(dist2 != FLT_MAX);
+    if (dist_prev <= dist2) {
+      return dist_prev;
     }
     dist0 = geodesic_distance_propagate_across_triangle(
-        mvert[v0].co, mvert[v1].co, mvert[v2].co, dists[v1], dists[v2]);
+        data->verts[v0].co, data->verts[v1].co, data->verts[v2].co, dist1, dist2);
   }
   else {
-    float vec[3];
-    sub_v3_v3v3(vec, mvert[v1].co, mvert[v0].co);
-    dist0 = dists[v1] + len_v3(vec);
+    dist0 = dist1 + len_v3v3(data->verts[v1].co, data->verts[v0].co);
+  }
+
+  if (dist0 >= dist_prev) {
+    return dist_prev;
+  }
+
+  float dist_next = data->dists_next[v0];
+  while (dist0 < dist_next) {
+    const float dist_orig = atomic_cas_float(&data->dists_next[v0], dist_next, dist0);
+    if (dist_orig == dist_next) {
+      break;
+    }
+    dist_next = dist_orig;
+  }
+  if (atomic_fetch_and_or_uint8(&data->vert_tag[v0], 1) == 0) {
+    sculpt_geodesic_chunk_append(&data->chunks, chunk, v0);
   }
+  return dist0;
+}
+
+static void sculpt_geodesic_propagate_task_cb(void *__restrict userdata,
+                                              const int chunk,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  GeodesicMeshData *data = userdata;
+  const int start = chunk * SCULPT_GEODESIC_CHUNK_SIZE;
+  const int end = min_ii(start + SCULPT_GEODESIC_CHUNK_SIZE, data->front_len);
+
+  for (int i = start; i < end; i++) {
+    const int e = data->front[i];
+    int v1 = data->edges[e].v1;
+    int v2 = data->edges[e].v2;
+    float dist1 = data->dists[v1];
+    float dist2 = data->dists[v2];
+
+    if (dist1 == FLT_MAX || dist2 == FLT_MAX) {
+      if (dist1 > dist2) {
+        SWAP(int, v1, v2);
+        SWAP(float, dist1, dist2);
+      }
+      /* Use the new distance for the faces of the edge, like a serial propagation would. */
+      dist2 = sculpt_geodesic_mesh_test_dist_add(
+          data, chunk, v2, v1, SCULPT_GEODESIC_VERTEX_NONE, dist1, dist2);
+    }
+
+    for (int poly_map_index = 0; poly_map_index < data->epmap[e].count; poly_map_index++) {
+      const int poly = data->epmap[e].indices[poly_map_index];
+      if (data->face_sets[poly] <= 0) {
+        continue;
+      }
+      const MPoly *mpoly = &data->mpoly[poly];
 
-  if (dist0 < dists[v0]) {
-    dists[v0] = dist0;
-    return true;
+      for (int loop_index = 0; loop_index < mpoly->totloop; loop_index++) {
+        const int v_other = data->mloop[loop_index + mpoly->loopstart].v;
+        if (ELEM(v_other, v1, v2)) {
+          continue;
+        }
+        sculpt_geodesic_mesh_test_dist_add(data, chunk, v_other, v1, v2, dist1, dist2);
+      }
+    }
   }
+}
 
-  return false;
+static void sculpt_geodesic_apply_task_cb(void *__restrict userdata,
+                                          const int i,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  GeodesicMeshData *data = userdata;
+  const int v = data->front[i];
+  data->dists[v] = data->dists_next[v];
+  data->vert_tag[v] = 0;
+}
+
+static void sculpt_geodesic_edges_front_task_cb(void *__restrict userdata,
+                                                const int chunk,
+                                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  GeodesicMeshData *data = userdata;
+  const int start = chunk * SCULPT_GEODESIC_CHUNK_SIZE;
+  const int end = min_ii(start + SCULPT_GEODESIC_CHUNK_SIZE, data->front_len);
+
+  for (int i = start; i < end; i++) {
+    const int v = data->front[i];
+    for (int edge_map_index = 0; edge_map_index < data->vemap[v].count; edge_map_index++) {
+      const int e_other = data->vemap[v].indices[edge_map_index];
+      const int ev_other = (data->edges[e_other].v1 == (uint)v) ? data->edges[e_other].v2 :
+                                                                  data->edges[e_other].v1;
+      if (data->epmap[e_other].count != 0 && data->dists[ev_other] == FLT_MAX) {
+        continue;
+      }
+      if (!BLI_BITMAP_TEST(data->affected_vertex, v) &&
+          !BLI_BITMAP_TEST(data->affected_vertex, ev_other)) {
+        continue;
+      }
+      if (atomic_fetch_and_or_uint8(&data->edge_tag[e_other], 1) == 0) {
+        sculpt_geodesic_chunk_append(&data->chunks, chunk, e_other);
+      }
+    }
+  }
 }
 
 static float *SCULPT_geodesic_mesh_create(Object *ob,
@@ -128,7 +327,6 @@ static float *SCULPT_geodesic_mesh_create(Object *ob,
   MVert *verts = SCULPT_mesh_deformed_mverts_get(ss);
 
   float *dists = MEM_malloc_arrayN(totvert, sizeof(float), "distances");
-  BLI_bitmap *edge_tag = BLI_BITMAP_NEW(totedge, "edge tag");
 
   if (!ss->epmap) {
     BKE_mesh_edge_poly_map_create(&ss->epmap,
@@ -145,15 +343,14 @@ static float *SCULPT_geodesic_mesh_create(Object *ob,
         &ss->vemap, &ss->vemap_mem, mesh->medge, mesh->totvert, mesh->totedge);
   }
 
-  /* Both contain edge indices encoded as *void. */
-  BLI_LINKSTACK_DECLARE(queue, void *);
-  BLI_LINKSTACK_DECLARE(queue_next, void *);
-
-  BLI_LINKSTACK_INIT(queue);
-  BLI_LINKSTACK_INIT(queue_next);
+  BLI_bitmap *initial_vertex = BLI_BITMAP_NEW(totvert, "initial vertex");
+  GSetIterator gs_iter;
+  GSET_ITER (gs_iter, initial_vertices) {
+    BLI_BITMAP_ENABLE(initial_vertex, POINTER_AS_INT(BLI_gsetIterator_getKey(&gs_iter)));
+  }
 
   for (int i = 0; i < totvert; i++) {
-    if (BLI_gset_haskey(initial_vertices, POINTER_FROM_INT(i))) {
+    if (BLI_BITMAP_TEST(initial_vertex, i)) {
       dists[i] = 0.0f;
     }
     else {
@@ -164,7 +361,6 @@ static float *SCULPT_geodesic_mesh_create(Object *ob,
   /* Masks vertices that are further than limit radius from an initial vertex. As there is no need
    * to define a distance to them the algorithm can stop earlier by skipping them. */
   BLI_bitmap *affected_vertex = BLI_BITMAP_NEW(totvert, "affected vertex");
-  GSetIterator gs_iter;
 
   if (limit_radius == FLT_MAX) {
     /* In this case, no need to loop through all initial vertices to check distances as they are
@@ -186,7 +382,26 @@ static float *SCULPT_geodesic_mesh_create(Object *ob,
     }
   }
 
-  /* Add edges adjacent to an initial vertex to the queue. */
+  GeodesicMeshData data = {
+      .verts = verts,
+      .edges = edges,
+      .mpoly = mesh->mpoly,
+      .mloop = mesh->mloop,
+      .epmap = ss->epmap,
+      .vemap = ss->vemap,
+      .face_sets = ss->face_sets,
+      .initial_vertex = initial_vertex,
+      .affected_vertex = affected_vertex,
+      .dists = dists,
+      .dists_next = MEM_dupallocN(dists),
+      .vert_tag = MEM_calloc_arrayN(totvert, sizeof(uint8_t), "vert tag"),
+      .edge_tag = MEM_calloc_arrayN(totedge, sizeof(uint8_t), "edge tag"),
+  };
+
+  /* Add edges adjacent to an initial vertex to the first front. */
+  int edges_front_alloc = SCULPT_GEODESIC_CHUNK_SIZE;
+  int *edges_front = MEM_malloc_arrayN(edges_front_alloc, sizeof(int), "edges front");
+  int edges_front_len = 0;
   for (int i = 0; i < totedge; i++) {
     const int v1 = edges[i].v1;
     const int v2 = edges[i].v2;
@@ -194,83 +409,78 @@ static float *SCULPT_geodesic_mesh_create(Object *ob,
       continue;
     }
     if (dists[v1] != FLT_MAX || dists[v2] != FLT_MAX) {
-      BLI_LINKSTACK_PUSH(queue, POINTER_FROM_INT(i));
-    }
-  }
-
-  do {
-    while (BLI_LINKSTACK_SIZE(queue)) {
-      const int e = POINTER_AS_INT(BLI_LINKSTACK_POP(queue));
-      int v1 = edges[e].v1;
-      int v2 = edges[e].v2;
-
-      if (dists[v1] == FLT_MAX || dists[v2] == FLT_MAX) {
-        if (dists[v1] > dists[v2]) {
-          SWAP(int, v1, v2);
-        }
-        sculpt_geodesic_mesh_test_dist_add(
-            verts, v2, v1, SCULPT_GEODESIC_VERTEX_NONE, dists, initial_vertices);
-      }
-
-      if (ss->epmap[e].count != 0) {
-        for (int poly_map_index = 0; poly_map_index < ss->epmap[e].count; poly_map_index++) {
-          const int poly = ss->epmap[e].indices[poly_map_index];
-          if (ss->face_sets[poly] <= 0) {
-            continue;
-          }
-          const MPoly *mpoly = &mesh->mpoly[poly];
-
-          for (int loop_index = 0; loop_index < mpoly->totloop; loop_index++) {
-            const MLoop *mloop = &mesh->mloop[loop_index + mpoly->loopstart];
-            const int v_other = mloop->v;
-            if (ELEM(v_other, v1, v2)) {
-              continue;
-            }
-            if (sculpt_geodesic_mesh_test_dist_add(
-                    verts, v_other, v1, v2, dists, initial_vertices)) {
-              for (int edge_map_index = 0; edge_map_index < ss->vemap[v_other].count;
-                   edge_map_index++) {
-                const int e_other = ss->vemap[v_other].indices[edge_map_index];
-                int ev_other;
-                if (edges[e_other].v1 == (uint)v_other) {
-                  ev_other = edges[e_other].v2;
-                }
-                else {
-                  ev_other = edges[e_other].v1;
-                }
-
-                if (e_other != e && !BLI_BITMAP_TEST(edge_tag, e_other) &&
-                    (ss->epmap[e_other].count == 0 || dists[ev_other] != FLT_MAX)) {
-                  if (BLI_BITMAP_TEST(affected_vertex, v_other) ||
-                      BLI_BITMAP_TEST(affected_vertex, ev_other)) {
-                    BLI_BITMAP_ENABLE(edge_tag, e_other);
-                    BLI_LINKSTACK_PUSH(queue_next, POINTER_FROM_INT(e_other));
-                  }
-                }
-              }
-            }
-          }
-        }
+      if (edges_front_len == edges_front_alloc) {
+        edges_front_alloc *= 2;
+        edges_front = MEM_reallocN(edges_front, sizeof(int) * edges_front_alloc);
       }
+      edges_front[edges_front_len++] = i;
     }
+  }
 
-    for (LinkNode *lnk = queue_next; lnk; lnk = lnk->next) {
-      const int e = POINTER_AS_INT(lnk->link);
-      BLI_BITMAP_DISABLE(edge_tag, e);
+  int verts_front_alloc = 0;
+  int *verts_front = NULL;
+
+  while (edges_front_len > 0) {
+    TaskParallelSettings settings;
+
+    /* Find the new distances from the edges of the front. */
+    int chunks_len = sculpt_geodesic_chunks_len(edges_front_len);
+    sculpt_geodesic_chunks_ensure(&data.chunks, chunks_len);
+    data.front = edges_front;
+    data.front_len = edges_front_len;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = chunks_len > 1;
+    BLI_task_parallel_range(0, chunks_len, &data, sculpt_geodesic_propagate_task_cb, &settings);
+    const int verts_front_len = sculpt_geodesic_chunks_gather(
+        &data.chunks, chunks_len, &verts_front, &verts_front_alloc);
+
+    /* Store them for the next front. */
+    data.front = verts_front;
+    data.front_len = verts_front_len;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = SCULPT_GEODESIC_CHUNK_SIZE;
+    BLI_task_parallel_range(0, verts_front_len, &data, sculpt_geodesic_apply_task_cb, &settings);
+
+    /* The next front are the edges of the vertices that changed. */
+    chunks_len = sculpt_geodesic_chunks_len(verts_front_len);
+    sculpt_geodesic_chunks_ensure(&data.chunks, chunks_len);
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = chunks_len > 1;
+    BLI_task_parallel_range(0, chunks_len, &data, sculpt_geodesic_edges_front_task_cb, &settings);
+    edges_front_len = sculpt_geodesic_chunks_gather(
+        &data.chunks, chunks_len, &edges_front, &edges_front_alloc);
+
+    for (int i = 0; i < edges_front_len; i++) {
+      data.edge_tag[edges_front[i]] = 0;
     }
+  }
 
-    BLI_LINKSTACK_SWAP(queue, queue_next);
-
-  } while (BLI_LINKSTACK_SIZE(queue));
-
-  BLI_LINKSTACK_FREE(queue);
-  BLI_LINKSTACK_FREE(queue_next);
-  MEM_SAFE_FREE(edge_tag);
+  sculpt_geodesic_chunks_free(&data.chunks);
+  MEM_SAFE_FREE(verts_front);
+  MEM_SAFE_FREE(edges_front);
+  MEM_SAFE_FREE(data.dists_next);
+  MEM_SAFE_FREE(data.vert_tag);
+  MEM_SAFE_FREE(data.edge_tag);
+  MEM_SAFE_FREE(initial_vertex);
   MEM_SAFE_FREE(affected_vertex);
 
   return dists;
 }
 
+typedef struct GeodesicFallbackData {
+  SculptSession *ss;
+  const float *co;
+  float *dists;
+} GeodesicFallbackData;
+
+static void sculpt_geodesic_fallback_task_cb(void *__restrict userdata,
+                                             const int i,
+                                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  GeodesicFallbackData *data = userdata;
+  data->dists[i] = len_v3v3(data->co, SCULPT_vertex_co_get(data->ss, i));
+}
+
 /* For sculpt mesh data that does not support a geodesic distances algorithm, fallback to the
  * distance to each vertex. In this case, only one of the initial vertices will be used to
  * calculate the distance. */
@@ -295,10 +505,15 @@ static float *SCULPT_geodesic_fallback_create(Object *ob, GSet *initial_vertices
     return dists;
   }
 
-  const float *first_affected_co = SCULPT_vertex_co_get(ss, first_affected);
-  for (int i = 0; i < totvert; i++) {
-    dists[i] = len_v3v3(first_affected_co, SCULPT_vertex_co_get(ss, i));
-  }
+  GeodesicFallbackData data = {
+      .ss = ss,
+      .co = SCULPT_vertex_co_get(ss, first_affected),
+      .dists = dists,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = SCULPT_GEODESIC_CHUNK_SIZE;
+  BLI_task_parallel_range(0, totvert, &data, sculpt_geodesic_fallback_task_cb, &settings);
 
   return dists;
 }
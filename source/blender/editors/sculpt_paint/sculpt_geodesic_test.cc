@@ -0,0 +1,220 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_customdata.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
+#include "BKE_paint.h"
+#include "BKE_pbvh.h"
+
+#include "BLI_array.hh"
+#include "BLI_ghash.h"
+#include "BLI_gsqueue.h"
+#include "BLI_math.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "tests/blenkernel_testing.hh"
+
+extern "C" {
+#include "sculpt_intern.h"
+}
+
+namespace blender::ed::sculpt_paint::tests {
+
+using blender::bke::tests::create_grid_mesh;
+
+class SculptGeodesicTest : public blender::bke::tests::MeshTest {
+ protected:
+  Mesh *mesh = nullptr;
+  Object *ob = nullptr;
+
+  /* Create an object in sculpt mode like #BKE_sculpt_update_object_for_edit would, with a
+   * regular mesh PBVH of a flat grid. */
+  void create_sculpt_grid(const int resolution)
+  {
+    mesh = create_grid_mesh(resolution);
+    int *face_sets = (int *)CustomData_add_layer(
+        &mesh->pdata, CD_SCULPT_FACE_SETS, CD_CALLOC, nullptr, mesh->totpoly);
+    for (int i = 0; i < mesh->totpoly; i++) {
+      face_sets[i] = 1;
+    }
+
+    ob = (Object *)BKE_id_new_nomain(ID_OB, "Sculpt");
+    ob->type = OB_MESH;
+    ob->data = mesh;
+
+    SculptSession *ss = (SculptSession *)MEM_callocN(sizeof(SculptSession), __func__);
+    ob->sculpt = ss;
+    ss->totvert = mesh->totvert;
+    ss->totpoly = mesh->totpoly;
+    ss->mvert = mesh->mvert;
+    ss->mpoly = mesh->mpoly;
+    ss->mloop = mesh->mloop;
+    ss->face_sets = face_sets;
+    BKE_mesh_vert_poly_map_create(&ss->pmap,
+                                  &ss->pmap_mem,
+                                  mesh->mpoly,
+                                  mesh->mloop,
+                                  mesh->totvert,
+                                  mesh->totpoly,
+                                  mesh->totloop);
+
+    const int looptri_num = poly_to_tri_count(mesh->totpoly, mesh->totloop);
+    MLoopTri *looptri = (MLoopTri *)MEM_malloc_arrayN(looptri_num, sizeof(MLoopTri), __func__);
+    BKE_mesh_recalc_looptri(
+        mesh->mloop, mesh->mpoly, mesh->mvert, mesh->totloop, mesh->totpoly, looptri);
+    ss->pbvh = BKE_pbvh_new();
+    BKE_pbvh_build_mesh(ss->pbvh,
+                        mesh,
+                        mesh->mpoly,
+                        mesh->mloop,
+                        mesh->mvert,
+                        mesh->totvert,
+                        &mesh->vdata,
+                        &mesh->ldata,
+                        &mesh->pdata,
+                        looptri,
+                        looptri_num);
+  }
+
+  void TearDown() override
+  {
+    if (ob != nullptr) {
+      BKE_sculptsession_free(ob);
+      ob->data = nullptr;
+      BKE_id_free(nullptr, ob);
+    }
+    if (mesh != nullptr) {
+      BKE_id_free(nullptr, mesh);
+    }
+  }
+
+  Array<float> geodesic_distances(const Span<int> initial_vertices)
+  {
+    GSet *initial = BLI_gset_int_new(__func__);
+    for (const int v : initial_vertices) {
+      BLI_gset_add(initial, POINTER_FROM_INT(v));
+    }
+    float *dists = SCULPT_geodesic_distances_create(ob, initial, FLT_MAX);
+    BLI_gset_free(initial, nullptr);
+
+    Array<float> result(mesh->totvert);
+    for (const int i : result.index_range()) {
+      result[i] = dists[i];
+    }
+    MEM_freeN(dists);
+    return result;
+  }
+};
+
+/* Distances on a flat grid are the straight line distances, the propagation across faces is exact
+ * in a plane. */
+TEST_F(SculptGeodesicTest, flat_grid_distances)
+{
+  const int resolution = 8;
+  create_sculpt_grid(resolution);
+
+  const int source = 0;
+  const Array<float> dists = geodesic_distances({source});
+  for (const int i : dists.index_range()) {
+    EXPECT_NEAR(dists[i], len_v3v3(mesh->mvert[i].co, mesh->mvert[source].co), 1e-4f)
+        << "vertex " << i;
+  }
+
+  /* The closest of several initial vertices. */
+  const Array<int> sources = {source, mesh->totvert - 1};
+  const Array<float> dists_closest = geodesic_distances(sources);
+  for (const int i : dists_closest.index_range()) {
+    const float expected = min_ff(len_v3v3(mesh->mvert[i].co, mesh->mvert[sources[0]].co),
+                                  len_v3v3(mesh->mvert[i].co, mesh->mvert[sources[1]].co));
+    EXPECT_NEAR(dists_closest[i], expected, 1e-4f) << "vertex " << i;
+  }
+}
+
+/* The fronts are processed in parallel chunks, the result must not depend on the scheduling. */
+TEST_F(SculptGeodesicTest, deterministic)
+{
+  create_sculpt_grid(100);
+
+  const Array<int> sources = {0, 5000, mesh->totvert / 3};
+  const Array<float> first = geodesic_distances(sources);
+  for (int run = 0; run < 5; run++) {
+    const Array<float> dists = geodesic_distances(sources);
+    EXPECT_EQ_ARRAY(first.data(), dists.data(), first.size());
+  }
+}
+
+/* The vertex a vertex is reached from, and the distance of the fill to it. */
+struct FloodFillResult {
+  Array<int> from;
+  Array<int> depth;
+};
+
+static bool floodfill_record_cb(
+    SculptSession * /*ss*/, int from_v, int to_v, bool /*is_duplicate*/, void *userdata)
+{
+  FloodFillResult *result = (FloodFillResult *)userdata;
+  result->from[to_v] = from_v;
+  result->depth[to_v] = result->depth[from_v] + 1;
+  /* Stop at a diagonal, so that not every vertex is visited. */
+  return result->depth[to_v] < 120;
+}
+
+static FloodFillResult floodfill(SculptSession *ss, const Span<int> initial, const bool parallel)
+{
+  FloodFillResult result;
+  result.from = Array<int>(ss->totvert, -1);
+  result.depth = Array<int>(ss->totvert, 0);
+
+  SculptFloodFill flood;
+  SCULPT_floodfill_init(ss, &flood);
+  for (const int v : initial) {
+    SCULPT_floodfill_add_initial(&flood, v);
+  }
+  if (parallel) {
+    SCULPT_floodfill_execute_parallel(ss, &flood, floodfill_record_cb, &result);
+  }
+  else {
+    SCULPT_floodfill_execute(ss, &flood, floodfill_record_cb, &result);
+  }
+  SCULPT_floodfill_free(&flood);
+  return result;
+}
+
+/* The parallel flood-fill visits every vertex from the same vertex as the serial one. */
+TEST_F(SculptGeodesicTest, floodfill_parallel_matches_serial)
+{
+  create_sculpt_grid(100);
+  SculptSession *ss = ob->sculpt;
+
+  const Array<int> initial = {0, 4321};
+  const FloodFillResult serial = floodfill(ss, initial, false);
+  for (int run = 0; run < 5; run++) {
+    const FloodFillResult parallel = floodfill(ss, initial, true);
+    EXPECT_EQ_ARRAY(serial.from.data(), parallel.from.data(), serial.from.size());
+    EXPECT_EQ_ARRAY(serial.depth.data(), parallel.depth.data(), serial.depth.size());
+  }
+}
+
+}  // namespace blender::ed::sculpt_paint::tests
@@ -308,6 +308,15 @@ void SCULPT_floodfill_execute(
     SculptFloodFill *flood,
     bool (*func)(SculptSession *ss, int from_v, int to_v, bool is_duplicate, void *userdata),
     void *userdata);
+/* Same as #SCULPT_floodfill_execute, but every front of the flood-fill is processed in parallel.
+ * The vertices are visited from the same vertices and in the same order as the serial version,
+ * but \a func can be called from multiple threads at the same time, so it may only write data of
+ * \a to_v and read data of \a from_v. */
+void SCULPT_floodfill_execute_parallel(
+    struct SculptSession *ss,
+    SculptFloodFill *flood,
+    bool (*func)(SculptSession *ss, int from_v, int to_v, bool is_duplicate, void *userdata),
+    void *userdata);
 void SCULPT_floodfill_free(SculptFloodFill *flood);
 
 /* Dynamic topology */
@@ -618,6 +627,26 @@ typedef struct SculptUndoNodeGeometry {
   int totpoly;
 } SculptUndoNodeGeometry;
 
+/* Values of an undo node replaced by their difference before and after the step, for the
+ * vertices which changed, see #sculpt_undo_delta_create. */
+typedef struct SculptUndoDelta {
+  /* Vertices of the node whose values changed. */
+  BLI_bitmap *changed;
+  int changed_len;
+  /* Floats per vertex, 3 for coordinates and 1 for masks. */
+  int components;
+
+  /* Compressed differences. */
+  unsigned char *data;
+  size_t data_len;
+
+  /* The mesh holds the values after the step, toggled on every restore. */
+  bool is_applied;
+  /* Hashes of the changed values, to detect a mesh which was modified outside of undo. */
+  unsigned int hash_before;
+  unsigned int hash_after;
+} SculptUndoDelta;
+
 typedef struct SculptUndoNode {
   struct SculptUndoNode *next, *prev;
 
@@ -633,6 +662,9 @@ typedef struct SculptUndoNode {
   float *mask;
   int totvert;
 
+  /* Replaces `co` or `mask` once the step is pushed. */
+  SculptUndoDelta *delta;
+
   /* non-multires */
   int maxvert; /* to verify if totvert it still the same */
   int *index;  /* to restore into right location */
@@ -866,6 +898,44 @@ float SCULPT_brush_strength_factor(struct SculptSession *ss,
                                    const int vertex_index,
                                    const int thread_id);
 
+/* Vertices of a PBVH node that are affected by the brush, gathered into flat arrays so their
+ * strength factors can be computed in a few tight loops over the whole node instead of one
+ * #SCULPT_brush_strength_factor call per vertex. */
+typedef struct SculptBrushBatch {
+  int len;
+  /* Index of the vertex in the node iteration (#PBVHVertexIter.i), used to index proxies. */
+  int *node_index;
+  /* Index of the vertex in the mesh (#PBVHVertexIter.index). */
+  int *vert_index;
+  float (*co)[3];
+  /* The falloff distance of every vertex, replaced by its strength factor by
+   * #SCULPT_brush_batch_factors. */
+  float *factor;
+  float *mask;
+  /* Only used by brushes with #BRUSH_FRONTFACE. */
+  float (*no)[3];
+  /* Optional brush specific vector, like the displacement of plane brushes. */
+  float (*vec)[3];
+  /* Vertices to tag for updates, only used by #PBVH_FACES. */
+  struct MVert **mvert;
+} SculptBrushBatch;
+
+void SCULPT_brush_batch_init(SculptBrushBatch *batch,
+                             SculptSession *ss,
+                             const struct Brush *br,
+                             PBVHNode *node,
+                             const bool use_vec);
+int SCULPT_brush_batch_add(SculptBrushBatch *batch,
+                           const PBVHVertexIter *vd,
+                           const float len,
+                           const float mask);
+void SCULPT_brush_batch_factors(SculptSession *ss,
+                                const struct Brush *br,
+                                SculptBrushBatch *batch,
+                                const int thread_id);
+void SCULPT_brush_batch_tag_update(const SculptBrushBatch *batch);
+void SCULPT_brush_batch_free(SculptBrushBatch *batch);
+
 /* Tilts a normal by the x and y tilt values using the view axis. */
 void SCULPT_tilt_apply_to_normal(float r_normal[3],
                                  struct StrokeCache *cache,
@@ -312,21 +312,31 @@ static void do_smooth_brush_task_cb_ex(void *__restrict userdata,
 
   const int thread_id = BLI_task_parallel_thread_id(tls);
 
+  /* Compute the factors of all vertices first. The brush test only depends on the position of
+   * the vertex itself, so smoothing the vertices in place afterwards gives the same result. */
+  SculptBrushBatch batch;
+  SCULPT_brush_batch_init(&batch, ss, brush, data->nodes[n], false);
+
   BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
   {
     if (!sculpt_brush_test_sq_fn(&test, vd.co)) {
       continue;
     }
-    const float fade = bstrength * SCULPT_brush_strength_factor(
-                                       ss,
-                                       brush,
-                                       vd.co,
-                                       sqrtf(test.dist),
-                                       vd.no,
-                                       vd.fno,
-                                       smooth_mask ? 0.0f : (vd.mask ? *vd.mask : 0.0f),
-                                       vd.index,
-                                       thread_id);
+    SCULPT_brush_batch_add(
+        &batch, &vd, sqrtf(test.dist), smooth_mask ? 0.0f : (vd.mask ? *vd.mask : 0.0f));
+  }
+  BKE_pbvh_vertex_iter_end;
+
+  SCULPT_brush_batch_factors(ss, brush, &batch, thread_id);
+
+  /* The batch is in iteration order, so iterating again visits its vertices in the same order. */
+  int batch_index = 0;
+  BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
+  {
+    if (batch_index == batch.len || batch.node_index[batch_index] != vd.i) {
+      continue;
+    }
+    const float fade = bstrength * batch.factor[batch_index++];
     if (smooth_mask) {
       float val = SCULPT_neighbor_mask_average(ss, vd.index) - *vd.mask;
       val *= fade * bstrength;
@@ -345,6 +355,8 @@ static void do_smooth_brush_task_cb_ex(void *__restrict userdata,
     }
   }
   BKE_pbvh_vertex_iter_end;
+
+  SCULPT_brush_batch_free(&batch);
 }
 
 void SCULPT_smooth(Sculpt *sd,
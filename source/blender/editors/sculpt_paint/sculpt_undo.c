@@ -26,7 +26,9 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_delta_codec.h"
 #include "BLI_ghash.h"
+#include "BLI_hash.h"
 #include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_string.h"
@@ -45,6 +47,7 @@
 #include "BKE_customdata.h"
 #include "BKE_global.h"
 #include "BKE_key.h"
+#include "BKE_lib_id.h"
 #include "BKE_main.h"
 #include "BKE_mesh.h"
 #include "BKE_multires.h"
@@ -180,6 +183,309 @@ static bool sculpt_undo_restore_deformed(
   return false;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Undo Node Deltas
+ *
+ * Once a step is pushed, the coordinates and masks stored by its regular mesh nodes are only
+ * needed to restore the mesh. They are replaced by the difference between the values before and
+ * after the step, only for the vertices which changed, so that nodes barely touched by a stroke
+ * don't keep a full copy of their vertices.
+ *
+ * The differences are stored with #BLI_delta_codec_compress, exact in both directions and small
+ * for nodes where most vertices didn't move.
+ * \{ */
+
+/**
+ * Create the delta from the values of the node before the step and the current values, found at
+ * `base + stride * index[i]` for every vertex of the node.
+ */
+static SculptUndoDelta *sculpt_undo_delta_create(const float *values_before,
+                                                 const int components,
+                                                 const int *index,
+                                                 const int totvert,
+                                                 const char *base,
+                                                 const size_t stride)
+{
+  SculptUndoDelta *delta = MEM_callocN(sizeof(*delta), __func__);
+  delta->changed = BLI_BITMAP_NEW(totvert, __func__);
+  delta->components = components;
+  delta->is_applied = true;
+
+  uint *words = MEM_mallocN(sizeof(*words) * (size_t)totvert * (size_t)components, __func__);
+  size_t words_len = 0;
+
+  for (int i = 0; i < totvert; i++) {
+    uint before[3], after[3];
+    memcpy(before, &values_before[i * components], sizeof(uint) * components);
+    memcpy(after, base + stride * (size_t)index[i], sizeof(uint) * components);
+
+    /* No need for float comparison here (memory is exactly equal or not). */
+    if (memcmp(before, after, sizeof(uint) * components) == 0) {
+      continue;
+    }
+
+    BLI_BITMAP_ENABLE(delta->changed, i);
+    delta->changed_len++;
+    for (int j = 0; j < components; j++) {
+      words[words_len++] = BLI_delta_codec_encode(before[j], after[j]);
+      delta->hash_before = BLI_hash_int_2d(delta->hash_before, before[j]);
+      delta->hash_after = BLI_hash_int_2d(delta->hash_after, after[j]);
+    }
+  }
+
+  delta->data = BLI_delta_codec_compress(words, words_len, &delta->data_len);
+  MEM_freeN(words);
+
+  return delta;
+}
+
+static size_t sculpt_undo_delta_size(const SculptUndoDelta *delta)
+{
+  return sizeof(*delta) + MEM_allocN_len(delta->changed) +
+         (delta->data ? MEM_allocN_len(delta->data) : 0);
+}
+
+static void sculpt_undo_delta_free(SculptUndoDelta *delta)
+{
+  MEM_freeN(delta->changed);
+  MEM_SAFE_FREE(delta->data);
+  MEM_freeN(delta);
+}
+
+/**
+ * Tell the user about vertices whose stored differences don't match the mesh, which happens when
+ * it was changed outside of sculpt mode undo, for example by a script.
+ */
+static void sculpt_undo_delta_report_mismatch(void)
+{
+  WM_report(RPT_WARNING,
+            "Mesh was changed outside of sculpt undo, some vertices were not restored");
+}
+
+/**
+ * Swap the values of the changed vertices between their state before and after the step, the
+ * counterpart of #sculpt_undo_delta_create.
+ *
+ * \return false when the current values are neither, in that case the mesh was modified outside
+ * of undo and applying the differences would only produce garbage, so the values are left as is.
+ */
+static bool sculpt_undo_delta_apply(SculptUndoDelta *delta,
+                                    const int *index,
+                                    const int totvert,
+                                    char *base,
+                                    const size_t stride,
+                                    MVert *mvert)
+{
+  const int components = delta->components;
+
+  if (delta->changed_len == 0) {
+    delta->is_applied = !delta->is_applied;
+    return true;
+  }
+
+  uint hash = 0;
+  for (int i = 0; i < totvert; i++) {
+    if (BLI_BITMAP_TEST(delta->changed, i)) {
+      uint bits[3];
+      memcpy(bits, base + stride * (size_t)index[i], sizeof(uint) * components);
+      for (int j = 0; j < components; j++) {
+        hash = BLI_hash_int_2d(hash, bits[j]);
+      }
+    }
+  }
+  if (hash != (delta->is_applied ? delta->hash_after : delta->hash_before)) {
+    return false;
+  }
+
+  const size_t words_len = (size_t)delta->changed_len * (size_t)components;
+  uint *words = MEM_mallocN(sizeof(*words) * words_len, __func__);
+  if (!BLI_delta_codec_decompress(delta->data, delta->data_len, words, words_len)) {
+    MEM_freeN(words);
+    return false;
+  }
+
+  const uint *word = words;
+  for (int i = 0; i < totvert; i++) {
+    if (BLI_BITMAP_TEST(delta->changed, i)) {
+      char *value = base + stride * (size_t)index[i];
+      uint bits[3];
+      memcpy(bits, value, sizeof(uint) * components);
+      for (int j = 0; j < components; j++, word++) {
+        bits[j] = BLI_delta_codec_apply(bits[j], *word, delta->is_applied);
+      }
+      memcpy(value, bits, sizeof(uint) * components);
+
+      if (mvert) {
+        mvert[index[i]].flag |= ME_VERT_PBVH_UPDATE;
+      }
+    }
+  }
+
+  MEM_freeN(words);
+
+  delta->is_applied = !delta->is_applied;
+  return true;
+}
+
+/**
+ * Nodes storing values which can be replaced by a delta: regular mesh coordinates and masks,
+ * except when they also need the original coordinates of deform modifiers or go through a shape
+ * key.
+ */
+static bool sculpt_undo_delta_supported(const SculptUndoNode *unode, const SculptSession *ss)
+{
+  if (unode->maxvert == 0 || unode->delta != NULL || ss == NULL || ss->bm != NULL ||
+      ss->totvert != unode->maxvert) {
+    return false;
+  }
+  switch (unode->type) {
+    case SCULPT_UNDO_COORDS:
+      return unode->co && !unode->orig_co && unode->shapeName[0] == '\0' &&
+             !ss->shapekey_active && !ss->deform_modifiers_active && ss->mvert;
+    case SCULPT_UNDO_MASK:
+      return unode->mask && ss->vmask;
+    default:
+      return false;
+  }
+}
+
+static void sculpt_undo_delta_target(const SculptUndoNode *unode,
+                                     SculptSession *ss,
+                                     char **r_base,
+                                     size_t *r_stride)
+{
+  if (unode->type == SCULPT_UNDO_COORDS) {
+    *r_base = (char *)ss->mvert[0].co;
+    *r_stride = sizeof(MVert);
+  }
+  else {
+    *r_base = (char *)ss->vmask;
+    *r_stride = sizeof(float);
+  }
+}
+
+typedef struct SculptUndoDeltaTaskData {
+  SculptSession *ss;
+  SculptUndoNode **nodes;
+  /* Result of every node, only when restoring. */
+  bool *restored;
+} SculptUndoDeltaTaskData;
+
+static void sculpt_undo_delta_create_task_cb(void *__restrict userdata,
+                                             const int n,
+                                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SculptUndoDeltaTaskData *data = userdata;
+  SculptUndoNode *unode = data->nodes[n];
+
+  char *base;
+  size_t stride;
+  sculpt_undo_delta_target(unode, data->ss, &base, &stride);
+
+  if (unode->type == SCULPT_UNDO_COORDS) {
+    unode->delta = sculpt_undo_delta_create(
+        (const float *)unode->co, 3, unode->index, unode->totvert, base, stride);
+    MEM_SAFE_FREE(unode->co);
+  }
+  else {
+    unode->delta = sculpt_undo_delta_create(
+        unode->mask, 1, unode->index, unode->totvert, base, stride);
+    MEM_SAFE_FREE(unode->mask);
+  }
+}
+
+/**
+ * Replace the values of the nodes of a finished step by deltas, called when the step is encoded so
+ * the mesh holds the values after the step.
+ */
+static void sculpt_undo_delta_create_nodes(Main *bmain, UndoSculpt *usculpt)
+{
+  const SculptUndoNode *first_unode = usculpt->nodes.first;
+  if (first_unode == NULL) {
+    return;
+  }
+
+  Object *ob = (Object *)BKE_libblock_find_name(bmain, ID_OB, first_unode->idname + 2);
+  if (ob == NULL || ob->sculpt == NULL) {
+    return;
+  }
+  SculptSession *ss = ob->sculpt;
+
+  SculptUndoNode **nodes = MEM_mallocN(sizeof(*nodes) * BLI_listbase_count(&usculpt->nodes),
+                                       __func__);
+  int totnode = 0;
+
+  LISTBASE_FOREACH (SculptUndoNode *, unode, &usculpt->nodes) {
+    if (STREQ(unode->idname, ob->id.name) && sculpt_undo_delta_supported(unode, ss)) {
+      usculpt->undo_size -= MEM_allocN_len(unode->type == SCULPT_UNDO_COORDS ?
+                                               (void *)unode->co :
+                                               (void *)unode->mask);
+      nodes[totnode++] = unode;
+    }
+  }
+
+  SculptUndoDeltaTaskData data = {
+      .ss = ss,
+      .nodes = nodes,
+  };
+
+  TaskParallelSettings settings;
+  BKE_pbvh_parallel_range_settings(&settings, true, totnode);
+  BLI_task_parallel_range(0, totnode, &data, sculpt_undo_delta_create_task_cb, &settings);
+
+  for (int i = 0; i < totnode; i++) {
+    usculpt->undo_size += sculpt_undo_delta_size(nodes[i]->delta);
+  }
+
+  MEM_freeN(nodes);
+}
+
+static void sculpt_undo_delta_restore_task_cb(void *__restrict userdata,
+                                              const int n,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SculptUndoDeltaTaskData *data = userdata;
+  SculptUndoNode *unode = data->nodes[n];
+
+  char *base;
+  size_t stride;
+  sculpt_undo_delta_target(unode, data->ss, &base, &stride);
+
+  data->restored[n] = sculpt_undo_delta_apply(
+      unode->delta, unode->index, unode->totvert, base, stride, data->ss->mvert);
+}
+
+/**
+ * Restore the nodes storing deltas, every node owns the vertices it restores so they are decoded
+ * and applied in parallel.
+ *
+ * \return false when some nodes don't match the mesh, see #sculpt_undo_delta_apply.
+ */
+static bool sculpt_undo_delta_restore_nodes(SculptSession *ss,
+                                            SculptUndoNode **nodes,
+                                            const int totnode)
+{
+  SculptUndoDeltaTaskData data = {
+      .ss = ss,
+      .nodes = nodes,
+      .restored = MEM_mallocN(sizeof(bool) * totnode, __func__),
+  };
+
+  TaskParallelSettings settings;
+  BKE_pbvh_parallel_range_settings(&settings, true, totnode);
+  BLI_task_parallel_range(0, totnode, &data, sculpt_undo_delta_restore_task_cb, &settings);
+
+  bool restored = true;
+  for (int i = 0; i < totnode; i++) {
+    restored &= data.restored[i];
+  }
+  MEM_freeN(data.restored);
+
+  return restored;
+}
+
+/** \} */
+
 static bool sculpt_undo_restore_coords(bContext *C, Depsgraph *depsgraph, SculptUndoNode *unode)
 {
   ViewLayer *view_layer = CTX_data_view_layer(C);
@@ -218,7 +524,17 @@ static bool sculpt_undo_restore_coords(bContext *C, Depsgraph *depsgraph, Sculpt
       float(*vertCos)[3];
       vertCos = BKE_keyblock_convert_to_vertcos(ob, ss->shapekey_active);
 
-      if (unode->orig_co) {
+      if (unode->delta) {
+        /* The shape key was added after the step was pushed. */
+        if (!sculpt_undo_delta_apply(
+                unode->delta, index, unode->totvert, (char *)vertCos, sizeof(*vertCos), NULL)) {
+          /* Leave the shape key as it is. */
+          sculpt_undo_delta_report_mismatch();
+          MEM_freeN(vertCos);
+          return false;
+        }
+      }
+      else if (unode->orig_co) {
         if (ss->deform_modifiers_active) {
           for (int i = 0; i < unode->totvert; i++) {
             sculpt_undo_restore_deformed(ss, unode, i, index[i], vertCos[index[i]]);
@@ -708,6 +1024,9 @@ static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase
 
   char *undo_modified_grids = NULL;
   bool use_multires_undo = false;
+  SculptUndoNode **delta_nodes = MEM_mallocN(sizeof(*delta_nodes) * BLI_listbase_count(lb),
+                                             __func__);
+  int delta_totnode = 0;
 
   for (unode = lb->first; unode; unode = unode->next) {
 
@@ -731,6 +1050,14 @@ static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase
       use_multires_undo = true;
     }
 
+    if (unode->delta && (unode->type == SCULPT_UNDO_MASK || !ss->shapekey_active)) {
+      /* Restored together once all other nodes are done. */
+      delta_nodes[delta_totnode++] = unode;
+      update = true;
+      update_mask |= unode->type == SCULPT_UNDO_MASK;
+      continue;
+    }
+
     switch (unode->type) {
       case SCULPT_UNDO_COORDS:
         if (sculpt_undo_restore_coords(C, depsgraph, unode)) {
@@ -771,6 +1098,14 @@ static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase
     }
   }
 
+  if (delta_totnode != 0 && !sculpt_undo_delta_restore_nodes(ss, delta_nodes, delta_totnode)) {
+    /* The mesh was modified outside of undo, the nodes which don't match keep their values.
+     * Rebuild everything so the drawing and bounds at least agree with the mesh. */
+    sculpt_undo_delta_report_mismatch();
+    rebuild = true;
+  }
+  MEM_freeN(delta_nodes);
+
   if (use_multires_undo) {
     for (unode = lb->first; unode; unode = unode->next) {
       if (!STREQ(unode->idname, ob->id.name)) {
@@ -885,6 +1220,9 @@ static void sculpt_undo_free_list(ListBase *lb)
     if (unode->mask) {
       MEM_freeN(unode->mask);
     }
+    if (unode->delta) {
+      sculpt_undo_delta_free(unode->delta);
+    }
 
     if (unode->bm_entry) {
       BM_log_entry_drop(unode->bm_entry);
@@ -1457,6 +1795,8 @@ static bool sculpt_undosys_step_encode(struct bContext *UNUSED(C),
   /* Dummy, encoding is done along the way by adding tiles
    * to the current 'SculptUndoStep' added by encode_init. */
   SculptUndoStep *us = (SculptUndoStep *)us_p;
+
+  sculpt_undo_delta_create_nodes(bmain, &us->data);
   us->step.data_size = us->data.undo_size;
 
   SculptUndoNode *unode = us->data.nodes.last;
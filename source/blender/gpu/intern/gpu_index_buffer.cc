@@ -66,6 +66,20 @@ void GPU_indexbuf_init(GPUIndexBufBuilder *builder,
   GPU_indexbuf_init_ex(builder, prim_type, prim_len * (uint)verts_per_prim, vertex_len);
 }
 
+void GPU_indexbuf_subbuilder_init(const GPUIndexBufBuilder *parent_builder,
+                                  GPUIndexBufBuilder *sub_builder)
+{
+  BLI_assert(parent_builder->data != nullptr);
+  *sub_builder = *parent_builder;
+  sub_builder->index_len = 0;
+}
+
+void GPU_indexbuf_join(GPUIndexBufBuilder *builder, const GPUIndexBufBuilder *sub_builder)
+{
+  BLI_assert(builder->data == sub_builder->data);
+  builder->index_len = MAX2(builder->index_len, sub_builder->index_len);
+}
+
 void GPU_indexbuf_add_generic_vert(GPUIndexBufBuilder *builder, uint v)
 {
 #if TRUST_NO_ONE
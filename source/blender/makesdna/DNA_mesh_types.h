@@ -80,15 +80,35 @@ typedef struct Mesh_Runtime {
    * This mesh is used as a result of modifier stack evaluation.
    * Since modifier stack evaluation is threaded on object level we need some synchronization. */
   struct Mesh *mesh_eval;
+  /**
+   * Result of the modifier stack which objects using this mesh with the same modifiers share,
+   * with the settings it is valid for, see #BKE_mesh_runtime_eval_shared_get.
+   * Protected by the same lock as #mesh_eval.
+   */
+  struct MeshEvalShared *eval_shared;
   void *eval_mutex;
 
   struct EditMeshData *edit_data;
   void *batch_cache;
+  /**
+   * Copy of the data besides vertex positions that the #batch_cache was built from, used to
+   * detect evaluated meshes that are only deformed from the previous evaluation result.
+   * See #BKE_mesh_runtime_batch_cache_restore.
+   */
+  struct MeshBatchCacheTopology *batch_cache_topology;
 
   struct SubdivCCG *subdiv_ccg;
-  void *_pad1;
+  /**
+   * Reference counted topology and attribute layers shared with other evaluated meshes,
+   * see #BKE_mesh_copy_for_eval_shared_topology.
+   */
+  struct MeshSharedTopology *shared_topology;
   int subdiv_ccg_tot_level;
-  char _pad2[4];
+  /**
+   * Number of objects and #eval_shared slots referencing this evaluated mesh,
+   * zero when it is owned by a single object.
+   */
+  int eval_shared_users;
 
   int64_t cd_dirty_vert;
   int64_t cd_dirty_edge;
@@ -148,6 +148,11 @@ typedef enum {
    * Only one modifier on an object should have this flag set.
    */
   eModifierFlag_Active = (1 << 2),
+  /**
+   * Keep the result of this modifier between evaluations, so that changing modifiers further
+   * down the stack does not evaluate it again.
+   */
+  eModifierFlag_CacheResult = (1 << 3),
 } ModifierFlag;
 
 /* not a real modifier */
@@ -642,6 +647,8 @@ enum {
   /** for dissolve only. collapse all verts between 2 faces */
   MOD_DECIM_FLAG_ALL_BOUNDARY_VERTS = (1 << 2),
   MOD_DECIM_FLAG_SYMMETRY = (1 << 3),
+  /** for collapse only. decimate spatial partitions of the mesh in parallel */
+  MOD_DECIM_FLAG_PARALLEL = (1 << 4),
 };
 
 enum {
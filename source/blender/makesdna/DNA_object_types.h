@@ -44,6 +44,7 @@ struct GeometrySet;
 struct Ipo;
 struct Material;
 struct Mesh;
+struct ModifierStackCache;
 struct Object;
 struct PartDeflect;
 struct Path;
@@ -201,6 +202,12 @@ typedef struct Object_Runtime {
   /** Runtime evaluated curve-specific data, not stored in the file. */
   struct CurveCache *curve_cache;
 
+  /**
+   * Result of a modifier in the middle of the stack, kept between evaluations.
+   * Not freed with the other evaluated data, see #eModifierFlag_CacheResult.
+   */
+  struct ModifierStackCache *modifier_stack_cache;
+
   unsigned short local_collections_bits;
   short _pad2[3];
 } Object_Runtime;
@@ -322,7 +329,8 @@ typedef struct Object {
   /** Used for DopeSheet filtering settings (expanded/collapsed). */
   short nlaflag;
 
-  char _pad1;
+  /** #OB_MODIFIER_CACHE_AUTO. */
+  char modifier_cache_flag;
   char duplicator_visibility_flag;
 
   /* Depsgraph */
@@ -701,6 +709,12 @@ enum {
   OB_DUPLI_FLAG_RENDER = 1 << 1,
 };
 
+/* ob->modifier_cache_flag */
+enum {
+  /** Cache the result of the modifier that took longest in the last evaluation. */
+  OB_MODIFIER_CACHE_AUTO = 1 << 0,
+};
+
 /* ob->empty_image_depth */
 #define OB_EMPTY_IMAGE_DEPTH_DEFAULT 0
 #define OB_EMPTY_IMAGE_DEPTH_FRONT 1
@@ -52,6 +52,9 @@ typedef struct PointCloud {
 
   /* Draw Cache */
   void *batch_cache;
+
+  /* Runtime spatial index, see #BKE_pointcloud_spatial_index_ensure. */
+  void *spatial_index;
 } PointCloud;
 
 /* PointCloud.flag */
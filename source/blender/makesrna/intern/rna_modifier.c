@@ -2309,6 +2309,14 @@ static void rna_def_modifier_decimate(BlenderRNA *brna)
       prop, "Triangulate", "Keep triangulated faces resulting from decimation (collapse only)");
   RNA_def_property_update(prop, 0, "rna_Modifier_update");
 
+  prop = RNA_def_property(srna, "use_collapse_parallel", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", MOD_DECIM_FLAG_PARALLEL);
+  RNA_def_property_ui_text(prop,
+                           "Parallel",
+                           "Decimate regions of the mesh in parallel, faster on large meshes "
+                           "but the result differs slightly (collapse only, without symmetry)");
+  RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
   prop = RNA_def_property(srna, "use_symmetry", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "flag", MOD_DECIM_FLAG_SYMMETRY);
   RNA_def_property_ui_text(prop, "Symmetry", "Maintain symmetry on an axis");
@@ -7277,6 +7285,16 @@ void RNA_def_modifier(BlenderRNA *brna)
   RNA_def_property_ui_text(prop, "Active", "The active modifier in the list");
   RNA_def_property_update(prop, NC_OBJECT | ND_MODIFIER, NULL);
 
+  prop = RNA_def_property(srna, "use_cache_result", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", eModifierFlag_CacheResult);
+  RNA_def_property_override_flag(prop, PROPOVERRIDE_OVERRIDABLE_LIBRARY);
+  RNA_def_property_ui_text(prop,
+                           "Cache Result",
+                           "Keep the result of this modifier in memory, so that changing "
+                           "modifiers further down the stack does not evaluate it again "
+                           "(only used for modifiers that generate geometry)");
+  RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
   prop = RNA_def_property(srna, "use_apply_on_spline", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "mode", eModifierMode_ApplyOnSpline);
   RNA_def_property_ui_text(
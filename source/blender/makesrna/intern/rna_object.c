@@ -3044,6 +3044,14 @@ static void rna_def_object(BlenderRNA *brna)
   RNA_def_property_override_flag(prop, PROPOVERRIDE_LIBRARY_INSERTION);
   rna_def_object_modifiers(brna, prop);
 
+  prop = RNA_def_property(srna, "use_modifier_cache_auto", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "modifier_cache_flag", OB_MODIFIER_CACHE_AUTO);
+  RNA_def_property_ui_text(prop,
+                           "Auto Cache Modifier Result",
+                           "Keep the result of the slowest modifier in memory, so that changing "
+                           "modifiers further down the stack does not evaluate it again");
+  RNA_def_property_update(prop, 0, "rna_Object_internal_update_data");
+
   /* Grease Pencil modifiers. */
   prop = RNA_def_property(srna, "grease_pencil_modifiers", PROP_COLLECTION, PROP_NONE);
   RNA_def_property_collection_sdna(prop, NULL, "greasepencil_modifiers", NULL);
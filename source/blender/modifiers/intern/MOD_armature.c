@@ -82,6 +82,28 @@ static void copyData(const ModifierData *md, ModifierData *target, const int fla
   tamd->vert_coords_prev = NULL;
 }
 
+static void freeRuntimeData(void *runtime_data)
+{
+  if (runtime_data != NULL) {
+    BKE_armature_skinning_cache_free(runtime_data);
+  }
+}
+
+static void freeData(ModifierData *md)
+{
+  freeRuntimeData(md->runtime);
+  md->runtime = NULL;
+}
+
+/* The vertex group weights, kept between evaluations. */
+static struct ArmatureSkinningCache *armature_skinning_cache_ensure(ModifierData *md)
+{
+  if (md->runtime == NULL) {
+    md->runtime = BKE_armature_skinning_cache_create();
+  }
+  return md->runtime;
+}
+
 static void requiredDataMask(Object *UNUSED(ob),
                              ModifierData *UNUSED(md),
                              CustomData_MeshMasks *r_cddata_masks)
@@ -159,12 +181,52 @@ static void deformVerts(ModifierData *md,
                                        amd->deformflag,
                                        amd->vert_coords_prev,
                                        amd->defgrp_name,
-                                       mesh);
+                                       mesh,
+                                       armature_skinning_cache_ensure(md));
 
   /* free cache */
   MEM_SAFE_FREE(amd->vert_coords_prev);
 }
 
+static void deform_range(void *userdata, float (*vertexCos)[3], int start, int end)
+{
+  BKE_armature_deform_range_eval(userdata, vertexCos, start, end);
+}
+
+static void deform_range_free(void *userdata)
+{
+  BKE_armature_deform_range_destroy(userdata);
+}
+
+static bool deformVertsPointwise(ModifierData *md,
+                                 const ModifierEvalContext *ctx,
+                                 Mesh *mesh,
+                                 int numVerts,
+                                 ModifierPointwiseDeform *r_deform)
+{
+  ArmatureModifierData *amd = (ArmatureModifierData *)md;
+
+  /* Blending with, or passing on the coordinates from before the modifier needs all of them. */
+  if (amd->vert_coords_prev != NULL || MOD_previous_vcos_needed(md)) {
+    return false;
+  }
+
+  struct ArmatureDeformRange *range = BKE_armature_deform_range_create_with_mesh(
+      amd->object,
+      ctx->object,
+      amd->deformflag,
+      amd->defgrp_name,
+      mesh,
+      numVerts,
+      armature_skinning_cache_ensure(md));
+  if (range != NULL) {
+    r_deform->deform_range = deform_range;
+    r_deform->free_userdata = deform_range_free;
+    r_deform->userdata = range;
+  }
+  return true;
+}
+
 static void deformVertsEM(ModifierData *md,
                           const ModifierEvalContext *ctx,
                           struct BMEditMesh *em,
@@ -234,7 +296,8 @@ static void deformMatrices(ModifierData *md,
                                        amd->deformflag,
                                        NULL,
                                        amd->defgrp_name,
-                                       mesh_src);
+                                       mesh_src,
+                                       armature_skinning_cache_ensure(md));
 
   if (!ELEM(mesh_src, NULL, mesh)) {
     BKE_id_free(NULL, mesh_src);
@@ -293,6 +356,7 @@ ModifierTypeInfo modifierType_Armature = {
     /* deformMatrices */ deformMatrices,
     /* deformVertsEM */ deformVertsEM,
     /* deformMatricesEM */ deformMatricesEM,
+    /* deformVertsPointwise */ deformVertsPointwise,
     /* modifyMesh */ NULL,
     /* modifyHair */ NULL,
     /* modifyGeometrySet */ NULL,
@@ -300,14 +364,14 @@ ModifierTypeInfo modifierType_Armature = {
 
     /* initData */ initData,
     /* requiredDataMask */ requiredDataMask,
-    /* freeData */ NULL,
+    /* freeData */ freeData,
     /* isDisabled */ isDisabled,
     /* updateDepsgraph */ updateDepsgraph,
     /* dependsOnTime */ NULL,
     /* dependsOnNormals */ NULL,
     /* foreachIDLink */ foreachIDLink,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ freeRuntimeData,
     /* panelRegister */ panelRegister,
     /* blendWrite */ NULL,
     /* blendRead */ blendRead,
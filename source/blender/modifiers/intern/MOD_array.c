@@ -1017,6 +1017,7 @@ ModifierTypeInfo modifierType_Array = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsPointwise */ NULL,
     /* modifyMesh */ modifyMesh,
     /* modifyHair */ NULL,
     /* modifyGeometrySet */ NULL,
@@ -445,6 +445,7 @@ ModifierTypeInfo modifierType_Bevel = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsPointwise */ NULL,
     /* modifyMesh */ modifyMesh,
     /* modifyHair */ NULL,
     /* modifyGeometrySet */ NULL,
@@ -888,6 +888,7 @@ ModifierTypeInfo modifierType_Boolean = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsPointwise */ NULL,
     /* modifyMesh */ modifyMesh,
     /* modifyHair */ NULL,
     /* modifyGeometrySet */ NULL,
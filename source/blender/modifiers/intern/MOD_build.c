@@ -344,6 +344,7 @@ ModifierTypeInfo modifierType_Build = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsPointwise */ NULL,
     /* modifyMesh */ modifyMesh,
     /* modifyHair */ NULL,
     /* modifyGeometrySet */ NULL,
@@ -50,6 +50,8 @@
 
 #include "DEG_depsgraph_query.h"
 
+#include "MEM_guardedalloc.h"
+
 #include "MOD_ui_common.h"
 #include "MOD_util.h"
 
@@ -106,27 +108,39 @@ static void updateDepsgraph(ModifierData *md, const ModifierUpdateDepsgraphConte
   }
 }
 
-static void sphere_do(CastModifierData *cmd,
-                      const ModifierEvalContext *UNUSED(ctx),
-                      Object *ob,
-                      Mesh *mesh,
-                      float (*vertexCos)[3],
-                      int numVerts)
+typedef struct CastSphereData {
+  const CastModifierData *cmd;
+  MDeformVert *dvert;
+  int defgrp_index;
+  short flag;
+  bool has_radius;
+  bool use_ctrl_ob;
+  float len;
+  float center[3];
+  float mat[4][4], imat[4][4];
+} CastSphereData;
+
+/**
+ * Prepare \a data for casting the vertices to a sphere or cylinder. When \a vertexCos is null,
+ * returns false if the size has to be computed from the vertex positions.
+ */
+static bool sphere_data_init(CastSphereData *data,
+                             CastModifierData *cmd,
+                             Object *ob,
+                             Mesh *mesh,
+                             float (*vertexCos)[3],
+                             int numVerts)
 {
   MDeformVert *dvert = NULL;
-  const bool invert_vgroup = (cmd->flag & MOD_CAST_INVERT_VGROUP) != 0;
 
   Object *ctrl_ob = NULL;
 
-  int i, defgrp_index;
+  int i, defgrp_index = -1;
   bool has_radius = false;
   short flag, type;
   float len = 0.0f;
-  float fac = cmd->fac;
-  float facm = 1.0f - fac;
-  const float fac_orig = fac;
-  float vec[3], center[3] = {0.0f, 0.0f, 0.0f};
-  float mat[4][4], imat[4][4];
+  float center[3] = {0.0f, 0.0f, 0.0f};
+  float mat[4][4] = {{0}}, imat[4][4] = {{0}};
 
   flag = cmd->flag;
   type = cmd->type; /* projection type: sphere or cylinder */
@@ -174,6 +188,9 @@ static void sphere_do(CastModifierData *cmd,
   }
 
   if (len <= 0) {
+    if (vertexCos == NULL) {
+      return false;
+    }
     for (i = 0; i < numVerts; i++) {
       len += len_v3v3(center, vertexCos[i]);
     }
@@ -184,66 +201,101 @@ static void sphere_do(CastModifierData *cmd,
     }
   }
 
-  for (i = 0; i < numVerts; i++) {
-    float tmp_co[3];
-
-    copy_v3_v3(tmp_co, vertexCos[i]);
-    if (ctrl_ob) {
-      if (flag & MOD_CAST_USE_OB_TRANSFORM) {
-        mul_m4_v3(mat, tmp_co);
-      }
-      else {
-        sub_v3_v3(tmp_co, center);
-      }
-    }
+  data->cmd = cmd;
+  data->dvert = dvert;
+  data->defgrp_index = defgrp_index;
+  data->flag = flag;
+  data->has_radius = has_radius;
+  data->use_ctrl_ob = ctrl_ob != NULL;
+  data->len = len;
+  copy_v3_v3(data->center, center);
+  copy_m4_m4(data->mat, mat);
+  copy_m4_m4(data->imat, imat);
+  return true;
+}
 
-    copy_v3_v3(vec, tmp_co);
+static void sphere_vert_do(const CastSphereData *data, float co[3], const int i)
+{
+  const CastModifierData *cmd = data->cmd;
+  const bool invert_vgroup = (cmd->flag & MOD_CAST_INVERT_VGROUP) != 0;
+  const short flag = data->flag;
+  const float len = data->len;
+  float fac = cmd->fac;
+  float facm = 1.0f - fac;
+  float vec[3];
+  float tmp_co[3];
 
-    if (type == MOD_CAST_TYPE_CYLINDER) {
-      vec[2] = 0.0f;
+  copy_v3_v3(tmp_co, co);
+  if (data->use_ctrl_ob) {
+    if (flag & MOD_CAST_USE_OB_TRANSFORM) {
+      mul_m4_v3(data->mat, tmp_co);
     }
-
-    if (has_radius) {
-      if (len_v3(vec) > cmd->radius) {
-        continue;
-      }
+    else {
+      sub_v3_v3(tmp_co, data->center);
     }
+  }
 
-    if (dvert) {
-      const float weight = invert_vgroup ?
-                               1.0f - BKE_defvert_find_weight(&dvert[i], defgrp_index) :
-                               BKE_defvert_find_weight(&dvert[i], defgrp_index);
+  copy_v3_v3(vec, tmp_co);
 
-      if (weight == 0.0f) {
-        continue;
-      }
+  if (cmd->type == MOD_CAST_TYPE_CYLINDER) {
+    vec[2] = 0.0f;
+  }
 
-      fac = fac_orig * weight;
-      facm = 1.0f - fac;
+  if (data->has_radius) {
+    if (len_v3(vec) > cmd->radius) {
+      return;
     }
+  }
 
-    normalize_v3(vec);
+  if (data->dvert) {
+    const float weight = invert_vgroup ?
+                             1.0f - BKE_defvert_find_weight(&data->dvert[i], data->defgrp_index) :
+                             BKE_defvert_find_weight(&data->dvert[i], data->defgrp_index);
 
-    if (flag & MOD_CAST_X) {
-      tmp_co[0] = fac * vec[0] * len + facm * tmp_co[0];
+    if (weight == 0.0f) {
+      return;
     }
-    if (flag & MOD_CAST_Y) {
-      tmp_co[1] = fac * vec[1] * len + facm * tmp_co[1];
+
+    fac = cmd->fac * weight;
+    facm = 1.0f - fac;
+  }
+
+  normalize_v3(vec);
+
+  if (flag & MOD_CAST_X) {
+    tmp_co[0] = fac * vec[0] * len + facm * tmp_co[0];
+  }
+  if (flag & MOD_CAST_Y) {
+    tmp_co[1] = fac * vec[1] * len + facm * tmp_co[1];
+  }
+  if (flag & MOD_CAST_Z) {
+    tmp_co[2] = fac * vec[2] * len + facm * tmp_co[2];
+  }
+
+  if (data->use_ctrl_ob) {
+    if (flag & MOD_CAST_USE_OB_TRANSFORM) {
+      mul_m4_v3(data->imat, tmp_co);
     }
-    if (flag & MOD_CAST_Z) {
-      tmp_co[2] = fac * vec[2] * len + facm * tmp_co[2];
+    else {
+      add_v3_v3(tmp_co, data->center);
     }
+  }
 
-    if (ctrl_ob) {
-      if (flag & MOD_CAST_USE_OB_TRANSFORM) {
-        mul_m4_v3(imat, tmp_co);
-      }
-      else {
-        add_v3_v3(tmp_co, center);
-      }
-    }
+  copy_v3_v3(co, tmp_co);
+}
 
-    copy_v3_v3(vertexCos[i], tmp_co);
+static void sphere_do(CastModifierData *cmd,
+                      const ModifierEvalContext *UNUSED(ctx),
+                      Object *ob,
+                      Mesh *mesh,
+                      float (*vertexCos)[3],
+                      int numVerts)
+{
+  CastSphereData data;
+  sphere_data_init(&data, cmd, ob, mesh, vertexCos, numVerts);
+
+  for (int i = 0; i < numVerts; i++) {
+    sphere_vert_do(&data, vertexCos[i], i);
   }
 }
 
@@ -497,6 +549,65 @@ static void deformVerts(ModifierData *md,
   }
 }
 
+typedef struct CastPointwiseData {
+  CastSphereData data;
+  Mesh *mesh_src;
+  Mesh *mesh;
+} CastPointwiseData;
+
+static void deform_range(void *userdata, float (*vertexCos)[3], int start, int end)
+{
+  const CastPointwiseData *pointwise_data = userdata;
+  for (int i = start; i < end; i++) {
+    sphere_vert_do(&pointwise_data->data, vertexCos[i], i);
+  }
+}
+
+static void deform_range_free(void *userdata)
+{
+  CastPointwiseData *pointwise_data = userdata;
+  if (!ELEM(pointwise_data->mesh_src, NULL, pointwise_data->mesh)) {
+    BKE_id_free(NULL, pointwise_data->mesh_src);
+  }
+  MEM_freeN(pointwise_data);
+}
+
+static bool deformVertsPointwise(ModifierData *md,
+                                 const ModifierEvalContext *ctx,
+                                 Mesh *mesh,
+                                 int numVerts,
+                                 ModifierPointwiseDeform *r_deform)
+{
+  CastModifierData *cmd = (CastModifierData *)md;
+
+  /* The cuboid is fitted to the bounds of the deformed vertices. */
+  if (cmd->type == MOD_CAST_TYPE_CUBOID) {
+    return false;
+  }
+
+  Mesh *mesh_src = NULL;
+  if (ctx->object->type == OB_MESH && cmd->defgrp_name[0] != '\0') {
+    /* mesh_src is only needed for vgroups. */
+    mesh_src = MOD_deform_mesh_eval_get(ctx->object, NULL, mesh, NULL, numVerts, false, false);
+  }
+
+  CastPointwiseData *pointwise_data = MEM_mallocN(sizeof(*pointwise_data), __func__);
+  if (!sphere_data_init(&pointwise_data->data, cmd, ctx->object, mesh_src, NULL, numVerts)) {
+    /* The size is computed from the deformed vertices. */
+    MEM_freeN(pointwise_data);
+    if (!ELEM(mesh_src, NULL, mesh)) {
+      BKE_id_free(NULL, mesh_src);
+    }
+    return false;
+  }
+  pointwise_data->mesh_src = mesh_src;
+  pointwise_data->mesh = mesh;
+  r_deform->deform_range = deform_range;
+  r_deform->free_userdata = deform_range_free;
+  r_deform->userdata = pointwise_data;
+  return true;
+}
+
 static void deformVertsEM(ModifierData *md,
                           const ModifierEvalContext *ctx,
                           struct BMEditMesh *editData,
@@ -588,6 +699,7 @@ ModifierTypeInfo modifierType_Cast = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ deformVertsEM,
     /* deformMatricesEM */ NULL,
+    /* deformVertsPointwise */ deformVertsPointwise,
     /* modifyMesh */ NULL,
     /* modifyHair */ NULL,
     /* modifyGeometrySet */ NULL,
@@ -308,6 +308,7 @@ ModifierTypeInfo modifierType_Cloth = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsPointwise */ NULL,
     /* modifyMesh */ NULL,
     /* modifyHair */ NULL,
     /* modifyGeometrySet */ NULL,
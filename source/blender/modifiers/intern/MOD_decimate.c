@@ -24,6 +24,7 @@
 #include "BLI_utildefines.h"
 
 #include "BLI_math.h"
+#include "BLI_threads.h"
 
 #include "BLT_translation.h"
 
@@ -185,13 +186,23 @@ static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *ctx, Mesh *
       const bool do_triangulate = (dmd->flag & MOD_DECIM_FLAG_TRIANGULATE) != 0;
       const int symmetry_axis = (dmd->flag & MOD_DECIM_FLAG_SYMMETRY) ? dmd->symmetry_axis : -1;
       const float symmetry_eps = 0.00002f;
-      BM_mesh_decimate_collapse(bm,
-                                dmd->percent,
-                                vweights,
-                                dmd->defgrp_factor,
-                                do_triangulate,
-                                symmetry_axis,
-                                symmetry_eps);
+      if ((dmd->flag & MOD_DECIM_FLAG_PARALLEL) && (symmetry_axis == -1)) {
+        BM_mesh_decimate_collapse_parallel(bm,
+                                           dmd->percent,
+                                           vweights,
+                                           dmd->defgrp_factor,
+                                           do_triangulate,
+                                           BLI_system_thread_count());
+      }
+      else {
+        BM_mesh_decimate_collapse(bm,
+                                  dmd->percent,
+                                  vweights,
+                                  dmd->defgrp_factor,
+                                  do_triangulate,
+                                  symmetry_axis,
+                                  symmetry_eps);
+      }
       break;
     }
     case MOD_DECIM_MODE_UNSUBDIV: {
@@ -256,6 +267,9 @@ static void panel_draw(const bContext *UNUSED(C), Panel *panel)
     uiItemDecoratorR(row, ptr, "symmetry_axis", 0);
 
     uiItemR(layout, ptr, "use_collapse_triangulate", 0, NULL, ICON_NONE);
+    sub = uiLayoutRow(layout, true);
+    uiLayoutSetActive(sub, !RNA_boolean_get(ptr, "use_symmetry"));
+    uiItemR(sub, ptr, "use_collapse_parallel", 0, NULL, ICON_NONE);
 
     modifier_vgroup_ui(layout, ptr, &ob_ptr, "vertex_group", "invert_vertex_group", NULL);
     sub = uiLayoutRow(layout, true);
@@ -297,6 +311,7 @@ ModifierTypeInfo modifierType_Decimate = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsPointwise */ NULL,
     /* modifyMesh */ modifyMesh,
     /* modifyHair */ NULL,
     /* modifyGeometrySet */ NULL,
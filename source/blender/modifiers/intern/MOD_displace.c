@@ -280,11 +280,16 @@ static void displaceModifier_do_task(void *__restrict userdata,
   }
 }
 
-static void displaceModifier_do(DisplaceModifierData *dmd,
-                                const ModifierEvalContext *ctx,
-                                Mesh *mesh,
-                                float (*vertexCos)[3],
-                                const int numVerts)
+/**
+ * Prepare \a data for displacing the vertices of \a mesh, returns false when the modifier has
+ * no effect. On success the data has to be freed with #displace_userdata_free.
+ */
+static bool displace_userdata_init(DisplaceUserdata *data,
+                                   DisplaceModifierData *dmd,
+                                   const ModifierEvalContext *ctx,
+                                   Mesh *mesh,
+                                   float (*vertexCos)[3],
+                                   const int numVerts)
 {
   Object *ob = ctx->object;
   MVert *mvert;
@@ -298,10 +303,10 @@ static void displaceModifier_do(DisplaceModifierData *dmd,
   const bool use_global_direction = dmd->space == MOD_DISP_SPACE_GLOBAL;
 
   if (dmd->texture == NULL && dmd->direction == MOD_DISP_DIR_RGB_XYZ) {
-    return;
+    return false;
   }
   if (dmd->strength == 0.0f) {
-    return;
+    return false;
   }
 
   mvert = mesh->mvert;
@@ -309,7 +314,7 @@ static void displaceModifier_do(DisplaceModifierData *dmd,
 
   if (defgrp_index >= 0 && dvert == NULL) {
     /* There is a vertex group, but it has no vertices. */
-    return;
+    return false;
   }
 
   Tex *tex_target = dmd->texture;
@@ -348,42 +353,61 @@ static void displaceModifier_do(DisplaceModifierData *dmd,
     copy_m4_m4(local_mat, ob->obmat);
   }
 
-  DisplaceUserdata data = {NULL};
-  data.scene = DEG_get_evaluated_scene(ctx->depsgraph);
-  data.dmd = dmd;
-  data.dvert = dvert;
-  data.weight = weight;
-  data.defgrp_index = defgrp_index;
-  data.direction = direction;
-  data.use_global_direction = use_global_direction;
-  data.tex_target = tex_target;
-  data.tex_co = tex_co;
-  data.vertexCos = vertexCos;
-  copy_m4_m4(data.local_mat, local_mat);
-  data.mvert = mvert;
-  data.vert_clnors = vert_clnors;
+  memset(data, 0, sizeof(*data));
+  data->scene = DEG_get_evaluated_scene(ctx->depsgraph);
+  data->dmd = dmd;
+  data->dvert = dvert;
+  data->weight = weight;
+  data->defgrp_index = defgrp_index;
+  data->direction = direction;
+  data->use_global_direction = use_global_direction;
+  data->tex_target = tex_target;
+  data->tex_co = tex_co;
+  data->vertexCos = vertexCos;
+  copy_m4_m4(data->local_mat, local_mat);
+  data->mvert = mvert;
+  data->vert_clnors = vert_clnors;
   if (tex_target != NULL) {
-    data.pool = BKE_image_pool_new();
-    BKE_texture_fetch_images_for_pool(tex_target, data.pool);
+    data->pool = BKE_image_pool_new();
+    BKE_texture_fetch_images_for_pool(tex_target, data->pool);
   }
-  TaskParallelSettings settings;
-  BLI_parallel_range_settings_defaults(&settings);
-  settings.use_threading = (numVerts > 512);
-  BLI_task_parallel_range(0, numVerts, &data, displaceModifier_do_task, &settings);
+  return true;
+}
 
-  if (data.pool != NULL) {
-    BKE_image_pool_free(data.pool);
+static void displace_userdata_free(DisplaceUserdata *data)
+{
+  if (data->pool != NULL) {
+    BKE_image_pool_free(data->pool);
   }
 
-  if (tex_co) {
-    MEM_freeN(tex_co);
+  if (data->tex_co) {
+    MEM_freeN(data->tex_co);
   }
 
-  if (vert_clnors) {
-    MEM_freeN(vert_clnors);
+  if (data->vert_clnors) {
+    MEM_freeN(data->vert_clnors);
   }
 }
 
+static void displaceModifier_do(DisplaceModifierData *dmd,
+                                const ModifierEvalContext *ctx,
+                                Mesh *mesh,
+                                float (*vertexCos)[3],
+                                const int numVerts)
+{
+  DisplaceUserdata data;
+  if (!displace_userdata_init(&data, dmd, ctx, mesh, vertexCos, numVerts)) {
+    return;
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (numVerts > 512);
+  BLI_task_parallel_range(0, numVerts, &data, displaceModifier_do_task, &settings);
+
+  displace_userdata_free(&data);
+}
+
 static void deformVerts(ModifierData *md,
                         const ModifierEvalContext *ctx,
                         Mesh *mesh,
@@ -399,6 +423,77 @@ static void deformVerts(ModifierData *md,
   }
 }
 
+typedef struct DisplacePointwiseData {
+  DisplaceUserdata data;
+  Mesh *mesh_src;
+  Mesh *mesh;
+} DisplacePointwiseData;
+
+static void deform_range(void *userdata, float (*vertexCos)[3], int start, int end)
+{
+  DisplacePointwiseData *pointwise_data = userdata;
+  DisplaceUserdata data = pointwise_data->data;
+  data.vertexCos = vertexCos;
+  for (int i = start; i < end; i++) {
+    displaceModifier_do_task(&data, i, NULL);
+  }
+}
+
+static void deform_range_free(void *userdata)
+{
+  DisplacePointwiseData *pointwise_data = userdata;
+  displace_userdata_free(&pointwise_data->data);
+  if (!ELEM(pointwise_data->mesh_src, NULL, pointwise_data->mesh)) {
+    BKE_id_free(NULL, pointwise_data->mesh_src);
+  }
+  MEM_freeN(pointwise_data);
+}
+
+static bool deformVertsPointwise(ModifierData *md,
+                                 const ModifierEvalContext *ctx,
+                                 Mesh *mesh,
+                                 int numVerts,
+                                 ModifierPointwiseDeform *r_deform)
+{
+  DisplaceModifierData *dmd = (DisplaceModifierData *)md;
+
+  /* Normals depend on the neighbors of the deformed vertices. */
+  if (ELEM(dmd->direction, MOD_DISP_DIR_NOR, MOD_DISP_DIR_CLNOR)) {
+    return false;
+  }
+  /* Only UV texture coordinates don't depend on the deformed vertex positions. */
+  if (dmd->texture != NULL && dmd->texmapping != MOD_DISP_MAP_UV) {
+    return false;
+  }
+
+  Mesh *mesh_src = MOD_deform_mesh_eval_get(ctx->object, NULL, mesh, NULL, numVerts, false, false);
+  if (mesh_src == NULL) {
+    return false;
+  }
+  if (dmd->texture != NULL && !CustomData_has_layer(&mesh_src->ldata, CD_MLOOPUV)) {
+    /* Falls back to local coordinates. */
+    if (!ELEM(mesh_src, NULL, mesh)) {
+      BKE_id_free(NULL, mesh_src);
+    }
+    return false;
+  }
+
+  DisplacePointwiseData *pointwise_data = MEM_mallocN(sizeof(*pointwise_data), __func__);
+  if (!displace_userdata_init(&pointwise_data->data, dmd, ctx, mesh_src, NULL, numVerts)) {
+    MEM_freeN(pointwise_data);
+    if (!ELEM(mesh_src, NULL, mesh)) {
+      BKE_id_free(NULL, mesh_src);
+    }
+    return true;
+  }
+  pointwise_data->mesh_src = mesh_src;
+  pointwise_data->mesh = mesh;
+  r_deform->deform_range = deform_range;
+  r_deform->free_userdata = deform_range_free;
+  r_deform->userdata = pointwise_data;
+  return true;
+}
+
 static void deformVertsEM(ModifierData *md,
                           const ModifierEvalContext *ctx,
                           struct BMEditMesh *editData,
@@ -504,6 +599,7 @@ ModifierTypeInfo modifierType_Displace = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ deformVertsEM,
     /* deformMatricesEM */ NULL,
+    /* deformVertsPointwise */ deformVertsPointwise,
     /* modifyMesh */ NULL,
     /* modifyHair */ NULL,
     /* modifyGeometrySet */ NULL,
@@ -131,6 +131,61 @@ static void deformVerts(ModifierData *md,
   }
 }
 
+typedef struct LatticePointwiseData {
+  struct LatticeDeformRange *range;
+  struct Mesh *mesh_src;
+  struct Mesh *mesh;
+} LatticePointwiseData;
+
+static void deform_range(void *userdata, float (*vertexCos)[3], int start, int end)
+{
+  LatticePointwiseData *data = userdata;
+  BKE_lattice_deform_range_eval(data->range, vertexCos, start, end);
+}
+
+static void deform_range_free(void *userdata)
+{
+  LatticePointwiseData *data = userdata;
+  BKE_lattice_deform_range_destroy(data->range);
+  if (!ELEM(data->mesh_src, NULL, data->mesh)) {
+    BKE_id_free(NULL, data->mesh_src);
+  }
+  MEM_freeN(data);
+}
+
+static bool deformVertsPointwise(ModifierData *md,
+                                 const ModifierEvalContext *ctx,
+                                 struct Mesh *mesh,
+                                 int numVerts,
+                                 ModifierPointwiseDeform *r_deform)
+{
+  LatticeModifierData *lmd = (LatticeModifierData *)md;
+
+  if (MOD_previous_vcos_needed(md)) {
+    return false;
+  }
+
+  struct Mesh *mesh_src = MOD_deform_mesh_eval_get(
+      ctx->object, NULL, mesh, NULL, numVerts, false, false);
+  struct LatticeDeformRange *range = BKE_lattice_deform_range_create_with_mesh(
+      lmd->object, ctx->object, lmd->flag, lmd->name, lmd->strength, mesh_src);
+  if (range == NULL) {
+    if (!ELEM(mesh_src, NULL, mesh)) {
+      BKE_id_free(NULL, mesh_src);
+    }
+    return true;
+  }
+
+  LatticePointwiseData *data = MEM_mallocN(sizeof(*data), __func__);
+  data->range = range;
+  data->mesh_src = mesh_src;
+  data->mesh = mesh;
+  r_deform->deform_range = deform_range;
+  r_deform->free_userdata = deform_range_free;
+  r_deform->userdata = data;
+  return true;
+}
+
 static void deformVertsEM(ModifierData *md,
                           const ModifierEvalContext *ctx,
                           struct BMEditMesh *em,
@@ -190,6 +245,7 @@ ModifierTypeInfo modifierType_Lattice = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ deformVertsEM,
     /* deformMatricesEM */ NULL,
+    /* deformVertsPointwise */ deformVertsPointwise,
     /* modifyMesh */ NULL,
     /* modifyHair */ NULL,
     /* modifyGeometrySet */ NULL,
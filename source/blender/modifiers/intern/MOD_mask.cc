@@ -460,6 +460,7 @@ ModifierTypeInfo modifierType_Mask = {
     /* deformMatrices */ nullptr,
     /* deformVertsEM */ nullptr,
     /* deformMatricesEM */ nullptr,
+    /* deformVertsPointwise */ nullptr,
     /* modifyMesh */ modifyMesh,
     /* modifyHair */ nullptr,
     /* modifyGeometrySet */ nullptr,
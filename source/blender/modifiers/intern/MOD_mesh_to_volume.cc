@@ -293,6 +293,7 @@ ModifierTypeInfo modifierType_MeshToVolume = {
     /* deformMatrices */ nullptr,
     /* deformVertsEM */ nullptr,
     /* deformMatricesEM */ nullptr,
+    /* deformVertsPointwise */ nullptr,
     /* modifyMesh */ nullptr,
     /* modifyHair */ nullptr,
     /* modifyGeometrySet */ nullptr,
@@ -31,6 +31,7 @@
 #include "BLI_listbase.h"
 #include "BLI_set.hh"
 #include "BLI_string.h"
+#include "BLI_timeit.hh"
 #include "BLI_utildefines.h"
 
 #include "DNA_collection_types.h"
@@ -394,10 +395,28 @@ class GeometryNodesEvaluator {
 
   void execute_node(const DNode node, GeoNodeExecParams params)
   {
-    const bNode &bnode = params.node();
-
     this->store_ui_hints(node, params);
 
+    /* Measuring every node has a cost, so it is only done when asked for. */
+    if (!(G.debug & G_DEBUG_NODES_TIME)) {
+      this->execute_node_implementation(node, params);
+      return;
+    }
+
+    const blender::timeit::TimePoint start_time = blender::timeit::Clock::now();
+    const int64_t start_memory = MEM_get_memory_in_use();
+
+    this->execute_node_implementation(node, params);
+
+    const blender::timeit::TimePoint end_time = blender::timeit::Clock::now();
+    const int64_t end_memory = MEM_get_memory_in_use();
+    this->store_exec_stats(node, end_time - start_time, end_memory - start_memory);
+  }
+
+  void execute_node_implementation(const DNode node, GeoNodeExecParams params)
+  {
+    const bNode &bnode = params.node();
+
     /* Use the geometry-node-execute callback if it exists. */
     if (bnode.typeinfo->geometry_node_execute != nullptr) {
       bnode.typeinfo->geometry_node_execute(params);
@@ -415,6 +434,17 @@ class GeometryNodesEvaluator {
     this->execute_unknown_node(node, params);
   }
 
+  void store_exec_stats(const DNode node,
+                        const blender::timeit::Nanoseconds exec_time,
+                        const int64_t exec_memory_delta) const
+  {
+    bNodeTree *btree_cow = node->btree();
+    bNodeTree *btree_original = (bNodeTree *)DEG_get_original_id((ID *)btree_cow);
+    const NodeTreeEvaluationContext context(*self_object_, *modifier_);
+    BKE_nodetree_exec_stats_add(
+        *btree_original, context, *node->bnode(), exec_time, exec_memory_delta);
+  }
+
   void store_ui_hints(const DNode node, GeoNodeExecParams params) const
   {
     for (const InputSocketRef *socket_ref : node->inputs()) {
@@ -1353,6 +1383,7 @@ ModifierTypeInfo modifierType_Nodes = {
     /* deformMatrices */ nullptr,
     /* deformVertsEM */ nullptr,
     /* deformMatricesEM */ nullptr,
+    /* deformVertsPointwise */ nullptr,
     /* modifyMesh */ modifyMesh,
     /* modifyHair */ nullptr,
     /* modifyGeometrySet */ modifyGeometrySet,
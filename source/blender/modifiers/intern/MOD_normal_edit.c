@@ -40,6 +40,7 @@
 #include "BKE_lib_id.h"
 #include "BKE_lib_query.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 #include "BKE_screen.h"
 
 #include "UI_interface.h"
@@ -528,6 +529,8 @@ static Mesh *normalEditModifier_do(NormalEditModifierData *enmd,
   }
   else {
     result = mesh;
+    /* Polygons may be flipped and edges marked sharp in place. */
+    BKE_mesh_runtime_shared_topology_ensure_mutable(result);
   }
 
   const int num_verts = result->totvert;
@@ -802,6 +805,7 @@ ModifierTypeInfo modifierType_NormalEdit = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsPointwise */ NULL,
     /* modifyMesh */ modifyMesh,
     /* modifyHair */ NULL,
     /* modifyGeometrySet */ NULL,
@@ -278,6 +278,11 @@ static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *ctx, Mesh *
     BKE_mesh_calc_normals_split(mesh);
     CustomData_clear_layer_flag(&mesh->ldata, CD_NORMAL, CD_FLAG_TEMPORARY);
   }
+  /* The result kept for deforming meshes is matched to the input by data pointers, which can be
+   * reused when the data of the original mesh is copied again after a change. */
+  if (((const ID *)ctx->object->data)->recalc != 0) {
+    BKE_subdiv_mesh_topology_cache_clear(subdiv);
+  }
   /* TODO(sergey): Decide whether we ever want to use CCG for subsurf,
    * maybe when it is a last modifier in the stack? */
   if (true) {
@@ -505,6 +510,7 @@ ModifierTypeInfo modifierType_Subsurf = {
     /* deformMatrices */ deformMatrices,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsPointwise */ NULL,
     /* modifyMesh */ modifyMesh,
     /* modifyHair */ NULL,
     /* modifyGeometrySet */ NULL,
@@ -33,6 +33,7 @@
 #include "DNA_screen_types.h"
 
 #include "BKE_context.h"
+#include "BKE_customdata.h"
 #include "BKE_mesh.h"
 #include "BKE_modifier.h"
 #include "BKE_screen.h"
@@ -42,51 +43,26 @@
 
 #include "RNA_access.h"
 
-#include "bmesh.h"
-#include "bmesh_tools.h"
-
 #include "MOD_modifiertypes.h"
 #include "MOD_ui_common.h"
 
-Mesh *triangulate_mesh(Mesh *mesh,
-                       const int quad_method,
-                       const int ngon_method,
-                       const int min_vertices,
-                       const int flag);
-
-Mesh *triangulate_mesh(Mesh *mesh,
-                       const int quad_method,
-                       const int ngon_method,
-                       const int min_vertices,
-                       const int flag)
+static Mesh *triangulate_mesh(Mesh *mesh,
+                              const int quad_method,
+                              const int ngon_method,
+                              const int min_vertices,
+                              const int flag)
 {
   Mesh *result;
-  BMesh *bm;
-  int total_edges, i;
-  MEdge *me;
-  CustomData_MeshMasks cd_mask_extra = {
-      .vmask = CD_MASK_ORIGINDEX, .emask = CD_MASK_ORIGINDEX, .pmask = CD_MASK_ORIGINDEX};
 
   bool keep_clnors = (flag & MOD_TRIANGULATE_KEEP_CUSTOMLOOP_NORMALS) != 0;
 
   if (keep_clnors) {
     BKE_mesh_calc_normals_split(mesh);
-    /* We need that one to 'survive' to/from BMesh conversions. */
+    /* We need that one to be copied to the result. */
     CustomData_clear_layer_flag(&mesh->ldata, CD_NORMAL, CD_FLAG_TEMPORARY);
-    cd_mask_extra.lmask |= CD_MASK_NORMAL;
   }
 
-  bm = BKE_mesh_to_bmesh_ex(mesh,
-                            &((struct BMeshCreateParams){0}),
-                            &((struct BMeshFromMeshParams){
-                                .calc_face_normal = true,
-                                .cd_mask_extra = cd_mask_extra,
-                            }));
-
-  BM_mesh_triangulate(bm, quad_method, ngon_method, min_vertices, false, NULL, NULL, NULL);
-
-  result = BKE_mesh_from_bmesh_for_eval_nomain(bm, &cd_mask_extra, mesh);
-  BM_mesh_free(bm);
+  result = BKE_mesh_triangulate(mesh, quad_method, ngon_method, min_vertices);
 
   if (keep_clnors) {
     float(*lnors)[3] = CustomData_get_layer(&result->ldata, CD_NORMAL);
@@ -99,16 +75,6 @@ Mesh *triangulate_mesh(Mesh *mesh,
     CustomData_set_layer_flag(&result->ldata, CD_NORMAL, CD_FLAG_TEMPORARY);
   }
 
-  total_edges = result->totedge;
-  me = result->medge;
-
-  /* force drawing of all edges (seems to be omitted in CDDM_from_bmesh) */
-  for (i = 0; i < total_edges; i++, me++) {
-    me->flag |= ME_EDGEDRAW | ME_EDGERENDER;
-  }
-
-  result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
-
   return result;
 }
 
@@ -175,6 +141,7 @@ ModifierTypeInfo modifierType_Triangulate = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsPointwise */ NULL,
     /* modifyMesh */ modifyMesh,
     /* modifyHair */ NULL,
     /* modifyGeometrySet */ NULL,
@@ -182,6 +182,15 @@ void MOD_previous_vcos_store(ModifierData *md, const float (*vert_coords)[3])
   /* lattice/mesh modifier too */
 }
 
+/* Whether the next modifier needs the coordinates from before \a md,
+ * see #MOD_previous_vcos_store. */
+bool MOD_previous_vcos_needed(const ModifierData *md)
+{
+  const ModifierData *md_next = md->next;
+  return md_next && md_next->type == eModifierType_Armature &&
+         ((const ArmatureModifierData *)md_next)->multi;
+}
+
 /* returns a mesh if mesh == NULL, for deforming modifiers that need it */
 Mesh *MOD_deform_mesh_eval_get(Object *ob,
                                struct BMEditMesh *em,
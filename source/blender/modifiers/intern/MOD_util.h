@@ -40,6 +40,7 @@ void MOD_get_texture_coords(struct MappingInfoModifierData *dmd,
                             float (*r_texco)[3]);
 
 void MOD_previous_vcos_store(struct ModifierData *md, const float (*vert_coords)[3]);
+bool MOD_previous_vcos_needed(const struct ModifierData *md);
 
 struct Mesh *MOD_deform_mesh_eval_get(struct Object *ob,
                                       struct BMEditMesh *em,
@@ -326,6 +326,7 @@ ModifierTypeInfo modifierType_VolumeDisplace = {
     /* deformMatrices */ nullptr,
     /* deformVertsEM */ nullptr,
     /* deformMatricesEM */ nullptr,
+    /* deformVertsPointwise */ nullptr,
     /* modifyMesh */ nullptr,
     /* modifyHair */ nullptr,
     /* modifyGeometrySet */ nullptr,
@@ -220,6 +220,7 @@ ModifierTypeInfo modifierType_VolumeToMesh = {
     /* deformMatrices */ nullptr,
     /* deformVertsEM */ nullptr,
     /* deformMatricesEM */ nullptr,
+    /* deformVertsPointwise */ nullptr,
     /* modifyMesh */ modifyMesh,
     /* modifyHair */ nullptr,
     /* modifyGeometrySet */ nullptr,
@@ -141,14 +141,31 @@ static bool dependsOnNormals(ModifierData *md)
   return (wmd->flag & MOD_WAVE_NORM) != 0;
 }
 
-static void waveModifier_do(WaveModifierData *md,
-                            const ModifierEvalContext *ctx,
-                            Object *ob,
-                            Mesh *mesh,
-                            float (*vertexCos)[3],
-                            int numVerts)
+typedef struct WaveUserdata {
+  WaveModifierData *wmd;
+  struct Scene *scene;
+  MVert *mvert;
+  MDeformVert *dvert;
+  int defgrp_index;
+  float ctime;
+  float minfac;
+  float lifefac;
+  float falloff_inv;
+  float (*tex_co)[3];
+} WaveUserdata;
+
+/**
+ * Prepare \a data for moving the vertices of \a mesh, returns false when the modifier has no
+ * effect. On success the data has to be freed with #wave_userdata_free.
+ */
+static bool wave_userdata_init(WaveUserdata *data,
+                               WaveModifierData *wmd,
+                               const ModifierEvalContext *ctx,
+                               Object *ob,
+                               Mesh *mesh,
+                               float (*vertexCos)[3],
+                               int numVerts)
 {
-  WaveModifierData *wmd = (WaveModifierData *)md;
   MVert *mvert = NULL;
   MDeformVert *dvert;
   int defgrp_index;
@@ -156,10 +173,7 @@ static void waveModifier_do(WaveModifierData *md,
   float minfac = (float)(1.0 / exp(wmd->width * wmd->narrow * wmd->width * wmd->narrow));
   float lifefac = wmd->height;
   float(*tex_co)[3] = NULL;
-  const int wmd_axis = wmd->flag & (MOD_WAVE_X | MOD_WAVE_Y);
   const float falloff = wmd->falloff;
-  float falloff_fac = 1.0f; /* when falloff == 0.0f this stays at 1.0f */
-  const bool invert_group = (wmd->flag & MOD_WAVE_INVERT_VGROUP) != 0;
 
   if ((wmd->flag & MOD_WAVE_NORM) && (mesh != NULL)) {
     mvert = mesh->mvert;
@@ -197,6 +211,10 @@ static void waveModifier_do(WaveModifierData *md,
     }
   }
 
+  if (lifefac == 0.0f) {
+    return false;
+  }
+
   Tex *tex_target = wmd->texture;
   if (mesh != NULL && tex_target != NULL) {
     tex_co = MEM_malloc_arrayN(numVerts, sizeof(*tex_co), "waveModifier_do tex_co");
@@ -205,105 +223,145 @@ static void waveModifier_do(WaveModifierData *md,
     MOD_init_texture((MappingInfoModifierData *)wmd, ctx);
   }
 
-  if (lifefac != 0.0f) {
-    /* avoid divide by zero checks within the loop */
-    float falloff_inv = falloff != 0.0f ? 1.0f / falloff : 1.0f;
-    int i;
+  data->wmd = wmd;
+  data->scene = DEG_get_evaluated_scene(ctx->depsgraph);
+  data->mvert = mvert;
+  data->dvert = dvert;
+  data->defgrp_index = defgrp_index;
+  data->ctime = ctime;
+  data->minfac = minfac;
+  data->lifefac = lifefac;
+  /* avoid divide by zero checks within the loop */
+  data->falloff_inv = falloff != 0.0f ? 1.0f / falloff : 1.0f;
+  data->tex_co = tex_co;
+  return true;
+}
 
-    for (i = 0; i < numVerts; i++) {
-      float *co = vertexCos[i];
-      float x = co[0] - wmd->startx;
-      float y = co[1] - wmd->starty;
-      float amplit = 0.0f;
-      float def_weight = 1.0f;
+static void wave_userdata_free(WaveUserdata *data)
+{
+  MEM_SAFE_FREE(data->tex_co);
+}
 
-      /* get weights */
-      if (dvert) {
-        def_weight = invert_group ? 1.0f - BKE_defvert_find_weight(&dvert[i], defgrp_index) :
-                                    BKE_defvert_find_weight(&dvert[i], defgrp_index);
+static void wave_vert_deform(const WaveUserdata *data, float co[3], const int i)
+{
+  const WaveModifierData *wmd = data->wmd;
+  const MDeformVert *dvert = data->dvert;
+  const MVert *mvert = data->mvert;
+  const int wmd_axis = wmd->flag & (MOD_WAVE_X | MOD_WAVE_Y);
+  const float falloff = wmd->falloff;
+  const bool invert_group = (wmd->flag & MOD_WAVE_INVERT_VGROUP) != 0;
+  const float ctime = data->ctime;
+  const float lifefac = data->lifefac;
+  float falloff_fac = 1.0f; /* when falloff == 0.0f this stays at 1.0f */
 
-        /* if this vert isn't in the vgroup, don't deform it */
-        if (def_weight == 0.0f) {
-          continue;
-        }
-      }
+  float x = co[0] - wmd->startx;
+  float y = co[1] - wmd->starty;
+  float amplit = 0.0f;
+  float def_weight = 1.0f;
 
-      switch (wmd_axis) {
-        case MOD_WAVE_X | MOD_WAVE_Y:
-          amplit = sqrtf(x * x + y * y);
-          break;
-        case MOD_WAVE_X:
-          amplit = x;
-          break;
-        case MOD_WAVE_Y:
-          amplit = y;
-          break;
-      }
+  /* get weights */
+  if (dvert) {
+    def_weight = invert_group ? 1.0f - BKE_defvert_find_weight(&dvert[i], data->defgrp_index) :
+                                BKE_defvert_find_weight(&dvert[i], data->defgrp_index);
 
-      /* this way it makes nice circles */
-      amplit -= (ctime - wmd->timeoffs) * wmd->speed;
+    /* if this vert isn't in the vgroup, don't deform it */
+    if (def_weight == 0.0f) {
+      return;
+    }
+  }
 
-      if (wmd->flag & MOD_WAVE_CYCL) {
-        amplit = (float)fmodf(amplit - wmd->width, 2.0f * wmd->width) + wmd->width;
-      }
+  switch (wmd_axis) {
+    case MOD_WAVE_X | MOD_WAVE_Y:
+      amplit = sqrtf(x * x + y * y);
+      break;
+    case MOD_WAVE_X:
+      amplit = x;
+      break;
+    case MOD_WAVE_Y:
+      amplit = y;
+      break;
+  }
 
-      if (falloff != 0.0f) {
-        float dist = 0.0f;
-
-        switch (wmd_axis) {
-          case MOD_WAVE_X | MOD_WAVE_Y:
-            dist = sqrtf(x * x + y * y);
-            break;
-          case MOD_WAVE_X:
-            dist = fabsf(x);
-            break;
-          case MOD_WAVE_Y:
-            dist = fabsf(y);
-            break;
-        }
-
-        falloff_fac = (1.0f - (dist * falloff_inv));
-        CLAMP(falloff_fac, 0.0f, 1.0f);
-      }
+  /* this way it makes nice circles */
+  amplit -= (ctime - wmd->timeoffs) * wmd->speed;
 
-      /* GAUSSIAN */
-      if ((falloff_fac != 0.0f) && (amplit > -wmd->width) && (amplit < wmd->width)) {
-        amplit = amplit * wmd->narrow;
-        amplit = (float)(1.0f / expf(amplit * amplit) - minfac);
-
-        /*apply texture*/
-        if (tex_co) {
-          Scene *scene = DEG_get_evaluated_scene(ctx->depsgraph);
-          TexResult texres;
-          texres.nor = NULL;
-          BKE_texture_get_value(scene, tex_target, tex_co[i], &texres, false);
-          amplit *= texres.tin;
-        }
-
-        /*apply weight & falloff */
-        amplit *= def_weight * falloff_fac;
-
-        if (mvert) {
-          /* move along normals */
-          if (wmd->flag & MOD_WAVE_NORM_X) {
-            co[0] += (lifefac * amplit) * mvert[i].no[0] / 32767.0f;
-          }
-          if (wmd->flag & MOD_WAVE_NORM_Y) {
-            co[1] += (lifefac * amplit) * mvert[i].no[1] / 32767.0f;
-          }
-          if (wmd->flag & MOD_WAVE_NORM_Z) {
-            co[2] += (lifefac * amplit) * mvert[i].no[2] / 32767.0f;
-          }
-        }
-        else {
-          /* move along local z axis */
-          co[2] += lifefac * amplit;
-        }
+  if (wmd->flag & MOD_WAVE_CYCL) {
+    amplit = (float)fmodf(amplit - wmd->width, 2.0f * wmd->width) + wmd->width;
+  }
+
+  if (falloff != 0.0f) {
+    float dist = 0.0f;
+
+    switch (wmd_axis) {
+      case MOD_WAVE_X | MOD_WAVE_Y:
+        dist = sqrtf(x * x + y * y);
+        break;
+      case MOD_WAVE_X:
+        dist = fabsf(x);
+        break;
+      case MOD_WAVE_Y:
+        dist = fabsf(y);
+        break;
+    }
+
+    falloff_fac = (1.0f - (dist * data->falloff_inv));
+    CLAMP(falloff_fac, 0.0f, 1.0f);
+  }
+
+  /* GAUSSIAN */
+  if ((falloff_fac != 0.0f) && (amplit > -wmd->width) && (amplit < wmd->width)) {
+    amplit = amplit * wmd->narrow;
+    amplit = (float)(1.0f / expf(amplit * amplit) - data->minfac);
+
+    /*apply texture*/
+    if (data->tex_co) {
+      TexResult texres;
+      texres.nor = NULL;
+      BKE_texture_get_value(data->scene, wmd->texture, data->tex_co[i], &texres, false);
+      amplit *= texres.tin;
+    }
+
+    /*apply weight & falloff */
+    amplit *= def_weight * falloff_fac;
+
+    if (mvert) {
+      /* move along normals */
+      if (wmd->flag & MOD_WAVE_NORM_X) {
+        co[0] += (lifefac * amplit) * mvert[i].no[0] / 32767.0f;
+      }
+      if (wmd->flag & MOD_WAVE_NORM_Y) {
+        co[1] += (lifefac * amplit) * mvert[i].no[1] / 32767.0f;
       }
+      if (wmd->flag & MOD_WAVE_NORM_Z) {
+        co[2] += (lifefac * amplit) * mvert[i].no[2] / 32767.0f;
+      }
+    }
+    else {
+      /* move along local z axis */
+      co[2] += lifefac * amplit;
     }
   }
+}
+
+static void waveModifier_do(WaveModifierData *md,
+                            const ModifierEvalContext *ctx,
+                            Object *ob,
+                            Mesh *mesh,
+                            float (*vertexCos)[3],
+                            int numVerts)
+{
+  WaveModifierData *wmd = (WaveModifierData *)md;
+  WaveUserdata data;
+
+  if (!wave_userdata_init(&data, wmd, ctx, ob, mesh, vertexCos, numVerts)) {
+    return;
+  }
+
+  for (int i = 0; i < numVerts; i++) {
+    wave_vert_deform(&data, vertexCos[i], i);
+  }
 
-  MEM_SAFE_FREE(tex_co);
+  wave_userdata_free(&data);
 }
 
 static void deformVerts(ModifierData *md,
@@ -329,6 +387,66 @@ static void deformVerts(ModifierData *md,
   }
 }
 
+typedef struct WavePointwiseData {
+  WaveUserdata data;
+  Mesh *mesh_src;
+  Mesh *mesh;
+} WavePointwiseData;
+
+static void deform_range(void *userdata, float (*vertexCos)[3], int start, int end)
+{
+  const WavePointwiseData *pointwise_data = userdata;
+  for (int i = start; i < end; i++) {
+    wave_vert_deform(&pointwise_data->data, vertexCos[i], i);
+  }
+}
+
+static void deform_range_free(void *userdata)
+{
+  WavePointwiseData *pointwise_data = userdata;
+  wave_userdata_free(&pointwise_data->data);
+  if (!ELEM(pointwise_data->mesh_src, NULL, pointwise_data->mesh)) {
+    BKE_id_free(NULL, pointwise_data->mesh_src);
+  }
+  MEM_freeN(pointwise_data);
+}
+
+static bool deformVertsPointwise(ModifierData *md,
+                                 const ModifierEvalContext *ctx,
+                                 Mesh *mesh,
+                                 int numVerts,
+                                 ModifierPointwiseDeform *r_deform)
+{
+  WaveModifierData *wmd = (WaveModifierData *)md;
+
+  /* Normals depend on the neighbors of the deformed vertices, texture coordinates on the
+   * deformed positions. */
+  if ((wmd->flag & MOD_WAVE_NORM) || wmd->texture != NULL) {
+    return false;
+  }
+
+  Mesh *mesh_src = NULL;
+  if (wmd->defgrp_name[0] != '\0') {
+    mesh_src = MOD_deform_mesh_eval_get(ctx->object, NULL, mesh, NULL, numVerts, false, false);
+  }
+
+  WavePointwiseData *pointwise_data = MEM_mallocN(sizeof(*pointwise_data), __func__);
+  if (!wave_userdata_init(
+          &pointwise_data->data, wmd, ctx, ctx->object, mesh_src, NULL, numVerts)) {
+    MEM_freeN(pointwise_data);
+    if (!ELEM(mesh_src, NULL, mesh)) {
+      BKE_id_free(NULL, mesh_src);
+    }
+    return true;
+  }
+  pointwise_data->mesh_src = mesh_src;
+  pointwise_data->mesh = mesh;
+  r_deform->deform_range = deform_range;
+  r_deform->free_userdata = deform_range_free;
+  r_deform->userdata = pointwise_data;
+  return true;
+}
+
 static void deformVertsEM(ModifierData *md,
                           const ModifierEvalContext *ctx,
                           struct BMEditMesh *editData,
@@ -489,6 +607,7 @@ ModifierTypeInfo modifierType_Wave = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ deformVertsEM,
     /* deformMatricesEM */ NULL,
+    /* deformVertsPointwise */ deformVertsPointwise,
     /* modifyMesh */ NULL,
     /* modifyHair */ NULL,
     /* modifyGeometrySet */ NULL,
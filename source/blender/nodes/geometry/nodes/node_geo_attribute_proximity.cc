@@ -20,8 +20,10 @@
 #include "BLI_timeit.hh"
 
 #include "DNA_mesh_types.h"
+#include "DNA_pointcloud_types.h"
 
 #include "BKE_bvhutils.h"
+#include "BKE_pointcloud_spatial_index.hh"
 
 #include "UI_interface.h"
 #include "UI_resources.h"
@@ -64,22 +66,29 @@ static void proximity_calc(MutableSpan<float> distance_span,
                            MutableSpan<float3> location_span,
                            Span<float3> positions,
                            BVHTreeFromMesh &tree_data_mesh,
-                           BVHTreeFromPointCloud &tree_data_pointcloud,
+                           const PointCloud *target_pointcloud,
                            const bool bvh_mesh_success,
-                           const bool bvh_pointcloud_success,
                            const bool store_distances,
                            const bool store_locations)
 {
+  const bke::PointCloudSpatialIndex *pointcloud_index = nullptr;
+  if (target_pointcloud != nullptr && target_pointcloud->totpoint > 0) {
+    pointcloud_index = &BKE_pointcloud_spatial_index_ensure(*target_pointcloud);
+  }
+
   IndexRange range = positions.index_range();
   parallel_for(range, 512, [&](IndexRange range) {
     BVHTreeNearest nearest_from_mesh;
-    BVHTreeNearest nearest_from_pointcloud;
-
     copy_v3_fl(nearest_from_mesh.co, FLT_MAX);
-    copy_v3_fl(nearest_from_pointcloud.co, FLT_MAX);
-
     nearest_from_mesh.index = -1;
-    nearest_from_pointcloud.index = -1;
+
+    /* Query the closest points of the whole chunk at once. */
+    Array<int> pointcloud_indices(pointcloud_index ? range.size() : 0);
+    Array<float> pointcloud_distances_sq(pointcloud_index ? range.size() : 0);
+    if (pointcloud_index) {
+      pointcloud_index->find_nearest_n(
+          positions.slice(range), 1, pointcloud_indices, pointcloud_distances_sq);
+    }
 
     for (int i : range) {
       /* Use the distance to the last found point as upper bound to speedup the bvh lookup. */
@@ -93,25 +102,14 @@ static void proximity_calc(MutableSpan<float> distance_span,
                                  &tree_data_mesh);
       }
 
-      /* Use the distance to the closest point in the mesh to speedup the pointcloud bvh lookup.
-       * This is ok because we only need to find the closest point in the pointcloud if it's closer
-       * than the mesh. */
-      nearest_from_pointcloud.dist_sq = nearest_from_mesh.dist_sq;
-
-      if (bvh_pointcloud_success) {
-        BLI_bvhtree_find_nearest(tree_data_pointcloud.tree,
-                                 positions[i],
-                                 &nearest_from_pointcloud,
-                                 tree_data_pointcloud.nearest_callback,
-                                 &tree_data_pointcloud);
-      }
-
-      if (nearest_from_pointcloud.dist_sq < nearest_from_mesh.dist_sq) {
+      const int chunk_index = i - range.start();
+      if (pointcloud_index &&
+          pointcloud_distances_sq[chunk_index] < nearest_from_mesh.dist_sq) {
         if (store_distances) {
-          distance_span[i] = sqrtf(nearest_from_pointcloud.dist_sq);
+          distance_span[i] = sqrtf(pointcloud_distances_sq[chunk_index]);
         }
         if (store_locations) {
-          location_span[i] = nearest_from_pointcloud.co;
+          location_span[i] = target_pointcloud->co[pointcloud_indices[chunk_index]];
         }
       }
       else {
@@ -151,16 +149,6 @@ static bool bvh_from_mesh(const Mesh *target_mesh,
   return true;
 }
 
-static bool bvh_from_pointcloud(const PointCloud *target_pointcloud,
-                                BVHTreeFromPointCloud &r_tree_data_pointcloud)
-{
-  BKE_bvhtree_from_pointcloud_get(&r_tree_data_pointcloud, target_pointcloud, 2);
-  if (r_tree_data_pointcloud.tree == nullptr) {
-    return false;
-  }
-  return true;
-}
-
 static void attribute_calc_proximity(GeometryComponent &component,
                                      GeometrySet &geometry_set_target,
                                      GeoNodeExecParams &params)
@@ -188,9 +176,8 @@ static void attribute_calc_proximity(GeometryComponent &component,
                                                        node.storage;
 
   BVHTreeFromMesh tree_data_mesh;
-  BVHTreeFromPointCloud tree_data_pointcloud;
   bool bvh_mesh_success = false;
-  bool bvh_pointcloud_success = false;
+  const PointCloud *target_pointcloud = nullptr;
 
   if (geometry_set_target.has_mesh()) {
     bvh_mesh_success = bvh_from_mesh(
@@ -200,8 +187,7 @@ static void attribute_calc_proximity(GeometryComponent &component,
   if (geometry_set_target.has_pointcloud() &&
       storage.target_geometry_element ==
           GEO_NODE_ATTRIBUTE_PROXIMITY_TARGET_GEOMETRY_ELEMENT_POINTS) {
-    bvh_pointcloud_success = bvh_from_pointcloud(geometry_set_target.get_pointcloud_for_read(),
-                                                 tree_data_pointcloud);
+    target_pointcloud = geometry_set_target.get_pointcloud_for_read();
   }
 
   Span<float3> position_span = position_attribute->get_span<float3>();
@@ -217,18 +203,14 @@ static void attribute_calc_proximity(GeometryComponent &component,
                  location_span,
                  position_span,
                  tree_data_mesh,
-                 tree_data_pointcloud,
+                 target_pointcloud,
                  bvh_mesh_success,
-                 bvh_pointcloud_success,
                  distance_attribute,  /* Boolean. */
                  location_attribute); /* Boolean. */
 
   if (bvh_mesh_success) {
     free_bvhtree_from_mesh(&tree_data_mesh);
   }
-  if (bvh_pointcloud_success) {
-    free_bvhtree_from_pointcloud(&tree_data_pointcloud);
-  }
 
   if (distance_attribute) {
     distance_attribute.apply_span_and_save();
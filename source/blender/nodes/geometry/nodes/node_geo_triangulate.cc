@@ -16,6 +16,8 @@
 
 #include "DNA_node_types.h"
 
+#include "BKE_mesh.h"
+
 #include "RNA_enum_types.h"
 
 #include "UI_interface.h"
@@ -23,14 +25,6 @@
 
 #include "node_geometry_util.hh"
 
-extern "C" {
-Mesh *triangulate_mesh(Mesh *mesh,
-                       const int quad_method,
-                       const int ngon_method,
-                       const int min_vertices,
-                       const int flag);
-}
-
 static bNodeSocketTemplate geo_node_triangulate_in[] = {
     {SOCK_GEOMETRY, N_("Geometry")},
     {SOCK_INT, N_("Minimum Vertices"), 4, 0, 0, 0, 4, 10000},
@@ -67,10 +61,9 @@ static void geo_node_triangulate_exec(GeoNodeExecParams params)
 
   geometry_set = geometry_set_realize_instances(geometry_set);
 
-  /* #triangulate_mesh might modify the input mesh currently. */
-  Mesh *mesh_in = geometry_set.get_mesh_for_write();
+  const Mesh *mesh_in = geometry_set.get_mesh_for_read();
   if (mesh_in != nullptr) {
-    Mesh *mesh_out = triangulate_mesh(mesh_in, quad_method, ngon_method, min_vertices, 0);
+    Mesh *mesh_out = BKE_mesh_triangulate(mesh_in, quad_method, ngon_method, min_vertices);
     geometry_set.replace_mesh(mesh_out);
   }
 
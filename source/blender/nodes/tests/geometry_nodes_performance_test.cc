@@ -0,0 +1,304 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup nodes
+ *
+ * Benchmarks for geometry nodes evaluation. Every benchmark builds a canonical node tree (scatter,
+ * boolean, attribute math chain, volume conversion) in a geometry nodes modifier on an object
+ * whose mesh is a generated grid with a varying resolution, so that the scaling of every node
+ * tree can be measured.
+ *
+ * The benchmarks are disabled by default, since they take a long time. Run them with:
+ * `blender_test --gtest_filter=*GeometryNodesPerformance* --gtest_also_run_disabled_tests`.
+ */
+
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+#include "tests/blendfile_loading_base_test.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_array.hh"
+#include "BLI_float3.hh"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_math_vector.h"
+#include "BLI_span.hh"
+#include "BLI_string.h"
+#include "BLI_timeit.hh"
+
+#include "BKE_global.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_modifier.h"
+#include "BKE_node.h"
+#include "BKE_node_ui_storage.hh"
+#include "BKE_object.h"
+#include "BKE_scene.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_node_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "MOD_nodes.h"
+
+#include "tests/blenkernel_testing.hh"
+
+namespace blender::nodes::tests {
+
+/* Number of evaluations that are averaged for every measurement. */
+#define NUM_RUN_AVERAGED 5
+
+/**
+ * Adds nodes between the group input and the group output of a node tree, returns the node
+ * whose geometry output is connected to the group output.
+ */
+using NodeTreeBuildFn = std::function<bNode *(bNodeTree *ntree, bNode *group_input)>;
+
+/* The benchmarks don't load files, the base class is only used to initialize Blender. */
+class GeometryNodesPerformanceTest : public BlendfileLoadingBaseTest {
+ protected:
+  Main *bmain = nullptr;
+
+  void TearDown() override
+  {
+    depsgraph_free();
+    if (bmain != nullptr) {
+      BKE_main_free(bmain);
+      bmain = nullptr;
+    }
+    BlendfileLoadingBaseTest::TearDown();
+  }
+
+  void run_benchmark(const char *name,
+                     const NodeTreeBuildFn &build_fn,
+                     Span<int> grid_resolutions);
+};
+
+/* Create a grid with `resolution * resolution` quads in the unit square around the origin. */
+static Mesh *create_unit_grid_mesh(const int resolution)
+{
+  Mesh *mesh = bke::tests::create_grid_mesh(resolution);
+  for (const int i : IndexRange(mesh->totvert)) {
+    float *co = mesh->mvert[i].co;
+    co[0] = co[0] / (float)resolution - 0.5f;
+    co[1] = co[1] / (float)resolution - 0.5f;
+  }
+  return mesh;
+}
+
+/* Find an input socket by name and type, attribute nodes have string and value inputs with the
+ * same name. */
+static bNodeSocket *node_input_find(bNode *node, const char *name, const int type)
+{
+  LISTBASE_FOREACH (bNodeSocket *, socket, &node->inputs) {
+    if (socket->type == type && STREQ(socket->name, name)) {
+      return socket;
+    }
+  }
+  BLI_assert(!"Socket not found");
+  return nullptr;
+}
+
+static void node_input_float_set(bNode *node, const char *name, const float value)
+{
+  bNodeSocket *socket = node_input_find(node, name, SOCK_FLOAT);
+  ((bNodeSocketValueFloat *)socket->default_value)->value = value;
+}
+
+static void node_input_vector_set(bNode *node, const char *name, const float3 value)
+{
+  bNodeSocket *socket = node_input_find(node, name, SOCK_VECTOR);
+  copy_v3_v3(((bNodeSocketValueVector *)socket->default_value)->value, value);
+}
+
+static void node_input_string_set(bNode *node, const char *name, const char *value)
+{
+  bNodeSocket *socket = node_input_find(node, name, SOCK_STRING);
+  STRNCPY(((bNodeSocketValueString *)socket->default_value)->value, value);
+}
+
+static void node_link_geometry(bNodeTree *ntree, bNode *from_node, bNode *to_node, int to_index)
+{
+  nodeAddLink(ntree,
+              from_node,
+              (bNodeSocket *)from_node->outputs.first,
+              to_node,
+              (bNodeSocket *)BLI_findlink(&to_node->inputs, to_index));
+}
+
+/* Add a node and connect its first geometry input to the geometry output of another node. */
+static bNode *node_add_after(bNodeTree *ntree, bNode *from_node, const int type)
+{
+  bNode *node = nodeAddStaticNode(nullptr, ntree, type);
+  node_link_geometry(ntree, from_node, node, 0);
+  return node;
+}
+
+static bNode *build_scatter(bNodeTree *ntree, bNode *group_input)
+{
+  bNode *distribute = node_add_after(ntree, group_input, GEO_NODE_POINT_DISTRIBUTE);
+  node_input_float_set(distribute, "Density Max", 10000.0f);
+  return distribute;
+}
+
+static bNode *build_boolean(bNodeTree *ntree, bNode *group_input)
+{
+  /* Union of the grid and a rotated copy of itself. */
+  bNode *transform = node_add_after(ntree, group_input, GEO_NODE_TRANSFORM);
+  node_input_vector_set(transform, "Rotation", float3(M_PI_2, 0.0f, 0.0f));
+  node_input_vector_set(transform, "Translation", float3(0.0f, 0.0f, 0.25f));
+  bNode *boolean = node_add_after(ntree, group_input, GEO_NODE_BOOLEAN);
+  boolean->custom1 = GEO_NODE_BOOLEAN_UNION;
+  node_link_geometry(ntree, transform, boolean, 1);
+  return boolean;
+}
+
+static bNode *build_attribute_math_chain(bNodeTree *ntree, bNode *group_input)
+{
+  bNode *prev = group_input;
+  for (const int i : IndexRange(8)) {
+    bNode *math = node_add_after(ntree, prev, GEO_NODE_ATTRIBUTE_MATH);
+    NodeAttributeMath *storage = (NodeAttributeMath *)math->storage;
+    storage->operation = (i % 2) ? NODE_MATH_MULTIPLY : NODE_MATH_ADD;
+    storage->input_type_b = GEO_NODE_ATTRIBUTE_INPUT_FLOAT;
+    node_input_string_set(math, "A", (i == 0) ? "position" : "value");
+    node_input_float_set(math, "B", 0.5f);
+    node_input_string_set(math, "Result", "value");
+    prev = math;
+  }
+  return prev;
+}
+
+static bNode *build_volume_conversion(bNodeTree *ntree, bNode *group_input)
+{
+  bNode *distribute = node_add_after(ntree, group_input, GEO_NODE_POINT_DISTRIBUTE);
+  node_input_float_set(distribute, "Density Max", 1000.0f);
+  bNode *to_volume = node_add_after(ntree, distribute, GEO_NODE_POINTS_TO_VOLUME);
+  node_input_float_set(to_volume, "Radius", 0.05f);
+  return node_add_after(ntree, to_volume, GEO_NODE_VOLUME_TO_MESH);
+}
+
+/* Print the execution statistics of every node, they are reset on every evaluation, so they
+ * only contain the data from the last evaluation. */
+static void print_node_exec_stats(const bNodeTree &ntree)
+{
+  if (ntree.ui_storage == nullptr) {
+    return;
+  }
+  for (const Map<std::string, NodeUIStorage> &node_storage_map :
+       ntree.ui_storage->context_map.values()) {
+    for (const auto item : node_storage_map.items()) {
+      std::cout << "    " << std::left << std::setw(32) << item.key << " ";
+      timeit::print_duration(item.value.exec_time);
+      std::cout << ", " << item.value.exec_memory_delta / 1024 << " KiB\n";
+    }
+  }
+}
+
+void GeometryNodesPerformanceTest::run_benchmark(const char *name,
+                                                 const NodeTreeBuildFn &build_fn,
+                                                 const Span<int> grid_resolutions)
+{
+  /* The per-node statistics are only recorded when asked for. */
+  const int debug_prev = G.debug;
+  G.debug |= G_DEBUG_NODES_TIME;
+
+  for (const int resolution : grid_resolutions) {
+    bmain = BKE_main_new();
+    Scene *scene = BKE_scene_add(bmain, "Scene");
+    ViewLayer *view_layer = (ViewLayer *)scene->view_layers.first;
+    Object *object = BKE_object_add(bmain, view_layer, OB_MESH, "Benchmark");
+
+    Mesh *grid = create_unit_grid_mesh(resolution);
+    BKE_mesh_nomain_to_mesh(grid, (Mesh *)object->data, object, &CD_MASK_MESH, true);
+
+    /* Start from the default node tree of a new modifier, with the input connected to the
+     * output, and insert the benchmarked nodes in between. */
+    NodesModifierData *nmd = (NodesModifierData *)BKE_modifier_new(eModifierType_Nodes);
+    BLI_addtail(&object->modifiers, nmd);
+    BKE_modifier_session_uuid_generate(&nmd->modifier);
+    MOD_nodes_init(bmain, nmd);
+    bNodeTree *ntree = nmd->node_group;
+    bNode *group_input = nodeFindNodebyName(ntree, "Group Input");
+    bNode *group_output = nodeFindNodebyName(ntree, "Group Output");
+    nodeRemLink(ntree, (bNodeLink *)ntree->links.first);
+    bNode *last = build_fn(ntree, group_input);
+    node_link_geometry(ntree, last, group_output, 0);
+    ntreeUpdateTree(bmain, ntree);
+    MOD_nodes_update_interface(object, nmd);
+
+    depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
+    DEG_graph_build_from_view_layer(depsgraph);
+    BKE_scene_graph_update_tagged(depsgraph, bmain);
+
+    const size_t memory_before = MEM_get_memory_in_use();
+    MEM_reset_peak_memory();
+
+    timeit::Nanoseconds total_time{0};
+    for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+      DEG_id_tag_update_ex(bmain, &object->id, ID_RECALC_GEOMETRY);
+      const timeit::TimePoint start = timeit::Clock::now();
+      BKE_scene_graph_update_tagged(depsgraph, bmain);
+      total_time += timeit::Clock::now() - start;
+    }
+    const size_t peak_memory = MEM_get_peak_memory() - memory_before;
+
+    std::cout << name << " (" << resolution * resolution << " faces): ";
+    timeit::print_duration(total_time / NUM_RUN_AVERAGED);
+    std::cout << ", peak memory " << peak_memory / 1024 << " KiB\n";
+    print_node_exec_stats(*ntree);
+
+    depsgraph_free();
+    BKE_main_free(bmain);
+    bmain = nullptr;
+  }
+
+  G.debug = debug_prev;
+}
+
+static const Array<int> grid_resolutions = {32, 256, 1024};
+
+TEST_F(GeometryNodesPerformanceTest, DISABLED_scatter)
+{
+  run_benchmark("scatter", build_scatter, grid_resolutions);
+}
+
+TEST_F(GeometryNodesPerformanceTest, DISABLED_boolean)
+{
+  run_benchmark("boolean", build_boolean, grid_resolutions);
+}
+
+TEST_F(GeometryNodesPerformanceTest, DISABLED_attribute_math_chain)
+{
+  run_benchmark("attribute_math_chain", build_attribute_math_chain, grid_resolutions);
+}
+
+TEST_F(GeometryNodesPerformanceTest, DISABLED_volume_conversion)
+{
+  run_benchmark("volume_conversion", build_volume_conversion, grid_resolutions);
+}
+
+}  // namespace blender::nodes::tests
@@ -590,6 +590,7 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-pretty");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-uuid");
   BLI_args_print_arg_doc(ba, "--debug-ghost");
+  BLI_args_print_arg_doc(ba, "--debug-nodes-time");
   BLI_args_print_arg_doc(ba, "--debug-gpu");
   BLI_args_print_arg_doc(ba, "--debug-gpu-force-workarounds");
   BLI_args_print_arg_doc(ba, "--debug-wm");
@@ -980,6 +981,9 @@ static const char arg_handle_debug_mode_generic_set_doc_depsgraph_tag[] =
 static const char arg_handle_debug_mode_generic_set_doc_depsgraph_time[] =
     "\n\t"
     "Enable debug messages from dependency graph related on timing.";
+static const char arg_handle_debug_mode_generic_set_doc_nodes_time[] =
+    "\n\t"
+    "Record the execution time and memory usage of every node in geometry node trees.";
 static const char arg_handle_debug_mode_generic_set_doc_depsgraph_eval[] =
     "\n\t"
     "Enable debug messages from dependency graph related on evaluation.";
@@ -2121,6 +2125,11 @@ void main_args_setup(bContext *C, bArgs *ba)
                "--debug-ghost",
                CB_EX(arg_handle_debug_mode_generic_set, handlers),
                (void *)G_DEBUG_GHOST);
+  BLI_args_add(ba,
+               NULL,
+               "--debug-nodes-time",
+               CB_EX(arg_handle_debug_mode_generic_set, nodes_time),
+               (void *)G_DEBUG_NODES_TIME);
   BLI_args_add(ba, NULL, "--debug-all", CB(arg_handle_debug_mode_all), NULL);
 
   BLI_args_add(ba, NULL, "--debug-io", CB(arg_handle_debug_mode_io), NULL);